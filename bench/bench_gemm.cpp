@@ -0,0 +1,240 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include "matrixLib.hpp"
+#include "parallel.hpp"
+#include "strassen.hpp"
+#include "spectral.hpp"
+#include "reductions.hpp"
+#include "outOfCore.hpp"
+
+using namespace MatrixLib;
+
+/* The i-j-k triple loop operator* used before the blocked kernel, kept here as the baseline */
+template <typename T, size_t M, size_t N, size_t P>
+void naive_multiply(const Matrix<T, M, N>& lhs, const Matrix<T, N, P>& rhs, Matrix<T, M, P>& ret) {
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < P; ++j) {
+            T acc = 0;
+            for (size_t k = 0; k < N; ++k) {
+                acc += lhs[i][k] * rhs[k][j];
+            }
+            ret[i][j] = acc;
+        }
+    }
+}
+
+template <typename F>
+double best_of_seconds(F&& f, size_t reps) {
+    double best = 1e300;
+    for (size_t r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+template <typename T, size_t M, size_t N, size_t P>
+void bench_shape(const char* typeName) {
+    auto lhs = std::make_unique<Matrix<T, M, N>>();
+    auto rhs = std::make_unique<Matrix<T, N, P>>();
+    auto out = std::make_unique<Matrix<T, M, P>>();
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < M; ++i) for (size_t j = 0; j < N; ++j) (*lhs)(i, j) = static_cast<T>(dist(rng));
+    for (size_t i = 0; i < N; ++i) for (size_t j = 0; j < P; ++j) (*rhs)(i, j) = static_cast<T>(dist(rng));
+
+    const size_t reps = std::max<size_t>(3, (size_t)(2e8 / (double)(M * N * P)));
+    const double naive = best_of_seconds([&] { naive_multiply(*lhs, *rhs, *out); }, reps);
+    const double blocked = best_of_seconds([&] { *out = *lhs * *rhs; }, reps);
+    const double parallel = best_of_seconds([&] { *out = multiply(Execution::par, *lhs, *rhs); }, reps);
+    const double gflop = 2.0 * M * N * P * 1e-9;
+
+    std::printf("%-6s %4zux%4zux%4zu  naive %8.2f GFLOP/s  operator* %8.2f GFLOP/s  par %8.2f GFLOP/s (%zu threads)  speedup %5.2fx\n",
+                typeName, M, N, P, gflop / naive, gflop / blocked, gflop / parallel, ThreadPool::global().thread_count(), naive / blocked);
+}
+
+/* Square products through operator* and through Strassen with the default leaf, to locate the crossover */
+template <typename T>
+void bench_strassen(const char* typeName, size_t n) {
+    DynMatrix<T> lhs(n, n), rhs(n, n), out(n, n);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < n; ++i) for (size_t j = 0; j < n; ++j) lhs(i, j) = static_cast<T>(dist(rng));
+    for (size_t i = 0; i < n; ++i) for (size_t j = 0; j < n; ++j) rhs(i, j) = static_cast<T>(dist(rng));
+
+    StrassenWorkspace<T> workspace;
+    workspace.reserve(n, n, n);
+
+    const size_t reps = std::max<size_t>(3, (size_t)(2e9 / (double)(n * n * n)));
+    const double blocked = best_of_seconds([&] { out = lhs * rhs; }, reps);
+    const double strassen = best_of_seconds([&] { out = multiply_strassen(lhs, rhs, workspace); }, reps);
+    const double gflop = 2.0 * n * n * n * 1e-9;
+
+    std::printf("%-6s %4zux%4zux%4zu  operator* %8.2f GFLOP/s  strassen (leaf %zu) %8.2f effective GFLOP/s  speedup %5.2fx\n",
+                typeName, n, n, n, gflop / blocked, workspace.leaf_size(), gflop / strassen, blocked / strassen);
+}
+
+/* Full and values-only symmetric eigensolves, Jacobi SVD and Lanczos top-8 of the same symmetric matrix */
+template <typename T>
+void bench_spectral(const char* typeName, size_t n) {
+    DynMatrix<T> a(n, n);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < n; ++i) for (size_t j = 0; j <= i; ++j) a(i, j) = a(j, i) = static_cast<T>(dist(rng));
+
+    SymmetricEigen<DynMatrix<T>> eigen;
+    SVD<DynMatrix<T>> svd;
+    LanczosEigen<DynMatrix<T>> lanczos;
+
+    const size_t reps = std::max<size_t>(1, (size_t)(2e8 / (double)(n * n * n)));
+    const double vectors = best_of_seconds([&] { eigen.compute(a); }, reps);
+    const double parallel = best_of_seconds([&] { eigen.compute(Execution::par, a); }, reps);
+    const double values = best_of_seconds([&] { eigen.compute(a, false); }, reps);
+    const double singular = best_of_seconds([&] { svd.compute(a); }, reps);
+    const double top = best_of_seconds([&] { lanczos.compute(a, 8); }, reps);
+
+    std::printf("%-6s %4zu  eigen %9.2f ms  par %9.2f ms  values %9.2f ms  svd %9.2f ms (%zu sweeps)  lanczos top-8 %7.2f ms (%zu steps)\n",
+                typeName, n, vectors * 1e3, parallel * 1e3, values * 1e3, singular * 1e3, svd.sweeps(), top * 1e3, lanczos.iterations());
+}
+
+/* Whole-matrix, row and column sums against a running sum, and an element-wise map, in GB/s of input read */
+template <typename T>
+void bench_reductions(const char* typeName, size_t rows, size_t cols) {
+    DynMatrix<T> a(rows, cols);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < a.size(); ++i) a.data()[i] = static_cast<T>(dist(rng));
+
+    volatile T sink = T(0);
+    const size_t reps = std::max<size_t>(1, (size_t)(2e8 / (double)(rows * cols)));
+    const double naive = best_of_seconds([&] {
+        T s = T(0);
+        for (size_t i = 0; i < a.size(); ++i) s += a.data()[i];
+        sink = s;
+    }, reps);
+    const double total = best_of_seconds([&] { sink = sum(a); }, reps);
+    const double parallel = best_of_seconds([&] { sink = sum(Execution::par, a); }, reps);
+    const double byRow = best_of_seconds([&] { sink = rowwise_sum(a)(0, 0); }, reps);
+    const double byCol = best_of_seconds([&] { sink = colwise_sum(a)(0, 0); }, reps);
+    const double mapped = best_of_seconds([&] { sink = map(a, [](T x) { return x * x + T(1); })(0, 0); }, reps);
+    (void)sink;
+
+    const double gb = (double)(rows * cols * sizeof(T)) * 1e-9;
+    std::printf("%-6s %5zux%-5zu  running %6.2f  sum %6.2f  par %6.2f  rowwise %6.2f  colwise %6.2f  map %6.2f GB/s\n",
+                typeName, rows, cols, gb / naive, gb / total, gb / parallel, gb / byRow, gb / byCol, gb / mapped);
+}
+
+/* dot, sum and gemv in the default mode and in deterministic mode, which fixes the summation order and never fuses */
+template <typename T>
+void bench_deterministic(const char* typeName, size_t n) {
+    DynMatrix<T> a(n, n), x(n * n, 1), y(n * n, 1), v(n, 1);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < a.size(); ++i) a.data()[i] = static_cast<T>(dist(rng));
+    for (size_t i = 0; i < x.size(); ++i) x.data()[i] = static_cast<T>(dist(rng)), y.data()[i] = static_cast<T>(dist(rng));
+    for (size_t i = 0; i < n; ++i) v.data()[i] = static_cast<T>(dist(rng));
+
+    volatile T sink = T(0);
+    DynMatrix<T> out(n, 1);
+    const size_t reps = std::max<size_t>(1, (size_t)(2e8 / (double)(n * n)));
+    double seconds[2][3];
+    for (int mode = 0; mode < 2; ++mode) {
+        Kernels::set_deterministic_mode(mode == 1);
+        seconds[mode][0] = best_of_seconds([&] { sink = dot(x, y); }, reps);
+        seconds[mode][1] = best_of_seconds([&] { sink = sum(a); }, reps);
+        seconds[mode][2] = best_of_seconds([&] { gemv(Execution::seq, T(1), a, v, T(0), out); sink = out(0, 0); }, reps);
+    }
+    Kernels::set_deterministic_mode(false);
+    (void)sink;
+
+    const double gb = (double)(n * n * sizeof(T)) * 1e-9;
+    std::printf("%-6s n=%-5zu  dot %6.2f -> %6.2f  sum %6.2f -> %6.2f  gemv %6.2f -> %6.2f GB/s (default -> deterministic)\n",
+                typeName, n, 2 * gb / seconds[0][0], 2 * gb / seconds[1][0], gb / seconds[0][1], gb / seconds[1][1],
+                gb / seconds[0][2], gb / seconds[1][2]);
+}
+
+template <typename T>
+void bench_out_of_core(const char* typeName, size_t n, size_t tile) {
+    DynMatrix<T> a(n, n), b(n, n);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < a.size(); ++i) a.data()[i] = static_cast<T>(dist(rng)), b.data()[i] = static_cast<T>(dist(rng));
+
+    const char* paths[3] = {"bench_tiled_a.mltl", "bench_tiled_b.mltl", "bench_tiled_c.mltl"};
+    {
+        TiledMatrix<T> ta = save_tiled(paths[0], a, tile, tile);
+        TiledMatrix<T> tb = save_tiled(paths[1], b, tile, tile);
+        TiledMatrix<T> tc(paths[2], n, n, tile, tile);
+
+        /* Room for a quarter of C plus the staged tiles, so A and B are streamed several times */
+        const size_t budget = (n * n / 4 + 4 * n * tile) * sizeof(T);
+        DynMatrix<T> c(n, n);
+        const double inMemory = best_of_seconds([&] { c = multiply(Execution::par, a, b); }, 3);
+        const double outOfCore = best_of_seconds([&] { multiply(Execution::par, ta, tb, tc, budget); }, 3);
+
+        const double gflop = 2.0 * (double)n * n * n * 1e-9;
+        std::printf("%-6s n=%-5zu tile=%-4zu  in memory %7.2f GFLOP/s  out of core %7.2f GFLOP/s (budget %zu KiB)\n",
+                    typeName, n, tile, gflop / inMemory, gflop / outOfCore, budget / 1024);
+    }
+
+    for (const char* path : paths) std::remove(path);
+}
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+
+    bench_shape<float, 16, 16, 16>("float");
+    bench_shape<float, 64, 64, 64>("float");
+    bench_shape<float, 128, 128, 128>("float");
+    bench_shape<float, 256, 256, 256>("float");
+    bench_shape<float, 512, 512, 512>("float");
+    bench_shape<double, 16, 16, 16>("double");
+    bench_shape<double, 32, 32, 32>("double");
+    bench_shape<double, 64, 64, 64>("double");
+    bench_shape<double, 128, 128, 128>("double");
+    bench_shape<double, 256, 256, 256>("double");
+    bench_shape<double, 512, 512, 512>("double");
+    bench_shape<double, 512, 64, 512>("double");
+    bench_shape<double, 64, 1024, 64>("double");
+    bench_shape<double, 300, 700, 200>("double");
+    bench_shape<int, 256, 256, 256>("int");
+
+    for (size_t n : {512, 768, 1024, 1536, 2048, 3072}) {
+        bench_strassen<float>("float", n);
+        bench_strassen<double>("double", n);
+    }
+
+    for (size_t n : {64, 200, 500}) {
+        bench_spectral<float>("float", n);
+        bench_spectral<double>("double", n);
+    }
+
+    for (size_t n : {64, 1000, 4000}) {
+        bench_reductions<float>("float", n, n);
+        bench_reductions<double>("double", n, n);
+    }
+
+    for (size_t n : {64, 1000, 4000}) {
+        bench_deterministic<float>("float", n);
+        bench_deterministic<double>("double", n);
+    }
+
+    for (size_t n : {1024, 2048}) {
+        bench_out_of_core<float>("float", n, 256);
+        bench_out_of_core<double>("double", n, 256);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,403 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "matrixLib.hpp"
+#include "serialization.hpp"
+#include "mixedPrecision.hpp"
+#include "matrixVector.hpp"
+
+using namespace MatrixLib;
+
+/*
+ * A small self-contained harness in the style of Google Benchmark: every benchmark is calibrated until one timed
+ * run lasts at least --benchmark_min_time seconds, and results are printed as a table or as Google Benchmark
+ * compatible JSON so that runs of different versions can be compared with the usual tooling.
+ */
+
+/* Keeps the compiler from discarding a result that is never read */
+template <typename T>
+inline void do_not_optimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    size_t iterations;
+    double realNs;
+    double cpuNs;
+    double flopsPerIter;
+    double bytesPerIter;
+};
+
+class BenchRunner {
+    double minTime_ = 0.1;
+    std::string filter_;
+    std::string format_ = "console";
+    std::string out_;
+    std::vector<BenchResult> results_;
+
+    static std::string json_escape(const std::string& s) {
+        std::string ret;
+        for (char c : s) {
+            if (c == '"' || c == '\\') ret += '\\';
+            ret += c;
+        }
+        return ret;
+    }
+
+public:
+    bool parse(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&](const char* flag) -> const char* {
+                const size_t len = std::strlen(flag);
+                return arg.compare(0, len, flag) == 0 ? arg.c_str() + len : nullptr;
+            };
+
+            if (const char* v = value("--benchmark_filter=")) filter_ = v;
+            else if (const char* v = value("--benchmark_min_time=")) minTime_ = std::atof(v);
+            else if (const char* v = value("--benchmark_format=")) format_ = v;
+            else if (const char* v = value("--benchmark_out=")) out_ = v;
+            else {
+                std::fprintf(stderr, "usage: %s [--benchmark_filter=<substring>] [--benchmark_min_time=<seconds>]\n"
+                                     "          [--benchmark_format=console|json] [--benchmark_out=<file.json>]\n", argv[0]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Times body() and records it under name. flops and bytes are the work and memory traffic of one call,
+     * from which the GFLOP/s and bytes/s columns are derived.
+     */
+    template <typename F>
+    void run(const std::string& name, double flops, double bytes, F&& body) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) return;
+
+        body();
+
+        size_t iterations = 1;
+        for (;;) {
+            const std::clock_t cpuStart = std::clock();
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i) body();
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const double cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+            if (elapsed >= minTime_ || iterations >= (size_t(1) << 40)) {
+                results_.push_back({name, iterations, elapsed * 1e9 / iterations, cpu * 1e9 / iterations, flops, bytes});
+                if (format_ == "console") print_row(results_.back());
+                return;
+            }
+
+            /* Aim 40% past the target so that the next attempt normally is the last one */
+            const double scale = elapsed > 0 ? 1.4 * minTime_ / elapsed : 100.0;
+            iterations = std::max(iterations + 1, static_cast<size_t>(static_cast<double>(iterations) * std::min(scale, 100.0)));
+        }
+    }
+
+    void print_header() const {
+        if (format_ != "console") return;
+        std::printf("%-32s %14s %14s %12s %12s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "GFLOP/s", "Bytes/s");
+        std::printf("%s\n", std::string(103, '-').c_str());
+    }
+
+    static void print_row(const BenchResult& r) {
+        const double gflops = r.flopsPerIter > 0 ? r.flopsPerIter / r.realNs : 0.0;
+        std::printf("%-32s %14.1f %14.1f %12zu %12.3f %13.3fG\n", r.name.c_str(), r.realNs, r.cpuNs, r.iterations,
+                    gflops, r.bytesPerIter / r.realNs);
+    }
+
+    std::string to_json() const {
+        std::ostringstream os;
+        char date[64];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+        os << "{\n  \"context\": {\n"
+           << "    \"date\": \"" << date << "\",\n"
+           << "    \"executable\": \"matrixLibBench\",\n"
+           << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+           << "    \"simd_isa\": \"" << Kernels::simd_isa_name(Kernels::active_simd_isa()) << "\",\n"
+           << "    \"library_build_type\": \"release\"\n"
+           << "  },\n  \"benchmarks\": [";
+
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            os << (i ? ",\n" : "\n") << "    {\n"
+               << "      \"name\": \"" << json_escape(r.name) << "\",\n"
+               << "      \"run_name\": \"" << json_escape(r.name) << "\",\n"
+               << "      \"run_type\": \"iteration\",\n"
+               << "      \"iterations\": " << r.iterations << ",\n"
+               << "      \"real_time\": " << r.realNs << ",\n"
+               << "      \"cpu_time\": " << r.cpuNs << ",\n"
+               << "      \"time_unit\": \"ns\",\n"
+               << "      \"bytes_per_second\": " << r.bytesPerIter / r.realNs * 1e9 << ",\n"
+               << "      \"GFLOP/s\": " << (r.flopsPerIter > 0 ? r.flopsPerIter / r.realNs : 0.0) << "\n"
+               << "    }";
+        }
+
+        os << "\n  ]\n}\n";
+        return os.str();
+    }
+
+    int finish() const {
+        const std::string json = to_json();
+        if (format_ == "json") std::fputs(json.c_str(), stdout);
+
+        if (!out_.empty()) {
+            std::ofstream file(out_);
+            if (!(file << json)) {
+                std::fprintf(stderr, "Cannot write %s\n", out_.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        return EXIT_SUCCESS;
+    }
+};
+
+template <typename T, size_t N>
+void fill(Matrix<T, N, N>& m, std::mt19937& rng) {
+    /* Integers stay in {-1, 0, 1} so that the repeated += below cannot overflow */
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (auto& x : m) x = std::is_integral<T>::value ? static_cast<T>(std::lround(dist(rng))) : static_cast<T>(dist(rng));
+}
+
+template <typename T, size_t N>
+void bench_size(BenchRunner& runner, const char* typeName) {
+    auto a = std::make_unique<Matrix<T, N, N>>();
+    auto b = std::make_unique<Matrix<T, N, N>>();
+    auto c = std::make_unique<Matrix<T, N, N>>();
+
+    std::mt19937 rng(42);
+    fill(*a, rng);
+    fill(*b, rng);
+    *c = *a;
+
+    const std::string suffix = std::string("<") + typeName + ">/" + std::to_string(N);
+    const double n2 = static_cast<double>(N * N), bytes = n2 * sizeof(T);
+
+    runner.run("multiply" + suffix, 2.0 * n2 * N, 3 * bytes, [&] {
+        *c = *a * *b;
+        do_not_optimize(*c);
+    });
+
+    runner.run("multiply_transposed" + suffix, 2.0 * n2 * N, 3 * bytes, [&] {
+        *c = *a * transpose_view(*b);
+        do_not_optimize(*c);
+    });
+
+    runner.run("add_assign" + suffix, n2, 3 * bytes, [&] {
+        *c += *a;
+        do_not_optimize(*c);
+    });
+
+    runner.run("sub_assign" + suffix, n2, 3 * bytes, [&] {
+        *c -= *a;
+        do_not_optimize(*c);
+    });
+
+    runner.run("scale_assign" + suffix, n2, 2 * bytes, [&] {
+        *c *= T(1);
+        do_not_optimize(*c);
+    });
+
+    /* Equal operands, so that the comparison has to read every element */
+    *c = *a;
+    runner.run("equal" + suffix, 0, 2 * bytes, [&] {
+        bool equal = (*a == *c);
+        do_not_optimize(equal);
+    });
+
+    /* Text output is measured in characters produced per second */
+    const double textBytes = static_cast<double>(to_string(*a).size());
+    runner.run("to_string" + suffix, 0, textBytes, [&] {
+        std::string text = to_string(*a);
+        do_not_optimize(text);
+    });
+
+    std::ostringstream os;
+    runner.run("stream" + suffix, 0, textBytes, [&] {
+        os.str(std::string());
+        os << *a;
+        do_not_optimize(os);
+    });
+
+    std::stringstream bin;
+    write_binary(bin, *a);
+    const double binBytes = static_cast<double>(bin.str().size());
+    runner.run("write_binary" + suffix, 0, binBytes, [&] {
+        bin.str(std::string());
+        write_binary(bin, *a);
+        do_not_optimize(bin);
+    });
+
+    runner.run("read_binary" + suffix, 0, binBytes, [&] {
+        bin.clear();
+        bin.seekg(0);
+        *c = read_binary<Matrix<T, N, N>>(bin);
+        do_not_optimize(*c);
+    });
+}
+
+template <typename T>
+void bench_type(BenchRunner& runner, const char* typeName) {
+    bench_size<T, 4>(runner, typeName);
+    bench_size<T, 16>(runner, typeName);
+    bench_size<T, 64>(runner, typeName);
+    bench_size<T, 256>(runner, typeName);
+}
+
+/* Odd sizes in the packed default layout against padded rows, which start every row on a cache line */
+template <typename Layout, size_t N>
+void bench_layout(BenchRunner& runner, const char* layoutName) {
+    Matrix<float, N, N, Layout> a, b, c;
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            a(i, j) = static_cast<float>(i + 2 * j) / N;
+            b(i, j) = static_cast<float>(2 * i + j) / N;
+        }
+    }
+
+    const std::string suffix = std::string("<float,") + layoutName + ">/" + std::to_string(N);
+    const double n2 = static_cast<double>(N * N), bytes = n2 * sizeof(float);
+
+    runner.run("multiply" + suffix, 2.0 * n2 * N, 3 * bytes, [&] {
+        c = a * b;
+        do_not_optimize(c);
+    });
+
+    runner.run("add_assign" + suffix, n2, 3 * bytes, [&] {
+        c += a;
+        do_not_optimize(c);
+    });
+}
+
+/* Reduced-precision storage: half widened to float, and int8 into int32 (VNNI where available) */
+template <size_t N>
+void bench_mixed(BenchRunner& runner) {
+    DynMatrix<Half> ha(N, N), hb(N, N);
+    DynMatrix<std::int8_t> ia(N, N), ib(N, N);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(-128, 127);
+    for (size_t k = 0; k < N * N; ++k) {
+        ha.data()[k] = Half(static_cast<float>(dist(rng)) / 128.0f);
+        hb.data()[k] = Half(static_cast<float>(dist(rng)) / 128.0f);
+        ia.data()[k] = static_cast<std::int8_t>(dist(rng));
+        ib.data()[k] = static_cast<std::int8_t>(dist(rng));
+    }
+
+    const std::string suffix = "/" + std::to_string(N);
+    const double n2 = static_cast<double>(N * N);
+
+    runner.run("multiply<half,float>" + suffix, 2.0 * n2 * N, n2 * (2 * sizeof(Half) + sizeof(float)), [&] {
+        DynMatrix<float> c = multiply<float>(ha, hb);
+        do_not_optimize(c);
+    });
+
+    runner.run("multiply<int8,int32>" + suffix, 2.0 * n2 * N, n2 * (2 + sizeof(std::int32_t)), [&] {
+        DynMatrix<std::int32_t> c = multiply<std::int32_t>(ia, ib);
+        do_not_optimize(c);
+    });
+}
+
+/* Matrix-vector products, plain and through a transposed view, and the level-1 routines on vectors of the same length */
+template <typename T, size_t N>
+void bench_vector(BenchRunner& runner, const char* typeName) {
+    DynMatrix<T> a(N, N);
+    Vector<T> x(N), y(N);
+    for (size_t i = 0; i < N; ++i) {
+        x(i, 0) = static_cast<T>(i % 7) / 7;
+        for (size_t j = 0; j < N; ++j) a(i, j) = static_cast<T>(i + 2 * j) / N;
+    }
+
+    const std::string suffix = std::string("<") + typeName + ">/" + std::to_string(N);
+    const double n2 = static_cast<double>(N * N), n = static_cast<double>(N);
+
+    runner.run("gemv" + suffix, 2.0 * n2, (n2 + 2 * n) * sizeof(T), [&] {
+        y = a * x;
+        do_not_optimize(y);
+    });
+
+    runner.run("gemv_transposed" + suffix, 2.0 * n2, (n2 + 2 * n) * sizeof(T), [&] {
+        gemv(T(1), transpose_view(a), x, T(0), y);
+        do_not_optimize(y);
+    });
+
+    runner.run("dot" + suffix, 2.0 * n, 2 * n * sizeof(T), [&] {
+        T d = dot(x, y);
+        do_not_optimize(d);
+    });
+
+    runner.run("axpy" + suffix, 2.0 * n, 3 * n * sizeof(T), [&] {
+        axpy(T(1) / 1024, x, y);
+        do_not_optimize(y);
+    });
+}
+
+/* Loops that create runtime-sized temporaries: nested products, and a residual held in a heap or a scratch matrix */
+template <size_t N>
+void bench_temporaries(BenchRunner& runner) {
+    DynMatrix<double> a(N, N, 0.5), b(N, N, 0.25), c(N, N), rhs(N, 1, 1.0), x(N, 1);
+    const std::string suffix = "<double>/" + std::to_string(N);
+    const double n2 = static_cast<double>(N * N);
+
+    runner.run("nested_product" + suffix, 2.0 * n2 * N + n2, 3 * n2 * sizeof(double), [&] {
+        c = (a + b) * b;
+        do_not_optimize(c);
+    });
+
+    runner.run("residual_heap" + suffix, 2.0 * n2, n2 * sizeof(double), [&] {
+        DynMatrix<double> residual = rhs - a * x;
+        x += 1e-3 * residual;
+        do_not_optimize(x);
+    });
+
+    runner.run("residual_scratch" + suffix, 2.0 * n2, n2 * sizeof(double), [&] {
+        ScratchMatrix<double> residual = rhs - a * x;
+        x += 1e-3 * residual;
+        do_not_optimize(x);
+    });
+}
+
+int main(int argc, char *argv[]) {
+    BenchRunner runner;
+    if (!runner.parse(argc, argv)) return EXIT_FAILURE;
+
+    runner.print_header();
+    bench_type<float>(runner, "float");
+    bench_type<double>(runner, "double");
+    bench_type<int>(runner, "int");
+    bench_layout<RowMajorLayout, 7>(runner, "packed");
+    bench_layout<PaddedLayout<32>, 7>(runner, "padded");
+    bench_layout<RowMajorLayout, 31>(runner, "packed");
+    bench_layout<PaddedLayout<64>, 31>(runner, "padded");
+    bench_mixed<64>(runner);
+    bench_mixed<256>(runner);
+    bench_vector<float, 64>(runner, "float");
+    bench_vector<float, 1024>(runner, "float");
+    bench_vector<double, 1024>(runner, "double");
+    bench_temporaries<16>(runner);
+    bench_temporaries<128>(runner);
+
+    return runner.finish();
+}
@@ -0,0 +1,52 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+/* Default alignment of heap-allocated matrix storage: one cache line, which also covers a full AVX-512 register */
+#ifndef MATRIXLIB_DEFAULT_ALIGNMENT
+#define MATRIXLIB_DEFAULT_ALIGNMENT 64
+#endif
+
+namespace MatrixLib {
+    /**
+     * Minimal standard allocator returning storage aligned to _Alignment bytes, so that the first element of
+     * every heap matrix starts on a cache line and vector loads of the leading elements never split.
+     */
+    template <typename T, size_t _Alignment = MATRIXLIB_DEFAULT_ALIGNMENT>
+    class AlignedAllocator {
+        static_assert(_Alignment >= alignof(T) && (_Alignment & (_Alignment - 1)) == 0,
+                      "Alignment must be a power of two no smaller than the element alignment");
+
+    public:
+        using value_type = T;
+        static constexpr size_t alignment = _Alignment;
+
+        template <typename U>
+        struct rebind { using other = AlignedAllocator<U, _Alignment>; };
+
+        constexpr AlignedAllocator() noexcept = default;
+
+        template <typename U>
+        constexpr AlignedAllocator(const AlignedAllocator<U, _Alignment>&) noexcept {}
+
+        T* allocate(size_t n) {
+            if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{_Alignment}));
+        }
+
+        void deallocate(T* p, size_t) noexcept {
+            ::operator delete(p, std::align_val_t{_Alignment});
+        }
+
+        template <typename U>
+        constexpr bool operator==(const AlignedAllocator<U, _Alignment>&) const noexcept { return true; }
+
+        template <typename U>
+        constexpr bool operator!=(const AlignedAllocator<U, _Alignment>&) const noexcept { return false; }
+    };
+} /* MatrixLib */
+
+#endif /* ALIGNED_ALLOCATOR_H */
@@ -0,0 +1,480 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#include <coroutine>
+#define MATRIXLIB_HAS_COROUTINES 1
+#else
+#define MATRIXLIB_HAS_COROUTINES 0
+#endif
+
+#include "parallel.hpp"
+#include "decomposition.hpp"
+
+namespace MatrixLib {
+    /**
+     * @brief The pool that runs asynchronous jobs unless another one is given.
+     *
+     * It is separate from ThreadPool::global(), so asynchronous jobs never queue behind the parallel loops of
+     * the threads that submitted them, and it has at least one worker even on a single-core machine, so the
+     * submitting thread always returns before the job runs. Sized by MATRIXLIB_NUM_THREADS like the global
+     * pool and started on first use.
+     */
+    inline ThreadPool& async_executor() {
+        static ThreadPool pool(std::max<size_t>(2, ThreadPool::default_thread_count()));
+        return pool;
+    }
+
+    template <typename T>
+    class Future;
+
+namespace Detail {
+    /* Completion flag, error and continuations shared by a Future and the job that fulfils it */
+    struct FutureStateBase {
+        ThreadPool* pool;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::vector<std::function<void()>> continuations;
+        std::exception_ptr error;
+        std::atomic<bool> ready{false};
+
+        explicit FutureStateBase(ThreadPool& executor) : pool(&executor) {}
+
+        /* Runs f once the state is ready: immediately if it already is, otherwise on the completing thread */
+        void on_ready(std::function<void()> f) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ready.load(std::memory_order_relaxed)) {
+                    continuations.push_back(std::move(f));
+                    return;
+                }
+            }
+            f();
+        }
+
+        void finish(std::exception_ptr failure = nullptr) {
+            std::vector<std::function<void()>> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::move(failure);
+                ready.store(true, std::memory_order_release);
+                pending.swap(continuations);
+            }
+
+            done.notify_all();
+            for (auto& f : pending) f();
+        }
+
+        /* A worker of the pool keeps running queued jobs while it waits, since the one it waits for may be among them */
+        void wait() {
+            if (ready.load(std::memory_order_acquire)) return;
+
+            if (pool->is_worker()) {
+                while (!ready.load(std::memory_order_acquire)) {
+                    if (!pool->run_pending_task()) std::this_thread::yield();
+                }
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return ready.load(std::memory_order_relaxed); });
+        }
+    };
+
+    template <typename T>
+    struct FutureState : FutureStateBase {
+        using FutureStateBase::FutureStateBase;
+        std::optional<T> value;
+    };
+
+    template <>
+    struct FutureState<void> : FutureStateBase {
+        using FutureStateBase::FutureStateBase;
+    };
+
+    struct FutureAccess {
+        template <typename T>
+        static const std::shared_ptr<FutureState<T>>& state(const Future<T>& future) { return future.state_; }
+
+        template <typename T>
+        static Future<T> make(std::shared_ptr<FutureState<T>> state) { return Future<T>(std::move(state)); }
+    };
+
+#if MATRIXLIB_HAS_COROUTINES
+    template <typename T>
+    struct FuturePromiseBase {
+        std::shared_ptr<FutureState<T>> state = std::make_shared<FutureState<T>>(async_executor());
+        std::exception_ptr error;
+
+        Future<T> get_return_object() { return FutureAccess::make(state); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        /* Published only here, after the coroutine's locals are gone */
+        std::suspend_never final_suspend() noexcept {
+            state->finish(error);
+            return {};
+        }
+
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct FuturePromise : FuturePromiseBase<T> {
+        template <typename U>
+        void return_value(U&& value) { this->state->value.emplace(std::forward<U>(value)); }
+    };
+
+    template <>
+    struct FuturePromise<void> : FuturePromiseBase<void> {
+        void return_void() noexcept {}
+    };
+
+    /* Resumes the awaiting coroutine on the future's pool, not inside the job that completed it */
+    template <typename T>
+    struct FutureAwaiter {
+        Future<T> future;
+
+        bool await_ready() const noexcept { return future.ready(); }
+
+        void await_suspend(std::coroutine_handle<> handle) const {
+            ThreadPool* pool = FutureAccess::state(future)->pool;
+            FutureAccess::state(future)->on_ready([handle, pool] { pool->submit([handle] { handle.resume(); }); });
+        }
+
+        T await_resume() const {
+            if constexpr (std::is_void_v<T>) future.get();
+            else return future.get();
+        }
+    };
+#endif
+} /* Detail */
+
+    /**
+     * @brief Result of an asynchronous matrix job, shared between any number of holders.
+     *
+     * Unlike std::future, a Future can be passed straight to async_invoke(), async_multiply() or async_solve() as
+     * an operand: the new job is queued once its operands are ready, so chains of dependent operations form a
+     * graph that the pool schedules without any thread blocking on an intermediate result. If a job throws, the
+     * exception is stored, every job depending on it completes with the same exception without running, and
+     * get() rethrows it. With C++20 coroutines a Future can be co_awaited and returned from a coroutine.
+     *
+     * @tparam T The result type, or void.
+     */
+    template <typename T>
+    class Future {
+        friend struct Detail::FutureAccess;
+
+        std::shared_ptr<Detail::FutureState<T>> state_;
+
+        explicit Future(std::shared_ptr<Detail::FutureState<T>> state) : state_(std::move(state)) {}
+
+        /* The shared state, which an empty or moved-from future does not have */
+        Detail::FutureState<T>& state() const {
+            if (!state_) Utils::throw_runtime_error("Future has no shared state");
+            return *state_;
+        }
+
+    public:
+        using value_type = T;
+
+        /**
+         * @brief An empty future that refers to no job; valid() is false.
+         */
+        Future() = default;
+
+        /**
+         * @return Whether this future refers to a job.
+         */
+        bool valid() const noexcept { return static_cast<bool>(state_); }
+
+        /**
+         * @return Whether the job has finished, successfully or not. Never blocks.
+         * @throw std::runtime_error if the future is not valid().
+         */
+        bool ready() const { return state().ready.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Blocks until the job has finished. Called on a worker of the job's pool, runs other queued jobs
+         * in the meantime instead of blocking.
+         * @throw std::runtime_error if the future is not valid().
+         */
+        void wait() const { state().wait(); }
+
+        /**
+         * @brief Waits for the job.
+         * @return The result, which stays owned by the shared state (nothing for Future<void>).
+         * @throw std::runtime_error if the future is not valid().
+         * @throw Whatever the job, or a job it depends on, threw.
+         */
+        decltype(auto) get() const {
+            Detail::FutureState<T>& s = state();
+            s.wait();
+            if (s.error) std::rethrow_exception(s.error);
+            if constexpr (!std::is_void_v<T>) return static_cast<const T&>(*s.value);
+        }
+
+        /**
+         * @brief Queues f(result), or f() for Future<void>, to run on the job's pool once this one has finished.
+         * @return The future of the continuation.
+         * @throw std::runtime_error if the future is not valid().
+         */
+        template <typename F>
+        auto then(F&& f) const;
+
+#if MATRIXLIB_HAS_COROUTINES
+        using promise_type = Detail::FuturePromise<T>;
+
+        Detail::FutureAwaiter<T> operator co_await() const { return {*this}; }
+#endif
+    };
+
+namespace Detail {
+    template <typename T>
+    struct is_future : std::false_type {};
+
+    template <typename T>
+    struct is_future<Future<T>> : std::true_type {};
+
+    /*
+     * How a job keeps an argument until it runs: futures as they are, std::ref/std::cref wrappers as
+     * references, matrix expressions evaluated up front (they refer to their operands, which the caller may
+     * destroy before the job runs), and anything else by value
+     */
+    template <typename A, typename D = typename std::decay<A>::type, bool = OperandTraits<D>::is_operand>
+    struct AsyncStorage { using type = D; };
+
+    template <typename A, typename D>
+    struct AsyncStorage<A, D, true> { using type = plain_t<D>; };
+
+    template <typename A>
+    using async_storage_t = typename AsyncStorage<A>::type;
+
+    template <typename T>
+    const T& async_unwrap(const Future<T>& future) { return *FutureAccess::state(future)->value; }
+
+    /* A Future<void> only orders jobs, so the job receives the (finished) future itself */
+    inline const Future<void>& async_unwrap(const Future<void>& future) { return future; }
+
+    template <typename T>
+    T& async_unwrap(const std::reference_wrapper<T>& ref) { return ref.get(); }
+
+    template <typename T>
+    struct is_reference_wrapper : std::false_type {};
+
+    template <typename T>
+    struct is_reference_wrapper<std::reference_wrapper<T>> : std::true_type {};
+
+    template <typename T, typename std::enable_if<!is_future<T>::value && !is_reference_wrapper<T>::value, int>::type = 0>
+    T& async_unwrap(T& value) { return value; }
+
+    template <typename T>
+    std::exception_ptr async_error(const Future<T>& future) { return FutureAccess::state(future)->error; }
+
+    template <typename T>
+    std::exception_ptr async_error(const T&) { return nullptr; }
+
+    template <typename T>
+    void async_on_ready(const Future<T>& future, std::function<void()> f) { FutureAccess::state(future)->on_ready(std::move(f)); }
+
+    template <typename T>
+    void async_on_ready(const T&, const std::function<void()>&) {}
+
+    template <typename T>
+    constexpr size_t async_dependency_count() { return is_future<T>::value ? 1 : 0; }
+
+    /* The type a job stores as its result: like async_storage_t, so returning an expression is safe */
+    template <typename F, typename... Stored>
+    using async_result_t = async_storage_t<std::invoke_result_t<F&, decltype(async_unwrap(std::declval<Stored&>()))...>>;
+
+    template <typename R, typename F, typename... Stored>
+    struct AsyncJob {
+        std::shared_ptr<FutureState<R>> state;
+        F function;
+        std::tuple<Stored...> args;
+        std::atomic<size_t> waiting;
+
+        template <typename G, typename... A>
+        AsyncJob(std::shared_ptr<FutureState<R>> s, G&& f, A&&... a)
+            : state(std::move(s)), function(std::forward<G>(f)), args(std::forward<A>(a)...),
+              waiting(1 + (async_dependency_count<Stored>() + ... + 0)) {}
+
+        void run() {
+            std::exception_ptr failure = std::apply([](const auto&... a) {
+                std::exception_ptr first;
+                ((first = first ? first : async_error(a)), ...);
+                return first;
+            }, args);
+
+            if (!failure) {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        std::apply([this](auto&... a) { std::invoke(function, async_unwrap(a)...); }, args);
+                    } else {
+                        state->value.emplace(std::apply([this](auto&... a) { return R(std::invoke(function, async_unwrap(a)...)); }, args));
+                    }
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+            }
+
+            state->finish(std::move(failure));
+        }
+    };
+
+    /* The matrix type behind an operand that may be a Future or a std::ref wrapper */
+    template <typename T>
+    struct AsyncValue { using type = T; };
+
+    template <typename T>
+    struct AsyncValue<Future<T>> { using type = T; };
+
+    template <typename T>
+    struct AsyncValue<std::reference_wrapper<T>> { using type = typename std::remove_const<T>::type; };
+
+    template <typename T>
+    using async_value_t = typename AsyncValue<typename std::decay<T>::type>::type;
+
+    template <typename L, typename R>
+    using enable_if_async_operands = enable_if_operands<async_value_t<L>, async_value_t<R>>;
+} /* Detail */
+
+    /**
+     * @brief Queues f(args...) on a pool and returns at once.
+     *
+     * Arguments that are Futures are dependencies: the job is queued once all of them are ready and f receives
+     * their results by const reference (a Future<void>, which carries no result, is passed as itself). Other arguments are copied into the job (wrap them in std::ref or
+     * std::cref to pass a reference instead), and matrix expressions are evaluated first. A result that is an
+     * expression is evaluated before it is stored.
+     *
+     * @return The future of f's result.
+     */
+    template <typename F, typename... Args>
+    auto async_invoke(ThreadPool& pool, F&& f, Args&&... args) {
+        using Function = typename std::decay<F>::type;
+        using Result = Detail::async_result_t<Function, Detail::async_storage_t<Args>...>;
+        using Job = Detail::AsyncJob<Result, Function, Detail::async_storage_t<Args>...>;
+
+        auto state = std::make_shared<Detail::FutureState<Result>>(pool);
+        auto job = std::make_shared<Job>(state, std::forward<F>(f), std::forward<Args>(args)...);
+
+        /* One count per dependency plus one for this thread, so the job cannot start while it is being wired up */
+        std::function<void()> arrive = [job, executor = &pool] {
+            if (job->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) executor->submit([job] { job->run(); });
+        };
+        std::apply([&arrive](const auto&... a) { (Detail::async_on_ready(a, arrive), ...); }, job->args);
+        arrive();
+
+        return Detail::FutureAccess::make(std::move(state));
+    }
+
+    /**
+     * @brief Queues f(args...) on async_executor().
+     */
+    template <typename F, typename... Args, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, ThreadPool>::value>::type>
+    auto async_invoke(F&& f, Args&&... args) {
+        return async_invoke(async_executor(), std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    template <typename F>
+    auto Future<T>::then(F&& f) const {
+        ThreadPool& pool = *state().pool;
+        if constexpr (std::is_void_v<T>) {
+            return async_invoke(pool, [g = typename std::decay<F>::type(std::forward<F>(f))](const Future<void>&) mutable { return g(); }, *this);
+        } else {
+            return async_invoke(pool, std::forward<F>(f), *this);
+        }
+    }
+
+    /**
+     * @brief Queues the product lhs * rhs on a pool. Either operand may be a Future of a matrix.
+     *
+     * The product itself runs as multiply(Execution::par.on(pool), ...), so a large product is also split into
+     * tiles that idle workers pick up, while small independent products run side by side.
+     *
+     * @return The future of the product, as the same matrix type `lhs * rhs` evaluates to.
+     * @throw std::invalid_argument from get() if runtime-sized operands have mismatched inner dimensions.
+     */
+    template <typename L, typename R, Detail::enable_if_async_operands<L, R> = 0>
+    auto async_multiply(ThreadPool& pool, L&& lhs, R&& rhs) {
+        return async_invoke(pool, [executor = &pool](const auto& a, const auto& b) { return multiply(Execution::par.on(*executor), a, b); },
+                            std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+
+    /**
+     * @brief Queues the product lhs * rhs on async_executor().
+     */
+    template <typename L, typename R, Detail::enable_if_async_operands<L, R> = 0>
+    auto async_multiply(L&& lhs, R&& rhs) {
+        return async_multiply(async_executor(), std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+
+    /**
+     * @brief Queues the solution of A X = B on a pool. Either operand may be a Future of a matrix.
+     * @return The future of X.
+     * @throw std::invalid_argument or std::runtime_error from get(), as solve() would throw them.
+     */
+    template <typename A, typename B, Detail::enable_if_async_operands<A, B> = 0>
+    auto async_solve(ThreadPool& pool, A&& a, B&& b) {
+        return async_invoke(pool, [](const auto& lhs, const auto& rhs) { return solve(lhs, rhs); }, std::forward<A>(a), std::forward<B>(b));
+    }
+
+    /**
+     * @brief Queues the solution of A X = B on async_executor().
+     */
+    template <typename A, typename B, Detail::enable_if_async_operands<A, B> = 0>
+    auto async_solve(A&& a, B&& b) {
+        return async_solve(async_executor(), std::forward<A>(a), std::forward<B>(b));
+    }
+
+    /**
+     * @brief A future that is ready once every future in the list is.
+     *
+     * It completes with the exception of the first failed future in the list, if any; the results themselves
+     * stay in the given futures.
+     */
+    template <typename T>
+    Future<void> when_all(const std::vector<Future<T>>& futures) {
+        struct Join {
+            std::vector<Future<T>> futures;
+            std::atomic<size_t> waiting;
+            std::shared_ptr<Detail::FutureState<void>> state;
+        };
+
+        ThreadPool& pool = futures.empty() ? async_executor() : *Detail::FutureAccess::state(futures.front())->pool;
+        auto join = std::make_shared<Join>();
+        join->futures = futures;
+        join->waiting.store(futures.size() + 1);
+        join->state = std::make_shared<Detail::FutureState<void>>(pool);
+
+        std::function<void()> arrive = [join] {
+            if (join->waiting.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+            std::exception_ptr failure;
+            for (const auto& f : join->futures) {
+                if (!failure) failure = Detail::async_error(f);
+            }
+            join->state->finish(std::move(failure));
+        };
+        for (const auto& f : futures) Detail::async_on_ready(f, arrive);
+        arrive();
+
+        return Detail::FutureAccess::make(join->state);
+    }
+} /* MatrixLib */
+
+#endif /* ASYNC_H */
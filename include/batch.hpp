@@ -0,0 +1,339 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "matrixLib.hpp"
+#include "alignedAllocator.h"
+
+namespace MatrixLib {
+namespace Detail {
+    template <typename F, size_t... I>
+    constexpr void static_for_impl(F&& f, std::index_sequence<I...>) {
+        (f(std::integral_constant<size_t, I>{}), ...);
+    }
+
+    /* Calls f(integral_constant<size_t, I>) for I in [0, N), fully unrolled */
+    template <size_t N, typename F>
+    constexpr void static_for(F&& f) {
+        static_for_impl(f, std::make_index_sequence<N>{});
+    }
+
+    /* Instances per block of a MatrixBatch: one cache line of each element */
+    template <typename T>
+    constexpr size_t batch_lanes = std::max<size_t>(1, MATRIXLIB_DEFAULT_ALIGNMENT / sizeof(T));
+
+    /* One block of a batch operand: element e of lane w lives at p[e * W + w] */
+    template <typename T, size_t W>
+    struct BlockOperand {
+        const T* p;
+
+        T operator()(size_t e, size_t w) const { return p[e * W + w]; }
+    };
+
+    /* A single matrix applied to every lane of the block */
+    template <typename T>
+    struct BroadcastOperand {
+        const T* p;
+
+        T operator()(size_t e, size_t) const { return p[e]; }
+    };
+
+    /*
+     * c = a * b for the W instances of one block. The loop runs across instances, so each SIMD lane computes a
+     * different product, and its body is unrolled at compile time: every operand element is loaded once and all
+     * offsets are constants, so a whole block needs a single base pointer per operand.
+     */
+    template <typename T, size_t M, size_t K, size_t N, size_t W, typename A, typename B>
+    void batch_gemm_block(const A& a, const B& b, T* MATRIXLIB_RESTRICT c) {
+        MATRIXLIB_IVDEP
+        for (size_t w = 0; w < W; ++w) {
+            T av[M * K];
+            T bv[K * N];
+            static_for<M * K>([&](auto e) { av[e] = a(e, w); });
+            static_for<K * N>([&](auto e) { bv[e] = b(e, w); });
+
+            static_for<M>([&](auto i) {
+                static_for<N>([&](auto j) {
+                    T acc = av[i * K] * bv[j];
+                    static_for<K - 1>([&](auto k) { acc += av[i * K + k + 1] * bv[(k + 1) * N + j]; });
+                    c[(i * N + j) * W + w] = acc;
+                });
+            });
+        }
+    }
+
+    template <typename T, typename F>
+    void flat_zip(const T* a, const T* b, T* out, size_t n, F f) {
+        MATRIXLIB_IVDEP
+        for (size_t i = 0; i < n; ++i) out[i] = f(a[i], b[i]);
+    }
+} /* Detail */
+
+    /**
+     * @brief A batch of same-shaped matrices stored as structure of arrays.
+     *
+     * Instances are grouped into blocks of `lanes` (one cache line per element). Inside a block each element is a
+     * contiguous run holding that element for every instance of the block, so the batched kernels vectorise across
+     * instances with every load aligned. Unused lanes of the last block are kept at zero.
+     *
+     * @tparam _Scalar The scalar type of the matrix elements. Must be a numeric type.
+     * @tparam _RowCount The number of rows of every matrix in the batch.
+     * @tparam _ColCount The number of columns of every matrix in the batch.
+     */
+    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
+    class MatrixBatch {
+        static_assert(std::is_arithmetic<_Scalar>::value, "Matrix element type must be numeric");
+
+    public:
+        using Scalar = _Scalar;
+        using MatrixType = Matrix<_Scalar, _RowCount, _ColCount>;
+
+        /** @brief Instances per block. */
+        static constexpr size_t lanes = Detail::batch_lanes<_Scalar>;
+
+        /** @brief Elements per block. */
+        static constexpr size_t block_size = _RowCount * _ColCount * lanes;
+
+    private:
+        size_t size_;
+        std::vector<_Scalar, AlignedAllocator<_Scalar>> data_;
+
+        static size_t block_count(size_t count) { return (count + lanes - 1) / lanes; }
+
+        size_t offset(size_t index, size_t element) const noexcept {
+            return (index / lanes) * block_size + element * lanes + index % lanes;
+        }
+
+    public:
+        /**
+         * @brief Constructs a batch of count zero matrices.
+         */
+        explicit MatrixBatch(size_t count = 0) : size_(count), data_(block_count(count) * block_size) {}
+
+        /**
+         * @brief Constructs a batch from a contiguous array of matrices.
+         */
+        MatrixBatch(const MatrixType* matrices, size_t count) : MatrixBatch(count) {
+            for (size_t l = 0; l < count; ++l) set(l, matrices[l]);
+        }
+
+        /**
+         * @return The number of matrices in the batch.
+         */
+        size_t size() const noexcept { return size_; }
+
+        /**
+         * @return The number of blocks of `lanes` matrices.
+         */
+        size_t blocks() const noexcept { return block_count(size_); }
+
+        /**
+         * @brief Changes the number of matrices. All matrices are reset to zero.
+         */
+        void resize(size_t count) {
+            size_ = count;
+            data_.assign(block_count(count) * block_size, _Scalar{});
+        }
+
+        /**
+         * @return A pointer to the first block; element e of instance l is at
+         * data()[(l / lanes) * block_size + e * lanes + l % lanes].
+         */
+        _Scalar* data() noexcept { return data_.data(); }
+
+        /**
+         * @return A pointer to the first block.
+         */
+        const _Scalar* data() const noexcept { return data_.data(); }
+
+        /**
+         * Access element (i, j) of matrix index. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @throw std::out_of_range if any index is out of bounds.
+         */
+        _Scalar& operator()(size_t index, size_t i, size_t j) {
+            check_index(index, i, j);
+            return data_[offset(index, i * _ColCount + j)];
+        }
+
+        /**
+         * Access element (i, j) of matrix index. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @throw std::out_of_range if any index is out of bounds.
+         */
+        const _Scalar& operator()(size_t index, size_t i, size_t j) const {
+            check_index(index, i, j);
+            return data_[offset(index, i * _ColCount + j)];
+        }
+
+        /**
+         * @brief Copies matrix index out of the batch.
+         * @throw std::out_of_range if index >= size().
+         */
+        MatrixType get(size_t index) const {
+            check_index(index, 0, 0);
+
+            MatrixType ret;
+            _Scalar* dst = Detail::MatrixAccess::data(ret);
+            for (size_t e = 0; e < _RowCount * _ColCount; ++e) dst[e] = data_[offset(index, e)];
+            return ret;
+        }
+
+        /**
+         * @brief Overwrites matrix index of the batch.
+         * @throw std::out_of_range if index >= size().
+         */
+        void set(size_t index, const MatrixType& matrix) {
+            check_index(index, 0, 0);
+
+            const _Scalar* src = Detail::MatrixAccess::data(matrix);
+            for (size_t e = 0; e < _RowCount * _ColCount; ++e) data_[offset(index, e)] = src[e];
+        }
+
+        /**
+         * @brief Copies every matrix of the batch into a contiguous array of size() matrices.
+         */
+        void store(MatrixType* out) const {
+            for (size_t l = 0; l < size_; ++l) out[l] = get(l);
+        }
+
+        /**
+         * Add the matching matrices of another batch of the same size to this one.
+         * @throw std::invalid_argument if the batch sizes differ.
+         */
+        MatrixBatch& operator+=(const MatrixBatch& other) {
+            check_same_size(other, "addition");
+            Kernels::add_inplace(data_.data(), other.data_.data(), data_.size());
+            return *this;
+        }
+
+        /**
+         * Subtract the matching matrices of another batch of the same size from this one.
+         * @throw std::invalid_argument if the batch sizes differ.
+         */
+        MatrixBatch& operator-=(const MatrixBatch& other) {
+            check_same_size(other, "subtraction");
+            Kernels::sub_inplace(data_.data(), other.data_.data(), data_.size());
+            return *this;
+        }
+
+        /**
+         * Multiply every matrix of the batch by a scalar value.
+         */
+        MatrixBatch& operator*=(const _Scalar& val) {
+            Kernels::scale_inplace(data_.data(), val, data_.size());
+            return *this;
+        }
+
+    private:
+        void check_index(size_t index, size_t i, size_t j) const {
+            MATRIXLIB_CHECK_INDEX(index < size_, "Index %zu is out of bounds", index);
+            MATRIXLIB_CHECK_INDEX(i < _RowCount, "Index outer %zu is out of bounds", i);
+            MATRIXLIB_CHECK_INDEX(j < _ColCount, "index inner %zu is out of bounds", j);
+        }
+
+        void check_same_size(const MatrixBatch& other, const char* operation) const {
+            if (other.size_ != size_) {
+                Utils::throw_invalid_argument_error("Batch %s requires equal sizes, got %zu and %zu", operation, size_, other.size_);
+            }
+        }
+    };
+
+namespace Batch {
+    /**
+     * Multiply the matching matrices of two batches: out[l] = lhs[l] * rhs[l]. out is resized to match.
+     * @throw std::invalid_argument if the batch sizes differ.
+     */
+    template <typename T, size_t M, size_t K, size_t N>
+    void multiply(const MatrixBatch<T, M, K>& lhs, const MatrixBatch<T, K, N>& rhs, MatrixBatch<T, M, N>& out) {
+        constexpr size_t W = Detail::batch_lanes<T>;
+
+        if (lhs.size() != rhs.size()) {
+            Utils::throw_invalid_argument_error("Batch multiplication requires equal sizes, got %zu and %zu", lhs.size(), rhs.size());
+        }
+
+        if (out.size() != lhs.size()) out.resize(lhs.size());
+        for (size_t blk = 0; blk < lhs.blocks(); ++blk) {
+            Detail::batch_gemm_block<T, M, K, N, W>(Detail::BlockOperand<T, W>{lhs.data() + blk * MatrixBatch<T, M, K>::block_size},
+                                                    Detail::BlockOperand<T, W>{rhs.data() + blk * MatrixBatch<T, K, N>::block_size},
+                                                    out.data() + blk * MatrixBatch<T, M, N>::block_size);
+        }
+    }
+
+    /**
+     * Apply one matrix to every matrix of a batch: out[l] = lhs * rhs[l]. With N = 1 this transforms a batch of
+     * column vectors. out is resized to match.
+     */
+    template <typename T, size_t M, size_t K, size_t N>
+    void multiply(const Matrix<T, M, K>& lhs, const MatrixBatch<T, K, N>& rhs, MatrixBatch<T, M, N>& out) {
+        constexpr size_t W = Detail::batch_lanes<T>;
+
+        if (out.size() != rhs.size()) out.resize(rhs.size());
+        for (size_t blk = 0; blk < rhs.blocks(); ++blk) {
+            Detail::batch_gemm_block<T, M, K, N, W>(Detail::BroadcastOperand<T>{Detail::MatrixAccess::data(lhs)},
+                                                    Detail::BlockOperand<T, W>{rhs.data() + blk * MatrixBatch<T, K, N>::block_size},
+                                                    out.data() + blk * MatrixBatch<T, M, N>::block_size);
+        }
+    }
+
+    /**
+     * Multiply count pairs of matrices stored as contiguous arrays: out[l] = lhs[l] * rhs[l], with the product of
+     * every instance fully unrolled at compile time. Keeping hot data in a MatrixBatch is faster still, since the
+     * instances are then processed side by side in SIMD lanes.
+     * out must not overlap lhs or rhs.
+     */
+    template <typename T, size_t M, size_t K, size_t N>
+    void multiply(const Matrix<T, M, K>* lhs, const Matrix<T, K, N>* rhs, Matrix<T, M, N>* out, size_t count) {
+        for (size_t l = 0; l < count; ++l) {
+            Detail::batch_gemm_block<T, M, K, N, 1>(Detail::BlockOperand<T, 1>{Detail::MatrixAccess::data(lhs[l])},
+                                                    Detail::BlockOperand<T, 1>{Detail::MatrixAccess::data(rhs[l])},
+                                                    Detail::MatrixAccess::data(out[l]));
+        }
+    }
+
+    /**
+     * Apply one matrix to count matrices stored as a contiguous array: out[l] = lhs * rhs[l].
+     * out must not overlap rhs.
+     */
+    template <typename T, size_t M, size_t K, size_t N>
+    void multiply(const Matrix<T, M, K>& lhs, const Matrix<T, K, N>* rhs, Matrix<T, M, N>* out, size_t count) {
+        const T* a = Detail::MatrixAccess::data(lhs);
+        for (size_t l = 0; l < count; ++l) {
+            Detail::batch_gemm_block<T, M, K, N, 1>(Detail::BroadcastOperand<T>{a}, Detail::BlockOperand<T, 1>{Detail::MatrixAccess::data(rhs[l])},
+                                                    Detail::MatrixAccess::data(out[l]));
+        }
+    }
+
+    /**
+     * Add count pairs of matrices stored as contiguous arrays: out[l] = lhs[l] + rhs[l]. out may alias either input.
+     */
+    template <typename T, size_t R, size_t C>
+    void add(const Matrix<T, R, C>* lhs, const Matrix<T, R, C>* rhs, Matrix<T, R, C>* out, size_t count) {
+        if (count == 0) return;
+        Detail::flat_zip(Detail::MatrixAccess::data(lhs[0]), Detail::MatrixAccess::data(rhs[0]), Detail::MatrixAccess::data(out[0]),
+                         count * R * C, [](T x, T y) { return static_cast<T>(x + y); });
+    }
+
+    /**
+     * Subtract count pairs of matrices stored as contiguous arrays: out[l] = lhs[l] - rhs[l]. out may alias either input.
+     */
+    template <typename T, size_t R, size_t C>
+    void subtract(const Matrix<T, R, C>* lhs, const Matrix<T, R, C>* rhs, Matrix<T, R, C>* out, size_t count) {
+        if (count == 0) return;
+        Detail::flat_zip(Detail::MatrixAccess::data(lhs[0]), Detail::MatrixAccess::data(rhs[0]), Detail::MatrixAccess::data(out[0]),
+                         count * R * C, [](T x, T y) { return static_cast<T>(x - y); });
+    }
+
+    /**
+     * Multiply count matrices stored as a contiguous array by a scalar value, in place.
+     */
+    template <typename T, size_t R, size_t C>
+    void scale(Matrix<T, R, C>* matrices, const T& val, size_t count) {
+        if (count == 0) return;
+        Kernels::scale_inplace(Detail::MatrixAccess::data(matrices[0]), val, count * R * C);
+    }
+} /* Batch */
+} /* MatrixLib */
+
+#endif /* BATCH_H */
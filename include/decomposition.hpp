@@ -0,0 +1,898 @@
+#ifndef DECOMPOSITION_H
+#define DECOMPOSITION_H
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+
+/* Width of the column panels that the blocked factorisations handle without level-3 updates */
+#ifndef MATRIXLIB_FACTOR_BLOCK
+#define MATRIXLIB_FACTOR_BLOCK 64
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+    /**
+     * Solves T X = B in place for an n x n triangular T, addressed with strides rst and cst, and a row-major
+     * n x nrhs B with row stride ldb. Only the triangle selected by lower is read. Rows are solved in blocks of
+     * MATRIXLIB_FACTOR_BLOCK, and the update of a block from the rows already solved is a single GEMM, so many
+     * right-hand sides run at GEMM speed.
+     */
+    template <typename T>
+    void trsm(bool lower, bool unitDiagonal, size_t n, size_t nrhs,
+              const T* t, ptrdiff_t rst, ptrdiff_t cst, T* b, ptrdiff_t ldb) {
+        const size_t nbMax = MATRIXLIB_FACTOR_BLOCK;
+
+        /* Solves rows [i0, i1) against each other, once the contribution of every other solved row is removed */
+        auto solveBlock = [&](size_t i0, size_t i1) {
+            for (size_t step = 0; step < i1 - i0; ++step) {
+                const size_t i = lower ? i0 + step : i1 - 1 - step;
+                T* bi = b + i * ldb;
+
+                const size_t p0 = lower ? i0 : i + 1;
+                const size_t p1 = lower ? i : i1;
+                for (size_t p = p0; p < p1; ++p) {
+                    const T tip = t[i * rst + p * cst];
+                    const T* bp = b + p * ldb;
+                    for (size_t j = 0; j < nrhs; ++j) bi[j] -= tip * bp[j];
+                }
+
+                if (!unitDiagonal) {
+                    const T inv = T(1) / t[i * rst + i * cst];
+                    for (size_t j = 0; j < nrhs; ++j) bi[j] *= inv;
+                }
+            }
+        };
+
+        if (lower) {
+            for (size_t i0 = 0; i0 < n; i0 += nbMax) {
+                const size_t ib = std::min(nbMax, n - i0);
+                if (i0 > 0) {
+                    gemm<T>(ib, nrhs, i0, T(-1), t + i0 * rst, rst, cst, b, ldb, 1, T(1), b + i0 * ldb, ldb, 1);
+                }
+                solveBlock(i0, i0 + ib);
+            }
+        } else {
+            for (size_t i1 = n; i1 > 0;) {
+                const size_t ib = std::min(nbMax, i1);
+                const size_t i0 = i1 - ib;
+                if (i1 < n) {
+                    gemm<T>(ib, nrhs, n - i1, T(-1), t + i0 * rst + i1 * cst, rst, cst, b + i1 * ldb, ldb, 1,
+                            T(1), b + i0 * ldb, ldb, 1);
+                }
+                solveBlock(i0, i1);
+                i1 = i0;
+            }
+        }
+    }
+
+    /**
+     * Blocked right-looking LU factorisation with partial pivoting, P A = L U, of the row-major n x n matrix a
+     * with row stride lda. a is overwritten by the unit lower triangular L below the diagonal and by U on and
+     * above it; row i was swapped with row piv[i]. Each panel of MATRIXLIB_FACTOR_BLOCK columns is factorised in
+     * place and the trailing matrix is then updated with a single GEMM.
+     *
+     * @return n if A is nonsingular, otherwise the column of the first exactly zero pivot. The factorisation is
+     * completed either way.
+     */
+    template <typename T>
+    size_t lu_factor(size_t n, T* a, ptrdiff_t lda, size_t* piv) {
+        const size_t nbMax = MATRIXLIB_FACTOR_BLOCK;
+        size_t singular = n;
+
+        for (size_t k0 = 0; k0 < n; k0 += nbMax) {
+            const size_t k1 = k0 + std::min(nbMax, n - k0);
+
+            for (size_t j = k0; j < k1; ++j) {
+                size_t p = j;
+                T maxAbs = std::abs(a[j * lda + j]);
+                for (size_t i = j + 1; i < n; ++i) {
+                    const T v = std::abs(a[i * lda + j]);
+                    if (v > maxAbs) {
+                        maxAbs = v;
+                        p = i;
+                    }
+                }
+
+                piv[j] = p;
+                if (p != j) std::swap_ranges(a + j * lda, a + j * lda + n, a + p * lda);
+
+                if (maxAbs == T(0)) {
+                    if (singular == n) singular = j;
+                    continue;
+                }
+
+                /* Rank-1 update restricted to the panel; columns right of it wait for the GEMM below */
+                const T* pivotRow = a + j * lda;
+                const T inv = T(1) / pivotRow[j];
+                for (size_t i = j + 1; i < n; ++i) {
+                    T* row = a + i * lda;
+                    row[j] *= inv;
+                    const T l = row[j];
+                    for (size_t c = j + 1; c < k1; ++c) row[c] -= l * pivotRow[c];
+                }
+            }
+
+            if (k1 < n) {
+                /* U12 = L11^-1 A12, then A22 -= L21 U12 */
+                trsm<T>(true, true, k1 - k0, n - k1, a + k0 * lda + k0, lda, 1, a + k0 * lda + k1, lda);
+                gemm<T>(n - k1, n - k1, k1 - k0, T(-1), a + k1 * lda + k0, lda, 1, a + k0 * lda + k1, lda, 1,
+                        T(1), a + k1 * lda + k1, lda, 1);
+            }
+        }
+
+        return singular;
+    }
+
+    /**
+     * Solves A X = B in place for the n x nrhs row-major B, given the factors and pivots from lu_factor.
+     */
+    template <typename T>
+    void lu_solve(size_t n, size_t nrhs, const T* lu, ptrdiff_t lda, const size_t* piv, T* b, ptrdiff_t ldb) {
+        for (size_t i = 0; i < n; ++i) {
+            if (piv[i] != i) std::swap_ranges(b + i * ldb, b + i * ldb + nrhs, b + piv[i] * ldb);
+        }
+
+        trsm<T>(true, true, n, nrhs, lu, lda, 1, b, ldb);
+        trsm<T>(false, false, n, nrhs, lu, lda, 1, b, ldb);
+    }
+
+    /**
+     * Blocked right-looking Cholesky factorisation A = L L^T of the symmetric positive definite, row-major
+     * n x n matrix a. Only the lower triangle of A is read and it is overwritten by L; the strict upper triangle
+     * is left with scratch values. The trailing update of every panel runs as one GEMM per block column, which
+     * touches the lower triangle and the diagonal blocks only.
+     *
+     * @return n on success, otherwise the column at which A was found not to be positive definite.
+     */
+    template <typename T>
+    size_t cholesky_factor(size_t n, T* a, ptrdiff_t lda) {
+        const size_t nbMax = MATRIXLIB_FACTOR_BLOCK;
+
+        for (size_t k0 = 0; k0 < n; k0 += nbMax) {
+            const size_t k1 = k0 + std::min(nbMax, n - k0);
+
+            for (size_t j = k0; j < k1; ++j) {
+                T* rowJ = a + j * lda;
+
+                T d = rowJ[j];
+                for (size_t p = k0; p < j; ++p) d -= rowJ[p] * rowJ[p];
+                if (!(d > T(0))) return j;
+
+                rowJ[j] = std::sqrt(d);
+                const T inv = T(1) / rowJ[j];
+                for (size_t i = j + 1; i < k1; ++i) {
+                    T* rowI = a + i * lda;
+                    T s = rowI[j];
+                    for (size_t p = k0; p < j; ++p) s -= rowI[p] * rowJ[p];
+                    rowI[j] = s * inv;
+                }
+            }
+
+            if (k1 < n) {
+                /* L21 = A21 L11^-T, a forward substitution along each row */
+                for (size_t i = k1; i < n; ++i) {
+                    T* rowI = a + i * lda;
+                    for (size_t j = k0; j < k1; ++j) {
+                        const T* rowJ = a + j * lda;
+                        T s = rowI[j];
+                        for (size_t p = k0; p < j; ++p) s -= rowI[p] * rowJ[p];
+                        rowI[j] = s / rowJ[j];
+                    }
+                }
+
+                /* A22 -= L21 L21^T, where L21^T is L21 read with swapped strides */
+                for (size_t j0 = k1; j0 < n; j0 += nbMax) {
+                    const size_t jb = std::min(nbMax, n - j0);
+                    gemm<T>(n - j0, jb, k1 - k0, T(-1), a + j0 * lda + k0, lda, 1, a + j0 * lda + k0, 1, lda,
+                            T(1), a + j0 * lda + j0, lda, 1);
+                }
+            }
+        }
+
+        return n;
+    }
+
+    /**
+     * Householder QR factorisation A = Q R of the row-major m x n matrix a, m >= n. R overwrites the upper
+     * triangle. Reflector j is H_j = I - tau[j] v v^T, with v(j) = 1 implied and v(j + 1 .. m) stored below the
+     * diagonal of column j. Reflectors are applied to the trailing columns one row at a time, so every inner loop
+     * runs over contiguous memory. work must hold n elements.
+     */
+    template <typename T>
+    void qr_factor(size_t m, size_t n, T* a, ptrdiff_t lda, T* tau, T* work) {
+        for (size_t j = 0; j < n; ++j) {
+            T* rowJ = a + j * lda;
+            const T alpha = rowJ[j];
+
+            /* The column norm is accumulated scaled by its largest entry so that it cannot overflow */
+            T maxAbs = std::abs(alpha);
+            for (size_t i = j + 1; i < m; ++i) maxAbs = std::max(maxAbs, std::abs(a[i * lda + j]));
+
+            T tail = 0;
+            if (maxAbs > T(0)) {
+                for (size_t i = j + 1; i < m; ++i) {
+                    const T x = a[i * lda + j] / maxAbs;
+                    tail += x * x;
+                }
+            }
+
+            if (tail == T(0)) {
+                tau[j] = T(0);
+                continue;
+            }
+
+            const T scaledAlpha = alpha / maxAbs;
+            const T norm = maxAbs * std::sqrt(scaledAlpha * scaledAlpha + tail);
+            const T beta = alpha >= T(0) ? -norm : norm;
+            tau[j] = (beta - alpha) / beta;
+
+            const T inv = T(1) / (alpha - beta);
+            for (size_t i = j + 1; i < m; ++i) a[i * lda + j] *= inv;
+            rowJ[j] = beta;
+
+            /* work = v^T A(j:m, j+1:n), then A(j:m, j+1:n) -= tau v work */
+            const size_t nt = n - j - 1;
+            std::copy(rowJ + j + 1, rowJ + n, work);
+            for (size_t i = j + 1; i < m; ++i) {
+                const T v = a[i * lda + j];
+                const T* row = a + i * lda + j + 1;
+                for (size_t c = 0; c < nt; ++c) work[c] += v * row[c];
+            }
+
+            for (size_t c = 0; c < nt; ++c) {
+                work[c] *= tau[j];
+                rowJ[j + 1 + c] -= work[c];
+            }
+
+            for (size_t i = j + 1; i < m; ++i) {
+                const T v = a[i * lda + j];
+                T* row = a + i * lda + j + 1;
+                for (size_t c = 0; c < nt; ++c) row[c] -= v * work[c];
+            }
+        }
+    }
+
+    /**
+     * Multiplies the row-major m x nrhs matrix B in place by Q^T (transpose) or Q, using the reflectors stored
+     * by qr_factor. work must hold nrhs elements.
+     */
+    template <typename T>
+    void qr_apply(bool transpose, size_t m, size_t n, const T* qr, ptrdiff_t lda, const T* tau,
+                  size_t nrhs, T* b, ptrdiff_t ldb, T* work) {
+        for (size_t step = 0; step < n; ++step) {
+            const size_t j = transpose ? step : n - 1 - step;
+            if (tau[j] == T(0)) continue;
+
+            T* bj = b + j * ldb;
+            std::copy(bj, bj + nrhs, work);
+            for (size_t i = j + 1; i < m; ++i) {
+                const T v = qr[i * lda + j];
+                const T* bi = b + i * ldb;
+                for (size_t c = 0; c < nrhs; ++c) work[c] += v * bi[c];
+            }
+
+            for (size_t c = 0; c < nrhs; ++c) {
+                work[c] *= tau[j];
+                bj[c] -= work[c];
+            }
+
+            for (size_t i = j + 1; i < m; ++i) {
+                const T v = qr[i * lda + j];
+                T* bi = b + i * ldb;
+                for (size_t c = 0; c < nrhs; ++c) bi[c] -= v * work[c];
+            }
+        }
+    }
+} /* Kernels */
+
+namespace Detail {
+    /* Per-factorisation vectors (pivots, reflector scales) stored inline when their length is known at compile time */
+    template <typename T, size_t N>
+    struct FactorBuffer {
+        std::array<T, N> values{};
+
+        void resize(size_t) {}
+        T* data() noexcept { return values.data(); }
+        const T* data() const noexcept { return values.data(); }
+    };
+
+    template <typename T>
+    struct FactorBuffer<T, Dynamic> {
+        std::vector<T> values;
+
+        void resize(size_t n) { values.resize(n); }
+        T* data() noexcept { return values.data(); }
+        const T* data() const noexcept { return values.data(); }
+    };
+
+    template <typename M>
+    M make_identity(size_t n) {
+        using Traits = OperandTraits<M>;
+
+        M ret;
+        Traits::resize(ret, n, n);
+        std::fill(Traits::data(ret), Traits::data(ret) + n * n, typename Traits::Scalar(0));
+        for (size_t i = 0; i < n; ++i) Traits::at(ret, i, i) = typename Traits::Scalar(1);
+        return ret;
+    }
+
+    /* Checks what every factorisation requires of the matrix type it is instantiated with */
+    template <typename M>
+    struct FactorTraits : OperandTraits<M> {
+        static_assert(OperandTraits<M>::is_leaf, "Decompositions operate on a Matrix or a DynMatrix");
+        static_assert(OperandTraits<M>::has_linear_access, "Decompositions store their factors in packed row-major matrices");
+        static_assert(std::is_floating_point<typename OperandTraits<M>::Scalar>::value,
+                      "Decompositions require a floating-point element type");
+    };
+
+    template <typename M, typename B>
+    void check_rhs(size_t rows, const B& b) {
+        static_assert(std::is_same<typename OperandTraits<M>::Scalar, typename OperandTraits<B>::Scalar>::value,
+                      "The right-hand side must have the same scalar type as the matrix");
+
+        if (OperandTraits<B>::rows(b) != rows) {
+            Utils::throw_invalid_argument_error("Expected %zu rows in the right-hand side, got %zu instead",
+                                                rows, OperandTraits<B>::rows(b));
+        }
+    }
+
+    template <typename T, size_t R, size_t C, bool _IsDynamic>
+    using plain_matrix_t = typename PlainObject<T, R, C, _IsDynamic>::type;
+} /* Detail */
+
+    /**
+     * @brief LU factorisation with partial pivoting, P A = L U, of a square Matrix or DynMatrix.
+     *
+     * The factors are kept, so repeated solves against the same A cost two triangular solves each. Large matrices
+     * are factorised in column panels whose trailing updates run through the blocked GEMM kernel.
+     *
+     * @tparam _MatrixType The matrix type being factorised, e.g. Matrix<double, 4, 4> or DynMatrix<float>.
+     */
+    template <typename _MatrixType>
+    class LU {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static_assert(Detail::extents_compatible(Traits::row_extent, Traits::col_extent), "LU requires a square matrix");
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+    private:
+        _MatrixType lu_;
+        Detail::FactorBuffer<size_t, Detail::merge_extents(Traits::row_extent, Traits::col_extent)> pivots_;
+        size_t n_ = 0;
+        size_t singular_ = 0;
+        bool oddSwaps_ = false;
+
+    public:
+        LU() = default;
+
+        /**
+         * @brief Factorises a.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        explicit LU(const _MatrixType& a) { compute(a); }
+
+        /**
+         * @brief Factorises a, reusing the storage of the previous factorisation.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        LU& compute(const _MatrixType& a) {
+            n_ = Traits::rows(a);
+            if (Traits::cols(a) != n_) {
+                Utils::throw_invalid_argument_error("LU requires a square matrix, got %zux%zu", n_, Traits::cols(a));
+            }
+
+            lu_ = a;
+            pivots_.resize(n_);
+            singular_ = Kernels::lu_factor<Scalar>(n_, Traits::data(lu_), n_, pivots_.data());
+
+            oddSwaps_ = false;
+            for (size_t i = 0; i < n_; ++i) oddSwaps_ ^= (pivots_.data()[i] != i);
+            return *this;
+        }
+
+        /**
+         * @return The dimension of the factorised matrix.
+         */
+        size_t rows() const noexcept { return n_; }
+
+        /**
+         * @return True unless a zero pivot was met, i.e. A is invertible in exact arithmetic.
+         */
+        bool is_invertible() const noexcept { return singular_ == n_; }
+
+        /**
+         * @return L (strictly below the diagonal, unit diagonal implied) and U (on and above it) packed into one matrix.
+         */
+        const _MatrixType& matrixLU() const noexcept { return lu_; }
+
+        /**
+         * @return The row that row i was swapped with during step i of the elimination.
+         */
+        size_t pivot(size_t i) const {
+            MATRIXLIB_CHECK_INDEX(i < n_, "Index %zu is out of bounds", i);
+            return pivots_.data()[i];
+        }
+
+        /**
+         * @return The determinant of A, zero if A is singular.
+         */
+        Scalar determinant() const {
+            if (!is_invertible()) return Scalar(0);
+
+            const Scalar* lu = Traits::ref(lu_).data;
+            Scalar det = oddSwaps_ ? Scalar(-1) : Scalar(1);
+            for (size_t i = 0; i < n_; ++i) det *= lu[i * n_ + i];
+            return det;
+        }
+
+        /**
+         * @brief Solves A X = B.
+         * @param b The right-hand side, a matrix or expression with as many rows as A.
+         * @return X, of the matrix type b evaluates to.
+         * @throw std::invalid_argument if b has the wrong number of rows.
+         * @throw std::runtime_error if A is singular.
+         */
+        template <typename B, typename = typename std::enable_if<Detail::OperandTraits<B>::is_operand>::type>
+        Detail::plain_t<B> solve(const B& b) const {
+            Detail::check_rhs<_MatrixType>(n_, b);
+            check_invertible();
+
+            Detail::plain_t<B> x(b);
+            using XT = Detail::OperandTraits<Detail::plain_t<B>>;
+            const size_t nrhs = XT::cols(x);
+            Kernels::lu_solve<Scalar>(n_, nrhs, Traits::ref(lu_).data, n_, pivots_.data(), XT::data(x), nrhs);
+            return x;
+        }
+
+        /**
+         * @return A^-1, computed by solving against the identity.
+         * @throw std::runtime_error if A is singular.
+         */
+        _MatrixType inverse() const {
+            check_invertible();
+
+            _MatrixType x = Detail::make_identity<_MatrixType>(n_);
+            Kernels::lu_solve<Scalar>(n_, n_, Traits::ref(lu_).data, n_, pivots_.data(), Traits::data(x), n_);
+            return x;
+        }
+
+    private:
+        void check_invertible() const {
+            if (!is_invertible()) {
+                Utils::throw_runtime_error("Matrix is singular: zero pivot in column %zu", singular_);
+            }
+        }
+    };
+
+    /**
+     * @brief Cholesky factorisation A = L L^T of a symmetric positive definite Matrix or DynMatrix.
+     *
+     * Only the lower triangle of A is read. Solving costs two triangular solves against L, about half the work of
+     * an LU factorisation, and is numerically stable without pivoting.
+     *
+     * @tparam _MatrixType The matrix type being factorised.
+     */
+    template <typename _MatrixType>
+    class Cholesky {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static_assert(Detail::extents_compatible(Traits::row_extent, Traits::col_extent), "Cholesky requires a square matrix");
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+    private:
+        _MatrixType l_;
+        size_t n_ = 0;
+        size_t failed_ = 0;
+
+    public:
+        Cholesky() = default;
+
+        /**
+         * @brief Factorises a.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        explicit Cholesky(const _MatrixType& a) { compute(a); }
+
+        /**
+         * @brief Factorises a, reusing the storage of the previous factorisation. Check is_positive_definite()
+         * afterwards; a matrix that is not positive definite is reported there rather than by an exception.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        Cholesky& compute(const _MatrixType& a) {
+            n_ = Traits::rows(a);
+            if (Traits::cols(a) != n_) {
+                Utils::throw_invalid_argument_error("Cholesky requires a square matrix, got %zux%zu", n_, Traits::cols(a));
+            }
+
+            l_ = a;
+            failed_ = Kernels::cholesky_factor<Scalar>(n_, Traits::data(l_), n_);
+            return *this;
+        }
+
+        /**
+         * @return The dimension of the factorised matrix.
+         */
+        size_t rows() const noexcept { return n_; }
+
+        /**
+         * @return True if the factorisation succeeded, i.e. A is (numerically) positive definite.
+         */
+        bool is_positive_definite() const noexcept { return failed_ == n_; }
+
+        /**
+         * @return The lower triangular factor L, with zeros above the diagonal.
+         * @throw std::runtime_error if A is not positive definite.
+         */
+        _MatrixType matrixL() const {
+            check_positive_definite();
+
+            _MatrixType ret = l_;
+            Scalar* l = Traits::data(ret);
+            for (size_t i = 0; i < n_; ++i) {
+                std::fill(l + i * n_ + i + 1, l + (i + 1) * n_, Scalar(0));
+            }
+
+            return ret;
+        }
+
+        /**
+         * @return The determinant of A, the squared product of the diagonal of L.
+         * @throw std::runtime_error if A is not positive definite.
+         */
+        Scalar determinant() const {
+            check_positive_definite();
+
+            const Scalar* l = Traits::ref(l_).data;
+            Scalar det(1);
+            for (size_t i = 0; i < n_; ++i) det *= l[i * n_ + i];
+            return det * det;
+        }
+
+        /**
+         * @brief Solves A X = B.
+         * @param b The right-hand side, a matrix or expression with as many rows as A.
+         * @return X, of the matrix type b evaluates to.
+         * @throw std::invalid_argument if b has the wrong number of rows.
+         * @throw std::runtime_error if A is not positive definite.
+         */
+        template <typename B, typename = typename std::enable_if<Detail::OperandTraits<B>::is_operand>::type>
+        Detail::plain_t<B> solve(const B& b) const {
+            Detail::check_rhs<_MatrixType>(n_, b);
+            check_positive_definite();
+
+            Detail::plain_t<B> x(b);
+            using XT = Detail::OperandTraits<Detail::plain_t<B>>;
+            const size_t nrhs = XT::cols(x);
+            const Scalar* l = Traits::ref(l_).data;
+
+            /* L Y = B, then L^T X = Y with L^T read through swapped strides */
+            Kernels::trsm<Scalar>(true, false, n_, nrhs, l, n_, 1, XT::data(x), nrhs);
+            Kernels::trsm<Scalar>(false, false, n_, nrhs, l, 1, n_, XT::data(x), nrhs);
+            return x;
+        }
+
+    private:
+        void check_positive_definite() const {
+            if (!is_positive_definite()) {
+                Utils::throw_runtime_error("Matrix is not positive definite: non-positive pivot in column %zu", failed_);
+            }
+        }
+    };
+
+    /**
+     * @brief Householder QR factorisation A = Q R of a Matrix or DynMatrix with at least as many rows as columns.
+     *
+     * solve() returns the least-squares solution of A X = B, which is the exact solution when A is square and
+     * invertible. Q is kept implicitly as the sequence of Householder reflectors.
+     *
+     * @tparam _MatrixType The matrix type being factorised.
+     */
+    template <typename _MatrixType>
+    class QR {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static_assert(Traits::row_extent == Dynamic || Traits::col_extent == Dynamic || Traits::row_extent >= Traits::col_extent,
+                      "QR requires at least as many rows as columns");
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+        /**
+         * @brief Type of the square factor R.
+         */
+        using RType = Detail::plain_matrix_t<Scalar, Traits::col_extent, Traits::col_extent, Traits::is_dynamic>;
+
+    private:
+        _MatrixType qr_;
+        Detail::FactorBuffer<Scalar, Traits::col_extent> tau_;
+        size_t m_ = 0;
+        size_t n_ = 0;
+
+        Scalar* work(size_t size) const {
+            static thread_local std::vector<Scalar> buffer;
+            if (buffer.size() < size) buffer.resize(size);
+            return buffer.data();
+        }
+
+    public:
+        QR() = default;
+
+        /**
+         * @brief Factorises a.
+         * @throw std::invalid_argument if a has fewer rows than columns.
+         */
+        explicit QR(const _MatrixType& a) { compute(a); }
+
+        /**
+         * @brief Factorises a, reusing the storage of the previous factorisation.
+         * @throw std::invalid_argument if a has fewer rows than columns.
+         */
+        QR& compute(const _MatrixType& a) {
+            m_ = Traits::rows(a);
+            n_ = Traits::cols(a);
+            if (m_ < n_) {
+                Utils::throw_invalid_argument_error("QR requires at least as many rows as columns, got %zux%zu", m_, n_);
+            }
+
+            qr_ = a;
+            tau_.resize(n_);
+            Kernels::qr_factor<Scalar>(m_, n_, Traits::data(qr_), n_, tau_.data(), work(n_));
+            return *this;
+        }
+
+        /**
+         * @return The number of rows of the factorised matrix.
+         */
+        size_t rows() const noexcept { return m_; }
+
+        /**
+         * @return The number of columns of the factorised matrix.
+         */
+        size_t cols() const noexcept { return n_; }
+
+        /**
+         * @return True if no diagonal entry of R is negligible relative to the largest one, i.e. A has full
+         * column rank to working precision.
+         */
+        bool is_full_rank() const {
+            const Scalar* r = Traits::ref(qr_).data;
+
+            Scalar maxDiag(0);
+            for (size_t i = 0; i < n_; ++i) maxDiag = std::max(maxDiag, std::abs(r[i * n_ + i]));
+
+            const Scalar threshold = maxDiag * std::numeric_limits<Scalar>::epsilon() * static_cast<Scalar>(m_);
+            for (size_t i = 0; i < n_; ++i) {
+                if (!(std::abs(r[i * n_ + i]) > threshold)) return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @return The upper triangular n x n factor R.
+         */
+        RType matrixR() const {
+            RType ret;
+            Detail::OperandTraits<RType>::resize(ret, n_, n_);
+
+            const Scalar* qr = Traits::ref(qr_).data;
+            Scalar* r = Detail::OperandTraits<RType>::data(ret);
+            for (size_t i = 0; i < n_; ++i) {
+                std::fill(r + i * n_, r + i * n_ + i, Scalar(0));
+                std::copy(qr + i * n_ + i, qr + (i + 1) * n_, r + i * n_ + i);
+            }
+
+            return ret;
+        }
+
+        /**
+         * @return The m x n factor Q with orthonormal columns (the thin Q), so that A = Q R.
+         */
+        _MatrixType matrixQ() const {
+            _MatrixType q;
+            Traits::resize(q, m_, n_);
+
+            Scalar* data = Traits::data(q);
+            std::fill(data, data + m_ * n_, Scalar(0));
+            for (size_t i = 0; i < n_; ++i) data[i * n_ + i] = Scalar(1);
+
+            Kernels::qr_apply<Scalar>(false, m_, n_, Traits::ref(qr_).data, n_, tau_.data(), n_, data, n_, work(n_));
+            return q;
+        }
+
+        /**
+         * @brief Solves A X = B in the least-squares sense, minimising the 2-norm of every column of A X - B.
+         * @param b The right-hand side, a matrix or expression with as many rows as A.
+         * @return X, with as many rows as A has columns.
+         * @throw std::invalid_argument if b has the wrong number of rows.
+         * @throw std::runtime_error if A does not have full column rank.
+         */
+        template <typename B, typename = typename std::enable_if<Detail::OperandTraits<B>::is_operand>::type>
+        auto solve(const B& b) const {
+            using BT = Detail::OperandTraits<B>;
+            using Result = Detail::plain_matrix_t<Scalar, Traits::col_extent, BT::col_extent, Traits::is_dynamic || BT::is_dynamic>;
+            using XT = Detail::OperandTraits<Result>;
+
+            Detail::check_rhs<_MatrixType>(m_, b);
+            if (!is_full_rank()) Utils::throw_runtime_error("Matrix does not have full column rank");
+
+            /* Q^T B, of which the first n rows are then solved against R */
+            Detail::plain_t<B> qtb(b);
+            using QT = Detail::OperandTraits<Detail::plain_t<B>>;
+            const size_t nrhs = QT::cols(qtb);
+            Scalar* y = QT::data(qtb);
+            Kernels::qr_apply<Scalar>(true, m_, n_, Traits::ref(qr_).data, n_, tau_.data(), nrhs, y, nrhs, work(nrhs));
+            Kernels::trsm<Scalar>(false, false, n_, nrhs, Traits::ref(qr_).data, n_, 1, y, nrhs);
+
+            Result x;
+            XT::resize(x, n_, nrhs);
+            std::copy(y, y + n_ * nrhs, XT::data(x));
+            return x;
+        }
+    };
+
+    /**
+     * @brief Determinant of a matrix of size 1 to 4, in any storage layout, by cofactor expansion, fully unrolled
+     * and usable in constant expressions. Exact for integer matrices.
+     */
+    template <typename _Scalar, size_t _Size, typename _Layout, typename std::enable_if<(_Size >= 1 && _Size <= 4), int>::type = 0>
+    constexpr _Scalar determinant(const Matrix<_Scalar, _Size, _Size, _Layout>& m) {
+        if constexpr (_Size == 1) {
+            return m(0, 0);
+        } else if constexpr (_Size == 2) {
+            return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+        } else if constexpr (_Size == 3) {
+            return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1))
+                 - m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0))
+                 + m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+        } else {
+            /* 2x2 minors of the top two rows (s) and the bottom two rows (c) */
+            const _Scalar s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1);
+            const _Scalar s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2);
+            const _Scalar s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3);
+            const _Scalar s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2);
+            const _Scalar s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3);
+            const _Scalar s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+            const _Scalar c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+            const _Scalar c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2);
+            const _Scalar c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3);
+            const _Scalar c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2);
+            const _Scalar c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3);
+            const _Scalar c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3);
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        }
+    }
+
+    /**
+     * @brief Inverse of a matrix of size 1 to 4, in any storage layout, through its adjugate, fully unrolled and
+     * usable in constant expressions.
+     * @throw std::runtime_error if the matrix is singular.
+     */
+    template <typename _Scalar, size_t _Size, typename _Layout, typename std::enable_if<(_Size >= 1 && _Size <= 4), int>::type = 0>
+    constexpr Matrix<_Scalar, _Size, _Size, _Layout> inverse(const Matrix<_Scalar, _Size, _Size, _Layout>& m) {
+        static_assert(std::is_floating_point<_Scalar>::value, "Inverse requires a floating-point element type");
+
+        Matrix<_Scalar, _Size, _Size, _Layout> ret;
+        _Scalar det(0);
+
+        if constexpr (_Size == 1) {
+            det = m(0, 0);
+            ret(0, 0) = _Scalar(1);
+        } else if constexpr (_Size == 2) {
+            det = determinant(m);
+            ret(0, 0) = m(1, 1);
+            ret(0, 1) = -m(0, 1);
+            ret(1, 0) = -m(1, 0);
+            ret(1, 1) = m(0, 0);
+        } else if constexpr (_Size == 3) {
+            ret(0, 0) = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+            ret(0, 1) = m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2);
+            ret(0, 2) = m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1);
+            ret(1, 0) = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+            ret(1, 1) = m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0);
+            ret(1, 2) = m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2);
+            ret(2, 0) = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+            ret(2, 1) = m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1);
+            ret(2, 2) = m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+            det = m(0, 0) * ret(0, 0) + m(0, 1) * ret(1, 0) + m(0, 2) * ret(2, 0);
+        } else {
+            const _Scalar s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1);
+            const _Scalar s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2);
+            const _Scalar s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3);
+            const _Scalar s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2);
+            const _Scalar s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3);
+            const _Scalar s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+            const _Scalar c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+            const _Scalar c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2);
+            const _Scalar c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3);
+            const _Scalar c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2);
+            const _Scalar c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3);
+            const _Scalar c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3);
+            det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+            ret(0, 0) =  m(1, 1) * c5 - m(1, 2) * c4 + m(1, 3) * c3;
+            ret(0, 1) = -m(0, 1) * c5 + m(0, 2) * c4 - m(0, 3) * c3;
+            ret(0, 2) =  m(3, 1) * s5 - m(3, 2) * s4 + m(3, 3) * s3;
+            ret(0, 3) = -m(2, 1) * s5 + m(2, 2) * s4 - m(2, 3) * s3;
+            ret(1, 0) = -m(1, 0) * c5 + m(1, 2) * c2 - m(1, 3) * c1;
+            ret(1, 1) =  m(0, 0) * c5 - m(0, 2) * c2 + m(0, 3) * c1;
+            ret(1, 2) = -m(3, 0) * s5 + m(3, 2) * s2 - m(3, 3) * s1;
+            ret(1, 3) =  m(2, 0) * s5 - m(2, 2) * s2 + m(2, 3) * s1;
+            ret(2, 0) =  m(1, 0) * c4 - m(1, 1) * c2 + m(1, 3) * c0;
+            ret(2, 1) = -m(0, 0) * c4 + m(0, 1) * c2 - m(0, 3) * c0;
+            ret(2, 2) =  m(3, 0) * s4 - m(3, 1) * s2 + m(3, 3) * s0;
+            ret(2, 3) = -m(2, 0) * s4 + m(2, 1) * s2 - m(2, 3) * s0;
+            ret(3, 0) = -m(1, 0) * c3 + m(1, 1) * c1 - m(1, 2) * c0;
+            ret(3, 1) =  m(0, 0) * c3 - m(0, 1) * c1 + m(0, 2) * c0;
+            ret(3, 2) = -m(3, 0) * s3 + m(3, 1) * s1 - m(3, 2) * s0;
+            ret(3, 3) =  m(2, 0) * s3 - m(2, 1) * s1 + m(2, 2) * s0;
+        }
+
+        if (det == _Scalar(0)) {
+            Utils::throw_runtime_error("Matrix is singular");
+        }
+
+        const _Scalar inv = _Scalar(1) / det;
+        for (size_t i = 0; i < _Size; ++i) {
+            for (size_t j = 0; j < _Size; ++j) ret(i, j) *= inv;
+        }
+
+        return ret;
+    }
+
+    /**
+     * @brief Solves A X = B for an A of size 1 to 4 through its unrolled inverse. Usable in constant expressions.
+     * @throw std::runtime_error if A is singular.
+     */
+    template <typename _Scalar, size_t _Size, size_t _RhsCount, typename _LayoutA, typename _LayoutB,
+              typename std::enable_if<(_Size >= 1 && _Size <= 4), int>::type = 0>
+    constexpr Matrix<_Scalar, _Size, _RhsCount, _LayoutB> solve(const Matrix<_Scalar, _Size, _Size, _LayoutA>& a,
+                                                                const Matrix<_Scalar, _Size, _RhsCount, _LayoutB>& b) {
+        const Matrix<_Scalar, _Size, _Size, _LayoutA> inv = inverse(a);
+
+        Matrix<_Scalar, _Size, _RhsCount, _LayoutB> x;
+        for (size_t i = 0; i < _Size; ++i) {
+            for (size_t p = 0; p < _Size; ++p) {
+                for (size_t j = 0; j < _RhsCount; ++j) x(i, j) += inv(i, p) * b(p, j);
+            }
+        }
+
+        return x;
+    }
+
+    /**
+     * @brief Determinant of a square matrix or expression, through an LU factorisation.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    typename Detail::OperandTraits<M>::Scalar determinant(const M& a) {
+        return LU<Detail::plain_t<M>>(a).determinant();
+    }
+
+    /**
+     * @brief Inverse of a square matrix or expression, through an LU factorisation.
+     * @throw std::runtime_error if the matrix is singular.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    Detail::plain_t<M> inverse(const M& a) {
+        return LU<Detail::plain_t<M>>(a).inverse();
+    }
+
+    /**
+     * @brief Solves A X = B for a square A, through an LU factorisation. Factorise once with LU when solving
+     * against the same A repeatedly.
+     * @throw std::invalid_argument if the shapes do not match.
+     * @throw std::runtime_error if A is singular.
+     */
+    template <typename A, typename B, Detail::enable_if_operands<A, B> = 0>
+    Detail::plain_t<B> solve(const A& a, const B& b) {
+        return LU<Detail::plain_t<A>>(a).solve(b);
+    }
+} /* MatrixLib */
+
+#endif /* DECOMPOSITION_H */
@@ -0,0 +1,596 @@
+#ifndef DYNMATRIX_H
+#define DYNMATRIX_H
+
+#include <vector>
+#include <utility>
+#include <memory_resource>
+
+#include "matrixLib.hpp"
+#include "alignedAllocator.h"
+#include "scratchArena.h"
+
+namespace MatrixLib {
+namespace Detail {
+    /* Enables the mixed comparisons below when both operands are dense matrices and at least one is a DynMatrix */
+    template <typename L, typename R>
+    using enable_if_dynamic_operands = typename std::enable_if<OperandTraits<L>::is_leaf && OperandTraits<R>::is_leaf
+                                                                && (OperandTraits<L>::is_dynamic || OperandTraits<R>::is_dynamic), int>::type;
+
+    template <typename T>
+    void check_same_shape(const DenseRef<T>& a, const DenseRef<T>& b, const char* operation) {
+        if (a.rows != b.rows || a.cols != b.cols) {
+            Utils::throw_invalid_argument_error("Matrix %s requires equal shapes, got %zux%zu and %zux%zu",
+                                                operation, a.rows, a.cols, b.rows, b.cols);
+        }
+    }
+} /* Detail */
+
+    /**
+     * @brief A matrix whose dimensions may be chosen at runtime, stored contiguously on the heap.
+     *
+     * Elements are kept row-major in a single cache-line aligned allocation, so large matrices do not live on
+     * the stack and moves are O(1). Either extent may also be fixed at compile time (a mixed static/dynamic
+     * matrix), in which case the runtime dimension is checked against it. The storage comes from _Allocator:
+     * ScratchMatrix draws from the thread's ScratchArena and pmr::DynMatrix from any std::pmr memory resource,
+     * so that temporaries in a hot loop can reuse memory instead of going back to the heap.
+     *
+     * @tparam _Scalar The scalar type of the matrix elements. Must be a numeric type.
+     * @tparam _RowExtent The number of rows, or Dynamic if only known at runtime.
+     * @tparam _ColExtent The number of columns, or Dynamic if only known at runtime.
+     * @tparam _Allocator The allocator of the element storage.
+     */
+    template <typename _Scalar, size_t _RowExtent, size_t _ColExtent, typename _Allocator>
+    class DynMatrix {
+        static_assert(Detail::is_matrix_scalar<_Scalar>::value, "Matrix element type must be numeric");
+        static_assert(std::is_same<typename std::allocator_traits<_Allocator>::value_type, _Scalar>::value,
+                      "Allocator value type must be the matrix element type");
+
+        template <typename, size_t, size_t, typename>
+        friend class DynMatrix;
+
+        size_t rows_;
+        size_t cols_;
+        std::vector<_Scalar, _Allocator> data_;
+
+        static size_t checked_size(size_t rows, size_t cols) {
+            if (_RowExtent != Dynamic && rows != _RowExtent) {
+                Utils::throw_invalid_argument_error("Expected %zu rows, got %zu instead", _RowExtent, rows);
+            }
+            if (_ColExtent != Dynamic && cols != _ColExtent) {
+                Utils::throw_invalid_argument_error("Expected %zu columns, got %zu instead", _ColExtent, cols);
+            }
+
+            return rows * cols;
+        }
+
+    public:
+        using Scalar = _Scalar;
+        using allocator_type = _Allocator;
+
+        /**
+         * @brief Default constructor. Static extents are zero-filled; dynamic extents start out empty.
+         */
+        DynMatrix() : DynMatrix(_Allocator()) {}
+
+        /**
+         * @brief Default constructor drawing storage from the given allocator.
+         */
+        explicit DynMatrix(const _Allocator& alloc)
+            : rows_(_RowExtent == Dynamic ? 0 : _RowExtent),
+              cols_(_ColExtent == Dynamic ? 0 : _ColExtent),
+              data_(rows_ * cols_, _Scalar{}, alloc) {}
+
+        /**
+         * @brief Constructs a rows x cols matrix with every element set to value.
+         * @throw std::invalid_argument if a dimension contradicts a static extent.
+         */
+        DynMatrix(size_t rows, size_t cols, const _Scalar& value = _Scalar{}, const _Allocator& alloc = _Allocator())
+            : rows_(rows), cols_(cols), data_(checked_size(rows, cols), value, alloc) {}
+
+        /**
+         * @brief Constructs a zero-filled rows x cols matrix drawing storage from the given allocator.
+         * @throw std::invalid_argument if a dimension contradicts a static extent.
+         */
+        DynMatrix(size_t rows, size_t cols, const _Allocator& alloc)
+            : DynMatrix(rows, cols, _Scalar{}, alloc) {}
+
+        /**
+         * @brief Constructs a zero-filled vector of the given length: a column for DynMatrix<T, Dynamic, 1>
+         * (Vector<T>), a row for DynMatrix<T, 1, Dynamic> (RowVector<T>), drawing storage from the given allocator.
+         */
+        template <size_t R = _RowExtent, size_t C = _ColExtent,
+                  typename = typename std::enable_if<(R == Dynamic && C == 1) || (R == 1 && C == Dynamic)>::type>
+        explicit DynMatrix(size_t size, const _Allocator& alloc = _Allocator()) : DynMatrix(size, _Scalar{}, alloc) {}
+
+        /**
+         * @brief Constructs a vector of the given length with every element set to value. value must have the
+         * element type exactly, so that `Vector<double>(n, 1)` still means an n x 1 matrix.
+         */
+        template <typename V, size_t R = _RowExtent, size_t C = _ColExtent,
+                  typename = typename std::enable_if<((R == Dynamic && C == 1) || (R == 1 && C == Dynamic)) && std::is_same<V, _Scalar>::value>::type>
+        DynMatrix(size_t size, const V& value, const _Allocator& alloc = _Allocator())
+            : rows_(_ColExtent == 1 ? size : 1), cols_(_ColExtent == 1 ? 1 : size), data_(checked_size(rows_, cols_), value, alloc) {}
+
+        /**
+         * @brief Constructor that initializes the matrix from an initializer list of rows.
+         * @param list The initializer list of lists of _Scalar values. Every inner list must have the same size.
+         * @throw std::invalid_argument if the rows are ragged or contradict a static extent.
+         */
+        DynMatrix(std::initializer_list<std::initializer_list<_Scalar>> list)
+            : rows_(list.size()), cols_(list.size() ? list.begin()->size() : 0), data_(checked_size(rows_, cols_)) {
+            for (size_t i = 0; i < rows_; ++i) {
+                auto& row = list.begin()[i];
+
+                if (row.size() != cols_) {
+                    Utils::throw_invalid_argument_error("Expected %zu columns in initializer list, got %zu on row %zu", cols_, row.size(), i);
+                }
+
+                std::copy(row.begin(), row.end(), data_.begin() + i * cols_);
+            }
+        }
+
+        /**
+         * @brief Copies a fixed-size Matrix, in any storage layout, into row-major heap storage.
+         */
+        template <size_t R, size_t C, typename L>
+        DynMatrix(const Matrix<_Scalar, R, C, L>& other) : rows_(R), cols_(C), data_(checked_size(R, C)) {
+            static_assert(Detail::extents_compatible(_RowExtent, R) && Detail::extents_compatible(_ColExtent, C),
+                          "Matrix shape contradicts the static extents of the DynMatrix");
+            Kernels::copy_strided(R, C, other.data(), other.row_stride(), other.col_stride(), data_.data(), static_cast<ptrdiff_t>(C));
+        }
+
+        /**
+         * @brief Copies a DynMatrix with different (but compatible) extents or another allocator.
+         * @throw std::invalid_argument if the runtime shape contradicts a static extent.
+         */
+        template <size_t R, size_t C, typename A,
+                  typename = typename std::enable_if<R != _RowExtent || C != _ColExtent || !std::is_same<A, _Allocator>::value>::type>
+        DynMatrix(const DynMatrix<_Scalar, R, C, A>& other, const _Allocator& alloc = _Allocator())
+            : rows_(other.rows_), cols_(other.cols_),
+              data_((checked_size(other.rows_, other.cols_), other.data_.begin()), other.data_.end(), alloc) {
+            static_assert(Detail::extents_compatible(_RowExtent, R) && Detail::extents_compatible(_ColExtent, C),
+                          "Matrix shape contradicts the static extents of the DynMatrix");
+        }
+
+        /**
+         * @brief Takes over the storage of a DynMatrix with different (but compatible) extents without copying.
+         * @throw std::invalid_argument if the runtime shape contradicts a static extent.
+         */
+        template <size_t R, size_t C, typename = typename std::enable_if<R != _RowExtent || C != _ColExtent>::type>
+        DynMatrix(DynMatrix<_Scalar, R, C, _Allocator>&& other)
+            : rows_(other.rows_), cols_(other.cols_), data_((checked_size(other.rows_, other.cols_), std::move(other.data_))) {
+            static_assert(Detail::extents_compatible(_RowExtent, R) && Detail::extents_compatible(_ColExtent, C),
+                          "Matrix shape contradicts the static extents of the DynMatrix");
+            other.rows_ = other.cols_ = 0;
+        }
+
+        /**
+         * @brief Evaluates a matrix expression into a new matrix in a single pass.
+         * @throw std::invalid_argument if the expression's shape contradicts a static extent.
+         */
+        template <typename E>
+        DynMatrix(const MatrixExpression<E>& expr, const _Allocator& alloc = _Allocator()) : rows_(0), cols_(0), data_(alloc) {
+            static_assert(Detail::extents_compatible(_RowExtent, E::row_extent) && Detail::extents_compatible(_ColExtent, E::col_extent),
+                          "Expression shape contradicts the static extents of the DynMatrix");
+            Detail::construct(*this, expr.derived());
+        }
+
+        /**
+         * @brief Copy constructor.
+         */
+        DynMatrix(const DynMatrix& other) = default;
+
+        /**
+         * @brief Copies a matrix into storage from the given allocator.
+         */
+        DynMatrix(const DynMatrix& other, const _Allocator& alloc)
+            : rows_(other.rows_), cols_(other.cols_), data_(other.data_, alloc) {}
+
+        /**
+         * @brief Move constructor. Steals the heap buffer; the moved-from matrix is left empty (0 x 0).
+         */
+        DynMatrix(DynMatrix&& other) noexcept
+            : rows_(other.rows_), cols_(other.cols_), data_(std::move(other.data_)) {
+            other.rows_ = other.cols_ = 0;
+        }
+
+        DynMatrix& operator=(const DynMatrix& other) = default;
+
+        /* Allocators that do not travel with their buffer (std::pmr) may have to copy, and so to allocate */
+        DynMatrix& operator=(DynMatrix&& other) noexcept(std::allocator_traits<_Allocator>::propagate_on_container_move_assignment::value
+                                                         || std::allocator_traits<_Allocator>::is_always_equal::value) {
+            if (this != &other) {
+                rows_ = other.rows_;
+                cols_ = other.cols_;
+                data_ = std::move(other.data_);
+                other.rows_ = other.cols_ = 0;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Evaluates a matrix expression into this matrix, resizing it if needed. If the expression contains
+         * a product that reads this matrix, it is evaluated into a temporary first.
+         * @throw std::invalid_argument if the expression's shape contradicts a static extent.
+         */
+        template <typename E>
+        DynMatrix& operator=(const MatrixExpression<E>& expr) {
+            static_assert(Detail::extents_compatible(_RowExtent, E::row_extent) && Detail::extents_compatible(_ColExtent, E::col_extent),
+                          "Expression shape contradicts the static extents of the DynMatrix");
+            Detail::evaluate(*this, expr.derived());
+            return *this;
+        }
+
+        ~DynMatrix() = default;
+
+    public:
+        /**
+         * @return A copy of the allocator the element storage comes from.
+         */
+        _Allocator get_allocator() const { return data_.get_allocator(); }
+
+        /**
+         * @return The number of rows in the matrix.
+         */
+        size_t rows() const noexcept { return rows_; }
+
+        /**
+         * @return The number of columns in the matrix.
+         */
+        size_t cols() const noexcept { return cols_; }
+
+        /**
+         * @return The number of elements in the matrix.
+         */
+        size_t size() const noexcept { return rows_ * cols_; }
+
+        /**
+         * @return A pointer to the contiguous, row-major element storage.
+         */
+        _Scalar* data() noexcept { return data_.data(); }
+
+        /**
+         * @return A pointer to the contiguous, row-major element storage.
+         */
+        const _Scalar* data() const noexcept { return data_.data(); }
+
+        /**
+         * @return An iterator to the first element, walking all elements in row-major order.
+         */
+        _Scalar* begin() noexcept { return data_.data(); }
+        const _Scalar* begin() const noexcept { return data_.data(); }
+
+        /**
+         * @return An iterator one past the last element.
+         */
+        _Scalar* end() noexcept { return data_.data() + data_.size(); }
+        const _Scalar* end() const noexcept { return data_.data() + data_.size(); }
+
+        /**
+         * @brief View of a row, without copying. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @param index The row index.
+         */
+        StridedSpan<_Scalar> row(size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < rows_, "Index %zu is out of bounds", index);
+            return StridedSpan<_Scalar>(data_.data() + index * cols_, cols_, 1);
+        }
+
+        StridedSpan<const _Scalar> row(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < rows_, "Index %zu is out of bounds", index);
+            return StridedSpan<const _Scalar>(data_.data() + index * cols_, cols_, 1);
+        }
+
+        /**
+         * @brief View of a column, without copying. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @param index The column index.
+         */
+        StridedSpan<_Scalar> col(size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < cols_, "Index %zu is out of bounds", index);
+            return StridedSpan<_Scalar>(data_.data() + index, rows_, static_cast<ptrdiff_t>(cols_));
+        }
+
+        StridedSpan<const _Scalar> col(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < cols_, "Index %zu is out of bounds", index);
+            return StridedSpan<const _Scalar>(data_.data() + index, rows_, static_cast<ptrdiff_t>(cols_));
+        }
+
+        /**
+         * @brief Returns the transposed matrix as a new cols() x rows() matrix. Use transpose_view() to read the
+         * transpose without copying.
+         */
+        DynMatrix<_Scalar, _ColExtent, _RowExtent, _Allocator> transpose() const {
+            DynMatrix<_Scalar, _ColExtent, _RowExtent, _Allocator> ret(cols_, rows_, get_allocator());
+            Kernels::transpose(rows_, cols_, data_.data(), static_cast<ptrdiff_t>(cols_), 1, ret.data(), static_cast<ptrdiff_t>(rows_));
+            return ret;
+        }
+
+        /**
+         * @brief Transposes the matrix in place. Square matrices are transposed without allocating; other shapes
+         * go through one temporary buffer and swap their row and column counts.
+         * @return A reference to this matrix.
+         */
+        DynMatrix& transpose_inplace() {
+            static_assert(_RowExtent == _ColExtent, "Transposing in place would change the static extents of the DynMatrix");
+
+            if (rows_ == cols_) {
+                Kernels::transpose_inplace(rows_, data_.data(), static_cast<ptrdiff_t>(cols_));
+            } else {
+                std::vector<_Scalar, _Allocator> transposed(data_.size(), _Scalar{}, get_allocator());
+                Kernels::transpose(rows_, cols_, data_.data(), static_cast<ptrdiff_t>(cols_), 1, transposed.data(), static_cast<ptrdiff_t>(rows_));
+                data_.swap(transposed);
+                std::swap(rows_, cols_);
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Changes the shape of the matrix. Existing contents are discarded and all elements are zeroed.
+         * @throw std::invalid_argument if a dimension contradicts a static extent.
+         */
+        void resize(size_t rows, size_t cols) {
+            data_.assign(checked_size(rows, cols), _Scalar{});
+            rows_ = rows;
+            cols_ = cols;
+        }
+
+        /**
+         * Access a row of the matrix using the subscript operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param index The row index to access.
+         * @return A pointer to the first element of the row.
+         */
+        const _Scalar* operator[](size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < rows_, "Index %zu is out of bounds", index);
+
+            return data_.data() + index * cols_;
+        }
+
+        /**
+         * Access a row of the matrix using the subscript operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param index The row index to access.
+         * @return A pointer to the first element of the row.
+         */
+        _Scalar* operator[](size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < rows_, "Index %zu is out of bounds", index);
+
+            return data_.data() + index * cols_;
+        }
+
+        /**
+         * Access an element in the matrix using the function call operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param indexOuter The row index of the element to access.
+         * @param indexInner The column index of the element to access.
+         * @return A constant reference to the element at the specified row and column.
+         */
+        const _Scalar& operator()(size_t indexOuter, size_t indexInner) const {
+            MATRIXLIB_CHECK_INDEX(indexOuter < rows_, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < cols_, "index inner %zu is out of bounds", indexInner);
+
+            return data_[indexOuter * cols_ + indexInner];
+        }
+
+        /**
+         * Access an element in the matrix using the function call operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param indexOuter The row index of the element to access.
+         * @param indexInner The column index of the element to access.
+         * @return A reference to the element at the specified row and column.
+         */
+        _Scalar& operator()(size_t indexOuter, size_t indexInner) {
+            MATRIXLIB_CHECK_INDEX(indexOuter < rows_, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < cols_, "index inner %zu is out of bounds", indexInner);
+
+            return data_[indexOuter * cols_ + indexInner];
+        }
+
+        /**
+         * Add another matrix (fixed or dynamic) to this matrix element-wise.
+         *
+         * @param other The matrix to add to this matrix.
+         * @return A reference to this matrix after the addition.
+         * @throw std::invalid_argument if the shapes differ.
+         */
+        template <typename Other, typename = typename std::enable_if<Detail::OperandTraits<Other>::is_leaf>::type>
+        DynMatrix& operator+=(const Other& other) {
+            if constexpr (!Detail::OperandTraits<Other>::has_linear_access) {
+                Detail::evaluate_accumulate(*this, other, _Scalar(1));
+            } else {
+                auto ref = Detail::OperandTraits<Other>::ref(other);
+                Detail::check_same_shape(Detail::OperandTraits<DynMatrix>::ref(*this), ref, "addition");
+                MATRIXLIB_PROBE(Instrumentation::Operation::add, rows_, cols_, 0, size(), 3 * size() * sizeof(_Scalar));
+                Kernels::add_inplace(data_.data(), ref.data, size());
+            }
+
+            return *this;
+        }
+
+        /**
+         * Subtract another matrix (fixed or dynamic) from this matrix element-wise.
+         *
+         * @param other The matrix to subtract from this matrix.
+         * @return A reference to this matrix after the subtraction.
+         * @throw std::invalid_argument if the shapes differ.
+         */
+        template <typename Other, typename = typename std::enable_if<Detail::OperandTraits<Other>::is_leaf>::type>
+        DynMatrix& operator-=(const Other& other) {
+            if constexpr (!Detail::OperandTraits<Other>::has_linear_access) {
+                Detail::evaluate_accumulate(*this, other, static_cast<_Scalar>(-1));
+            } else {
+                auto ref = Detail::OperandTraits<Other>::ref(other);
+                Detail::check_same_shape(Detail::OperandTraits<DynMatrix>::ref(*this), ref, "subtraction");
+                MATRIXLIB_PROBE(Instrumentation::Operation::subtract, rows_, cols_, 0, size(), 3 * size() * sizeof(_Scalar));
+                Kernels::sub_inplace(data_.data(), ref.data, size());
+            }
+
+            return *this;
+        }
+
+        /**
+         * Add a matrix expression to this matrix element-wise without materialising it.
+         *
+         * @param expr The expression to add to this matrix.
+         * @return A reference to this matrix after the addition.
+         * @throw std::invalid_argument if the shapes differ.
+         */
+        template <typename E>
+        DynMatrix& operator+=(const MatrixExpression<E>& expr) {
+            Detail::evaluate_accumulate(*this, expr.derived(), _Scalar(1));
+            return *this;
+        }
+
+        /**
+         * Subtract a matrix expression from this matrix element-wise without materialising it.
+         *
+         * @param expr The expression to subtract from this matrix.
+         * @return A reference to this matrix after the subtraction.
+         * @throw std::invalid_argument if the shapes differ.
+         */
+        template <typename E>
+        DynMatrix& operator-=(const MatrixExpression<E>& expr) {
+            Detail::evaluate_accumulate(*this, expr.derived(), static_cast<_Scalar>(-1));
+            return *this;
+        }
+
+        /**
+         * Multiply this matrix by a scalar value.
+         *
+         * @tparam _NumericScalar The type of the scalar value to multiply by.
+         * @param val The scalar value to multiply by.
+         * @return A reference to this matrix after the multiplication.
+         */
+        template <typename _NumericScalar>
+        DynMatrix& operator*=(const _NumericScalar& val) {
+            static_assert(std::is_arithmetic<_NumericScalar>::value, "Can only do scalar multiplication with a numeric type!");
+            MATRIXLIB_PROBE(Instrumentation::Operation::scale, rows_, cols_, 0, size(), 2 * size() * sizeof(_Scalar));
+
+            if constexpr (std::is_same<typename std::common_type<_Scalar, _NumericScalar>::type, _Scalar>::value) {
+                Kernels::scale_inplace(data_.data(), static_cast<_Scalar>(val), size());
+            } else {
+                for (auto& x : data_) x *= val;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Copies the matrix into a fixed-size Matrix.
+         * @throw std::invalid_argument if the runtime shape is not R x C.
+         */
+        template <size_t R, size_t C>
+        Matrix<_Scalar, R, C> to_matrix() const {
+            if (rows_ != R || cols_ != C) {
+                Utils::throw_invalid_argument_error("Cannot convert a %zux%zu matrix to %zux%zu", rows_, cols_, R, C);
+            }
+
+            Matrix<_Scalar, R, C> ret;
+            std::copy(data_.begin(), data_.end(), Detail::MatrixAccess::data(ret));
+            return ret;
+        }
+
+        /**
+         * @brief Explicit conversion to a fixed-size Matrix, see to_matrix().
+         */
+        template <size_t R, size_t C>
+        explicit operator Matrix<_Scalar, R, C>() const {
+            return to_matrix<R, C>();
+        }
+    };
+
+namespace Detail {
+    template <typename T, size_t R, size_t C, typename A>
+    struct OperandTraits<DynMatrix<T, R, C, A>> {
+        using Scalar = T;
+        static constexpr bool is_operand = true;
+        static constexpr bool is_leaf = true;
+        static constexpr bool is_expression = false;
+        static constexpr bool is_dynamic = true;
+        static constexpr bool has_product = false;
+        static constexpr bool has_linear_access = true;
+        static constexpr size_t row_extent = R;
+        static constexpr size_t col_extent = C;
+
+        static size_t rows(const DynMatrix<T, R, C, A>& m) { return m.rows(); }
+        static size_t cols(const DynMatrix<T, R, C, A>& m) { return m.cols(); }
+        static T coeff(const DynMatrix<T, R, C, A>& m, size_t i, size_t j) { return m.data()[i * m.cols() + j]; }
+        static T coeff(const DynMatrix<T, R, C, A>& m, size_t k) { return m.data()[k]; }
+        static T& at(DynMatrix<T, R, C, A>& m, size_t i, size_t j) { return m.data()[i * m.cols() + j]; }
+        static T* data(DynMatrix<T, R, C, A>& m) { return m.data(); }
+        static DenseRef<T> ref(const DynMatrix<T, R, C, A>& m) { return {m.data(), m.rows(), m.cols()}; }
+
+        static bool aliases(const DynMatrix<T, R, C, A>& m, const void* begin, const void* end) {
+            return ranges_overlap(m.data(), m.data() + m.size(), begin, end);
+        }
+
+        /* Keeps the contents when the shape already matches, so that `a = a + b` reads valid data */
+        static void resize(DynMatrix<T, R, C, A>& m, size_t rows, size_t cols) {
+            if (m.rows() != rows || m.cols() != cols) m.resize(rows, cols);
+        }
+    };
+} /* Detail */
+
+    /**
+     * @brief Check if two matrices, at least one of them a DynMatrix, are equal. Matrices of different shapes are never equal.
+     */
+    template <typename L, typename R, Detail::enable_if_dynamic_operands<L, R> = 0>
+    bool operator==(const L& lhs, const R& rhs) {
+        const size_t m = Detail::OperandTraits<L>::rows(lhs), n = Detail::OperandTraits<L>::cols(lhs);
+        MATRIXLIB_PROBE(Instrumentation::Operation::compare, m, n, 0, 0, 2 * m * n * sizeof(typename Detail::OperandTraits<L>::Scalar));
+
+        if constexpr (!Detail::OperandTraits<L>::has_linear_access || !Detail::OperandTraits<R>::has_linear_access) {
+            return Detail::equal_strided(Detail::strided_ref(lhs), Detail::strided_ref(rhs));
+        } else {
+            auto a = Detail::OperandTraits<L>::ref(lhs);
+            auto b = Detail::OperandTraits<R>::ref(rhs);
+            return a.rows == b.rows && a.cols == b.cols && Kernels::equal(a.data, b.data, a.rows * a.cols);
+        }
+    }
+
+    template <typename L, typename R, Detail::enable_if_dynamic_operands<L, R> = 0>
+    bool operator!=(const L& lhs, const R& rhs) {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * @brief Converts the matrix to a string representation, one "| a, b, c |" line per row.
+     */
+    template <typename _Scalar, size_t _RowExtent, size_t _ColExtent, typename _Allocator>
+    std::string to_string(const DynMatrix<_Scalar, _RowExtent, _ColExtent, _Allocator>& toPrint) {
+        return Detail::rows_to_string(toPrint.data(), toPrint.rows(), toPrint.cols(), static_cast<ptrdiff_t>(toPrint.cols()), 1);
+    }
+
+    /**
+     * @brief Overload of the stream output operator for the DynMatrix class, in the same format as Matrix.
+     */
+    template <typename _Scalar, size_t _RowExtent, size_t _ColExtent, typename _Allocator>
+    std::ostream& operator<<(std::ostream& os, const DynMatrix<_Scalar, _RowExtent, _ColExtent, _Allocator>& toPrint) {
+        Detail::write_rows(os, toPrint.data(), toPrint.rows(), toPrint.cols(), static_cast<ptrdiff_t>(toPrint.cols()), 1);
+        return os;
+    }
+
+    /**
+     * @brief Runtime-sized matrix whose storage comes from the calling thread's ScratchArena. Use it for
+     * temporaries inside loops: once the first iteration has sized the arena, later iterations allocate nothing.
+     * A ScratchMatrix must be destroyed on the thread that created it; a copy belongs to the thread that made it.
+     */
+    template <typename _Scalar, size_t _RowExtent = Dynamic, size_t _ColExtent = Dynamic>
+    using ScratchMatrix = DynMatrix<_Scalar, _RowExtent, _ColExtent, ScratchAllocator<_Scalar>>;
+
+namespace pmr {
+    /**
+     * @brief Runtime-sized matrix allocating through a std::pmr::memory_resource, e.g. a ScratchArena or a
+     * std::pmr::monotonic_buffer_resource. Storage is aligned as the resource aligns it.
+     */
+    template <typename _Scalar, size_t _RowExtent = Dynamic, size_t _ColExtent = Dynamic>
+    using DynMatrix = MatrixLib::DynMatrix<_Scalar, _RowExtent, _ColExtent, std::pmr::polymorphic_allocator<_Scalar>>;
+} /* pmr */
+} /* MatrixLib */
+
+#endif /* DYNMATRIX_H */
@@ -0,0 +1,855 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <iostream>
+#include <string>
+
+#include "utils.h"
+#include "gemm.h"
+#include "storageLayout.h"
+#include "alignedAllocator.h"
+#include "scratchArena.h"
+#include "instrumentation.h"
+
+namespace MatrixLib {
+    /**
+     * @brief Extent value marking a matrix dimension that is only known at runtime.
+     */
+    constexpr size_t Dynamic = static_cast<size_t>(-1);
+
+    template <typename _Scalar, size_t _RowCount, size_t _ColCount, typename _Layout = RowMajorLayout>
+    class Matrix;
+
+    template <typename _Scalar, size_t _RowExtent = Dynamic, size_t _ColExtent = Dynamic, typename _Allocator = AlignedAllocator<_Scalar>>
+    class DynMatrix;
+
+    template <typename _Scalar, size_t _RowExtent = Dynamic, size_t _ColExtent = Dynamic>
+    class MatrixView;
+
+    /**
+     * @brief Base class of every lazy matrix expression.
+     *
+     * The arithmetic operators on matrices do not compute anything; they return lightweight nodes that remember
+     * their operands. The whole expression is evaluated in one pass when it is assigned to a Matrix or DynMatrix,
+     * or when eval() is called. Nodes refer to matrix operands by reference, so an expression must not outlive
+     * the matrices it was built from (store results, not expressions, in `auto` variables).
+     *
+     * @tparam Derived The concrete expression node type.
+     */
+    template <typename Derived>
+    class MatrixExpression {
+    public:
+        constexpr const Derived& derived() const noexcept { return static_cast<const Derived&>(*this); }
+
+        /**
+         * @brief Forces evaluation of the expression.
+         * @return A Matrix, or a DynMatrix if any operand is a DynMatrix, holding the result.
+         */
+        constexpr auto eval() const {
+            return typename Derived::PlainType(derived());
+        }
+
+        /**
+         * Computes a single element of the expression.
+         *
+         * @param indexOuter The row index of the element.
+         * @param indexInner The column index of the element.
+         * @return The value of the element at the specified row and column.
+         */
+        constexpr auto operator()(size_t indexOuter, size_t indexInner) const {
+            MATRIXLIB_CHECK_INDEX(indexOuter < derived().rows(), "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < derived().cols(), "index inner %zu is out of bounds", indexInner);
+
+            return derived().coeff(indexOuter, indexInner);
+        }
+    };
+
+namespace Detail {
+    constexpr bool extents_compatible(size_t a, size_t b) {
+        return a == Dynamic || b == Dynamic || a == b;
+    }
+
+    constexpr size_t merge_extents(size_t a, size_t b) {
+        return a == Dynamic ? b : a;
+    }
+
+    /* Flat row-major description of a dense operand, used to run the kernels over either matrix type */
+    template <typename T>
+    struct DenseRef {
+        const T* data;
+        size_t rows;
+        size_t cols;
+    };
+
+    /* Strided description of a dense operand: element (i, j) lives at data[i * row_stride + j * col_stride] */
+    template <typename T>
+    struct StridedRef {
+        const T* data;
+        size_t rows;
+        size_t cols;
+        ptrdiff_t row_stride;
+        ptrdiff_t col_stride;
+    };
+
+    template <typename E>
+    struct is_matrix_view : std::false_type {};
+
+    template <typename T, size_t R, size_t C>
+    struct is_matrix_view<MatrixView<T, R, C>> : std::true_type {};
+
+    /* Destinations stored column by column are filled column by column */
+    template <typename E>
+    struct is_col_major : std::false_type {};
+
+    template <typename T, size_t R, size_t C, typename L>
+    struct is_col_major<Matrix<T, R, C, L>> : std::integral_constant<bool, L::order == StorageOrder::ColMajor> {};
+
+    /* Compile-time distance between the rows of a row-major Matrix (padding included), or 0 for other operands */
+    template <typename E>
+    struct static_row_stride : std::integral_constant<size_t, 0> {};
+
+    template <typename T, size_t R, size_t C, typename L>
+    struct static_row_stride<Matrix<T, R, C, L>>
+        : std::integral_constant<size_t, L::order == StorageOrder::RowMajor ? L::template Shape<T, R, C>::leading_dimension : 0> {};
+
+    inline bool ranges_overlap(const void* a_begin, const void* a_end, const void* b_begin, const void* b_end) {
+        auto a0 = reinterpret_cast<std::uintptr_t>(a_begin), a1 = reinterpret_cast<std::uintptr_t>(a_end);
+        auto b0 = reinterpret_cast<std::uintptr_t>(b_begin), b1 = reinterpret_cast<std::uintptr_t>(b_end);
+        return a0 < b1 && b0 < a1;
+    }
+
+    /*
+     * Uniform view of everything that can appear in an expression. Matrix and DynMatrix ("leaves", which own
+     * dense storage) specialise this next to their definitions; expression nodes are handled below.
+     */
+    template <typename E, typename = void>
+    struct OperandTraits {
+        static constexpr bool is_operand = false;
+        static constexpr bool is_leaf = false;
+        static constexpr bool is_expression = false;
+    };
+
+    template <typename E>
+    struct OperandTraits<E, typename std::enable_if<std::is_base_of<MatrixExpression<E>, E>::value>::type> {
+        using Scalar = typename E::Scalar;
+        static constexpr bool is_operand = true;
+        static constexpr bool is_leaf = false;
+        static constexpr bool is_expression = true;
+        static constexpr bool is_dynamic = E::is_dynamic;
+        static constexpr bool has_product = E::has_product;
+        static constexpr bool has_linear_access = E::has_linear_access;
+        static constexpr size_t row_extent = E::row_extent;
+        static constexpr size_t col_extent = E::col_extent;
+
+        static constexpr size_t rows(const E& e) { return e.rows(); }
+        static constexpr size_t cols(const E& e) { return e.cols(); }
+        static constexpr Scalar coeff(const E& e, size_t i, size_t j) { return e.coeff(i, j); }
+        static constexpr Scalar coeff(const E& e, size_t k) { return e.coeff(k); }
+        static bool aliases(const E& e, const void* begin, const void* end) { return e.aliases(begin, end); }
+    };
+
+    template <typename T, size_t R, size_t C, bool _IsDynamic>
+    struct PlainObject { using type = Matrix<T, R, C>; };
+
+    template <typename T, size_t R, size_t C>
+    struct PlainObject<T, R, C, true> { using type = DynMatrix<T, R, C>; };
+
+    /* The matrix type an operand evaluates to: a Matrix unless a DynMatrix took part */
+    template <typename E>
+    using plain_t = typename PlainObject<typename OperandTraits<E>::Scalar, OperandTraits<E>::row_extent,
+                                         OperandTraits<E>::col_extent, OperandTraits<E>::is_dynamic>::type;
+
+    /* Where the library keeps an evaluated operand it frees before returning: runtime-sized ones go to the thread's scratch arena */
+    template <typename E>
+    using scratch_t = typename std::conditional<OperandTraits<E>::is_dynamic,
+                                                DynMatrix<typename OperandTraits<E>::Scalar, OperandTraits<E>::row_extent, OperandTraits<E>::col_extent,
+                                                          ScratchAllocator<typename OperandTraits<E>::Scalar>>,
+                                                plain_t<E>>::type;
+
+    /* Leaves are held by reference, nodes by value so that temporaries built inside an expression stay alive */
+    template <typename E>
+    using nested_t = typename std::conditional<OperandTraits<E>::is_leaf, const E&, E>::type;
+
+    /* Product operands must be dense for the GEMM kernels, so nested expressions are evaluated up front; views are passed by stride */
+    template <typename E>
+    using product_operand_t = typename std::conditional<OperandTraits<E>::is_leaf || is_matrix_view<E>::value, E, scratch_t<E>>::type;
+
+    /* Hands a matrix or a view to the strided kernels without copying it */
+    template <typename E>
+    StridedRef<typename OperandTraits<E>::Scalar> strided_ref(const E& e) {
+        if constexpr (is_matrix_view<E>::value) {
+            return {e.data(), e.rows(), e.cols(), e.row_stride(), e.col_stride()};
+        } else if constexpr (!OperandTraits<E>::has_linear_access) {
+            return OperandTraits<E>::strided(e);
+        } else {
+            const auto ref = OperandTraits<E>::ref(e);
+            return {ref.data, ref.rows, ref.cols, static_cast<ptrdiff_t>(ref.cols), 1};
+        }
+    }
+
+    /*
+     * Whether two strided operands have the same shape and rows_match(x, y, n) holds for all their runs of n
+     * elements contiguous in both: whole rows, whole columns, or else single elements.
+     */
+    template <typename T, typename F>
+    bool compare_strided(const StridedRef<T>& a, const StridedRef<T>& b, const F& rows_match) {
+        if (a.rows != b.rows || a.cols != b.cols) return false;
+
+        const bool byColumn = a.col_stride != 1 || b.col_stride != 1;
+        const size_t lines = byColumn ? a.cols : a.rows, length = byColumn ? a.rows : a.cols;
+        const ptrdiff_t la = byColumn ? a.col_stride : a.row_stride, lb = byColumn ? b.col_stride : b.row_stride;
+        const ptrdiff_t ea = byColumn ? a.row_stride : a.col_stride, eb = byColumn ? b.row_stride : b.col_stride;
+
+        for (size_t i = 0; i < lines; ++i) {
+            const T* x = a.data + i * la;
+            const T* y = b.data + i * lb;
+
+            if (ea == 1 && eb == 1) {
+                if (!rows_match(x, y, length)) return false;
+            } else {
+                for (size_t j = 0; j < length; ++j) {
+                    if (!rows_match(x + j * ea, y + j * eb, 1)) return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /* Element-wise equality of two strided operands; runs that are contiguous in both go through the SIMD kernel */
+    template <typename T>
+    bool equal_strided(const StridedRef<T>& a, const StridedRef<T>& b) {
+        return compare_strided(a, b, [](const T* x, const T* y, size_t n) {
+            return n == 1 ? *x == *y : Kernels::equal(x, y, n);
+        });
+    }
+
+    template <typename L, typename R>
+    using enable_if_operands = typename std::enable_if<OperandTraits<L>::is_operand && OperandTraits<R>::is_operand, int>::type;
+
+    template <typename E, typename S>
+    using enable_if_scalar_operand = typename std::enable_if<OperandTraits<E>::is_operand && std::is_arithmetic<S>::value, int>::type;
+
+    struct PlusOp {
+        static constexpr int sign = 1;
+        static constexpr const char* name = "addition";
+
+        template <typename T>
+        static constexpr T apply(const T& a, const T& b) { return static_cast<T>(a + b); }
+    };
+
+    struct MinusOp {
+        static constexpr int sign = -1;
+        static constexpr const char* name = "subtraction";
+
+        template <typename T>
+        static constexpr T apply(const T& a, const T& b) { return static_cast<T>(a - b); }
+    };
+
+    template <typename Dst, typename E>
+    constexpr void construct(Dst& dst, const E& e);
+
+    template <typename Dst, typename E>
+    constexpr void evaluate(Dst& dst, const E& e);
+
+    template <typename Dst, typename E, typename T>
+    constexpr void evaluate_accumulate(Dst& dst, const E& e, T alpha);
+} /* Detail */
+
+    /**
+     * @brief Lazy element-wise sum or difference of two operands of the same shape.
+     */
+    template <typename Op, typename L, typename R>
+    class CwiseBinaryExpr : public MatrixExpression<CwiseBinaryExpr<Op, L, R>> {
+        using LT = Detail::OperandTraits<L>;
+        using RT = Detail::OperandTraits<R>;
+        static_assert(std::is_same<typename LT::Scalar, typename RT::Scalar>::value, "Element-wise operations require the same scalar type");
+        static_assert(Detail::extents_compatible(LT::row_extent, RT::row_extent) && Detail::extents_compatible(LT::col_extent, RT::col_extent),
+                      "Element-wise operations require operands of the same shape");
+
+        Detail::nested_t<L> lhs_;
+        Detail::nested_t<R> rhs_;
+
+    public:
+        using Scalar = typename LT::Scalar;
+        using Operation = Op;
+        using Lhs = L;
+        using Rhs = R;
+        static constexpr size_t row_extent = Detail::merge_extents(LT::row_extent, RT::row_extent);
+        static constexpr size_t col_extent = Detail::merge_extents(LT::col_extent, RT::col_extent);
+        static constexpr bool is_dynamic = LT::is_dynamic || RT::is_dynamic;
+        static constexpr bool has_product = LT::has_product || RT::has_product;
+        static constexpr bool has_linear_access = LT::has_linear_access && RT::has_linear_access;
+        using PlainType = typename Detail::PlainObject<Scalar, row_extent, col_extent, is_dynamic>::type;
+
+        /**
+         * @throw std::invalid_argument if runtime-sized operands have different shapes.
+         */
+        constexpr CwiseBinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+            if constexpr (is_dynamic) {
+                if (LT::rows(lhs_) != RT::rows(rhs_) || LT::cols(lhs_) != RT::cols(rhs_)) {
+                    Utils::throw_invalid_argument_error("Matrix %s requires equal shapes, got %zux%zu and %zux%zu",
+                                                        Op::name, LT::rows(lhs_), LT::cols(lhs_), RT::rows(rhs_), RT::cols(rhs_));
+                }
+            }
+        }
+
+        constexpr size_t rows() const { return LT::rows(lhs_); }
+        constexpr size_t cols() const { return LT::cols(lhs_); }
+        constexpr const L& lhs() const { return lhs_; }
+        constexpr const R& rhs() const { return rhs_; }
+
+        constexpr Scalar coeff(size_t i, size_t j) const { return Op::apply(LT::coeff(lhs_, i, j), RT::coeff(rhs_, i, j)); }
+        constexpr Scalar coeff(size_t k) const { return Op::apply(LT::coeff(lhs_, k), RT::coeff(rhs_, k)); }
+
+        bool aliases(const void* begin, const void* end) const {
+            return LT::aliases(lhs_, begin, end) || RT::aliases(rhs_, begin, end);
+        }
+    };
+
+    /**
+     * @brief Lazy product of an operand with a scalar. Each element is computed as `x * scalar` in the promoted
+     * type and converted back, exactly like Matrix::operator*=.
+     */
+    template <typename E, typename S>
+    class ScaledExpr : public MatrixExpression<ScaledExpr<E, S>> {
+        using ET = Detail::OperandTraits<E>;
+        using T = typename ET::Scalar;
+
+        /* A promoting scalar cannot be folded into a GEMM alpha, so a product underneath is evaluated first */
+        static constexpr bool promotes = !std::is_same<typename std::common_type<T, S>::type, T>::value;
+        static constexpr bool evaluates_inner = promotes && ET::has_product;
+
+    public:
+        using Inner = typename std::conditional<evaluates_inner, Detail::scratch_t<E>, E>::type;
+
+    private:
+        using IT = Detail::OperandTraits<Inner>;
+
+        typename std::conditional<evaluates_inner, Inner, Detail::nested_t<E>>::type inner_;
+        S scalar_;
+
+    public:
+        using Scalar = T;
+        static constexpr size_t row_extent = ET::row_extent;
+        static constexpr size_t col_extent = ET::col_extent;
+        static constexpr bool is_dynamic = ET::is_dynamic;
+        static constexpr bool has_product = IT::has_product;
+        static constexpr bool has_linear_access = IT::has_linear_access;
+        using PlainType = typename Detail::PlainObject<Scalar, row_extent, col_extent, is_dynamic>::type;
+
+        constexpr ScaledExpr(const E& inner, const S& scalar) : inner_(inner), scalar_(scalar) {}
+
+        constexpr size_t rows() const { return IT::rows(inner_); }
+        constexpr size_t cols() const { return IT::cols(inner_); }
+        constexpr const Inner& inner() const { return inner_; }
+        constexpr const S& scalar() const { return scalar_; }
+
+        constexpr Scalar coeff(size_t i, size_t j) const { return static_cast<Scalar>(IT::coeff(inner_, i, j) * scalar_); }
+        constexpr Scalar coeff(size_t k) const { return static_cast<Scalar>(IT::coeff(inner_, k) * scalar_); }
+
+        bool aliases(const void* begin, const void* end) const { return IT::aliases(inner_, begin, end); }
+    };
+
+    /**
+     * @brief Lazy matrix product. Assigning it runs the GEMM kernels straight into the destination; when it
+     * is summed with other terms (`A * B + C`) the sum is accumulated into the GEMM output instead of
+     * materialising the product.
+     */
+    template <typename L, typename R>
+    class ProductExpr : public MatrixExpression<ProductExpr<L, R>> {
+    public:
+        using Lhs = Detail::product_operand_t<L>;
+        using Rhs = Detail::product_operand_t<R>;
+
+    private:
+        using LT = Detail::OperandTraits<Lhs>;
+        using RT = Detail::OperandTraits<Rhs>;
+        static_assert(std::is_same<typename LT::Scalar, typename RT::Scalar>::value, "Matrix multiplication requires the same scalar type");
+        static_assert(Detail::extents_compatible(LT::col_extent, RT::row_extent),
+                      "Matrix multiplication is only supported if second matrix's row count == first matrix's column count");
+
+        typename std::conditional<Detail::OperandTraits<L>::is_leaf, const L&, Lhs>::type lhs_;
+        typename std::conditional<Detail::OperandTraits<R>::is_leaf, const R&, Rhs>::type rhs_;
+
+    public:
+        using Scalar = typename LT::Scalar;
+        static constexpr size_t row_extent = LT::row_extent;
+        static constexpr size_t col_extent = RT::col_extent;
+        static constexpr size_t inner_extent = Detail::merge_extents(LT::col_extent, RT::row_extent);
+        static constexpr bool is_dynamic = LT::is_dynamic || RT::is_dynamic;
+        static constexpr bool has_product = true;
+        static constexpr bool has_linear_access = true;
+        using PlainType = typename Detail::PlainObject<Scalar, row_extent, col_extent, is_dynamic>::type;
+
+        /**
+         * @throw std::invalid_argument if runtime-sized operands have mismatched inner dimensions.
+         */
+        constexpr ProductExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+            if constexpr (is_dynamic) {
+                if (LT::cols(lhs_) != RT::rows(rhs_)) {
+                    Utils::throw_invalid_argument_error("Cannot multiply a %zux%zu matrix by a %zux%zu matrix",
+                                                        LT::rows(lhs_), LT::cols(lhs_), RT::rows(rhs_), RT::cols(rhs_));
+                }
+            }
+        }
+
+        constexpr size_t rows() const { return LT::rows(lhs_); }
+        constexpr size_t cols() const { return RT::cols(rhs_); }
+        constexpr size_t inner() const { return LT::cols(lhs_); }
+        constexpr const Lhs& lhs() const { return lhs_; }
+        constexpr const Rhs& rhs() const { return rhs_; }
+
+        /* Single dot product; the evaluators never call this, it only backs element access on the node */
+        constexpr Scalar coeff(size_t i, size_t j) const {
+            Scalar acc{};
+            for (size_t k = 0; k < inner(); ++k) acc += LT::coeff(lhs_, i, k) * RT::coeff(rhs_, k, j);
+            return acc;
+        }
+
+        constexpr Scalar coeff(size_t k) const { return coeff(k / cols(), k % cols()); }
+
+        bool aliases(const void* begin, const void* end) const {
+            return LT::aliases(lhs_, begin, end) || RT::aliases(rhs_, begin, end);
+        }
+    };
+
+namespace Detail {
+    template <typename E>
+    struct is_product_expr : std::false_type {};
+
+    template <typename L, typename R>
+    struct is_product_expr<ProductExpr<L, R>> : std::true_type {};
+
+    template <typename E>
+    struct is_cwise_expr : std::false_type {};
+
+    template <typename Op, typename L, typename R>
+    struct is_cwise_expr<CwiseBinaryExpr<Op, L, R>> : std::true_type {};
+
+    template <typename E>
+    struct is_scaled_expr : std::false_type {};
+
+    template <typename E, typename S>
+    struct is_scaled_expr<ScaledExpr<E, S>> : std::true_type {};
+
+    /* Runs f(dst_element, expression_element) over every element in one pass */
+    template <typename Dst, typename E, typename F>
+    constexpr void for_each_coeff(Dst& dst, const E& e, F f) {
+        using DT = OperandTraits<Dst>;
+        using ET = OperandTraits<E>;
+        const size_t rows = DT::rows(dst), cols = DT::cols(dst);
+
+        if (!Utils::is_constant_evaluated() && is_col_major<Dst>::value) {
+            for (size_t j = 0; j < cols; ++j) {
+                for (size_t i = 0; i < rows; ++i) {
+                    f(DT::at(dst, i, j), ET::coeff(e, i, j));
+                }
+            }
+        } else if (Utils::is_constant_evaluated() || !ET::has_linear_access || !DT::has_linear_access) {
+            for (size_t i = 0; i < rows; ++i) {
+                for (size_t j = 0; j < cols; ++j) {
+                    f(DT::at(dst, i, j), ET::coeff(e, i, j));
+                }
+            }
+        } else {
+            /* Every operand shares the destination's packed row-major layout, so element k only ever reads index k */
+            auto* d = DT::data(dst);
+            const size_t n = rows * cols;
+            MATRIXLIB_IVDEP
+            for (size_t k = 0; k < n; ++k) f(d[k], ET::coeff(e, k));
+        }
+    }
+
+    /* Packed row-major leaves are used as they are; expressions, views and other layouts are evaluated */
+    template <typename E>
+    constexpr decltype(auto) eval_operand(const E& e) {
+        if constexpr (OperandTraits<E>::is_leaf && OperandTraits<E>::has_linear_access) {
+            return (e);
+        } else {
+            return scratch_t<E>(e);
+        }
+    }
+
+    /* Matrices and views are read in place; expressions are evaluated into a temporary first */
+    template <typename E>
+    decltype(auto) stored_operand(const E& e) {
+        if constexpr (OperandTraits<E>::is_leaf || is_matrix_view<E>::value) {
+            return (e);
+        } else {
+            return scratch_t<E>(e);
+        }
+    }
+
+    /* Row-major matrices, padded or not, are used as they are; anything else is gathered into a packed Matrix */
+    template <typename E>
+    constexpr decltype(auto) row_major_operand(const E& e) {
+        if constexpr (static_row_stride<E>::value != 0) {
+            return (e);
+        } else {
+            return scratch_t<E>(e);
+        }
+    }
+
+    /* The runtime half of product_into */
+    template <typename Dst, typename L, typename R, typename T>
+    void product_kernel(Dst& dst, const ProductExpr<L, R>& e, T alpha, T beta) {
+        using DT = OperandTraits<Dst>;
+        using P = ProductExpr<L, R>;
+        const size_t m = e.rows(), n = e.cols(), k = e.inner();
+
+        MATRIXLIB_PROBE(Instrumentation::Operation::multiply, m, n, k, 2 * m * n * k, (m * k + k * n + (beta == T(0) ? 1 : 2) * m * n) * sizeof(T));
+
+        T* c = DT::data(dst);
+
+        constexpr size_t ldc = DT::has_linear_access ? P::col_extent : static_row_stride<Dst>::value;
+
+        constexpr size_t volume = P::row_extent * P::inner_extent * P::col_extent;
+        constexpr bool is_vector_product = P::row_extent == 1 || P::col_extent == 1;
+
+        if constexpr (ldc != 0 && !P::is_dynamic && volume < static_cast<size_t>(MATRIXLIB_GEMM_BLOCKED_THRESHOLD) && (!is_vector_product || volume < 256)) {
+            /*
+             * Small fixed-size products skip packing; callers guarantee dst does not alias the operands. A view
+             * this small is cheaper to gather onto the stack than to multiply through its strides. Matrix-vector
+             * products beyond 16 x 16 are faster through gemv, which GEMM dispatches to below.
+             */
+            if (alpha == T(1) && beta == T(0)) {
+                const auto& lhs = row_major_operand(e.lhs());
+                const auto& rhs = row_major_operand(e.rhs());
+                constexpr size_t lda = static_row_stride<typename std::decay<decltype(lhs)>::type>::value;
+                constexpr size_t ldb = static_row_stride<typename std::decay<decltype(rhs)>::type>::value;
+                Kernels::gemm_fixed<T, P::row_extent, P::inner_extent, P::col_extent, lda, ldb, ldc>(strided_ref(lhs).data, strided_ref(rhs).data, c);
+                return;
+            }
+        }
+
+        /* Views keep their own strides, so a transposed or sub-matrix operand is read in place by the kernels */
+        const auto a = strided_ref(e.lhs());
+        const auto b = strided_ref(e.rhs());
+        const auto d = strided_ref(dst);
+        Kernels::gemm<T>(m, n, k, alpha, a.data, a.row_stride, a.col_stride, b.data, b.row_stride, b.col_stride, beta, c, d.row_stride, d.col_stride);
+    }
+
+    /* dst += alpha * (lhs * rhs), or dst = alpha * (lhs * rhs) when beta is zero */
+    template <typename Dst, typename L, typename R, typename T>
+    constexpr void product_into(Dst& dst, const ProductExpr<L, R>& e, T alpha, T beta) {
+        using DT = OperandTraits<Dst>;
+        using P = ProductExpr<L, R>;
+        using LT = OperandTraits<typename P::Lhs>;
+        using RT = OperandTraits<typename P::Rhs>;
+
+        if (!Utils::is_constant_evaluated()) {
+            product_kernel(dst, e, alpha, beta);
+            return;
+        }
+
+        const size_t m = e.rows(), n = e.cols(), k = e.inner();
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                T acc{};
+                for (size_t p = 0; p < k; ++p) acc += LT::coeff(e.lhs(), i, p) * RT::coeff(e.rhs(), p, j);
+
+                T& d = DT::at(dst, i, j);
+                d = beta == T(0) ? (alpha == T(1) ? acc : alpha * acc) : alpha * acc + beta * d;
+            }
+        }
+    }
+
+    template <typename Dst, typename E, typename T>
+    constexpr void accumulate(Dst& dst, const E& e, T alpha);
+
+    /*
+     * dst = alpha * e, assuming dst already has the right shape and does not alias any product operand.
+     * Expressions without products are a single fused loop; sums containing products are decomposed so that the
+     * product-free terms are written first and every product is then accumulated by GEMM with beta = 1.
+     */
+    template <typename Dst, typename E, typename T>
+    constexpr void assign(Dst& dst, const E& e, T alpha) {
+        if constexpr (!OperandTraits<E>::has_product) {
+            if (alpha == T(1)) {
+                for_each_coeff(dst, e, [](T& d, T v) { d = v; });
+            } else {
+                for_each_coeff(dst, e, [alpha](T& d, T v) { d = static_cast<T>(alpha * v); });
+            }
+        } else if constexpr (is_product_expr<E>::value) {
+            product_into(dst, e, alpha, T(0));
+        } else if constexpr (is_cwise_expr<E>::value) {
+            const T signed_alpha = static_cast<T>(alpha * E::Operation::sign);
+
+            if constexpr (!OperandTraits<typename E::Rhs>::has_product) {
+                assign(dst, e.rhs(), signed_alpha);
+                accumulate(dst, e.lhs(), alpha);
+            } else {
+                assign(dst, e.lhs(), alpha);
+                accumulate(dst, e.rhs(), signed_alpha);
+            }
+        } else {
+            static_assert(is_scaled_expr<E>::value, "Unknown expression node");
+            assign(dst, e.inner(), static_cast<T>(alpha * static_cast<T>(e.scalar())));
+        }
+    }
+
+    /* dst += alpha * e, under the same assumptions as assign() */
+    template <typename Dst, typename E, typename T>
+    constexpr void accumulate(Dst& dst, const E& e, T alpha) {
+        if constexpr (!OperandTraits<E>::has_product) {
+            if (alpha == T(1)) {
+                for_each_coeff(dst, e, [](T& d, T v) { d = static_cast<T>(d + v); });
+            } else if (alpha == static_cast<T>(-1)) {
+                for_each_coeff(dst, e, [](T& d, T v) { d = static_cast<T>(d - v); });
+            } else {
+                for_each_coeff(dst, e, [alpha](T& d, T v) { d = static_cast<T>(d + alpha * v); });
+            }
+        } else if constexpr (is_product_expr<E>::value) {
+            product_into(dst, e, alpha, T(1));
+        } else if constexpr (is_cwise_expr<E>::value) {
+            accumulate(dst, e.lhs(), alpha);
+            accumulate(dst, e.rhs(), static_cast<T>(alpha * E::Operation::sign));
+        } else {
+            static_assert(is_scaled_expr<E>::value, "Unknown expression node");
+            accumulate(dst, e.inner(), static_cast<T>(alpha * static_cast<T>(e.scalar())));
+        }
+    }
+
+    /*
+     * Product operands are read while the destination is written, so they must not share storage with it. The
+     * same holds for views, which read other elements than the one being written (`a = transpose_view(a)`).
+     */
+    template <typename E>
+    constexpr bool may_need_temporary = OperandTraits<E>::has_product || !OperandTraits<E>::has_linear_access;
+
+    template <typename Dst, typename E>
+    bool needs_temporary(const Dst& dst, const E& e) {
+        if constexpr (may_need_temporary<E>) {
+            const auto ref = strided_ref(dst);
+            if (ref.rows == 0 || ref.cols == 0) return false;
+            const auto* last = ref.data + (ref.rows - 1) * ref.row_stride + (ref.cols - 1) * ref.col_stride;
+            return OperandTraits<E>::aliases(e, ref.data, last + 1);
+        } else {
+            return false;
+        }
+    }
+
+    /* Fills a freshly constructed destination */
+    template <typename Dst, typename E>
+    constexpr void construct(Dst& dst, const E& e) {
+        using ET = OperandTraits<E>;
+        OperandTraits<Dst>::resize(dst, ET::rows(e), ET::cols(e));
+        assign(dst, e, typename ET::Scalar(1));
+    }
+
+    /* dst = e, going through a temporary only when a product operand or a view aliases dst */
+    template <typename Dst, typename E>
+    constexpr void evaluate(Dst& dst, const E& e) {
+        using ET = OperandTraits<E>;
+        using T = typename ET::Scalar;
+
+        if constexpr (may_need_temporary<E>) {
+            if (Utils::is_constant_evaluated() || needs_temporary(dst, e)) {
+                const scratch_t<E> tmp(e);
+                OperandTraits<Dst>::resize(dst, ET::rows(e), ET::cols(e));
+                assign(dst, tmp, T(1));
+                return;
+            }
+        }
+
+        OperandTraits<Dst>::resize(dst, ET::rows(e), ET::cols(e));
+        assign(dst, e, T(1));
+    }
+
+    /* The runtime half of evaluate_accumulate */
+    template <typename Dst, typename E, typename T>
+    void accumulate_kernel(Dst& dst, const E& e, T alpha) {
+        const size_t m = OperandTraits<Dst>::rows(dst), n = OperandTraits<Dst>::cols(dst);
+        MATRIXLIB_PROBE(alpha == T(1) ? Instrumentation::Operation::add : Instrumentation::Operation::subtract,
+                        m, n, 0, m * n, 3 * m * n * sizeof(T));
+
+        if constexpr (may_need_temporary<E>) {
+            if (needs_temporary(dst, e)) {
+                const scratch_t<E> tmp(e);
+                accumulate(dst, tmp, alpha);
+                return;
+            }
+        }
+
+        accumulate(dst, e, alpha);
+    }
+
+    /* dst += alpha * e, going through a temporary only when a product operand or a view aliases dst */
+    template <typename Dst, typename E, typename T>
+    constexpr void evaluate_accumulate(Dst& dst, const E& e, T alpha) {
+        using DT = OperandTraits<Dst>;
+        using ET = OperandTraits<E>;
+
+        if (DT::rows(dst) != ET::rows(e) || DT::cols(dst) != ET::cols(e)) {
+            Utils::throw_invalid_argument_error("Matrix %s requires equal shapes, got %zux%zu and %zux%zu",
+                                                alpha == T(1) ? PlusOp::name : MinusOp::name,
+                                                DT::rows(dst), DT::cols(dst), ET::rows(e), ET::cols(e));
+        }
+
+        if (!Utils::is_constant_evaluated()) {
+            accumulate_kernel(dst, e, alpha);
+            return;
+        }
+
+        if constexpr (may_need_temporary<E>) {
+            const scratch_t<E> tmp(e);
+            accumulate(dst, tmp, alpha);
+        } else {
+            accumulate(dst, e, alpha);
+        }
+    }
+
+    template <typename L, typename R>
+    using enable_if_expression_operands = typename std::enable_if<OperandTraits<L>::is_operand && OperandTraits<R>::is_operand
+                                                                  && (OperandTraits<L>::is_expression || OperandTraits<R>::is_expression), int>::type;
+} /* Detail */
+
+    /**
+     * @brief Returns the lazy element-wise sum of two matrices or expressions.
+     *
+     * Nothing is computed until the result is assigned to a matrix, at which point the whole expression is
+     * evaluated in a single pass over the destination.
+     *
+     * @param lhs The left-hand side operand.
+     * @param rhs The right-hand side operand.
+     * @return An expression node representing the element-wise sum.
+     * @throw std::invalid_argument if runtime-sized operands have different shapes.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    constexpr CwiseBinaryExpr<Detail::PlusOp, L, R> operator+(const L& lhs, const R& rhs) {
+        return CwiseBinaryExpr<Detail::PlusOp, L, R>(lhs, rhs);
+    }
+
+    /**
+     * @brief Returns the lazy element-wise difference of two matrices or expressions.
+     *
+     * @param lhs The left-hand side operand.
+     * @param rhs The right-hand side operand.
+     * @return An expression node representing the element-wise difference.
+     * @throw std::invalid_argument if runtime-sized operands have different shapes.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    constexpr CwiseBinaryExpr<Detail::MinusOp, L, R> operator-(const L& lhs, const R& rhs) {
+        return CwiseBinaryExpr<Detail::MinusOp, L, R>(lhs, rhs);
+    }
+
+    /**
+     * @brief Returns the lazy product of a matrix or expression with a scalar.
+     */
+    template <typename E, typename S, Detail::enable_if_scalar_operand<E, S> = 0>
+    constexpr ScaledExpr<E, S> operator*(const E& expr, const S& scalar) {
+        return ScaledExpr<E, S>(expr, scalar);
+    }
+
+    /**
+     * @brief Returns the lazy product of a scalar with a matrix or expression.
+     */
+    template <typename S, typename E, Detail::enable_if_scalar_operand<E, S> = 0>
+    constexpr ScaledExpr<E, S> operator*(const S& scalar, const E& expr) {
+        return ScaledExpr<E, S>(expr, scalar);
+    }
+
+    /**
+     * Multiply two matrices together.
+     *
+     * The product is lazy: assigning it runs the GEMM kernels directly into the destination, and sums such as
+     * `A * B + C` accumulate into the GEMM output. Operands that are themselves expressions are evaluated first.
+     *
+     * @param lhs The left-hand matrix or expression.
+     * @param rhs The right-hand matrix or expression.
+     *
+     * @pre The number of columns in the left matrix must be equal to the number of rows in the right matrix.
+     * @post The resulting matrix has the same number of rows as the left matrix and the same number of columns as the right matrix.
+     *
+     * @return An expression node representing the product.
+     * @throw std::invalid_argument if runtime-sized operands have mismatched inner dimensions.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    constexpr ProductExpr<L, R> operator*(const L& lhs, const R& rhs) {
+        return ProductExpr<L, R>(lhs, rhs);
+    }
+
+    /**
+     * @brief Check if two operands, at least one of them an expression, evaluate to equal matrices.
+     */
+    template <typename L, typename R, Detail::enable_if_expression_operands<L, R> = 0>
+    constexpr bool operator==(const L& lhs, const R& rhs) {
+        return Detail::eval_operand(lhs) == Detail::eval_operand(rhs);
+    }
+
+    template <typename L, typename R, Detail::enable_if_expression_operands<L, R> = 0>
+    constexpr bool operator!=(const L& lhs, const R& rhs) {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * @brief Check if two operands are element-wise equal within a tolerance: every pair a, b is equal or differs by
+     * at most max(absolute, relative * max(|a|, |b|)). Contiguous runs are compared with the SIMD kernels, like
+     * operator==.
+     *
+     * Infinities only match themselves and NaN matches nothing. Operands of different shapes are never equal.
+     *
+     * @param lhs The left-hand matrix, view or expression.
+     * @param rhs The right-hand matrix, view or expression, with the same floating-point scalar type.
+     * @param relative The tolerance relative to the larger magnitude of each pair, e.g. 1e-12.
+     * @param absolute The tolerance that applies near zero, where a relative one is too strict.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    bool approx_equal(const L& lhs, const R& rhs, typename Detail::OperandTraits<L>::Scalar relative,
+                      typename Detail::OperandTraits<L>::Scalar absolute = 0) {
+        using T = typename Detail::OperandTraits<L>::Scalar;
+        static_assert(std::is_floating_point<T>::value, "approx_equal needs floating-point operands");
+        static_assert(std::is_same<T, typename Detail::OperandTraits<R>::Scalar>::value, "approx_equal needs operands of the same scalar type");
+
+        const auto& a = Detail::stored_operand(lhs);
+        const auto& b = Detail::stored_operand(rhs);
+        return Detail::compare_strided(Detail::strided_ref(a), Detail::strided_ref(b), [&](const T* x, const T* y, size_t n) {
+            return Kernels::approx_equal(x, y, n, relative, absolute);
+        });
+    }
+
+    /**
+     * @brief Check if two operands are element-wise equal to within max_ulps units in the last place: every pair is
+     * equal, or both are finite with at most max_ulps representable values between them. -0 and +0 count as
+     * one value, infinities only match themselves and NaN matches nothing.
+     *
+     * @param lhs The left-hand float or double matrix, view or expression.
+     * @param rhs The right-hand matrix, view or expression, with the same scalar type.
+     * @param max_ulps The largest distance accepted; 0 is operator== except for NaN.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    bool ulp_equal(const L& lhs, const R& rhs, uint64_t max_ulps) {
+        using T = typename Detail::OperandTraits<L>::Scalar;
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "ulp_equal needs float or double operands");
+        static_assert(std::is_same<T, typename Detail::OperandTraits<R>::Scalar>::value, "ulp_equal needs operands of the same scalar type");
+
+        const auto& a = Detail::stored_operand(lhs);
+        const auto& b = Detail::stored_operand(rhs);
+        return Detail::compare_strided(Detail::strided_ref(a), Detail::strided_ref(b), [&](const T* x, const T* y, size_t n) {
+            return Kernels::ulp_equal(x, y, n, max_ulps);
+        });
+    }
+
+    /**
+     * @brief Converts the evaluated expression to a string representation, one "| a, b, c |" line per row.
+     */
+    template <typename E>
+    std::string to_string(const MatrixExpression<E>& expr) {
+        return to_string(expr.eval());
+    }
+
+    /**
+     * @brief Writes the evaluated expression to the stream, in the same format as Matrix.
+     */
+    template <typename E>
+    std::ostream& operator<<(std::ostream& os, const MatrixExpression<E>& expr) {
+        return os << expr.eval();
+    }
+} /* MatrixLib */
+
+#endif /* EXPRESSION_H */
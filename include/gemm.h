@@ -0,0 +1,390 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "gemv.h"
+#include "transpose.h"
+
+/* Below this many multiply-adds (m * n * k) the packing overhead of the blocked kernel is not worth paying */
+#ifndef MATRIXLIB_GEMM_BLOCKED_THRESHOLD
+#define MATRIXLIB_GEMM_BLOCKED_THRESHOLD (32 * 32 * 32)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATRIXLIB_HAS_VECTOR_EXTENSIONS 1
+#define MATRIXLIB_RESTRICT __restrict__
+#elif defined(_MSC_VER)
+#define MATRIXLIB_RESTRICT __restrict
+#else
+#define MATRIXLIB_RESTRICT
+#endif
+
+/* Promises the compiler that the following loop carries no dependencies through memory */
+#if defined(__clang__)
+#define MATRIXLIB_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define MATRIXLIB_IVDEP _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+#define MATRIXLIB_IVDEP __pragma(loop(ivdep))
+#else
+#define MATRIXLIB_IVDEP
+#endif
+
+#ifndef MATRIXLIB_HAS_VECTOR_EXTENSIONS
+#define MATRIXLIB_HAS_VECTOR_EXTENSIONS 0
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+    /*
+     * All kernels in this namespace address operands BLIS-style: an element (i, j) of X lives at
+     * x[i * rsx + j * csx]. Row-major, column-major and transposed operands are therefore all just
+     * different strides and no kernel needs to materialise a copy to handle them.
+     */
+
+#if defined(__AVX512F__)
+    constexpr size_t simd_register_bytes = 64;
+#elif defined(__AVX__)
+    constexpr size_t simd_register_bytes = 32;
+#else
+    constexpr size_t simd_register_bytes = 16;
+#endif
+
+    /* Element types that can be packed into GNU vector-extension registers */
+    template <typename T>
+    struct is_vectorisable : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value
+                                                          && !std::is_same<T, long double>::value
+                                                          && ((simd_register_bytes / sizeof(T)) > 1)> {};
+
+    /**
+     * Cache blocking parameters for the packed GEMM. MR x NR is the register tile held by the micro-kernel,
+     * a KC x NR sliver of B is sized for L1, an MC x KC block of A for L2 and a KC x NC panel of B for L3.
+     */
+    template <typename T>
+    struct GemmBlocking {
+        static constexpr size_t MR = 4;
+        static constexpr size_t NR = std::max<size_t>(2, 2 * simd_register_bytes / sizeof(T));
+        static constexpr size_t KC = std::max<size_t>(64, 2048 / sizeof(T));
+        static constexpr size_t MC = 128;
+        static constexpr size_t NC = 4096;
+    };
+
+    /**
+     * Unpacked product C = alpha * A * B + beta * C for small operands where packing would dominate. The i-k-j
+     * order streams rows of B and C, so when B is not row-major (a transposed view, as in A * B^T) it is first
+     * transposed into a row-major buffer: O(k n) extra work that keeps the O(m n k) inner loop unit-stride.
+     */
+    template <typename T>
+    void gemm_small(size_t m, size_t n, size_t k, T alpha,
+                    const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                    const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                    T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        if (csb != 1 && m > 1 && n > 1 && k > 0) {
+            static thread_local std::vector<T> rowMajorB;
+            rowMajorB.resize(k * n);
+            transpose(n, k, b, csb, rsb, rowMajorB.data(), static_cast<ptrdiff_t>(n));
+            gemm_small(m, n, k, alpha, a, rsa, csa, rowMajorB.data(), static_cast<ptrdiff_t>(n), 1, beta, c, rsc, csc);
+            return;
+        }
+
+        for (size_t i = 0; i < m; ++i) {
+            T* cRow = c + i * rsc;
+
+            for (size_t j = 0; j < n; ++j) {
+                cRow[j * csc] = (beta == T(0)) ? T(0) : beta * cRow[j * csc];
+            }
+
+            for (size_t p = 0; p < k; ++p) {
+                const T aip = alpha * a[i * rsa + p * csa];
+                const T* bRow = b + p * rsb;
+
+                if (csb == 1 && csc == 1) {
+                    /* Unit-stride rows: give the vectoriser a loop it can prove contiguous */
+                    for (size_t j = 0; j < n; ++j) cRow[j] += aip * bRow[j];
+                } else {
+                    for (size_t j = 0; j < n; ++j) cRow[j * csc] += aip * bRow[j * csb];
+                }
+            }
+        }
+    }
+
+    /* Elements per vector for rows of n elements padded to ldb and ldc: the next power of two if the padding holds it */
+    template <typename T>
+    constexpr size_t padded_row_lanes(size_t n, size_t ldb, size_t ldc) {
+        size_t w = 1;
+        while (w < n) w *= 2;
+        return w > n && w <= ldb && w <= ldc && w * sizeof(T) >= 16 && w * sizeof(T) <= simd_register_bytes ? w : 0;
+    }
+
+    /**
+     * Product C = A * B of row-major operands whose extents and leading dimensions are known at compile time,
+     * for shapes too small to amortise packing. The leading dimensions default to packed rows; when they are
+     * padded, every row of B and C must be addressable up to its leading dimension. C must not alias A or B.
+     */
+    template <typename T, size_t M, size_t K, size_t N, size_t LDA = K, size_t LDB = N, size_t LDC = N>
+    inline void gemm_fixed(const T* MATRIXLIB_RESTRICT a, const T* MATRIXLIB_RESTRICT b, T* MATRIXLIB_RESTRICT c) {
+#if MATRIXLIB_HAS_VECTOR_EXTENSIONS
+        constexpr size_t lanes = simd_register_bytes / sizeof(T);
+
+        if constexpr (is_vectorisable<T>::value && N < lanes && padded_row_lanes<T>(N, LDB, LDC) != 0) {
+            /* Rows shorter than a register but padded to a full vector; lanes are independent, so B's padding only reaches C's */
+            constexpr size_t width = padded_row_lanes<T>(N, LDB, LDC);
+            typedef T Row __attribute__((vector_size(width * sizeof(T))));
+
+            for (size_t i = 0; i < M; ++i) {
+                Row acc = {};
+
+                for (size_t p = 0; p < K; ++p) {
+                    Row bv;
+                    std::memcpy(&bv, b + p * LDB, sizeof(Row));
+                    acc += a[i * LDA + p] * bv;
+                }
+
+                std::memcpy(c + i * LDC, &acc, sizeof(Row));
+            }
+            return;
+        } else if constexpr (is_vectorisable<T>::value && N >= lanes) {
+            /* Explicit row vectors again: GCC otherwise vectorises the fully unrolled fixed-size nest along k */
+            typedef T Vec __attribute__((vector_size(simd_register_bytes)));
+            constexpr size_t NV = N / lanes;
+            constexpr size_t tail = NV * lanes;
+
+            for (size_t i = 0; i < M; ++i) {
+                Vec acc[NV] = {};
+                T accTail[N - tail + 1] = {};
+
+                for (size_t p = 0; p < K; ++p) {
+                    const T aip = a[i * LDA + p];
+                    const T* bRow = b + p * LDB;
+
+                    for (size_t v = 0; v < NV; ++v) {
+                        Vec bv;
+                        std::memcpy(&bv, bRow + v * lanes, sizeof(Vec));
+                        acc[v] += aip * bv;
+                    }
+                    for (size_t j = tail; j < N; ++j) accTail[j - tail] += aip * bRow[j];
+                }
+
+                for (size_t v = 0; v < NV; ++v) std::memcpy(c + i * LDC + v * lanes, &acc[v], sizeof(Vec));
+                for (size_t j = tail; j < N; ++j) c[i * LDC + j] = accTail[j - tail];
+            }
+            return;
+        }
+#endif
+        for (size_t i = 0; i < M; ++i) {
+            T acc[N] = {};
+
+            for (size_t p = 0; p < K; ++p) {
+                const T aip = a[i * LDA + p];
+                for (size_t j = 0; j < N; ++j) acc[j] += aip * b[p * LDB + j];
+            }
+
+            for (size_t j = 0; j < N; ++j) c[i * LDC + j] = acc[j];
+        }
+    }
+
+namespace Detail {
+    /* Packs an mc x kc block of A into MR-row micro-panels, each stored column by column, zero-padding the last panel */
+    template <typename T, size_t MR>
+    void pack_a(size_t mc, size_t kc, const T* a, ptrdiff_t rsa, ptrdiff_t csa, T* MATRIXLIB_RESTRICT dst) {
+        for (size_t ir = 0; ir < mc; ir += MR) {
+            const size_t mr = std::min(MR, mc - ir);
+            const T* src = a + ir * rsa;
+
+            if (csa == 1 && rsa != 1) {
+                /* Row-major source: read each row contiguously and scatter into the panel */
+                for (size_t i = 0; i < mr; ++i) {
+                    for (size_t p = 0; p < kc; ++p) dst[p * MR + i] = src[i * rsa + p];
+                }
+            } else {
+                for (size_t p = 0; p < kc; ++p) {
+                    for (size_t i = 0; i < mr; ++i) dst[p * MR + i] = src[i * rsa + p * csa];
+                }
+            }
+
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t i = mr; i < MR; ++i) dst[p * MR + i] = T(0);
+            }
+
+            dst += MR * kc;
+        }
+    }
+
+    /* Packs a kc x nc panel of B into NR-column micro-panels, each stored row by row, zero-padding the last panel */
+    template <typename T, size_t NR>
+    void pack_b(size_t kc, size_t nc, const T* b, ptrdiff_t rsb, ptrdiff_t csb, T* MATRIXLIB_RESTRICT dst) {
+        for (size_t jr = 0; jr < nc; jr += NR) {
+            const size_t nr = std::min(NR, nc - jr);
+            const T* src = b + jr * csb;
+
+            if (rsb == 1 && csb != 1) {
+                /* Column-major source: read each column contiguously and scatter into the panel */
+                for (size_t j = 0; j < nr; ++j) {
+                    for (size_t p = 0; p < kc; ++p) dst[p * NR + j] = src[j * csb + p];
+                }
+            } else {
+                for (size_t p = 0; p < kc; ++p) {
+                    for (size_t j = 0; j < nr; ++j) dst[p * NR + j] = src[p * rsb + j * csb];
+                }
+            }
+
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t j = nr; j < NR; ++j) dst[p * NR + j] = T(0);
+            }
+
+            dst += NR * kc;
+        }
+    }
+
+    /* Register-tiled MR x NR micro-kernel over packed panels. The accumulator tile is kept in registers by the compiler */
+    template <typename T, size_t MR, size_t NR>
+    inline void micro_kernel(size_t kc, const T* MATRIXLIB_RESTRICT a, const T* MATRIXLIB_RESTRICT b, T* MATRIXLIB_RESTRICT ab) {
+#if MATRIXLIB_HAS_VECTOR_EXTENSIONS
+        constexpr size_t lanes = simd_register_bytes / sizeof(T);
+
+        if constexpr (is_vectorisable<T>::value && NR % lanes == 0) {
+            /* Spell the tile out in vector registers: left to itself the auto-vectoriser tends to vectorise along k */
+            typedef T Vec __attribute__((vector_size(simd_register_bytes)));
+            constexpr size_t NV = NR / lanes;
+            Vec acc[MR][NV] = {};
+
+            for (size_t p = 0; p < kc; ++p) {
+                Vec bv[NV];
+                for (size_t v = 0; v < NV; ++v) std::memcpy(&bv[v], b + v * lanes, sizeof(Vec));
+
+                for (size_t i = 0; i < MR; ++i) {
+                    const Vec ai = Vec{} + a[i];
+                    for (size_t v = 0; v < NV; ++v) acc[i][v] += ai * bv[v];
+                }
+
+                a += MR;
+                b += NR;
+            }
+
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t v = 0; v < NV; ++v) std::memcpy(ab + i * NR + v * lanes, &acc[i][v], sizeof(Vec));
+            }
+            return;
+        }
+#endif
+        T acc[MR][NR] = {};
+
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t i = 0; i < MR; ++i) {
+                const T ai = a[i];
+                for (size_t j = 0; j < NR; ++j) {
+                    acc[i][j] += ai * b[j];
+                }
+            }
+
+            a += MR;
+            b += NR;
+        }
+
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) ab[i * NR + j] = acc[i][j];
+        }
+    }
+
+    template <typename T, size_t MR, size_t NR>
+    void macro_kernel(size_t mc, size_t nc, size_t kc, T alpha, const T* ap, const T* bp,
+                      T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        alignas(64) T ab[MR * NR];
+
+        for (size_t jr = 0; jr < nc; jr += NR) {
+            const size_t nr = std::min(NR, nc - jr);
+
+            for (size_t ir = 0; ir < mc; ir += MR) {
+                const size_t mr = std::min(MR, mc - ir);
+                micro_kernel<T, MR, NR>(kc, ap + ir * kc, bp + jr * kc, ab);
+
+                T* cTile = c + ir * rsc + jr * csc;
+                for (size_t i = 0; i < mr; ++i) {
+                    for (size_t j = 0; j < nr; ++j) {
+                        T& cij = cTile[i * rsc + j * csc];
+                        cij = (beta == T(0)) ? alpha * ab[i * NR + j] : alpha * ab[i * NR + j] + beta * cij;
+                    }
+                }
+            }
+        }
+    }
+} /* Detail */
+
+    /**
+     * Packed, cache-blocked product C = alpha * A * B + beta * C with A m x k, B k x n and C m x n.
+     * When beta is zero C is treated as write-only and is never read.
+     */
+    template <typename T>
+    void gemm_blocked(size_t m, size_t n, size_t k, T alpha,
+                      const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                      const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                      T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        using Blk = GemmBlocking<T>;
+
+        if (m == 0 || n == 0) return;
+
+        if (k == 0) {
+            gemm_small<T>(m, n, 0, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+            return;
+        }
+
+        /* Packing buffers are reused across calls, so steady-state loops do not touch the allocator */
+        static thread_local std::vector<T> packedA;
+        static thread_local std::vector<T> packedB;
+
+        const size_t kcMax = std::min(Blk::KC, k);
+        const size_t mcMax = std::min(Blk::MC, m);
+        const size_t ncMax = std::min(Blk::NC, n);
+        packedA.resize(((mcMax + Blk::MR - 1) / Blk::MR) * Blk::MR * kcMax);
+        packedB.resize(((ncMax + Blk::NR - 1) / Blk::NR) * Blk::NR * kcMax);
+
+        for (size_t jc = 0; jc < n; jc += Blk::NC) {
+            const size_t nc = std::min(Blk::NC, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += Blk::KC) {
+                const size_t kc = std::min(Blk::KC, k - pc);
+                const T betaEff = (pc == 0) ? beta : T(1);
+
+                Detail::pack_b<T, Blk::NR>(kc, nc, b + pc * rsb + jc * csb, rsb, csb, packedB.data());
+
+                for (size_t ic = 0; ic < m; ic += Blk::MC) {
+                    const size_t mc = std::min(Blk::MC, m - ic);
+
+                    Detail::pack_a<T, Blk::MR>(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA.data());
+                    Detail::macro_kernel<T, Blk::MR, Blk::NR>(mc, nc, kc, alpha, packedA.data(), packedB.data(),
+                                                               betaEff, c + ic * rsc + jc * csc, rsc, csc);
+                }
+            }
+        }
+    }
+
+    /**
+     * General matrix product C = alpha * A * B + beta * C. Matrix-vector shapes go to gemv, which streams the
+     * matrix once instead of packing it; other shapes choose between the streaming and the packed,
+     * cache-blocked kernel based on the amount of work.
+     */
+    template <typename T>
+    void gemm(size_t m, size_t n, size_t k, T alpha,
+              const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+              const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+              T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        if (n == 1) {
+            gemv<T>(m, k, alpha, a, rsa, csa, b, rsb, beta, c, rsc);
+        } else if (m == 1) {
+            /* A row vector times B is B^T times a column vector */
+            gemv<T>(n, k, alpha, b, csb, rsb, a, csa, beta, c, csc);
+        } else if (m * n * k < static_cast<size_t>(MATRIXLIB_GEMM_BLOCKED_THRESHOLD)) {
+            gemm_small<T>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+        } else {
+            gemm_blocked<T>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+        }
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* GEMM_H */
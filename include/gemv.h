@@ -0,0 +1,135 @@
+#ifndef GEMV_H
+#define GEMV_H
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "simd.h"
+
+/* Elements of y accumulated together when A is read column by column; the default slice of doubles fits in L1 */
+#ifndef MATRIXLIB_GEMV_BLOCK
+#define MATRIXLIB_GEMV_BLOCK 2048
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+    /*
+     * Level-1 and level-2 kernels, addressed like the GEMM kernels: element i of a vector lives at x[i * incx]
+     * and element (i, j) of A at a[i * rsa + j * csa]. Unit-stride vectors and contiguous rows or columns of A
+     * run through the SIMD kernels; anything else falls back to plain strided loops.
+     */
+
+namespace Detail {
+    /* x itself when it is contiguous, otherwise a unit-stride copy in a per-thread buffer; _Slot keeps two copies apart */
+    template <typename T, int _Slot>
+    const T* contiguous(const T* x, ptrdiff_t incx, size_t n) {
+        if (incx == 1) return x;
+
+        static thread_local std::vector<T> buffer;
+        buffer.resize(n);
+        for (size_t i = 0; i < n; ++i) buffer[i] = x[i * incx];
+        return buffer.data();
+    }
+} /* Detail */
+
+    /**
+     * Dot product of the n elements x[i * incx] and y[i * incy]. In deterministic mode strided operands are
+     * copied first, so that they are summed in the same fixed order as contiguous ones.
+     */
+    template <typename T>
+    T dot(size_t n, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy) {
+        if (incx == 1 && incy == 1) return dot_product(x, y, n);
+        if (std::is_floating_point<T>::value && deterministic_mode()) {
+            return dot_product(Detail::contiguous<T, 2>(x, incx, n), Detail::contiguous<T, 3>(y, incy, n), n);
+        }
+
+        T ret(0);
+        for (size_t i = 0; i < n; ++i) ret += x[i * incx] * y[i * incy];
+        return ret;
+    }
+
+    /**
+     * y += alpha * x over n elements. y must not overlap x.
+     */
+    template <typename T>
+    void axpy(size_t n, T alpha, const T* x, ptrdiff_t incx, T* y, ptrdiff_t incy) {
+        if (incx == 1 && incy == 1) return axpy_inplace(y, alpha, x, n);
+
+        for (size_t i = 0; i < n; ++i) y[i * incy] += alpha * x[i * incx];
+    }
+
+    /**
+     * Matrix-vector product y = alpha * A * x + beta * y with A m x n. Rows of a row-major A are reduced four at
+     * a time against a contiguous copy of x, so x is loaded once per four rows. A column-major A is accumulated
+     * column by column with axpy into slices of y small enough to stay in L1. Either way A is streamed exactly
+     * once and nothing is packed. When beta is zero y is write-only. y must not overlap A or x.
+     */
+    template <typename T>
+    void gemv(size_t m, size_t n, T alpha, const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+              const T* x, ptrdiff_t incx, T beta, T* y, ptrdiff_t incy) {
+        auto update = [&](T& yi, T acc) {
+            yi = (beta == T(0)) ? alpha * acc : alpha * acc + beta * yi;
+        };
+
+        if (m == 0) return;
+
+        if (n == 0) {
+            for (size_t i = 0; i < m; ++i) update(y[i * incy], T(0));
+            return;
+        }
+
+        if (rsa != 1 || csa == 1) {
+            const T* xc = Detail::contiguous<T, 0>(x, incx, n);
+            const size_t quads = csa == 1 ? m / 4 : 0;
+
+            for (size_t q = 0; q < quads; ++q) {
+                T acc[4];
+                dot_product4(a + 4 * q * rsa, rsa, xc, n, acc);
+                for (size_t r = 0; r < 4; ++r) update(y[(4 * q + r) * incy], acc[r]);
+            }
+
+            for (size_t i = 4 * quads; i < m; ++i) update(y[i * incy], dot(n, a + i * rsa, csa, xc, 1));
+            return;
+        }
+
+        static thread_local std::vector<T> acc;
+        const size_t block = std::min<size_t>(MATRIXLIB_GEMV_BLOCK, m);
+        acc.resize(block);
+
+        for (size_t ib = 0; ib < m; ib += block) {
+            const size_t mb = std::min(block, m - ib);
+            std::fill_n(acc.data(), mb, T(0));
+
+            for (size_t j = 0; j < n; ++j) axpy_inplace(acc.data(), x[j * incx], a + ib + j * csa, mb);
+            for (size_t i = 0; i < mb; ++i) update(y[(ib + i) * incy], acc[i]);
+        }
+    }
+
+    /**
+     * Rank-1 update A += alpha * x * y^T with A m x n, as one axpy per row of a row-major A (or per column of a
+     * column-major one) against a contiguous copy of y (or x). A must not overlap x or y.
+     */
+    template <typename T>
+    void ger(size_t m, size_t n, T alpha, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy,
+             T* a, ptrdiff_t rsa, ptrdiff_t csa) {
+        if (m == 0 || n == 0) return;
+
+        if (csa == 1) {
+            const T* yc = Detail::contiguous<T, 1>(y, incy, n);
+            for (size_t i = 0; i < m; ++i) axpy_inplace(a + i * rsa, alpha * x[i * incx], yc, n);
+        } else if (rsa == 1) {
+            const T* xc = Detail::contiguous<T, 0>(x, incx, m);
+            for (size_t j = 0; j < n; ++j) axpy_inplace(a + j * csa, alpha * y[j * incy], xc, m);
+        } else {
+            for (size_t i = 0; i < m; ++i) {
+                const T axi = alpha * x[i * incx];
+                for (size_t j = 0; j < n; ++j) a[i * rsa + j * csa] += axi * y[j * incy];
+            }
+        }
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* GEMV_H */
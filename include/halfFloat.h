@@ -0,0 +1,210 @@
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "simd.h"
+
+#if defined(MATRIXLIB_SIMD_X86)
+#define MATRIXLIB_TARGET_F16C __attribute__((target("avx2,f16c")))
+#endif
+
+namespace MatrixLib {
+namespace Detail {
+    inline std::uint32_t float_bits(float f) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    inline float bits_float(std::uint32_t bits) {
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    /* IEEE binary32 to binary16, rounding to nearest even; out-of-range values become infinities */
+    inline std::uint16_t float_to_half_bits(float f) {
+        std::uint32_t x = float_bits(f);
+        const std::uint32_t sign = (x >> 16) & 0x8000u;
+        x &= 0x7FFFFFFFu;
+
+        if (x >= 0x7F800000u) return static_cast<std::uint16_t>(sign | (x > 0x7F800000u ? 0x7E00u : 0x7C00u));
+        if (x >= 0x477FF000u) return static_cast<std::uint16_t>(sign | 0x7C00u);
+
+        if (x < 0x38800000u) {
+            /* Below the smallest normal half: shift the full mantissa down to units of 2^-24 */
+            if (x < 0x33000000u) return static_cast<std::uint16_t>(sign);
+            const std::uint32_t exponent = x >> 23;
+            const std::uint32_t mantissa = (x & 0x7FFFFFu) | 0x800000u;
+            const std::uint32_t shift = 126 - exponent;
+            std::uint32_t h = mantissa >> shift;
+            const std::uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (h & 1u))) ++h;
+            return static_cast<std::uint16_t>(sign | h);
+        }
+
+        /* Rebias the exponent from 127 to 15; a carry out of the mantissa correctly bumps the exponent */
+        std::uint32_t h = (x - 0x38000000u) >> 13;
+        const std::uint32_t rest = x & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (h & 1u))) ++h;
+        return static_cast<std::uint16_t>(sign | h);
+    }
+
+    inline float half_bits_to_float(std::uint16_t h) {
+        const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+        const std::uint32_t exponent = (h >> 10) & 0x1Fu;
+        const std::uint32_t mantissa = h & 0x3FFu;
+
+        if (exponent == 0x1F) return bits_float(sign | 0x7F800000u | (mantissa << 13));
+        if (exponent == 0) {
+            /* Zero or subnormal: mantissa * 2^-24 is exact in binary32 */
+            const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-08f;
+            return sign ? -magnitude : magnitude;
+        }
+        return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    /* IEEE binary32 to bfloat16 (its upper half), rounding to nearest even and keeping NaNs quiet */
+    inline std::uint16_t float_to_bfloat16_bits(float f) {
+        const std::uint32_t x = float_bits(f);
+        if ((x & 0x7FFFFFFFu) > 0x7F800000u) return static_cast<std::uint16_t>((x >> 16) | 0x40u);
+        return static_cast<std::uint16_t>((x + 0x7FFFu + ((x >> 16) & 1u)) >> 16);
+    }
+} /* Detail */
+
+    /**
+     * @brief IEEE 754 half-precision (binary16) storage type.
+     *
+     * Half stores a value in 16 bits and converts to float implicitly, so arithmetic on it is carried out in
+     * float. It is meant for keeping large matrices compact; multiply them with `multiply<float>(a, b)`,
+     * which widens panels on the fly and accumulates in float.
+     */
+    class Half {
+        std::uint16_t bits_ = 0;
+
+    public:
+        Half() = default;
+
+        /**
+         * @brief Converts from float, rounding to the nearest representable value.
+         */
+        explicit Half(float value) : bits_(Detail::float_to_half_bits(value)) {}
+
+        /**
+         * @brief Reinterprets 16 raw bits as a half.
+         */
+        static Half from_bits(std::uint16_t bits) noexcept {
+            Half h;
+            h.bits_ = bits;
+            return h;
+        }
+
+        std::uint16_t bits() const noexcept { return bits_; }
+
+        operator float() const { return Detail::half_bits_to_float(bits_); }
+
+        Half& operator+=(float rhs) { return *this = Half(float(*this) + rhs); }
+        Half& operator-=(float rhs) { return *this = Half(float(*this) - rhs); }
+        Half& operator*=(float rhs) { return *this = Half(float(*this) * rhs); }
+        Half& operator/=(float rhs) { return *this = Half(float(*this) / rhs); }
+    };
+
+    /**
+     * @brief bfloat16 storage type: the upper 16 bits of a float, with float's range and 8 bits of precision.
+     *
+     * Like Half it converts to float implicitly and is multiplied with `multiply<float>(a, b)`.
+     */
+    class BFloat16 {
+        std::uint16_t bits_ = 0;
+
+    public:
+        BFloat16() = default;
+
+        /**
+         * @brief Converts from float, rounding to the nearest representable value.
+         */
+        explicit BFloat16(float value) : bits_(Detail::float_to_bfloat16_bits(value)) {}
+
+        /**
+         * @brief Reinterprets 16 raw bits as a bfloat16.
+         */
+        static BFloat16 from_bits(std::uint16_t bits) noexcept {
+            BFloat16 b;
+            b.bits_ = bits;
+            return b;
+        }
+
+        std::uint16_t bits() const noexcept { return bits_; }
+
+        operator float() const { return Detail::bits_float(static_cast<std::uint32_t>(bits_) << 16); }
+
+        BFloat16& operator+=(float rhs) { return *this = BFloat16(float(*this) + rhs); }
+        BFloat16& operator-=(float rhs) { return *this = BFloat16(float(*this) - rhs); }
+        BFloat16& operator*=(float rhs) { return *this = BFloat16(float(*this) * rhs); }
+        BFloat16& operator/=(float rhs) { return *this = BFloat16(float(*this) / rhs); }
+    };
+
+namespace Detail {
+    /* Element types a Matrix or DynMatrix may hold: the arithmetic types plus the 16-bit floating point formats */
+    template <typename T>
+    struct is_matrix_scalar : std::is_arithmetic<T> {};
+
+    template <>
+    struct is_matrix_scalar<Half> : std::true_type {};
+
+    template <>
+    struct is_matrix_scalar<BFloat16> : std::true_type {};
+
+    template <typename T>
+    struct is_reduced_float : std::integral_constant<bool, std::is_same<T, Half>::value || std::is_same<T, BFloat16>::value> {};
+
+#if defined(MATRIXLIB_SIMD_X86)
+    MATRIXLIB_TARGET_F16C inline void half_to_float_f16c(const Half* src, float* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+        }
+        for (; i < n; ++i) dst[i] = half_bits_to_float(src[i].bits());
+    }
+
+    MATRIXLIB_TARGET_F16C inline void float_to_half_f16c(const float* src, Half* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+        }
+        for (; i < n; ++i) dst[i] = Half(src[i]);
+    }
+
+    inline bool f16c_enabled() {
+        static const bool supported = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx2");
+        return supported && (Kernels::active_simd_isa() == Kernels::SimdIsa::AVX2 || Kernels::active_simd_isa() == Kernels::SimdIsa::AVX512);
+    }
+#endif
+} /* Detail */
+
+namespace Kernels {
+    /**
+     * Converts n contiguous elements, e.g. to widen a panel of Half or int8 values before a float or int32
+     * GEMM. Half <-> float uses the F16C conversion instructions when the CPU has them.
+     */
+    template <typename From, typename To>
+    void convert(const From* src, To* dst, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86)
+        if constexpr (std::is_same<From, Half>::value && std::is_same<To, float>::value) {
+            if (MatrixLib::Detail::f16c_enabled()) return MatrixLib::Detail::half_to_float_f16c(src, dst, n);
+        } else if constexpr (std::is_same<From, float>::value && std::is_same<To, Half>::value) {
+            if (MatrixLib::Detail::f16c_enabled()) return MatrixLib::Detail::float_to_half_f16c(src, dst, n);
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) dst[i] = static_cast<To>(src[i]);
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* HALFFLOAT_H */
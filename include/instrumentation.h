@@ -0,0 +1,445 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Defining MATRIXLIB_INSTRUMENTATION to 1 makes the matrix operators count their calls, FLOPs, bytes and time
+ * per operation and shape. Left at 0, the probes expand to nothing and the Instrumentation API reports nothing.
+ */
+#ifndef MATRIXLIB_INSTRUMENTATION
+#define MATRIXLIB_INSTRUMENTATION 0
+#endif
+
+/* Distinct (operation, shape) pairs each thread can tell apart; later shapes are counted together per operation */
+#ifndef MATRIXLIB_INSTRUMENTATION_SLOTS
+#define MATRIXLIB_INSTRUMENTATION_SLOTS 512
+#endif
+
+namespace MatrixLib {
+namespace Instrumentation {
+    /**
+     * @brief True when the library was compiled with MATRIXLIB_INSTRUMENTATION.
+     */
+    constexpr bool enabled = MATRIXLIB_INSTRUMENTATION != 0;
+
+    /**
+     * @brief The instrumented operations.
+     */
+    enum class Operation : uint8_t {
+        multiply,   /* Every evaluated matrix product, however it was written */
+        add,        /* operator+= */
+        subtract,   /* operator-= */
+        scale,      /* operator*= with a scalar */
+        compare,    /* operator== and operator!= */
+        to_string,  /* to_string */
+    };
+
+    constexpr size_t operation_count = 6;
+
+    /**
+     * @return The name of the operation as it appears in JSON dumps.
+     */
+    constexpr const char* name(Operation op) noexcept {
+        constexpr const char* names[operation_count] = {"multiply", "add", "subtract", "scale", "compare", "to_string"};
+        return names[static_cast<size_t>(op)];
+    }
+
+    /**
+     * @brief One completed operation, as passed to the callback.
+     *
+     * Products are m x n with inner dimension k; the other operations have `inner` 0. FLOPs count the
+     * multiplications and additions of the textbook algorithm, bytes the operands read and the result written.
+     */
+    struct Event {
+        Operation operation;
+        size_t rows;
+        size_t cols;
+        size_t inner;
+        uint64_t flops;
+        uint64_t bytes;
+        uint64_t nanoseconds;
+    };
+
+    /**
+     * @brief Totals of one operation on one shape.
+     *
+     * `other_shapes` marks the per-operation record that collects the shapes a thread saw after its table of
+     * MATRIXLIB_INSTRUMENTATION_SLOTS shapes filled up; its extents are 0.
+     */
+    struct Record {
+        Operation operation;
+        size_t rows = 0;
+        size_t cols = 0;
+        size_t inner = 0;
+        bool other_shapes = false;
+        uint64_t calls = 0;
+        uint64_t flops = 0;
+        uint64_t bytes = 0;
+        uint64_t nanoseconds = 0;
+    };
+
+    /**
+     * @brief Totals of every thread, live or finished, with the most time-consuming records first.
+     */
+    struct Snapshot {
+        std::vector<Record> records;
+    };
+
+    /**
+     * @brief Called on the calling thread after every instrumented operation. It must not throw.
+     */
+    using Callback = void (*)(const Event&);
+
+#if MATRIXLIB_INSTRUMENTATION
+namespace Detail {
+    /*
+     * Each thread aggregates into its own table, so recording is a hash lookup and a few plain stores: counters
+     * are atomics only so that a snapshot can read them while their thread writes. The registry mutex is taken
+     * when a thread records its first operation, when it exits and by snapshot() and reset(), never per call.
+     */
+    struct Slot {
+        /* 0 while free; set with release once the key below is written */
+        std::atomic<uint32_t> used{0};
+        Operation operation{};
+        size_t rows = 0;
+        size_t cols = 0;
+        size_t inner = 0;
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> flops{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> nanoseconds{0};
+
+        /* Only the owning thread writes, so a load and a store are enough */
+        void add(const Event& e) noexcept {
+            calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            flops.store(flops.load(std::memory_order_relaxed) + e.flops, std::memory_order_relaxed);
+            bytes.store(bytes.load(std::memory_order_relaxed) + e.bytes, std::memory_order_relaxed);
+            nanoseconds.store(nanoseconds.load(std::memory_order_relaxed) + e.nanoseconds, std::memory_order_relaxed);
+        }
+
+        void clear() noexcept {
+            used.store(0, std::memory_order_relaxed);
+            calls.store(0, std::memory_order_relaxed);
+            flops.store(0, std::memory_order_relaxed);
+            bytes.store(0, std::memory_order_relaxed);
+            nanoseconds.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct ThreadTable;
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadTable*> tables;
+        /* Totals of threads that have exited */
+        std::vector<Record> retired;
+        /* Bumped by reset(); a table recorded under an older generation counts as empty */
+        std::atomic<uint64_t> generation{0};
+        std::atomic<Callback> callback{nullptr};
+        std::atomic<bool> active{true};
+        std::atomic<bool> timing{true};
+    };
+
+    inline Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    inline void merge(std::vector<Record>& into, const Record& r) {
+        for (Record& existing : into) {
+            if (existing.operation == r.operation && existing.rows == r.rows && existing.cols == r.cols
+                && existing.inner == r.inner && existing.other_shapes == r.other_shapes) {
+                existing.calls += r.calls;
+                existing.flops += r.flops;
+                existing.bytes += r.bytes;
+                existing.nanoseconds += r.nanoseconds;
+                return;
+            }
+        }
+        into.push_back(r);
+    }
+
+    struct ThreadTable {
+        static constexpr size_t capacity = MATRIXLIB_INSTRUMENTATION_SLOTS;
+        static_assert((capacity & (capacity - 1)) == 0, "MATRIXLIB_INSTRUMENTATION_SLOTS must be a power of two");
+
+        std::unique_ptr<Slot[]> slots{new Slot[capacity]};
+        Slot overflow[operation_count];
+        std::atomic<uint64_t> generation;
+
+        ThreadTable() : generation(registry().generation.load(std::memory_order_relaxed)) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.tables.push_back(this);
+        }
+
+        ThreadTable(const ThreadTable&) = delete;
+        ThreadTable& operator=(const ThreadTable&) = delete;
+
+        ~ThreadTable() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.tables.erase(std::find(reg.tables.begin(), reg.tables.end(), this));
+            collect(reg, reg.retired);
+        }
+
+        static ThreadTable& local() {
+            static thread_local ThreadTable table;
+            return table;
+        }
+
+        static size_t hash(const Event& e) noexcept {
+            uint64_t h = static_cast<uint64_t>(e.operation) + 1;
+            for (uint64_t v : {static_cast<uint64_t>(e.rows), static_cast<uint64_t>(e.cols), static_cast<uint64_t>(e.inner)}) {
+                h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+                h ^= h >> 29;
+            }
+            return static_cast<size_t>(h);
+        }
+
+        void record(const Event& e) noexcept {
+            const uint64_t current = registry().generation.load(std::memory_order_relaxed);
+            if (generation.load(std::memory_order_relaxed) != current) {
+                for (size_t i = 0; i < capacity; ++i) slots[i].clear();
+                for (Slot& slot : overflow) slot.clear();
+                generation.store(current, std::memory_order_release);
+            }
+
+            for (size_t probe = 0, i = hash(e); probe < capacity; ++probe, ++i) {
+                Slot& slot = slots[i & (capacity - 1)];
+
+                if (slot.used.load(std::memory_order_relaxed) == 0) {
+                    slot.operation = e.operation;
+                    slot.rows = e.rows;
+                    slot.cols = e.cols;
+                    slot.inner = e.inner;
+                    slot.used.store(1, std::memory_order_release);
+                } else if (slot.operation != e.operation || slot.rows != e.rows || slot.cols != e.cols || slot.inner != e.inner) {
+                    continue;
+                }
+
+                slot.add(e);
+                return;
+            }
+
+            overflow[static_cast<size_t>(e.operation)].add(e);
+        }
+
+        /* Adds this table's totals to `into`; the caller holds the registry mutex */
+        void collect(const Registry& reg, std::vector<Record>& into) const {
+            if (generation.load(std::memory_order_acquire) != reg.generation.load(std::memory_order_relaxed)) return;
+
+            auto add = [&into](const Slot& slot, Record r) {
+                r.calls = slot.calls.load(std::memory_order_relaxed);
+                if (r.calls == 0) return;
+                r.flops = slot.flops.load(std::memory_order_relaxed);
+                r.bytes = slot.bytes.load(std::memory_order_relaxed);
+                r.nanoseconds = slot.nanoseconds.load(std::memory_order_relaxed);
+                merge(into, r);
+            };
+
+            for (size_t i = 0; i < capacity; ++i) {
+                const Slot& slot = slots[i];
+                if (slot.used.load(std::memory_order_acquire) == 0) continue;
+
+                Record r;
+                r.operation = slot.operation;
+                r.rows = slot.rows;
+                r.cols = slot.cols;
+                r.inner = slot.inner;
+                add(slot, r);
+            }
+
+            for (size_t op = 0; op < operation_count; ++op) {
+                Record r;
+                r.operation = static_cast<Operation>(op);
+                r.other_shapes = true;
+                add(overflow[op], r);
+            }
+        }
+    };
+} /* Detail */
+
+    /**
+     * @brief Times one operation from its construction to its destruction and records it on the calling thread.
+     *
+     * The library places one in each instrumented operator through MATRIXLIB_PROBE; it can also wrap user code
+     * that should show up in the same statistics.
+     */
+    class Probe {
+    public:
+        Probe(Operation op, size_t rows, size_t cols, size_t inner, uint64_t flops, uint64_t bytes) noexcept
+            : event_{op, rows, cols, inner, flops, bytes, 0} {
+            const Detail::Registry& reg = Detail::registry();
+            active_ = reg.active.load(std::memory_order_relaxed);
+            timed_ = active_ && reg.timing.load(std::memory_order_relaxed);
+            if (timed_) start_ = std::chrono::steady_clock::now();
+        }
+
+        Probe(const Probe&) = delete;
+        Probe& operator=(const Probe&) = delete;
+
+        ~Probe() {
+            if (!active_) return;
+
+            if (timed_) {
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                event_.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+            Detail::ThreadTable::local().record(event_);
+
+            if (Callback callback = Detail::registry().callback.load(std::memory_order_acquire)) callback(event_);
+        }
+
+    private:
+        Event event_;
+        bool active_;
+        bool timed_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * @brief Pauses or resumes recording at runtime; a paused probe does not read the clock.
+     */
+    inline void set_active(bool active) noexcept {
+        Detail::registry().active.store(active, std::memory_order_relaxed);
+    }
+
+    inline bool active() noexcept {
+        return Detail::registry().active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Turns the timing of operations on or off at runtime. The two clock reads per operation are most
+     * of the cost of a probe, so counting calls, FLOPs and bytes alone is several times cheaper.
+     */
+    inline void set_timing(bool timing) noexcept {
+        Detail::registry().timing.store(timing, std::memory_order_relaxed);
+    }
+
+    inline bool timing() noexcept {
+        return Detail::registry().timing.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Installs a callback run after every recorded operation, or removes it with nullptr.
+     * @return The previous callback.
+     */
+    inline Callback set_callback(Callback callback) noexcept {
+        return Detail::registry().callback.exchange(callback, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @return The totals of all threads so far.
+     */
+    inline Snapshot snapshot() {
+        Detail::Registry& reg = Detail::registry();
+        Snapshot ret;
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            ret.records = reg.retired;
+            for (const Detail::ThreadTable* table : reg.tables) table->collect(reg, ret.records);
+        }
+
+        std::sort(ret.records.begin(), ret.records.end(), [](const Record& a, const Record& b) {
+            return a.nanoseconds != b.nanoseconds ? a.nanoseconds > b.nanoseconds : a.calls > b.calls;
+        });
+        return ret;
+    }
+
+    /**
+     * @brief Discards all totals. Threads clear their own tables when they next record.
+     */
+    inline void reset() {
+        Detail::Registry& reg = Detail::registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired.clear();
+        reg.generation.fetch_add(1, std::memory_order_relaxed);
+    }
+#else
+    /**
+     * @brief Does nothing, so user code wrapped in a Probe compiles unchanged without instrumentation.
+     */
+    class Probe {
+    public:
+        constexpr Probe(Operation, size_t, size_t, size_t, uint64_t, uint64_t) noexcept {}
+
+        Probe(const Probe&) = delete;
+        Probe& operator=(const Probe&) = delete;
+    };
+
+    inline void set_active(bool) noexcept {}
+    inline bool active() noexcept { return false; }
+    inline void set_timing(bool) noexcept {}
+    inline bool timing() noexcept { return false; }
+    inline Callback set_callback(Callback) noexcept { return nullptr; }
+    inline Snapshot snapshot() { return {}; }
+    inline void reset() {}
+#endif
+
+    /**
+     * @brief Formats a snapshot as a JSON object with one entry per record, `"shape": null` marking the
+     * records of other shapes.
+     */
+    inline std::string to_json(const Snapshot& snapshot) {
+        std::string ret = "{\n  \"enabled\": ";
+        ret += enabled ? "true" : "false";
+        ret += ",\n  \"records\": [";
+
+        for (size_t i = 0; i < snapshot.records.size(); ++i) {
+            const Record& r = snapshot.records[i];
+            ret += i == 0 ? "\n    {" : ",\n    {";
+            ret += "\"operation\": \"";
+            ret += name(r.operation);
+            ret += "\", \"shape\": ";
+            if (r.other_shapes) {
+                ret += "null";
+            } else {
+                ret += "[" + std::to_string(r.rows) + ", " + std::to_string(r.cols);
+                if (r.operation == Operation::multiply) ret += ", " + std::to_string(r.inner);
+                ret += "]";
+            }
+            ret += ", \"calls\": " + std::to_string(r.calls);
+            ret += ", \"flops\": " + std::to_string(r.flops);
+            ret += ", \"bytes\": " + std::to_string(r.bytes);
+            ret += ", \"nanoseconds\": " + std::to_string(r.nanoseconds);
+            ret += "}";
+        }
+
+        ret += snapshot.records.empty() ? "]\n}\n" : "\n  ]\n}\n";
+        return ret;
+    }
+
+    /**
+     * @brief Writes the JSON of a fresh snapshot to the stream.
+     */
+    inline std::ostream& dump_json(std::ostream& os) {
+        return os << to_json(snapshot());
+    }
+} /* Instrumentation */
+} /* MatrixLib */
+
+/*
+ * Records the enclosing scope as one operation. Probes are not literal types, so constexpr functions place
+ * theirs in a lambda on their runtime path. Disabled, the arguments are not evaluated.
+ */
+#if MATRIXLIB_INSTRUMENTATION
+#define MATRIXLIB_PROBE(op, rows, cols, inner, flops, bytes) \
+    const ::MatrixLib::Instrumentation::Probe matrixlib_probe_((op), (rows), (cols), (inner), static_cast<uint64_t>(flops), \
+                                                               static_cast<uint64_t>(bytes))
+#else
+#define MATRIXLIB_PROBE(op, rows, cols, inner, flops, bytes) \
+    ((void)sizeof(op), (void)sizeof(rows), (void)sizeof(cols), (void)sizeof(inner), (void)sizeof(flops), (void)sizeof(bytes))
+#endif
+
+#endif /* INSTRUMENTATION_H */
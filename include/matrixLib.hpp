@@ -2,27 +2,185 @@
 #define MATRIXLIB_H
 
 #include <array>
+#include <charconv>
 #include <iostream>
+#include <locale>
 #include <type_traits>
 #include <initializer_list>
 #include <type_traits>
 #include <algorithm>
 #include <string>
 #include <sstream>
+#include <utility>
 
 #include "utils.h"
+#include "gemm.h"
+#include "halfFloat.h"
+#include "simd.h"
+#include "expression.hpp"
+#include "matrixView.hpp"
+#include "span.h"
+#include "storageLayout.h"
+#include "transpose.h"
 
 namespace MatrixLib {
+namespace Detail {
+    struct MatrixAccess;
+
+    /*
+     * Scalars that std::to_chars prints exactly like a default-formatted stream (`%g` with precision 6 for
+     * floating point). Character types and bool keep going through the stream, which prints them differently.
+     */
+    template <typename T>
+    struct has_fast_format : std::integral_constant<bool, std::is_floating_point<T>::value
+                                                          || (std::is_integral<T>::value && !std::is_same<T, bool>::value
+                                                              && !std::is_same<T, char>::value && !std::is_same<T, signed char>::value
+                                                              && !std::is_same<T, unsigned char>::value && !std::is_same<T, wchar_t>::value
+                                                              && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value)> {};
+
+    template <typename T>
+    char* format_scalar(char* first, char* last, T value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            return std::to_chars(first, last, value, std::chars_format::general, 6).ptr;
+        } else {
+            return std::to_chars(first, last, value).ptr;
+        }
+    }
+
+    /*
+     * Appends rows as "| a, b, c |\n", the format shared by every matrix type's to_string and operator<<.
+     * Element (i, j) is read from data[i * rowStride + j * colStride].
+     */
+    template <typename T>
+    void append_rows(std::string& out, const T* data, size_t rows, size_t cols, ptrdiff_t rowStride, ptrdiff_t colStride) {
+        /* Enough for any `%.6g` double or long double and for 64-bit integers */
+        char buf[64];
+
+        for (size_t i = 0; i < rows; ++i) {
+            out += "| ";
+            for (size_t j = 0; j < cols; ++j) {
+                if (j > 0) out += ", ";
+                out.append(buf, format_scalar(buf, buf + sizeof(buf), data[i * rowStride + j * colStride]));
+            }
+            out += " |\n";
+        }
+    }
+
+    /* Whether the stream still formats numbers the way append_rows does */
+    inline bool has_default_format(const std::ostream& os) {
+        return os.flags() == (std::ios_base::dec | std::ios_base::skipws) && os.precision() == 6 && os.width() == 0
+               && os.getloc() == std::locale::classic();
+    }
+
+    /* Writes rows in the append_rows format, formatted by the stream itself if it has non-default settings */
+    template <typename T>
+    void write_rows(std::ostream& os, const T* data, size_t rows, size_t cols, ptrdiff_t rowStride, ptrdiff_t colStride) {
+        if constexpr (has_fast_format<T>::value) {
+            if (has_default_format(os)) {
+                std::string line;
+                for (size_t i = 0; i < rows; ++i) {
+                    line.clear();
+                    append_rows(line, data + i * rowStride, 1, cols, rowStride, colStride);
+                    os.write(line.data(), static_cast<std::streamsize>(line.size()));
+                }
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < rows; ++i) {
+            os << "| ";
+            for (size_t j = 0; j + 1 < cols; ++j) {
+                os << data[i * rowStride + j * colStride] << ", ";
+            }
+
+            if (cols > 0) os << data[i * rowStride + (cols - 1) * colStride];
+            os << " |\n";
+        }
+    }
+
+    template <typename T>
+    std::string rows_to_string(const T* data, size_t rows, size_t cols, ptrdiff_t rowStride, ptrdiff_t colStride) {
+        MATRIXLIB_PROBE(Instrumentation::Operation::to_string, rows, cols, 0, 0, rows * cols * sizeof(T));
+
+        if constexpr (has_fast_format<T>::value) {
+            std::string ret;
+            ret.reserve(rows * (4 + cols * 10));
+            append_rows(ret, data, rows, cols, rowStride, colStride);
+            return ret;
+        } else {
+            std::stringstream ss;
+            write_rows(ss, data, rows, cols, rowStride, colStride);
+            return ss.str();
+        }
+    }
+} /* Detail */
+
     /**
      * @brief A class representing a matrix of arbitrary size.
      * @tparam _Scalar The scalar type of the matrix elements. Must be a numeric type.
      * @tparam _RowCount The number of rows in the matrix.
      * @tparam _ColCount The number of columns in the matrix.
+     * @tparam _Layout The StorageLayout: element order, alignment and padding. Defaults to packed row-major.
      */
-    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
+    template <typename _Scalar, size_t _RowCount, size_t _ColCount, typename _Layout>
     class Matrix {
-        static_assert(std::is_arithmetic<_Scalar>::value, "Matrix element type must be numeric");
-        std::array<std::array<_Scalar, _ColCount>, _RowCount> data_;
+        static_assert(Detail::is_matrix_scalar<_Scalar>::value, "Matrix element type must be numeric");
+        using Shape = typename _Layout::template Shape<_Scalar, _RowCount, _ColCount>;
+        using Storage = std::array<std::array<_Scalar, Shape::leading_dimension>, Shape::outer>;
+
+        alignas(Shape::storage_alignment) Storage data_;
+        static_assert(sizeof(Storage) == sizeof(_Scalar) * Shape::storage_size,
+                      "Matrix storage must be contiguous so that it can be handed to the flat kernels");
+
+        /* Rows of packed row-major matrices are handed out as std::array, rows of other layouts as strided spans */
+        using RowReference = typename std::conditional<Shape::is_dense_row_major, std::array<_Scalar, _ColCount>&, StridedSpan<_Scalar>>::type;
+        using ConstRowReference = typename std::conditional<Shape::is_dense_row_major, const std::array<_Scalar, _ColCount>&,
+                                                            StridedSpan<const _Scalar>>::type;
+
+        template <typename T, size_t R, size_t C, typename L>
+        friend class Matrix;
+
+        friend struct Detail::MatrixAccess;
+
+        constexpr _Scalar& element(size_t i, size_t j) {
+            if constexpr (Shape::row_major) {
+                return data_[i][j];
+            } else {
+                return data_[j][i];
+            }
+        }
+
+        constexpr const _Scalar& element(size_t i, size_t j) const {
+            if constexpr (Shape::row_major) {
+                return data_[i][j];
+            } else {
+                return data_[j][i];
+            }
+        }
+
+        /* Diagonal matrices built with one assignment per diagonal element, so constant evaluation runs no loops */
+        template <size_t... _Index>
+        static constexpr Matrix make_diagonal(const std::array<_Scalar, sizeof...(_Index)>& values, std::index_sequence<_Index...>) {
+            Matrix ret;
+            ((ret.element(_Index, _Index) = values[_Index]), ...);
+            return ret;
+        }
+
+        template <size_t... _Index>
+        static constexpr Matrix make_scaled_identity(const _Scalar& value, std::index_sequence<_Index...>) {
+            Matrix ret;
+            ((ret.element(_Index, _Index) = value), ...);
+            return ret;
+        }
+
+        /* Fills the storage from a _RowCount x _ColCount operand whose element (i, j) is src[i * rs + j * cs] */
+        void assign_strided(const _Scalar* src, ptrdiff_t rs, ptrdiff_t cs) {
+            if constexpr (Shape::row_major) {
+                Kernels::copy_strided(_RowCount, _ColCount, src, rs, cs, data(), Shape::row_stride);
+            } else {
+                Kernels::copy_strided(_ColCount, _RowCount, src, cs, rs, data(), Shape::col_stride);
+            }
+        }
 
     public:
         /**
@@ -49,7 +207,7 @@ namespace MatrixLib {
                 }
 
                 for (size_t j = 0; j < _ColCount; ++j) {
-                    data_[i][j] = list.begin()[i].begin()[j];
+                    element(i, j) = list.begin()[i].begin()[j];
                 }
             }
         }
@@ -58,19 +216,54 @@ namespace MatrixLib {
          * @brief Constructor that initializes the matrix from a std::array of std::arrays.
          * @param data The std::array of std::arrays representing the matrix elements.
          */
-        constexpr Matrix(const std::array<std::array<_Scalar, _ColCount>, _RowCount>& data) : data_{data} {}
+        constexpr Matrix(const std::array<std::array<_Scalar, _ColCount>, _RowCount>& data) : data_{} {
+            if constexpr (Shape::is_dense_row_major) {
+                data_ = data;
+            } else {
+                for (size_t i = 0; i < _RowCount; ++i) {
+                    for (size_t j = 0; j < _ColCount; ++j) element(i, j) = data[i][j];
+                }
+            }
+        }
+
+        /**
+         * @brief Copies a matrix of the same shape stored in another layout.
+         * @param other The matrix to copy, e.g. a column-major or padded matrix.
+         */
+        template <typename _OtherLayout, typename = typename std::enable_if<!std::is_same<_OtherLayout, _Layout>::value>::type>
+        constexpr Matrix(const Matrix<_Scalar, _RowCount, _ColCount, _OtherLayout>& other) :data_{} {
+            if (Utils::is_constant_evaluated()) {
+                for (size_t i = 0; i < _RowCount; ++i) {
+                    for (size_t j = 0; j < _ColCount; ++j) element(i, j) = other.element(i, j);
+                }
+            } else {
+                assign_strided(other.data(), other.row_stride(), other.col_stride());
+            }
+        }
+
+        /**
+         * @brief Evaluates a matrix expression into a new matrix in a single pass.
+         * @param expr The expression to evaluate, e.g. `A + B - C` or `A * B + C`.
+         * @throw std::invalid_argument if a runtime-sized expression does not have _RowCount rows and _ColCount columns.
+         */
+        template <typename E>
+        constexpr Matrix(const MatrixExpression<E>& expr) :data_{} {
+            static_assert(Detail::extents_compatible(_RowCount, E::row_extent) && Detail::extents_compatible(_ColCount, E::col_extent),
+                          "Expression shape does not match the matrix");
+            Detail::construct(*this, expr.derived());
+        }
 
         /**
          * @brief Copy constructor.
          * @param other The Matrix object to copy from.
          */
-        constexpr Matrix(const Matrix& other) : Matrix(other.data_) {}
+        constexpr Matrix(const Matrix& other) : data_(other.data_) {}
 
         /**
          * @brief Move constructor.
          * @param other The Matrix object to move from.
          */
-        constexpr Matrix(Matrix&& other) : Matrix(std::move(other.data_)) {}
+        constexpr Matrix(Matrix&& other) : data_(std::move(other.data_)) {}
 
         /**
          * @brief Assigns the contents of another matrix to this matrix using the copy assignment operator.
@@ -100,6 +293,23 @@ namespace MatrixLib {
             return *this;
         }
 
+        /**
+         * @brief Evaluates a matrix expression into this matrix.
+         *
+         * Element-wise expressions are computed in one fused pass and may freely refer to this matrix. If the
+         * expression contains a product that reads this matrix, it is evaluated into a temporary first.
+         *
+         * @param expr The expression to evaluate.
+         * @return A reference to this matrix.
+         */
+        template <typename E>
+        constexpr Matrix& operator=(const MatrixExpression<E>& expr) {
+            static_assert(Detail::extents_compatible(_RowCount, E::row_extent) && Detail::extents_compatible(_ColCount, E::col_extent),
+                          "Expression shape does not match the matrix");
+            Detail::evaluate(*this, expr.derived());
+            return *this;
+        }
+
         /**
          * @brief Destroys the matrix and releases any allocated resources.
          * 
@@ -110,57 +320,236 @@ namespace MatrixLib {
          */
         ~Matrix() = default;
 
-    public: 
+    public:
+        /**
+         * @brief The matrix with every element zero. Usable in constant expressions.
+         */
+        static constexpr Matrix zero() { return Matrix(); }
+
+        /**
+         * @brief The identity matrix, with ones on the main diagonal; a non-square matrix gets ones on its leading
+         * diagonal. Usable in constant expressions.
+         */
+        static constexpr Matrix identity() {
+            return make_scaled_identity(_Scalar(1), std::make_index_sequence<std::min(_RowCount, _ColCount)>{});
+        }
+
+        /**
+         * @brief A matrix with the given values on its main diagonal and zeros elsewhere. Usable in constant
+         * expressions.
+         * @param values The diagonal, from the top-left element down.
+         */
+        static constexpr Matrix diagonal(const std::array<_Scalar, std::min(_RowCount, _ColCount)>& values) {
+            return make_diagonal(values, std::make_index_sequence<std::min(_RowCount, _ColCount)>{});
+        }
+
+        /**
+         * @return The number of rows in the matrix.
+         */
+        static constexpr size_t rows() noexcept { return _RowCount; }
+
+        /**
+         * @return The number of columns in the matrix.
+         */
+        static constexpr size_t cols() noexcept { return _ColCount; }
+
+        /**
+         * @return The number of elements in the matrix.
+         */
+        static constexpr size_t size() noexcept { return _RowCount * _ColCount; }
+
+        /**
+         * @return The order in which the elements are stored.
+         */
+        static constexpr StorageOrder order() noexcept { return _Layout::order; }
+
+        /**
+         * @return The distance in elements between the starts of consecutive rows (row-major) or columns
+         * (column-major), including any padding.
+         */
+        static constexpr size_t leading_dimension() noexcept { return Shape::leading_dimension; }
+
+        /**
+         * @return The distance in elements between (i, j) and (i + 1, j).
+         */
+        static constexpr ptrdiff_t row_stride() noexcept { return Shape::row_stride; }
+
+        /**
+         * @return The distance in elements between (i, j) and (i, j + 1).
+         */
+        static constexpr ptrdiff_t col_stride() noexcept { return Shape::col_stride; }
+
+        /**
+         * @return A pointer to the contiguous element storage, for handing the matrix to other code. Element
+         * (i, j) lives at `data()[i * row_stride() + j * col_stride()]`; for the default layout that is plain
+         * row-major order.
+         */
+        constexpr _Scalar* data() noexcept {
+            /* At runtime the pointer is derived from the whole storage, so the optimiser sees every row behind it */
+            if (!Utils::is_constant_evaluated()) return reinterpret_cast<_Scalar*>(&this->data_);
+            return this->data_[0].data();
+        }
+
+        /**
+         * @return A pointer to the contiguous element storage, laid out as described for data().
+         */
+        constexpr const _Scalar* data() const noexcept {
+            if (!Utils::is_constant_evaluated()) return reinterpret_cast<const _Scalar*>(&this->data_);
+            return this->data_[0].data();
+        }
+
+        /**
+         * @return An iterator to the first element, walking all elements in storage order. Not available for
+         * padded layouts, whose storage has gaps; use row() or view() there.
+         */
+        _Scalar* begin() noexcept {
+            static_assert(Shape::leading_dimension == Shape::inner, "Padded matrices cannot be iterated as a flat range");
+            return data();
+        }
+
+        const _Scalar* begin() const noexcept {
+            static_assert(Shape::leading_dimension == Shape::inner, "Padded matrices cannot be iterated as a flat range");
+            return data();
+        }
+
+        /**
+         * @return An iterator one past the last element.
+         */
+        _Scalar* end() noexcept { return begin() + size(); }
+        const _Scalar* end() const noexcept { return begin() + size(); }
+
+        /**
+         * @brief View of a row, without copying. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @param index The row index.
+         */
+        StridedSpan<_Scalar> row(size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < _RowCount, "Index %zu is out of bounds", index);
+            return StridedSpan<_Scalar>(data() + index * row_stride(), _ColCount, col_stride());
+        }
+
+        StridedSpan<const _Scalar> row(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < _RowCount, "Index %zu is out of bounds", index);
+            return StridedSpan<const _Scalar>(data() + index * row_stride(), _ColCount, col_stride());
+        }
+
         /**
-         * Access an element in the matrix using the subscript operator.
+         * @brief View of a column, without copying. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         * @param index The column index.
+         */
+        StridedSpan<_Scalar> col(size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < _ColCount, "Index %zu is out of bounds", index);
+            return StridedSpan<_Scalar>(data() + index * col_stride(), _RowCount, row_stride());
+        }
+
+        StridedSpan<const _Scalar> col(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < _ColCount, "Index %zu is out of bounds", index);
+            return StridedSpan<const _Scalar>(data() + index * col_stride(), _RowCount, row_stride());
+        }
+
+        /**
+         * @brief Returns the transposed matrix as a new _ColCount x _RowCount matrix in the same layout. Use
+         * transpose_view() to read the transpose without copying.
+         */
+        constexpr Matrix<_Scalar, _ColCount, _RowCount, _Layout> transpose() const {
+            Matrix<_Scalar, _ColCount, _RowCount, _Layout> ret;
+
+            if (Utils::is_constant_evaluated()) {
+                for (size_t i = 0; i < _RowCount; ++i) {
+                    for (size_t j = 0; j < _ColCount; ++j) ret(j, i) = element(i, j);
+                }
+            } else {
+                ret.assign_strided(data(), col_stride(), row_stride());
+            }
+
+            return ret;
+        }
+
+        /**
+         * @brief Transposes a square matrix in place.
+         * @return A reference to this matrix.
+         */
+        constexpr Matrix& transpose_inplace() {
+            static_assert(_RowCount == _ColCount, "Only square matrices can be transposed in place");
+
+            if (Utils::is_constant_evaluated()) {
+                for (size_t i = 0; i < _RowCount; ++i) {
+                    for (size_t j = i + 1; j < _ColCount; ++j) {
+                        const _Scalar tmp = this->data_[i][j];
+                        this->data_[i][j] = this->data_[j][i];
+                        this->data_[j][i] = tmp;
+                    }
+                }
+            } else {
+                Kernels::transpose_inplace(_RowCount, data(), Shape::leading_dimension);
+            }
+
+            return *this;
+        }
+
+        /**
+         * Access an element in the matrix using the subscript operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
          *
          * @param index The row index of the element to access.
-         * @return A constant reference to the array of elements in the specified row.
+         * @return A constant reference to the array of elements in the specified row, or a StridedSpan over the
+         * row for layouts other than packed row-major.
          */
-        constexpr const std::array<_Scalar, _ColCount>& operator[](size_t index) const {
-            if (index >= _RowCount) Utils::throw_out_of_range_error("Index %zu is out of bounds", index);
+        constexpr ConstRowReference operator[](size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < _RowCount, "Index %zu is out of bounds", index);
 
-            return this->data_[index];
+            if constexpr (Shape::is_dense_row_major) {
+                return this->data_[index];
+            } else {
+                return row(index);
+            }
         }
 
         /**
-         * Access an element in the matrix using the function call operator.
+         * Access an element in the matrix using the function call operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
          *
          * @param indexOuter The row index of the element to access.
          * @param indexInner The column index of the element to access.
          * @return A constant reference to the element at the specified row and column.
          */
         constexpr const _Scalar& operator()(size_t indexOuter, size_t indexInner) const {
-            if (indexOuter < 0 || indexOuter >= _RowCount) Utils::throw_out_of_range_error("Index outer %zu is out of bounds", indexOuter);
-            if (indexInner < 0 || indexInner >= _ColCount) Utils::throw_out_of_range_error("index inner %zu is out of bounds", indexInner);
+            MATRIXLIB_CHECK_INDEX(indexOuter < _RowCount, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < _ColCount, "index inner %zu is out of bounds", indexInner);
 
-            return this->data_[indexOuter][indexInner];
+            return element(indexOuter, indexInner);
         }
 
         /**
-         * Access an element in the matrix using the subscript operator.
+         * Access an element in the matrix using the subscript operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
          *
          * @param index The row index of the element to access.
-         * @return A reference to the array of elements in the specified row.
+         * @return A reference to the array of elements in the specified row, or a StridedSpan over the row for
+         * layouts other than packed row-major.
          */
-        constexpr std::array<_Scalar, _ColCount>& operator[](size_t index) {
-            if (index >= _RowCount) Utils::throw_out_of_range_error("Index %zu is out of bounds", index);
+        constexpr RowReference operator[](size_t index) {
+            MATRIXLIB_CHECK_INDEX(index < _RowCount, "Index %zu is out of bounds", index);
 
-            return this->data_[index];
+            if constexpr (Shape::is_dense_row_major) {
+                return this->data_[index];
+            } else {
+                return row(index);
+            }
         }
 
         /**
-         * Access an element in the matrix using the function call operator.
+         * Access an element in the matrix using the function call operator. Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
          *
          * @param indexOuter The row index of the element to access.
          * @param indexInner The column index of the element to access.
          * @return A reference to the element at the specified row and column.
          */
         constexpr _Scalar& operator()(size_t indexOuter, size_t indexInner) {
-            if (indexOuter >= _RowCount) Utils::throw_out_of_range_error("Index outer %zu is out of bounds", indexOuter);
-            if (indexInner >= _ColCount) Utils::throw_out_of_range_error("index inner %zu is out of bounds", indexInner);
+            MATRIXLIB_CHECK_INDEX(indexOuter < _RowCount, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < _ColCount, "index inner %zu is out of bounds", indexInner);
 
-            return this->data_[indexOuter][indexInner];
+            return element(indexOuter, indexInner);
         }
 
         /**
@@ -170,15 +559,56 @@ namespace MatrixLib {
          * @return True if the matrices are equal, false otherwise.
          */
         constexpr bool operator==(const Matrix& other) const {
+            if (!Utils::is_constant_evaluated()) {
+                return [&] {
+                    MATRIXLIB_PROBE(Instrumentation::Operation::compare, _RowCount, _ColCount, 0, 0, 2 * _RowCount * _ColCount * sizeof(_Scalar));
+
+                    if constexpr (Shape::leading_dimension == Shape::inner) {
+                        return Kernels::equal(data(), other.data(), _RowCount * _ColCount);
+                    } else {
+                        for (size_t k = 0; k < Shape::outer; ++k) {
+                            if (!Kernels::equal(this->data_[k].data(), other.data_[k].data(), Shape::inner)) return false;
+                        }
+                        return true;
+                    }
+                }();
+            }
+
+            for (size_t i = 0; i < _RowCount; ++i) {
+                for (size_t j = 0; j < _ColCount; ++j) {
+                    if (element(i, j) != other.element(i, j)) return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Check if the matrix is equal to a matrix of the same shape stored in another layout.
+         */
+        template <typename _OtherLayout>
+        constexpr bool operator==(const Matrix<_Scalar, _RowCount, _ColCount, _OtherLayout>& other) const {
+            if (!Utils::is_constant_evaluated()) {
+                return [&] {
+                    MATRIXLIB_PROBE(Instrumentation::Operation::compare, _RowCount, _ColCount, 0, 0, 2 * _RowCount * _ColCount * sizeof(_Scalar));
+                    return Detail::equal_strided(Detail::strided_ref(*this), Detail::strided_ref(other));
+                }();
+            }
+
             for (size_t i = 0; i < _RowCount; ++i) {
                 for (size_t j = 0; j < _ColCount; ++j) {
-                    if (this->data_[i][j] != other.data_[i][j]) return false;
+                    if (element(i, j) != other.element(i, j)) return false;
                 }
             }
 
             return true;
         }
 
+        template <typename _OtherLayout>
+        constexpr bool operator!=(const Matrix<_Scalar, _RowCount, _ColCount, _OtherLayout>& other) const {
+            return !(operator==(other));
+        }
+
         /**
          * @brief Check if the matrix is not equal to another matrix.
          *
@@ -200,9 +630,18 @@ namespace MatrixLib {
          * @return A reference to this matrix after the addition.
          */
         constexpr Matrix& operator+=(const Matrix& other) {
+            if (!Utils::is_constant_evaluated()) {
+                /* Padding is updated along with the elements, so each call is one flat vector loop */
+                [&] {
+                    MATRIXLIB_PROBE(Instrumentation::Operation::add, _RowCount, _ColCount, 0, _RowCount * _ColCount, 3 * _RowCount * _ColCount * sizeof(_Scalar));
+                    Kernels::add_inplace(data(), other.data(), Shape::storage_size);
+                }();
+                return *this;
+            }
+
             for (size_t i = 0; i < _RowCount; ++i) {
                 for (size_t j = 0; j < _ColCount; ++j) {
-                    this->data_[i][j] += other.data_[i][j];
+                    element(i, j) += other.element(i, j);
                 }
             }
 
@@ -219,15 +658,67 @@ namespace MatrixLib {
          * @return A reference to this matrix after the addition.
          */
         constexpr Matrix& operator-=(const Matrix& other) {
+            if (!Utils::is_constant_evaluated()) {
+                /* Padding is updated along with the elements, so each call is one flat vector loop */
+                [&] {
+                    MATRIXLIB_PROBE(Instrumentation::Operation::subtract, _RowCount, _ColCount, 0, _RowCount * _ColCount, 3 * _RowCount * _ColCount * sizeof(_Scalar));
+                    Kernels::sub_inplace(data(), other.data(), Shape::storage_size);
+                }();
+                return *this;
+            }
+
             for (size_t i = 0; i < _RowCount; ++i) {
                 for (size_t j = 0; j < _ColCount; ++j) {
-                    this->data_[i][j] -= other.data_[i][j];
+                    element(i, j) -= other.element(i, j);
                 }
             }
 
             return *this;
         }
 
+        /**
+         * Add a matrix expression to this matrix element-wise without materialising it. Products inside the
+         * expression are accumulated by the GEMM kernels directly into this matrix.
+         *
+         * @param expr The expression to add to this matrix.
+         * @return A reference to this matrix after the addition.
+         */
+        template <typename E>
+        constexpr Matrix& operator+=(const MatrixExpression<E>& expr) {
+            Detail::evaluate_accumulate(*this, expr.derived(), _Scalar(1));
+            return *this;
+        }
+
+        /**
+         * Subtract a matrix expression from this matrix element-wise without materialising it.
+         *
+         * @param expr The expression to subtract from this matrix.
+         * @return A reference to this matrix after the subtraction.
+         */
+        template <typename E>
+        constexpr Matrix& operator-=(const MatrixExpression<E>& expr) {
+            Detail::evaluate_accumulate(*this, expr.derived(), static_cast<_Scalar>(-1));
+            return *this;
+        }
+
+        /**
+         * Add a matrix of the same shape stored in another layout to this matrix element-wise.
+         */
+        template <typename _OtherLayout>
+        constexpr Matrix& operator+=(const Matrix<_Scalar, _RowCount, _ColCount, _OtherLayout>& other) {
+            Detail::evaluate_accumulate(*this, other, _Scalar(1));
+            return *this;
+        }
+
+        /**
+         * Subtract a matrix of the same shape stored in another layout from this matrix element-wise.
+         */
+        template <typename _OtherLayout>
+        constexpr Matrix& operator-=(const Matrix<_Scalar, _RowCount, _ColCount, _OtherLayout>& other) {
+            Detail::evaluate_accumulate(*this, other, static_cast<_Scalar>(-1));
+            return *this;
+        }
+
         /**
          * Multiply this matrix by a scalar value.
          *
@@ -239,35 +730,26 @@ namespace MatrixLib {
         constexpr Matrix& operator*=(const _NumericScalar& val) {
             static_assert(std::is_arithmetic<_NumericScalar>::value, "Can only do scalar multiplication with a numeric type!");
 
+            /* The flat kernel multiplies in _Scalar, which only matches `x *= val` when val does not promote x */
+            if constexpr (std::is_same<typename std::common_type<_Scalar, _NumericScalar>::type, _Scalar>::value) {
+                if (!Utils::is_constant_evaluated()) {
+                    [&] {
+                        MATRIXLIB_PROBE(Instrumentation::Operation::scale, _RowCount, _ColCount, 0, _RowCount * _ColCount, 2 * _RowCount * _ColCount * sizeof(_Scalar));
+                        Kernels::scale_inplace(data(), static_cast<_Scalar>(val), Shape::storage_size);
+                    }();
+                    return *this;
+                }
+            }
+
             for (size_t i = 0; i < _RowCount; ++i) {
                 for (size_t j = 0; j < _ColCount; ++j) {
-                    this->data_[i][j] *= val;
+                    element(i, j) *= val;
                 }
             }
 
             return *this;
         }
 
-        /**
-         * Multiply two matrices together.
-         *
-         * @tparam T The type of the elements in both matrices
-         * @tparam M The number of rows in the left-hand matrix.
-         * @tparam N The number of columns in the left-hand matrix and the number of rows in the right-hand matrix.
-         * @tparam _OtherRowCount The number of rows in the right-hand matrix.
-         * @tparam _OtherColCount The number of columns in the right-hand matrix.
-         * 
-         * @param lhs The left-hand matrix.
-         * @param rhs The right-hand matrix.
-         * 
-         * @pre The number of columns in the left matrix must be equal to the number of rows in the right matrix.
-         * @post The resulting matrix has the same number of rows as the left matrix and the same number of columns as the right matrix.
-         * 
-         * @return The matrix resulting from the multiplication.
-         */
-        template <typename T, size_t M, size_t N, size_t _OtherRowCount, size_t _OtherColCount>
-        constexpr friend Matrix<T, M, _OtherColCount> operator*(const Matrix<T, M, N>& lhs, const Matrix<T, _OtherRowCount, _OtherColCount>& rhs);
-
         /**
          * @brief Overload of the stream output operator for the Matrix class.
          * 
@@ -282,8 +764,8 @@ namespace MatrixLib {
          * Matrix objects. The matrix is printed in row-major order, with each row printed
          * on a separate line.
          */
-        template <typename T, size_t M, size_t N>
-        constexpr friend std::ostream& operator<<(std::ostream& os, Matrix<T, M, N> const &toPrint);
+        template <typename T, size_t M, size_t N, typename L>
+        constexpr friend std::ostream& operator<<(std::ostream& os, Matrix<T, M, N, L> const &toPrint);
 
         /**
          * @brief Converts the matrix to a string representation.
@@ -298,97 +780,157 @@ namespace MatrixLib {
          * for logging or other purposes. The matrix is printed in row-major order, with
          * each row separated by a newline character.
          */
-        template <typename T, size_t M, size_t N>
-        constexpr friend std::string to_string(const Matrix<T, M, N>& toPrint);
+        template <typename T, size_t M, size_t N, typename L>
+        constexpr friend std::string to_string(const Matrix<T, M, N, L>& toPrint);
     };
 
-    /**
-     * @brief Returns the result of adding two matrices element-wise.
-     *
-     * This function returns a new matrix which is the result of adding
-     * each element of the left-hand side matrix with the corresponding
-     * element of the right-hand side matrix.
-     *
-     * @tparam _Scalar The scalar type of the matrix elements.
-     * @tparam _RowCount The number of rows in the matrix.
-     * @tparam _ColCount The number of columns in the matrix.
-     * @param lhs The left-hand side matrix.
-     * @param rhs The right-hand side matrix.
-     * @return The result of adding the two matrices element-wise.
-     */
-    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
-    constexpr Matrix<_Scalar, _RowCount, _ColCount> operator+(const Matrix<_Scalar, _RowCount, _ColCount>& lhs, const Matrix<_Scalar, _RowCount, _ColCount>& rhs) {
-        return Matrix<_Scalar, _RowCount, _ColCount>{lhs} += rhs;
-    }
+namespace Detail {
+    /* Lets the other matrix types in the library reach Matrix's flat storage without widening its public API */
+    struct MatrixAccess {
+        template <typename T, size_t R, size_t C, typename L>
+        static constexpr T* data(Matrix<T, R, C, L>& m) { return m.data(); }
 
-    /**
-     * @brief Returns the result of subtracting two matrices element-wise.
-     *
-     * This function returns a new matrix which is the result of subtracting
-     * each element of the right-hand side matrix from the corresponding
-     * element of the left-hand side matrix.
-     *
-     * @tparam _Scalar The scalar type of the matrix elements.
-     * @tparam _RowCount The number of rows in the matrix.
-     * @tparam _ColCount The number of columns in the matrix.
-     * @param lhs The left-hand side matrix.
-     * @param rhs The right-hand side matrix.
-     * @return The result of subtracting the two matrices element-wise.
-     */
-    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
-    constexpr Matrix<_Scalar, _RowCount, _ColCount> operator-(const Matrix<_Scalar, _RowCount, _ColCount>& lhs, const Matrix<_Scalar, _RowCount, _ColCount>& rhs) {
-        return Matrix<_Scalar, _RowCount, _ColCount>{lhs} -= rhs;
-    }
+        template <typename T, size_t R, size_t C, typename L>
+        static constexpr const T* data(const Matrix<T, R, C, L>& m) { return m.data(); }
 
-    template <typename T, size_t M, size_t N, size_t _OtherRowCount, size_t _OtherColCount>
-    constexpr Matrix<T, M, _OtherColCount> operator*(const Matrix<T, M, N>& lhs, const Matrix<T, _OtherRowCount, _OtherColCount>& rhs) {
-        static_assert(N == _OtherRowCount, "Matrix multiplication is only supported if second matrix's row count == first matrix's column count");
+        template <typename T, size_t R, size_t C, typename L>
+        static constexpr T& at(Matrix<T, R, C, L>& m, size_t i, size_t j) { return m.element(i, j); }
 
-        Matrix<T, M, _OtherColCount> ret;
+        template <typename T, size_t R, size_t C, typename L>
+        static constexpr const T& at(const Matrix<T, R, C, L>& m, size_t i, size_t j) { return m.element(i, j); }
+    };
 
-        for (size_t i = 0; i < M; ++i) {
-            std::fill(ret.data_[i].begin(), ret.data_[i].end(), 0);
+    template <typename T, size_t R, size_t C, typename L>
+    struct OperandTraits<Matrix<T, R, C, L>> {
+        using Scalar = T;
+        using Type = Matrix<T, R, C, L>;
+        using Shape = typename L::template Shape<T, R, C>;
+        static constexpr bool is_operand = true;
+        static constexpr bool is_leaf = true;
+        static constexpr bool is_expression = false;
+        static constexpr bool is_dynamic = false;
+        static constexpr bool has_product = false;
+        static constexpr bool has_linear_access = Shape::is_dense_row_major;
+        static constexpr size_t row_extent = R;
+        static constexpr size_t col_extent = C;
+
+        static constexpr size_t rows(const Type&) { return R; }
+        static constexpr size_t cols(const Type&) { return C; }
+        static constexpr T coeff(const Type& m, size_t i, size_t j) { return MatrixAccess::at(m, i, j); }
+        static constexpr T coeff(const Type& m, size_t k) { return MatrixAccess::data(m)[k]; }
+        static constexpr T& at(Type& m, size_t i, size_t j) { return MatrixAccess::at(m, i, j); }
+        static constexpr T* data(Type& m) { return MatrixAccess::data(m); }
+
+        static DenseRef<T> ref(const Type& m) {
+            static_assert(has_linear_access, "Only packed row-major matrices can be read as a flat array");
+            return {MatrixAccess::data(m), R, C};
         }
 
-        for (size_t i = 0; i < M; ++i) {
-            for (size_t j = 0; j < _OtherColCount; ++j) {
-                for (size_t k = 0; k < N; ++k) {
-                    ret.data_[i][j] += lhs.data_[i][k] * rhs.data_[k][j];
-                }
+        static StridedRef<T> strided(const Type& m) { return {MatrixAccess::data(m), R, C, Type::row_stride(), Type::col_stride()}; }
+
+        static bool aliases(const Type& m, const void* begin, const void* end) {
+            return ranges_overlap(MatrixAccess::data(m), MatrixAccess::data(m) + Shape::storage_size, begin, end);
+        }
+
+        static constexpr void resize(Type&, size_t rows, size_t cols) {
+            if (rows != R || cols != C) {
+                Utils::throw_invalid_argument_error("Cannot assign a %zux%zu matrix to a %zux%zu matrix", rows, cols, R, C);
             }
         }
+    };
+} /* Detail */
 
-        return ret;
+    template <typename _Scalar, size_t _RowCount, size_t _ColCount, typename _Layout>
+    constexpr std::string to_string(const Matrix<_Scalar, _RowCount, _ColCount, _Layout>& toPrint) {
+        return Detail::rows_to_string(toPrint.data(), _RowCount, _ColCount, toPrint.row_stride(), toPrint.col_stride());
     }
 
-    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
-    constexpr std::string to_string(const Matrix<_Scalar, _RowCount, _ColCount>& toPrint) {
-        std::stringstream ss;
+    template <typename _Scalar, size_t _RowCount, size_t _ColCount, typename _Layout>
+    constexpr std::ostream& operator<<(std::ostream& os, const Matrix<_Scalar, _RowCount, _ColCount, _Layout>& toPrint) {
+        Detail::write_rows(os, toPrint.data(), _RowCount, _ColCount, toPrint.row_stride(), toPrint.col_stride());
+        return os;
+    }
 
-        for (size_t i = 0; i < _RowCount; ++i) {
-            ss << "| ";
-            for (size_t j = 0; j < _ColCount - 1; ++j) {
-                ss << toPrint.data_[i][j] << ", ";
-            }
+namespace Detail {
+    template <typename _Scalar, size_t _Size, typename _Layout, size_t... _Index>
+    constexpr _Scalar diagonal_sum(const Matrix<_Scalar, _Size, _Size, _Layout>& m, std::index_sequence<_Index...>) {
+        return (_Scalar(0) + ... + m(_Index, _Index));
+    }
+} /* Detail */
 
-            ss << toPrint.data_[i][_ColCount - 1] << " |\n";
+    /**
+     * @brief Sum of the main diagonal of a square matrix, unrolled at compile time and usable in constant
+     * expressions.
+     */
+    template <typename _Scalar, size_t _Size, typename _Layout>
+    constexpr _Scalar trace(const Matrix<_Scalar, _Size, _Size, _Layout>& m) {
+        return Detail::diagonal_sum(m, std::make_index_sequence<_Size>{});
+    }
+
+    /**
+     * @brief Sum of the main diagonal of a square matrix or expression.
+     * @throw std::invalid_argument if the operand is not square.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    constexpr typename Detail::OperandTraits<M>::Scalar trace(const M& a) {
+        using Traits = Detail::OperandTraits<M>;
+
+        if (Traits::rows(a) != Traits::cols(a)) {
+            Utils::throw_invalid_argument_error("Trace requires a square matrix, got %zux%zu", Traits::rows(a), Traits::cols(a));
         }
 
-        return ss.str();
+        const auto& m = Detail::eval_operand(a);
+        using Plain = typename std::decay<decltype(m)>::type;
+
+        typename Traits::Scalar sum(0);
+        for (size_t i = 0; i < Traits::rows(a); ++i) sum += Detail::OperandTraits<Plain>::coeff(m, i, i);
+        return sum;
     }
 
-    template <typename _Scalar, size_t _RowCount, size_t _ColCount>
-    constexpr std::ostream& operator<<(std::ostream& os, const Matrix<_Scalar, _RowCount, _ColCount>& toPrint) {
-        for (size_t i = 0; i < _RowCount; ++i) {
-            os << "| ";
-            for (size_t j = 0; j < _ColCount - 1; ++j) {
-                os << toPrint.data_[i][j] << ", ";
+    /**
+     * @brief Raises a square matrix to a power known at compile time by repeated squaring: the chain of
+     * O(log _Exponent) products is unrolled, so a constant matrix raised in a constant expression leaves only
+     * the result in the binary.
+     * @tparam _Exponent The power; pow<0> is the identity.
+     */
+    template <size_t _Exponent, typename _Scalar, size_t _Size, typename _Layout>
+    constexpr Matrix<_Scalar, _Size, _Size, _Layout> pow(const Matrix<_Scalar, _Size, _Size, _Layout>& m) {
+        using Result = Matrix<_Scalar, _Size, _Size, _Layout>;
+
+        if constexpr (_Exponent == 0) {
+            return Result::identity();
+        } else if constexpr (_Exponent == 1) {
+            return m;
+        } else {
+            const Result half = pow<_Exponent / 2>(m);
+            const Result square = half * half;
+            if constexpr (_Exponent % 2 == 0) {
+                return square;
+            } else {
+                return Result(square * m);
             }
+        }
+    }
+
+    /**
+     * @brief Raises a square matrix to a power by repeated squaring, in O(log exponent) products. Usable in
+     * constant expressions.
+     * @param exponent The power; 0 gives the identity.
+     */
+    template <typename _Scalar, size_t _Size, typename _Layout>
+    constexpr Matrix<_Scalar, _Size, _Size, _Layout> pow(const Matrix<_Scalar, _Size, _Size, _Layout>& m, size_t exponent) {
+        using Result = Matrix<_Scalar, _Size, _Size, _Layout>;
 
-            os << toPrint.data_[i][_ColCount - 1] << " |\n";
+        Result ret = Result::identity();
+        Result base = m;
+
+        while (exponent > 0) {
+            if (exponent & 1) ret = Result(ret * base);
+            exponent >>= 1;
+            if (exponent > 0) base = Result(base * base);
         }
 
-        return os;
+        return ret;
     }
 
 } /* Matrix */
@@ -0,0 +1,280 @@
+#ifndef MATRIXVECTOR_H
+#define MATRIXVECTOR_H
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "utils.h"
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "gemv.h"
+#include "reduce.h"
+
+namespace MatrixLib {
+    /**
+     * @brief Column vector of _Size elements: a Matrix<_Scalar, _Size, 1>, or a heap-backed
+     * DynMatrix<_Scalar, Dynamic, 1> when _Size is Dynamic.
+     *
+     * Vectors are matrices, so they take part in every expression and mix freely with Matrix, DynMatrix and
+     * views. Products with a vector run through the matrix-vector kernels rather than the general GEMM.
+     */
+    template <typename _Scalar, size_t _Size = Dynamic>
+    using Vector = typename Detail::PlainObject<_Scalar, _Size, 1, _Size == Dynamic>::type;
+
+    /**
+     * @brief Row vector of _Size elements: a Matrix<_Scalar, 1, _Size>, or a DynMatrix<_Scalar, 1, Dynamic>
+     * when _Size is Dynamic.
+     */
+    template <typename _Scalar, size_t _Size = Dynamic>
+    using RowVector = typename Detail::PlainObject<_Scalar, 1, _Size, _Size == Dynamic>::type;
+
+namespace Detail {
+    /* Element i of a vector lives at data[i * inc]; T is const-qualified for operands that are only read */
+    template <typename T>
+    struct VectorRef {
+        T* data;
+        size_t size;
+        ptrdiff_t inc;
+    };
+
+    /* Row and column vectors, including rows and columns of matrices, read as one strided sequence */
+    template <typename T>
+    VectorRef<const T> vector_ref(const StridedRef<T>& s) {
+        if (s.rows != 1 && s.cols != 1) {
+            Utils::throw_invalid_argument_error("Expected a vector, got a %zux%zu matrix", s.rows, s.cols);
+        }
+
+        return {s.data, s.rows * s.cols, s.cols == 1 ? s.row_stride : s.col_stride};
+    }
+
+    /* The elements of a Matrix, a DynMatrix or a view of mutable elements, for the routines that update in place */
+    template <typename E>
+    typename OperandTraits<E>::Scalar* mutable_data(E& e) {
+        static_assert(OperandTraits<E>::is_leaf || is_matrix_view<E>::value, "Only matrices and views can be updated in place");
+
+        if constexpr (is_matrix_view<E>::value) {
+            static_assert(!std::is_const<typename std::remove_pointer<decltype(e.data())>::type>::value,
+                          "Cannot update a view of const elements");
+            return e.data();
+        } else {
+            return OperandTraits<E>::data(e);
+        }
+    }
+
+    template <typename E>
+    VectorRef<typename OperandTraits<E>::Scalar> mutable_vector_ref(E& e) {
+        const auto v = vector_ref(strided_ref(e));
+        return {mutable_data(e), v.size, v.inc};
+    }
+
+    /* Whether operand e shares memory with the strided range of n elements starting at data */
+    template <typename E, typename T>
+    bool overlaps(const E& e, const T* data, size_t n, ptrdiff_t inc) {
+        if (n == 0) return false;
+        const T* last = data + static_cast<ptrdiff_t>(n - 1) * inc;
+        return OperandTraits<E>::aliases(e, std::min(data, last), std::max(data, last) + 1);
+    }
+
+    /* A unit-stride copy of v, for operands that overlap the destination of an in-place routine */
+    template <typename T>
+    VectorRef<const T> copy_vector(const VectorRef<const T>& v, std::vector<T>& buffer) {
+        buffer.resize(v.size);
+        for (size_t i = 0; i < v.size; ++i) buffer[i] = v.data[i * v.inc];
+        return {buffer.data(), v.size, 1};
+    }
+
+    template <typename X, typename Y>
+    void check_vector_lengths(const VectorRef<X>& x, const VectorRef<Y>& y) {
+        if (x.size != y.size) {
+            Utils::throw_invalid_argument_error("Vector lengths do not match: %zu and %zu", x.size, y.size);
+        }
+    }
+
+    /* The kernels the public routines run on the calling thread; parallel.hpp supplies a pool-backed set */
+    struct SequencedVectorKernels {
+        template <typename T>
+        T dot(size_t n, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy) const {
+            return Kernels::dot<T>(n, x, incx, y, incy);
+        }
+
+        template <typename T>
+        void axpy(size_t n, T alpha, const T* x, ptrdiff_t incx, T* y, ptrdiff_t incy) const {
+            Kernels::axpy<T>(n, alpha, x, incx, y, incy);
+        }
+
+        template <typename T>
+        void gemv(size_t m, size_t n, T alpha, const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                  const T* x, ptrdiff_t incx, T beta, T* y, ptrdiff_t incy) const {
+            Kernels::gemv<T>(m, n, alpha, a, rsa, csa, x, incx, beta, y, incy);
+        }
+
+        template <typename T>
+        void ger(size_t m, size_t n, T alpha, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy,
+                 T* a, ptrdiff_t rsa, ptrdiff_t csa) const {
+            Kernels::ger<T>(m, n, alpha, x, incx, y, incy, a, rsa, csa);
+        }
+    };
+
+    template <typename K, typename X, typename Y>
+    typename OperandTraits<X>::Scalar dot(const K& kernels, const X& x, const Y& y) {
+        static_assert(std::is_same<typename OperandTraits<X>::Scalar, typename OperandTraits<Y>::Scalar>::value,
+                      "Dot product requires the same scalar type");
+
+        const auto& xs = stored_operand(x);
+        const auto& ys = stored_operand(y);
+        const auto xv = vector_ref(strided_ref(xs));
+        const auto yv = vector_ref(strided_ref(ys));
+        check_vector_lengths(xv, yv);
+
+        return kernels.dot(xv.size, xv.data, xv.inc, yv.data, yv.inc);
+    }
+
+    template <typename K, typename X, typename Y>
+    void axpy(const K& kernels, typename OperandTraits<X>::Scalar alpha, const X& x, Y& y) {
+        using T = typename OperandTraits<X>::Scalar;
+        static_assert(std::is_same<T, typename OperandTraits<Y>::Scalar>::value, "axpy requires the same scalar type");
+
+        const auto yv = mutable_vector_ref(y);
+        const auto& xs = stored_operand(x);
+        auto xv = vector_ref(strided_ref(xs));
+        check_vector_lengths(xv, yv);
+
+        std::vector<T> copy;
+        if (overlaps(xs, yv.data, yv.size, yv.inc)) xv = copy_vector(xv, copy);
+
+        kernels.axpy(xv.size, alpha, xv.data, xv.inc, yv.data, yv.inc);
+    }
+
+    template <typename K, typename M, typename X, typename Y>
+    void gemv(const K& kernels, typename OperandTraits<M>::Scalar alpha, const M& a, const X& x,
+              typename OperandTraits<M>::Scalar beta, Y& y) {
+        using T = typename OperandTraits<M>::Scalar;
+        static_assert(std::is_same<T, typename OperandTraits<X>::Scalar>::value && std::is_same<T, typename OperandTraits<Y>::Scalar>::value,
+                      "Matrix-vector product requires the same scalar type");
+
+        const auto yv = mutable_vector_ref(y);
+        const auto& as = stored_operand(a);
+        const auto& xs = stored_operand(x);
+        const auto av = strided_ref(as);
+        const auto xv = vector_ref(strided_ref(xs));
+
+        if (av.cols != xv.size || av.rows != yv.size) {
+            Utils::throw_invalid_argument_error("Cannot multiply a %zux%zu matrix by a vector of %zu elements into one of %zu",
+                                                av.rows, av.cols, xv.size, yv.size);
+        }
+
+        if (overlaps(as, yv.data, yv.size, yv.inc) || overlaps(xs, yv.data, yv.size, yv.inc)) {
+            /* y is also an input: accumulate into a copy of it and write the result back once */
+            std::vector<T> result(yv.size);
+            for (size_t i = 0; i < yv.size; ++i) result[i] = yv.data[i * yv.inc];
+            kernels.gemv(av.rows, av.cols, alpha, av.data, av.row_stride, av.col_stride, xv.data, xv.inc, beta, result.data(), 1);
+            for (size_t i = 0; i < yv.size; ++i) yv.data[i * yv.inc] = result[i];
+        } else {
+            kernels.gemv(av.rows, av.cols, alpha, av.data, av.row_stride, av.col_stride, xv.data, xv.inc, beta, yv.data, yv.inc);
+        }
+    }
+
+    template <typename K, typename X, typename Y, typename M>
+    void ger(const K& kernels, typename OperandTraits<M>::Scalar alpha, const X& x, const Y& y, M& a) {
+        using T = typename OperandTraits<M>::Scalar;
+        static_assert(std::is_same<T, typename OperandTraits<X>::Scalar>::value && std::is_same<T, typename OperandTraits<Y>::Scalar>::value,
+                      "Rank-1 update requires the same scalar type");
+
+        const auto as = strided_ref(a);
+        T* data = mutable_data(a);
+        const auto& xs = stored_operand(x);
+        const auto& ys = stored_operand(y);
+        auto xv = vector_ref(strided_ref(xs));
+        auto yv = vector_ref(strided_ref(ys));
+
+        if (as.rows != xv.size || as.cols != yv.size) {
+            Utils::throw_invalid_argument_error("Cannot add the outer product of vectors of %zu and %zu elements to a %zux%zu matrix",
+                                                xv.size, yv.size, as.rows, as.cols);
+        }
+
+        std::vector<T> xCopy, yCopy;
+        if (as.rows > 0 && as.cols > 0) {
+            const T* last = data + (as.rows - 1) * as.row_stride + (as.cols - 1) * as.col_stride;
+            if (OperandTraits<typename std::decay<decltype(xs)>::type>::aliases(xs, data, last + 1)) xv = copy_vector(xv, xCopy);
+            if (OperandTraits<typename std::decay<decltype(ys)>::type>::aliases(ys, data, last + 1)) yv = copy_vector(yv, yCopy);
+        }
+
+        kernels.ger(as.rows, as.cols, alpha, xv.data, xv.inc, yv.data, yv.inc, data, as.row_stride, as.col_stride);
+    }
+} /* Detail */
+
+    /**
+     * @brief Dot product of two vectors of the same length. Row and column vectors, rows and columns of
+     * matrices, views and expressions are all accepted.
+     * @throw std::invalid_argument if an operand is not a vector or the lengths differ.
+     */
+    template <typename X, typename Y, Detail::enable_if_operands<X, Y> = 0>
+    typename Detail::OperandTraits<X>::Scalar dot(const X& x, const Y& y) {
+        return Detail::dot(Detail::SequencedVectorKernels{}, x, y);
+    }
+
+    /**
+     * @brief Euclidean norm of a vector, or Frobenius norm of a matrix: the square root of the sum of the squared
+     * elements, added up pairwise, or in double for integer matrices.
+     */
+    template <typename X, typename std::enable_if<Detail::OperandTraits<X>::is_operand, int>::type = 0>
+    auto norm(const X& x) {
+        using std::sqrt;
+        const auto& xs = Detail::stored_operand(x);
+        const auto s = Detail::strided_ref(xs);
+        using T = typename Detail::OperandTraits<X>::Scalar;
+        if (s.rows == 0 || s.cols == 0) return sqrt(T(0));
+
+        /* The squares of integers are added up in double, as the element type would overflow */
+        if constexpr (std::is_integral<T>::value) {
+            double ret = 0;
+            for (size_t i = 0; i < s.rows; ++i) {
+                for (size_t j = 0; j < s.cols; ++j) {
+                    const double v = static_cast<double>(s.data[static_cast<ptrdiff_t>(i) * s.row_stride + static_cast<ptrdiff_t>(j) * s.col_stride]);
+                    ret += v * v;
+                }
+            }
+            return sqrt(ret);
+        } else {
+            return sqrt(Kernels::reduce<Kernels::Reduction::sum_squares>(s.rows, s.cols, s.data, s.row_stride, s.col_stride));
+        }
+    }
+
+    /**
+     * @brief y += alpha * x for two vectors of the same length.
+     * @param y A Matrix, DynMatrix or mutable view shaped as a row or column vector.
+     * @throw std::invalid_argument if an operand is not a vector or the lengths differ.
+     */
+    template <typename X, typename Y, Detail::enable_if_operands<X, typename std::decay<Y>::type> = 0>
+    void axpy(typename Detail::OperandTraits<X>::Scalar alpha, const X& x, Y&& y) {
+        Detail::axpy(Detail::SequencedVectorKernels{}, alpha, x, y);
+    }
+
+    /**
+     * @brief Matrix-vector product y = alpha * A * x + beta * y, updating y in place. `y = A * x` gives the same
+     * result for alpha = 1 and beta = 0; gemv also accumulates, scales and writes into views without a temporary.
+     * When beta is zero the previous contents of y are ignored.
+     * @param y A Matrix, DynMatrix or mutable view shaped as a vector of A.rows() elements.
+     * @throw std::invalid_argument if the shapes do not match.
+     */
+    template <typename M, typename X, typename Y, Detail::enable_if_operands<M, X> = 0>
+    void gemv(typename Detail::OperandTraits<M>::Scalar alpha, const M& a, const X& x,
+              typename Detail::OperandTraits<M>::Scalar beta, Y&& y) {
+        Detail::gemv(Detail::SequencedVectorKernels{}, alpha, a, x, beta, y);
+    }
+
+    /**
+     * @brief Rank-1 update A += alpha * x * y^T.
+     * @param a A Matrix, DynMatrix or mutable view of x.size() rows and y.size() columns.
+     * @throw std::invalid_argument if the shapes do not match.
+     */
+    template <typename X, typename Y, typename M, Detail::enable_if_operands<X, Y> = 0>
+    void ger(typename Detail::OperandTraits<typename std::decay<M>::type>::Scalar alpha, const X& x, const Y& y, M&& a) {
+        Detail::ger(Detail::SequencedVectorKernels{}, alpha, x, y, a);
+    }
+} /* MatrixLib */
+
+#endif /* MATRIXVECTOR_H */
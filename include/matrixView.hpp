@@ -0,0 +1,196 @@
+#ifndef MATRIXVIEW_H
+#define MATRIXVIEW_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include "utils.h"
+#include "expression.hpp"
+
+namespace MatrixLib {
+    /**
+     * @brief Non-owning, strided view of a matrix: the whole matrix, its transpose, a block, a row, a column or
+     * every n-th element. Element (i, j) lives at `data[i * row_stride + j * col_stride]`.
+     *
+     * A view is an operand like any matrix: it can be used in `+`, `-`, scalar products and `*`, and assigned to
+     * a Matrix or DynMatrix. Products hand the view's strides straight to the GEMM kernels, so `A * transpose_view(B)`
+     * never copies B. Views are cheap to copy and are held by value inside expressions, but like StridedSpan they
+     * are invalidated by anything that reallocates the matrix they look at.
+     *
+     * @tparam _Scalar The element type, const-qualified for read-only views.
+     * @tparam _RowExtent The row count when it is known at compile time, Dynamic otherwise.
+     * @tparam _ColExtent The column count when it is known at compile time, Dynamic otherwise.
+     */
+    template <typename _Scalar, size_t _RowExtent, size_t _ColExtent>
+    class MatrixView : public MatrixExpression<MatrixView<_Scalar, _RowExtent, _ColExtent>> {
+        _Scalar* data_;
+        size_t rows_;
+        size_t cols_;
+        ptrdiff_t rowStride_;
+        ptrdiff_t colStride_;
+
+        template <typename U, size_t R, size_t C>
+        friend class MatrixView;
+
+    public:
+        using Scalar = typename std::remove_const<_Scalar>::type;
+        static constexpr size_t row_extent = _RowExtent;
+        static constexpr size_t col_extent = _ColExtent;
+        static constexpr bool is_dynamic = _RowExtent == Dynamic || _ColExtent == Dynamic;
+        static constexpr bool has_product = false;
+        static constexpr bool has_linear_access = false;
+        using PlainType = typename Detail::PlainObject<Scalar, row_extent, col_extent, is_dynamic>::type;
+
+        /**
+         * @brief Views rows x cols elements starting at data with the given strides.
+         * @throw std::invalid_argument if a dimension contradicts a static extent.
+         */
+        constexpr MatrixView(_Scalar* data, size_t rows, size_t cols, ptrdiff_t rowStride, ptrdiff_t colStride)
+            : data_(data), rows_(rows), cols_(cols), rowStride_(rowStride), colStride_(colStride) {
+            if ((_RowExtent != Dynamic && rows != _RowExtent) || (_ColExtent != Dynamic && cols != _ColExtent)) {
+                Utils::throw_invalid_argument_error("Cannot view %zux%zu elements as a %zux%zu matrix", rows, cols, _RowExtent, _ColExtent);
+            }
+        }
+
+        /**
+         * @brief A mutable view converts to a read-only one, and a fixed-size view to a runtime-sized one.
+         */
+        template <typename U, size_t R, size_t C,
+                  typename = typename std::enable_if<(std::is_same<U, _Scalar>::value || std::is_same<const U, _Scalar>::value)
+                                                     && Detail::extents_compatible(_RowExtent, R) && Detail::extents_compatible(_ColExtent, C)>::type>
+        constexpr MatrixView(const MatrixView<U, R, C>& other)
+            : MatrixView(other.data_, other.rows_, other.cols_, other.rowStride_, other.colStride_) {}
+
+        constexpr size_t rows() const noexcept { return rows_; }
+        constexpr size_t cols() const noexcept { return cols_; }
+        constexpr size_t size() const noexcept { return rows_ * cols_; }
+        constexpr ptrdiff_t row_stride() const noexcept { return rowStride_; }
+        constexpr ptrdiff_t col_stride() const noexcept { return colStride_; }
+
+        /**
+         * @return A pointer to element (0, 0).
+         */
+        constexpr _Scalar* data() const noexcept { return data_; }
+
+        /**
+         * @return Whether the view covers contiguous row-major storage, like a Matrix of the same shape.
+         */
+        constexpr bool is_contiguous() const noexcept {
+            return (colStride_ == 1 || cols_ <= 1) && (rowStride_ == static_cast<ptrdiff_t>(cols_) || rows_ <= 1);
+        }
+
+        /**
+         * Access an element of the viewed matrix. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param indexOuter The row index of the element to access.
+         * @param indexInner The column index of the element to access.
+         * @return A reference to the element, const for read-only views.
+         */
+        constexpr _Scalar& operator()(size_t indexOuter, size_t indexInner) const {
+            MATRIXLIB_CHECK_INDEX(indexOuter < rows_, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < cols_, "index inner %zu is out of bounds", indexInner);
+
+            return data_[indexOuter * rowStride_ + indexInner * colStride_];
+        }
+
+        constexpr Scalar coeff(size_t i, size_t j) const { return data_[i * rowStride_ + j * colStride_]; }
+        constexpr Scalar coeff(size_t k) const { return coeff(k / cols_, k % cols_); }
+
+        bool aliases(const void* begin, const void* end) const {
+            if (rows_ == 0 || cols_ == 0) return false;
+            const _Scalar* last = data_ + (rows_ - 1) * rowStride_ + (cols_ - 1) * colStride_;
+            return Detail::ranges_overlap(data_, last + 1, begin, end);
+        }
+
+        /**
+         * @return The transposed view of the same elements; nothing is copied.
+         */
+        constexpr MatrixView<_Scalar, _ColExtent, _RowExtent> transpose() const noexcept {
+            return MatrixView<_Scalar, _ColExtent, _RowExtent>(data_, cols_, rows_, colStride_, rowStride_);
+        }
+
+        /**
+         * @brief View of the rows x cols sub-matrix whose top-left element is (row, col). Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         */
+        constexpr MatrixView<_Scalar> block(size_t row, size_t col, size_t rows, size_t cols) const {
+            MATRIXLIB_CHECK_INDEX(row <= rows_ && rows <= rows_ - row && col <= cols_ && cols <= cols_ - col,
+                                  "Block %zux%zu at (%zu, %zu) is out of bounds", rows, cols, row, col);
+            return MatrixView<_Scalar>(data_ + row * rowStride_ + col * colStride_, rows, cols, rowStride_, colStride_);
+        }
+
+        /**
+         * @brief View of a row as a 1 x cols matrix. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         */
+        constexpr MatrixView<_Scalar, 1, _ColExtent> row(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < rows_, "Index %zu is out of bounds", index);
+            return MatrixView<_Scalar, 1, _ColExtent>(data_ + index * rowStride_, 1, cols_, rowStride_, colStride_);
+        }
+
+        /**
+         * @brief View of a column as a rows x 1 matrix. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         */
+        constexpr MatrixView<_Scalar, _RowExtent, 1> col(size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < cols_, "Index %zu is out of bounds", index);
+            return MatrixView<_Scalar, _RowExtent, 1>(data_ + index * colStride_, rows_, 1, rowStride_, colStride_);
+        }
+
+        /**
+         * @brief View of every rowStep-th row and colStep-th column, starting with element (0, 0).
+         * @throw std::invalid_argument if a step is zero.
+         */
+        constexpr MatrixView<_Scalar> strided(size_t rowStep, size_t colStep) const {
+            if (rowStep == 0 || colStep == 0) {
+                Utils::throw_invalid_argument_error("Cannot view every %zu-th row and %zu-th column", rowStep, colStep);
+            }
+
+            return MatrixView<_Scalar>(data_, (rows_ + rowStep - 1) / rowStep, (cols_ + colStep - 1) / colStep,
+                                       rowStride_ * static_cast<ptrdiff_t>(rowStep), colStride_ * static_cast<ptrdiff_t>(colStep));
+        }
+    };
+
+namespace Detail {
+    template <typename M>
+    using enable_if_leaf = typename std::enable_if<OperandTraits<M>::is_leaf, int>::type;
+
+    template <typename M>
+    using view_t = MatrixView<typename OperandTraits<M>::Scalar, OperandTraits<M>::row_extent, OperandTraits<M>::col_extent>;
+
+    template <typename M>
+    using const_view_t = MatrixView<const typename OperandTraits<M>::Scalar, OperandTraits<M>::row_extent, OperandTraits<M>::col_extent>;
+} /* Detail */
+
+    /**
+     * @brief Mutable view of a whole Matrix or DynMatrix, from which blocks, rows, columns and transposes can be taken.
+     */
+    template <typename M, Detail::enable_if_leaf<M> = 0>
+    Detail::view_t<M> view(M& m) {
+        const auto ref = Detail::strided_ref(m);
+        return Detail::view_t<M>(Detail::OperandTraits<M>::data(m), ref.rows, ref.cols, ref.row_stride, ref.col_stride);
+    }
+
+    /**
+     * @brief Read-only view of a whole Matrix or DynMatrix.
+     */
+    template <typename M, Detail::enable_if_leaf<M> = 0>
+    Detail::const_view_t<M> view(const M& m) {
+        const auto ref = Detail::strided_ref(m);
+        return Detail::const_view_t<M>(ref.data, ref.rows, ref.cols, ref.row_stride, ref.col_stride);
+    }
+
+    /**
+     * @brief Transposed view of a Matrix or DynMatrix. Unlike Matrix::transpose() nothing is copied, and a
+     * product such as `A * transpose_view(B)` reads B in place.
+     */
+    template <typename M, Detail::enable_if_leaf<M> = 0>
+    auto transpose_view(M& m) {
+        return view(m).transpose();
+    }
+
+    template <typename M, Detail::enable_if_leaf<M> = 0>
+    auto transpose_view(const M& m) {
+        return view(m).transpose();
+    }
+} /* MatrixLib */
+
+#endif /* MATRIXVIEW_H */
@@ -0,0 +1,333 @@
+#ifndef MIXEDPRECISION_H
+#define MIXEDPRECISION_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "halfFloat.h"
+
+#if defined(MATRIXLIB_SIMD_X86)
+#define MATRIXLIB_TARGET_AVX512VNNI __attribute__((target("avx512f,avx512vnni")))
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+namespace Detail {
+#if defined(MATRIXLIB_SIMD_X86)
+    /*
+     * VNNI register tile: MR rows of C by 32 columns. vpdpbusd multiplies four unsigned bytes of A with four
+     * signed bytes of B and adds the four products to one int32 lane, so B is packed in groups of four k
+     * values per column and each step broadcasts four consecutive bytes of an A row.
+     */
+    template <int MR>
+    MATRIXLIB_TARGET_AVX512VNNI inline void s8_micro_kernel_vnni(size_t groups, const std::uint8_t* a, size_t lda, const std::int8_t* b,
+                                                               __m512i corr0, __m512i corr1, std::int32_t* c, size_t ldc,
+                                                               __mmask16 mask0, __mmask16 mask1) {
+        __m512i acc0[MR], acc1[MR];
+        for (int r = 0; r < MR; ++r) acc0[r] = acc1[r] = _mm512_setzero_si512();
+
+        for (size_t g = 0; g < groups; ++g) {
+            const __m512i b0 = _mm512_loadu_si512(b + g * 128);
+            const __m512i b1 = _mm512_loadu_si512(b + g * 128 + 64);
+
+            for (int r = 0; r < MR; ++r) {
+                std::int32_t quad;
+                std::memcpy(&quad, a + r * lda + 4 * g, sizeof(quad));
+                const __m512i av = _mm512_set1_epi32(quad);
+                acc0[r] = _mm512_dpbusd_epi32(acc0[r], av, b0);
+                acc1[r] = _mm512_dpbusd_epi32(acc1[r], av, b1);
+            }
+        }
+
+        for (int r = 0; r < MR; ++r) {
+            _mm512_mask_storeu_epi32(c + r * ldc, mask0, _mm512_sub_epi32(acc0[r], corr0));
+            _mm512_mask_storeu_epi32(c + r * ldc + 16, mask1, _mm512_sub_epi32(acc1[r], corr1));
+        }
+    }
+
+    /*
+     * C = A * B for int8 A and B into int32 C with leading dimension ldc. A is shifted to unsigned by adding 128
+     * while it is packed, and 128 times each column sum of B is subtracted again when the tile is stored.
+     */
+    MATRIXLIB_TARGET_AVX512VNNI inline void gemm_s8_vnni(size_t m, size_t n, size_t k,
+                                                       const std::int8_t* a, ptrdiff_t rsa, ptrdiff_t csa,
+                                                       const std::int8_t* b, ptrdiff_t rsb, ptrdiff_t csb,
+                                                       std::int32_t* c, size_t ldc) {
+        constexpr size_t NR = 32;
+        const size_t groups = (k + 3) / 4, kp = groups * 4;
+        const size_t panels = (n + NR - 1) / NR;
+
+        static thread_local std::vector<std::uint8_t> packedA;
+        static thread_local std::vector<std::int8_t> packedB;
+        static thread_local std::vector<std::int32_t> colSums;
+        packedA.assign(m * kp, 0x80);
+        packedB.assign(panels * groups * NR * 4, 0);
+        colSums.assign(panels * NR, 0);
+
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t p = 0; p < k; ++p) packedA[i * kp + p] = static_cast<std::uint8_t>(a[i * rsa + p * csa] ^ 0x80);
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            std::int8_t* panel = packedB.data() + (j / NR) * groups * NR * 4 + (j % NR) * 4;
+            std::int32_t sum = 0;
+            for (size_t p = 0; p < k; ++p) {
+                const std::int8_t v = b[p * rsb + j * csb];
+                panel[(p / 4) * NR * 4 + p % 4] = v;
+                sum += v;
+            }
+            colSums[j] = 128 * sum;
+        }
+
+        for (size_t q = 0; q < panels; ++q) {
+            const size_t cols = std::min(NR, n - q * NR);
+            const __mmask16 mask0 = cols >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << cols) - 1);
+            const __mmask16 mask1 = cols >= 32 ? __mmask16(0xFFFF) : cols > 16 ? __mmask16((1u << (cols - 16)) - 1) : __mmask16(0);
+            const __m512i corr0 = _mm512_loadu_si512(colSums.data() + q * NR);
+            const __m512i corr1 = _mm512_loadu_si512(colSums.data() + q * NR + 16);
+            const std::int8_t* panel = packedB.data() + q * groups * NR * 4;
+            std::int32_t* cPanel = c + q * NR;
+
+            size_t i = 0;
+            for (; i + 4 <= m; i += 4) {
+                s8_micro_kernel_vnni<4>(groups, packedA.data() + i * kp, kp, panel, corr0, corr1, cPanel + i * ldc, ldc, mask0, mask1);
+            }
+            switch (m - i) {
+                case 3: s8_micro_kernel_vnni<3>(groups, packedA.data() + i * kp, kp, panel, corr0, corr1, cPanel + i * ldc, ldc, mask0, mask1); break;
+                case 2: s8_micro_kernel_vnni<2>(groups, packedA.data() + i * kp, kp, panel, corr0, corr1, cPanel + i * ldc, ldc, mask0, mask1); break;
+                case 1: s8_micro_kernel_vnni<1>(groups, packedA.data() + i * kp, kp, panel, corr0, corr1, cPanel + i * ldc, ldc, mask0, mask1); break;
+                default: break;
+            }
+        }
+    }
+
+    inline bool vnni_enabled() {
+        static const bool supported = __builtin_cpu_supports("avx512vnni");
+        return supported && active_simd_isa() == SimdIsa::AVX512;
+    }
+#endif
+} /* Detail */
+
+    /**
+     * Mixed-precision product C = A * B with A of type TA, B of type TB and C of the accumulator type Acc, stored
+     * row-major with leading dimension ldc. Blocks of A and B are widened to Acc into cache-sized buffers and
+     * multiplied by the packed GEMM, so the narrow operands are read from memory only once per block. int8 x int8
+     * into int32 runs on the AVX-512 VNNI dot-product instructions when the CPU has them.
+     */
+    template <typename TA, typename TB, typename Acc>
+    void gemm_mixed(size_t m, size_t n, size_t k,
+                    const TA* a, ptrdiff_t rsa, ptrdiff_t csa,
+                    const TB* b, ptrdiff_t rsb, ptrdiff_t csb,
+                    Acc* c, size_t ldc) {
+#if defined(MATRIXLIB_SIMD_X86)
+        if constexpr (std::is_same<TA, std::int8_t>::value && std::is_same<TB, std::int8_t>::value && std::is_same<Acc, std::int32_t>::value) {
+            if (Detail::vnni_enabled() && m > 0 && n > 0) {
+                Detail::gemm_s8_vnni(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc);
+                return;
+            }
+        }
+#endif
+        using Blk = GemmBlocking<Acc>;
+        const ptrdiff_t ldcs = static_cast<ptrdiff_t>(ldc);
+
+        if (k == 0) {
+            for (size_t i = 0; i < m; ++i) std::fill(c + i * ldc, c + i * ldc + n, Acc(0));
+            return;
+        }
+
+        static thread_local std::vector<Acc> wideA;
+        static thread_local std::vector<Acc> wideB;
+
+        for (size_t jc = 0; jc < n; jc += Blk::NC) {
+            const size_t nc = std::min(Blk::NC, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += Blk::KC) {
+                const size_t kc = std::min(Blk::KC, k - pc);
+
+                wideB.resize(kc * nc);
+                for (size_t p = 0; p < kc; ++p) {
+                    const TB* src = b + (pc + p) * rsb + jc * csb;
+                    if (csb == 1) {
+                        convert(src, wideB.data() + p * nc, nc);
+                    } else {
+                        for (size_t j = 0; j < nc; ++j) wideB[p * nc + j] = static_cast<Acc>(src[j * csb]);
+                    }
+                }
+
+                for (size_t ic = 0; ic < m; ic += Blk::MC) {
+                    const size_t mc = std::min(Blk::MC, m - ic);
+
+                    wideA.resize(mc * kc);
+                    for (size_t i = 0; i < mc; ++i) {
+                        const TA* src = a + (ic + i) * rsa + pc * csa;
+                        if (csa == 1) {
+                            convert(src, wideA.data() + i * kc, kc);
+                        } else {
+                            for (size_t p = 0; p < kc; ++p) wideA[i * kc + p] = static_cast<Acc>(src[p * csa]);
+                        }
+                    }
+
+                    gemm<Acc>(mc, nc, kc, Acc(1), wideA.data(), static_cast<ptrdiff_t>(kc), 1, wideB.data(), static_cast<ptrdiff_t>(nc), 1,
+                              pc == 0 ? Acc(0) : Acc(1), c + ic * ldc + jc, ldcs, 1);
+                }
+            }
+        }
+    }
+} /* Kernels */
+
+    /**
+     * Multiply two matrices (or views, or expressions) accumulating in Acc, e.g. `multiply<float>(halfA, halfB)`
+     * or `multiply<std::int32_t>(int8A, int8B)`. The operands may have different element types; they are widened
+     * block by block, so they never need to be converted up front.
+     *
+     * @tparam Acc The element type of the result and of the accumulation.
+     * @return A Matrix of Acc, or a DynMatrix of Acc if either operand is runtime-sized.
+     * @throw std::invalid_argument if runtime-sized operands have mismatched inner dimensions.
+     */
+    template <typename Acc, typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    auto multiply(const L& lhs, const R& rhs) {
+        using LT = Detail::OperandTraits<L>;
+        using RT = Detail::OperandTraits<R>;
+        static_assert(std::is_arithmetic<Acc>::value, "The accumulator must be an arithmetic type");
+        static_assert(Detail::extents_compatible(LT::col_extent, RT::row_extent),
+                      "Matrix multiplication is only supported if second matrix's row count == first matrix's column count");
+        using Result = typename Detail::PlainObject<Acc, LT::row_extent, RT::col_extent, LT::is_dynamic || RT::is_dynamic>::type;
+
+        const Detail::product_operand_t<L>& a = lhs;
+        const Detail::product_operand_t<R>& b = rhs;
+        const auto ra = Detail::strided_ref(a);
+        const auto rb = Detail::strided_ref(b);
+
+        if (ra.cols != rb.rows) {
+            Utils::throw_invalid_argument_error("Cannot multiply a %zux%zu matrix by a %zux%zu matrix", ra.rows, ra.cols, rb.rows, rb.cols);
+        }
+
+        Result ret;
+        Detail::OperandTraits<Result>::resize(ret, ra.rows, rb.cols);
+        Kernels::gemm_mixed(ra.rows, rb.cols, ra.cols, ra.data, ra.row_stride, ra.col_stride, rb.data, rb.row_stride, rb.col_stride,
+                            Detail::OperandTraits<Result>::data(ret), rb.cols);
+        return ret;
+    }
+
+    /**
+     * @brief Affinely quantised int8 matrix: each stored value q stands for `scale * (q - zero_point)`.
+     *
+     * It takes a quarter of the memory of a float matrix. Products of two quantised matrices run as an
+     * int8 x int8 -> int32 GEMM (on VNNI where available) and are then rescaled to float.
+     */
+    class QuantizedMatrix {
+        DynMatrix<std::int8_t> values_;
+        float scale_ = 1.0f;
+        std::int32_t zeroPoint_ = 0;
+
+    public:
+        QuantizedMatrix() = default;
+
+        /**
+         * @brief Wraps already quantised values.
+         * @throw std::invalid_argument if scale is not positive and finite, or zeroPoint is outside the int8 range.
+         */
+        QuantizedMatrix(DynMatrix<std::int8_t> values, float scale, std::int32_t zeroPoint)
+            : values_(std::move(values)), scale_(scale), zeroPoint_(zeroPoint) {
+            if (!(scale > 0.0f) || !std::isfinite(scale)) {
+                Utils::throw_invalid_argument_error("Quantisation scale must be positive and finite, got %g", static_cast<double>(scale));
+            }
+            if (zeroPoint < -128 || zeroPoint > 127) {
+                Utils::throw_invalid_argument_error("Quantisation zero point %d is outside the int8 range", static_cast<int>(zeroPoint));
+            }
+        }
+
+        /**
+         * @brief Quantises a matrix, view or expression, choosing scale and zero point so that the range of its
+         * values (widened to include 0, which stays exact) maps onto [-128, 127].
+         */
+        template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+        static QuantizedMatrix quantize(const M& m) {
+            const Detail::plain_t<M> plain(m);
+            const auto ref = Detail::OperandTraits<Detail::plain_t<M>>::ref(plain);
+            const size_t count = ref.rows * ref.cols;
+
+            float lo = 0.0f, hi = 0.0f;
+            for (size_t i = 0; i < count; ++i) {
+                lo = std::min(lo, static_cast<float>(ref.data[i]));
+                hi = std::max(hi, static_cast<float>(ref.data[i]));
+            }
+
+            const float scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+            const long zeroPoint = std::clamp(std::lround(-128.0f - lo / scale), -128L, 127L);
+
+            DynMatrix<std::int8_t> values(ref.rows, ref.cols);
+            for (size_t i = 0; i < count; ++i) {
+                const long q = std::lround(static_cast<float>(ref.data[i]) / scale) + zeroPoint;
+                values.data()[i] = static_cast<std::int8_t>(std::clamp(q, -128L, 127L));
+            }
+
+            return QuantizedMatrix(std::move(values), scale, static_cast<std::int32_t>(zeroPoint));
+        }
+
+        size_t rows() const noexcept { return values_.rows(); }
+        size_t cols() const noexcept { return values_.cols(); }
+        const DynMatrix<std::int8_t>& values() const noexcept { return values_; }
+        float scale() const noexcept { return scale_; }
+        std::int32_t zero_point() const noexcept { return zeroPoint_; }
+
+        /**
+         * @return The real values the matrix stands for.
+         */
+        DynMatrix<float> dequantize() const {
+            DynMatrix<float> ret(rows(), cols());
+            const std::int8_t* q = values_.data();
+            for (size_t i = 0; i < values_.size(); ++i) ret.data()[i] = scale_ * static_cast<float>(q[i] - zeroPoint_);
+            return ret;
+        }
+    };
+
+    /**
+     * Product of two quantised matrices, as float. The integer product is computed exactly in int32 and the
+     * zero points are removed afterwards with the row sums of A and the column sums of B:
+     * `sa * sb * (QA QB - za * colsum(QB) - zb * rowsum(QA) + k * za * zb)`.
+     *
+     * @throw std::invalid_argument if the inner dimensions do not match.
+     */
+    inline DynMatrix<float> multiply(const QuantizedMatrix& lhs, const QuantizedMatrix& rhs) {
+        const size_t m = lhs.rows(), n = rhs.cols(), k = lhs.cols();
+        const DynMatrix<std::int32_t> product = multiply<std::int32_t>(lhs.values(), rhs.values());
+
+        std::vector<std::int64_t> rowSums(m, 0), colSums(n, 0);
+        const std::int8_t* a = lhs.values().data();
+        const std::int8_t* b = rhs.values().data();
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t p = 0; p < k; ++p) rowSums[i] += a[i * k + p];
+        }
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t j = 0; j < n; ++j) colSums[j] += b[p * n + j];
+        }
+
+        const std::int64_t za = lhs.zero_point(), zb = rhs.zero_point();
+        const std::int64_t offset = static_cast<std::int64_t>(k) * za * zb;
+        const double scale = static_cast<double>(lhs.scale()) * rhs.scale();
+
+        DynMatrix<float> ret(m, n);
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                const std::int64_t acc = product(i, j) - za * colSums[j] - zb * rowSums[i] + offset;
+                ret(i, j) = static_cast<float>(scale * static_cast<double>(acc));
+            }
+        }
+
+        return ret;
+    }
+
+    inline DynMatrix<float> operator*(const QuantizedMatrix& lhs, const QuantizedMatrix& rhs) {
+        return multiply(lhs, rhs);
+    }
+} /* MatrixLib */
+
+#endif /* MIXEDPRECISION_H */
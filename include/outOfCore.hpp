@@ -0,0 +1,483 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "serialization.hpp"
+
+/* Bytes of tiles an out-of-core product keeps in memory when the call does not give its own budget */
+#ifndef MATRIXLIB_OUT_OF_CORE_BUDGET
+#define MATRIXLIB_OUT_OF_CORE_BUDGET (size_t(1) << 30)
+#endif
+
+namespace MatrixLib {
+namespace Detail {
+    /*
+     * A tiled matrix file is a 64-byte header followed by its tiles in row-major order of the tile grid:
+     *
+     *   0  char[4]   magic "MLTL"
+     *   4  uint8     format version
+     *   5  uint8     ScalarType of the elements
+     *   6  uint8     sizeof one element
+     *   7  uint8     byte order of the header fields and the elements: 0 little-endian, 1 big-endian
+     *   8  uint64    rows
+     *   16 uint64    cols
+     *   24 uint64    rows per tile
+     *   32 uint64    columns per tile
+     *   40 ...       zero padding
+     *
+     * Every tile is stored as a full block of row-major elements, edge tiles padded with zeros, so a tile is
+     * found by its index alone and is read or written with one contiguous transfer.
+     */
+    constexpr char tiled_magic[4] = {'M', 'L', 'T', 'L'};
+    constexpr std::uint8_t tiled_version = 1;
+} /* Detail */
+
+    /**
+     * @brief Dense matrix stored in a file as a grid of tiles, for matrices larger than memory.
+     *
+     * Only the tiles being worked on are held in memory: tile() and set_tile() move one tile between the file
+     * and a DynMatrix, and multiply() streams tiles through a bounded memory budget. Tiles of rows x cols
+     * elements are tile_rows() x tile_cols(), except the last row and column of tiles, which are cut to the
+     * matrix. Reads and writes of one TiledMatrix are serialised, so it can be used from several threads.
+     *
+     * @tparam _Scalar The element type stored in the file.
+     */
+    template <typename _Scalar>
+    class TiledMatrix {
+        static_assert(Detail::is_matrix_scalar<_Scalar>::value, "Matrix element type must be numeric");
+
+        struct File {
+            std::fstream stream;
+            std::mutex mutex;
+        };
+
+        std::string path_;
+        std::unique_ptr<File> file_;
+        size_t rows_ = 0;
+        size_t cols_ = 0;
+        size_t tileRows_ = 0;
+        size_t tileCols_ = 0;
+
+        size_t tile_elements() const noexcept { return tileRows_ * tileCols_; }
+
+        std::streamoff tile_offset(size_t ti, size_t tj) const {
+            MATRIXLIB_CHECK_INDEX(ti < tile_row_count(), "Tile row %zu is out of bounds", ti);
+            MATRIXLIB_CHECK_INDEX(tj < tile_col_count(), "Tile column %zu is out of bounds", tj);
+
+            const std::uint64_t index = static_cast<std::uint64_t>(ti) * tile_col_count() + tj;
+            return static_cast<std::streamoff>(Detail::binary_header_size + index * tile_elements() * sizeof(_Scalar));
+        }
+
+        void open(std::ios::openmode mode) {
+            file_ = std::make_unique<File>();
+            file_->stream.open(path_, mode | std::ios::binary);
+            if (!file_->stream && !(mode & std::ios::trunc)) file_->stream.open(path_, std::ios::in | std::ios::binary);
+            if (!file_->stream) Utils::throw_runtime_error("Cannot open %s", path_.c_str());
+        }
+
+    public:
+        using Scalar = _Scalar;
+
+        TiledMatrix() = default;
+
+        /**
+         * @brief Creates a tiled matrix file of zeros, replacing any file at the path. The space is only taken
+         * as tiles are written on file systems that support sparse files.
+         * @throw std::invalid_argument if a tile dimension is zero or the matrix is too large to address.
+         * @throw std::runtime_error if the file cannot be written.
+         */
+        TiledMatrix(const std::string& path, size_t rows, size_t cols, size_t tileRows, size_t tileCols)
+            : path_(path), rows_(rows), cols_(cols), tileRows_(tileRows), tileCols_(tileCols) {
+            if (tileRows == 0 || tileCols == 0) {
+                Utils::throw_invalid_argument_error("Tiles of %zux%zu elements cannot hold a matrix", tileRows, tileCols);
+            }
+            const std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::streamoff>::max()) / sizeof(_Scalar);
+            const std::uint64_t paddedRows = static_cast<std::uint64_t>(tile_row_count()) * tileRows;
+            const std::uint64_t paddedCols = static_cast<std::uint64_t>(tile_col_count()) * tileCols;
+            if (tileRows > limit / tileCols || (paddedRows != 0 && paddedCols > limit / paddedRows)) {
+                Utils::throw_invalid_argument_error("A tiled matrix of %zu x %zu elements is too large", rows, cols);
+            }
+
+            open(std::ios::in | std::ios::out | std::ios::trunc);
+
+            unsigned char header[Detail::binary_header_size];
+            Detail::encode_header(header, Detail::scalar_type<_Scalar>(), sizeof(_Scalar), rows, cols);
+            std::memcpy(header, Detail::tiled_magic, sizeof(Detail::tiled_magic));
+            header[4] = Detail::tiled_version;
+            const std::uint64_t tileShape[2] = {tileRows, tileCols};
+            std::memcpy(header + 24, tileShape, sizeof(tileShape));
+
+            std::fstream& s = file_->stream;
+            s.write(reinterpret_cast<const char*>(header), sizeof(header));
+            if (paddedRows * paddedCols != 0) {
+                s.seekp(static_cast<std::streamoff>(Detail::binary_header_size + paddedRows * paddedCols * sizeof(_Scalar) - 1));
+                s.put('\0');
+            }
+            if (!s.flush()) Utils::throw_runtime_error("Failed to write a %zux%zu tiled matrix to %s", rows, cols, path.c_str());
+        }
+
+        /**
+         * @brief Opens a file written by a TiledMatrix, for reading and, if the file allows it, writing.
+         * @throw std::runtime_error if the file cannot be opened, is truncated, holds a different element type or
+         * was written on a machine of the other byte order.
+         */
+        explicit TiledMatrix(const std::string& path) : path_(path) {
+            open(std::ios::in | std::ios::out);
+
+            unsigned char raw[Detail::binary_header_size];
+            if (!file_->stream.read(reinterpret_cast<char*>(raw), sizeof(raw))) {
+                Utils::throw_runtime_error("Unexpected end of tiled matrix header in %s", path.c_str());
+            }
+            if (std::memcmp(raw, Detail::tiled_magic, sizeof(Detail::tiled_magic)) != 0) {
+                Utils::throw_runtime_error("%s is not a tiled matrix: bad magic number", path.c_str());
+            }
+            if (raw[4] != Detail::tiled_version) {
+                Utils::throw_runtime_error("Unsupported tiled matrix format version %d", static_cast<int>(raw[4]));
+            }
+
+            /* Past the magic number and version the header is the binary format's, plus the tile shape */
+            std::memcpy(raw, Detail::binary_magic, sizeof(Detail::binary_magic));
+            raw[4] = Detail::binary_version;
+            const Detail::BinaryHeader header = Detail::decode_header(raw);
+            (void)Detail::checked_element_count<_Scalar>(header);
+            if (header.bigEndian != Detail::host_is_big_endian()) {
+                Utils::throw_runtime_error("%s was written with the other byte order", path.c_str());
+            }
+
+            std::uint64_t tileShape[2];
+            std::memcpy(tileShape, raw + 24, sizeof(tileShape));
+            if (tileShape[0] == 0 || tileShape[1] == 0 || tileShape[0] > std::numeric_limits<size_t>::max() / tileShape[1]) {
+                Utils::throw_runtime_error("Corrupt tiled matrix header in %s", path.c_str());
+            }
+
+            rows_ = static_cast<size_t>(header.rows);
+            cols_ = static_cast<size_t>(header.cols);
+            tileRows_ = static_cast<size_t>(tileShape[0]);
+            tileCols_ = static_cast<size_t>(tileShape[1]);
+        }
+
+        TiledMatrix(TiledMatrix&&) noexcept = default;
+        TiledMatrix& operator=(TiledMatrix&&) noexcept = default;
+
+        size_t rows() const noexcept { return rows_; }
+        size_t cols() const noexcept { return cols_; }
+        size_t tile_rows() const noexcept { return tileRows_; }
+        size_t tile_cols() const noexcept { return tileCols_; }
+        size_t tile_row_count() const noexcept { return tileRows_ == 0 ? 0 : (rows_ + tileRows_ - 1) / tileRows_; }
+        size_t tile_col_count() const noexcept { return tileCols_ == 0 ? 0 : (cols_ + tileCols_ - 1) / tileCols_; }
+        const std::string& path() const noexcept { return path_; }
+
+        /**
+         * @return The number of rows in tile row ti, which is tile_rows() except at the bottom edge.
+         * @throw std::out_of_range if ti is not a tile row.
+         */
+        size_t tile_height(size_t ti) const {
+            MATRIXLIB_CHECK_INDEX(ti < tile_row_count(), "Tile row %zu is out of bounds", ti);
+            return std::min(tileRows_, rows_ - ti * tileRows_);
+        }
+
+        /**
+         * @return The number of columns in tile column tj, which is tile_cols() except at the right edge.
+         * @throw std::out_of_range if tj is not a tile column.
+         */
+        size_t tile_width(size_t tj) const {
+            MATRIXLIB_CHECK_INDEX(tj < tile_col_count(), "Tile column %zu is out of bounds", tj);
+            return std::min(tileCols_, cols_ - tj * tileCols_);
+        }
+
+        /**
+         * @brief Reads tile (ti, tj) as a full tile_rows() x tile_cols() block of row-major elements; an edge
+         * tile comes back padded with zeros.
+         * @throw std::runtime_error if the file cannot be read.
+         */
+        void read_tile(size_t ti, size_t tj, _Scalar* out) const {
+            const std::streamoff offset = tile_offset(ti, tj);
+            std::lock_guard<std::mutex> lock(file_->mutex);
+            std::fstream& s = file_->stream;
+            s.clear();
+            s.seekg(offset);
+            if (!s.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(tile_elements() * sizeof(_Scalar)))) {
+                s.clear();
+                Utils::throw_runtime_error("Unexpected end of tiled matrix data in %s at tile (%zu, %zu)", path_.c_str(), ti, tj);
+            }
+        }
+
+        /**
+         * @brief Writes tile (ti, tj) from a full tile_rows() x tile_cols() block of row-major elements, whose
+         * padding past the edge of the matrix should be zero.
+         * @throw std::runtime_error if the file cannot be written.
+         */
+        void write_tile(size_t ti, size_t tj, const _Scalar* in) {
+            const std::streamoff offset = tile_offset(ti, tj);
+            std::lock_guard<std::mutex> lock(file_->mutex);
+            std::fstream& s = file_->stream;
+            s.clear();
+            s.seekp(offset);
+            if (!s.write(reinterpret_cast<const char*>(in), static_cast<std::streamsize>(tile_elements() * sizeof(_Scalar)))) {
+                s.clear();
+                Utils::throw_runtime_error("Failed to write tile (%zu, %zu) of %s", ti, tj, path_.c_str());
+            }
+        }
+
+        /**
+         * @brief Writes buffered tiles through to the file, so that other readers of the path see them.
+         * @throw std::runtime_error if the file cannot be written.
+         */
+        void flush() {
+            std::lock_guard<std::mutex> lock(file_->mutex);
+            if (!file_->stream.flush()) Utils::throw_runtime_error("Failed to write %s", path_.c_str());
+        }
+
+        /**
+         * @return Tile (ti, tj), cut to the matrix at the edges.
+         */
+        DynMatrix<_Scalar> tile(size_t ti, size_t tj) const {
+            std::vector<_Scalar> block(tile_elements());
+            read_tile(ti, tj, block.data());
+            return DynMatrix<_Scalar>(MatrixView<const _Scalar>(block.data(), tile_height(ti), tile_width(tj), static_cast<ptrdiff_t>(tileCols_), 1));
+        }
+
+        /**
+         * @brief Replaces tile (ti, tj) with a matrix, view or expression of its shape.
+         * @throw std::invalid_argument if the shapes differ.
+         */
+        template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+        void set_tile(size_t ti, size_t tj, const M& m) {
+            const auto& plain = Detail::stored_operand(m);
+            const auto src = Detail::strided_ref(plain);
+            const size_t h = tile_height(ti), w = tile_width(tj);
+            if (src.rows != h || src.cols != w) {
+                Utils::throw_invalid_argument_error("Tile (%zu, %zu) is %zux%zu, got a %zux%zu matrix", ti, tj, h, w, src.rows, src.cols);
+            }
+
+            std::vector<_Scalar> block(tile_elements());
+            for (size_t i = 0; i < h; ++i) {
+                const _Scalar* row = src.data + static_cast<ptrdiff_t>(i) * src.row_stride;
+                for (size_t j = 0; j < w; ++j) block[i * tileCols_ + j] = row[static_cast<ptrdiff_t>(j) * src.col_stride];
+            }
+            write_tile(ti, tj, block.data());
+        }
+
+        /**
+         * @return A DynMatrix holding the whole matrix, for matrices that do fit in memory.
+         */
+        DynMatrix<_Scalar> to_matrix() const {
+            DynMatrix<_Scalar> ret(rows_, cols_);
+            std::vector<_Scalar> block(tile_elements());
+
+            for (size_t ti = 0; ti < tile_row_count(); ++ti) {
+                for (size_t tj = 0; tj < tile_col_count(); ++tj) {
+                    read_tile(ti, tj, block.data());
+                    for (size_t i = 0; i < tile_height(ti); ++i) {
+                        std::copy_n(block.data() + i * tileCols_, tile_width(tj), ret.data() + (ti * tileRows_ + i) * cols_ + tj * tileCols_);
+                    }
+                }
+            }
+
+            return ret;
+        }
+    };
+
+    /**
+     * @brief Writes a matrix, view or expression to a new tiled matrix file, one tile at a time.
+     * @throw std::invalid_argument if a tile dimension is zero.
+     * @throw std::runtime_error if the file cannot be written.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    TiledMatrix<typename Detail::OperandTraits<M>::Scalar> save_tiled(const std::string& path, const M& m, size_t tileRows, size_t tileCols) {
+        using T = typename Detail::OperandTraits<M>::Scalar;
+        const auto& plain = Detail::stored_operand(m);
+        const auto src = Detail::strided_ref(plain);
+
+        TiledMatrix<T> ret(path, src.rows, src.cols, tileRows, tileCols);
+        for (size_t ti = 0; ti < ret.tile_row_count(); ++ti) {
+            for (size_t tj = 0; tj < ret.tile_col_count(); ++tj) {
+                const T* corner = src.data + static_cast<ptrdiff_t>(ti * tileRows) * src.row_stride + static_cast<ptrdiff_t>(tj * tileCols) * src.col_stride;
+                ret.set_tile(ti, tj, MatrixView<const T>(corner, ret.tile_height(ti), ret.tile_width(tj), src.row_stride, src.col_stride));
+            }
+        }
+
+        ret.flush();
+        return ret;
+    }
+
+namespace Detail {
+    /*
+     * The background thread that reads tiles ahead of out-of-core products. A pool of two counts the waiting
+     * caller, so this is exactly one worker, started on first use and shared by all products.
+     */
+    inline ThreadPool& tile_reader() {
+        static ThreadPool pool(2);
+        return pool;
+    }
+
+    /*
+     * C = A * B over tiled files. C is computed a block of p x q tiles at a time, with p and q as large as the
+     * budget allows: every step of a block brings in one column of A tiles and one row of B tiles over the
+     * same k, and adds their products into the block with the in-memory GEMM kernels. Steps are double
+     * buffered: a background I/O thread reads step s + 1 while step s is multiplied, so the disk and the
+     * cores overlap. A is read once per column of blocks and B once per row of blocks.
+     */
+    template <typename T>
+    void multiply_tiled(ThreadPool* pool, const TiledMatrix<T>& a, const TiledMatrix<T>& b, TiledMatrix<T>& c, size_t budget) {
+        /* Only a default-constructed TiledMatrix, which has no file, has empty tiles */
+        for (const TiledMatrix<T>* m : {&a, &b, static_cast<const TiledMatrix<T>*>(&c)}) {
+            if (m->tile_rows() == 0 || m->tile_cols() == 0) {
+                Utils::throw_invalid_argument_error("Cannot multiply tiled matrices without a file");
+            }
+        }
+        if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols()) {
+            Utils::throw_invalid_argument_error("Cannot multiply a %zux%zu tiled matrix by a %zux%zu one into a %zux%zu one",
+                                                a.rows(), a.cols(), b.rows(), b.cols(), c.rows(), c.cols());
+        }
+        if (a.tile_cols() != b.tile_rows() || c.tile_rows() != a.tile_rows() || c.tile_cols() != b.tile_cols()) {
+            Utils::throw_invalid_argument_error("Tiles of %zux%zu times %zux%zu do not make tiles of %zux%zu",
+                                                a.tile_rows(), a.tile_cols(), b.tile_rows(), b.tile_cols(), c.tile_rows(), c.tile_cols());
+        }
+        /* Different paths may still name the same file, through links or relative parts */
+        auto same_file = [&c](const TiledMatrix<T>& m) {
+            std::error_code error;
+            return c.path() == m.path() || std::filesystem::equivalent(c.path(), m.path(), error);
+        };
+        if (same_file(a) || same_file(b)) {
+            Utils::throw_invalid_argument_error("The product cannot be written over its operand %s", c.path().c_str());
+        }
+
+        const size_t tr = a.tile_rows(), tk = a.tile_cols(), tc = b.tile_cols();
+        const size_t tilesM = c.tile_row_count(), tilesN = c.tile_col_count(), tilesK = a.tile_col_count();
+        const size_t sizeA = tr * tk, sizeB = tk * tc, sizeC = tr * tc;
+
+        /* A block of p x q accumulators and two buffers of p tiles of A and q tiles of B */
+        auto fits = [&](size_t p, size_t q) {
+            return (static_cast<double>(p * q * sizeC) + 2.0 * static_cast<double>(p * sizeA + q * sizeB)) * sizeof(T) <= static_cast<double>(budget);
+        };
+        if (!fits(1, 1)) {
+            Utils::throw_invalid_argument_error("A budget of %zu bytes cannot hold one tile of the product and two of each operand", budget);
+        }
+
+        size_t p = 1, q = 1;
+        for (bool grew = true; grew;) {
+            grew = false;
+            if (q < tilesN && fits(p, q + 1)) ++q, grew = true;
+            if (p < tilesM && fits(p + 1, q)) ++p, grew = true;
+        }
+
+        const size_t blocksN = (tilesN + q - 1) / q;
+        const size_t blocks = ((tilesM + p - 1) / p) * blocksN;
+        const size_t steps = blocks * tilesK;
+        std::vector<T> acc(p * q * sizeC);
+        std::vector<T> staged[2] = {std::vector<T>(tilesK ? p * sizeA + q * sizeB : 0), std::vector<T>(tilesK ? p * sizeA + q * sizeB : 0)};
+        ThreadPool& io = tile_reader();
+
+        auto load = [&](size_t step) {
+            const size_t block = step / tilesK, kt = step % tilesK;
+            const size_t i0 = block / blocksN * p, j0 = block % blocksN * q;
+            T* buffer = staged[step % 2].data();
+
+            auto task = std::make_shared<std::packaged_task<void()>>([&a, &b, buffer, i0, j0, kt, p, q, sizeA, sizeB, tilesM, tilesN] {
+                for (size_t i = 0; i < p && i0 + i < tilesM; ++i) a.read_tile(i0 + i, kt, buffer + i * sizeA);
+                for (size_t j = 0; j < q && j0 + j < tilesN; ++j) b.read_tile(kt, j0 + j, buffer + p * sizeA + j * sizeB);
+            });
+            std::future<void> done = task->get_future();
+            io.submit([task] { (*task)(); });
+            return done;
+        };
+
+        /* Declared after the buffers, so that a read still in flight when an exception leaves is finished first */
+        std::future<void> next;
+        struct Drain {
+            std::future<void>& read;
+            ~Drain() { if (read.valid()) read.wait(); }
+        } drain{next};
+        if (steps > 0) next = load(0);
+
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t i0 = block / blocksN * p, j0 = block % blocksN * q;
+            const size_t pb = std::min(p, tilesM - i0), qb = std::min(q, tilesN - j0);
+            std::fill(acc.begin(), acc.end(), T(0));
+
+            for (size_t kt = 0; kt < tilesK; ++kt) {
+                const size_t step = block * tilesK + kt;
+                next.get();
+                if (step + 1 < steps) next = load(step + 1);
+
+                const T* buffer = staged[step % 2].data();
+                const size_t kk = a.tile_width(kt);
+                auto product = [&](size_t t, ThreadPool* tilePool) {
+                    const size_t i = t / qb, j = t % qb;
+                    const size_t mi = c.tile_height(i0 + i), nj = c.tile_width(j0 + j);
+                    const T* at = buffer + i * sizeA;
+                    const T* bt = buffer + p * sizeA + j * sizeB;
+                    T* ct = acc.data() + t * sizeC;
+
+                    if (tilePool) Kernels::gemm_parallel<T>(*tilePool, mi, nj, kk, T(1), at, tk, 1, bt, tc, 1, T(1), ct, tc, 1);
+                    else Kernels::gemm<T>(mi, nj, kk, T(1), at, tk, 1, bt, tc, 1, T(1), ct, tc, 1);
+                };
+
+                /* Enough tiles keep every thread on its own product; fewer split each product instead */
+                const size_t products = pb * qb;
+                if (!pool || pool->thread_count() <= 1) {
+                    for (size_t t = 0; t < products; ++t) product(t, nullptr);
+                } else if (products >= pool->thread_count()) {
+                    pool->parallel_for(products, [&](size_t t) { product(t, nullptr); });
+                } else {
+                    for (size_t t = 0; t < products; ++t) product(t, pool);
+                }
+            }
+
+            for (size_t t = 0; t < pb * qb; ++t) c.write_tile(i0 + t / qb, j0 + t % qb, acc.data() + t * sizeC);
+        }
+
+        c.flush();
+    }
+} /* Detail */
+
+    /**
+     * @brief Out-of-core product C = A * B of tiled matrix files, holding at most about memoryBudget bytes of
+     * tiles in memory. While one set of tiles is multiplied with the in-memory blocked kernels, a background
+     * thread reads the next one from disk. C must already exist with A's rows and B's columns, and its file
+     * must differ from A's and B's.
+     *
+     * @pre A's tiles are as wide as B's are tall, and C's tiles are as tall as A's and as wide as B's.
+     * @throw std::invalid_argument if the shapes or tiles do not line up, or the budget cannot hold one tile of
+     * C and two tiles of A and of B.
+     * @throw std::runtime_error if a file cannot be read or written.
+     */
+    template <typename T>
+    void multiply(const TiledMatrix<T>& a, const TiledMatrix<T>& b, TiledMatrix<T>& c, size_t memoryBudget = MATRIXLIB_OUT_OF_CORE_BUDGET) {
+        Detail::multiply_tiled<T>(nullptr, a, b, c, memoryBudget);
+    }
+
+    /**
+     * @brief Out-of-core product as above, with the tile products run on the calling thread.
+     */
+    template <typename T>
+    void multiply(Execution::SequencedPolicy, const TiledMatrix<T>& a, const TiledMatrix<T>& b, TiledMatrix<T>& c,
+                  size_t memoryBudget = MATRIXLIB_OUT_OF_CORE_BUDGET) {
+        Detail::multiply_tiled<T>(nullptr, a, b, c, memoryBudget);
+    }
+
+    /**
+     * @brief Out-of-core product as above, with the tile products run on the policy's thread pool.
+     */
+    template <typename T>
+    void multiply(Execution::ParallelPolicy policy, const TiledMatrix<T>& a, const TiledMatrix<T>& b, TiledMatrix<T>& c,
+                  size_t memoryBudget = MATRIXLIB_OUT_OF_CORE_BUDGET) {
+        Detail::multiply_tiled<T>(&policy.resolve(), a, b, c, memoryBudget);
+    }
+} /* MatrixLib */
+
+#endif /* OUT_OF_CORE_H */
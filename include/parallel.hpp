@@ -0,0 +1,303 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "matrixVector.hpp"
+#include "threadPool.h"
+
+/* Below this many multiply-adds (m * n * k) a product is not worth splitting across threads */
+#ifndef MATRIXLIB_PARALLEL_GEMM_THRESHOLD
+#define MATRIXLIB_PARALLEL_GEMM_THRESHOLD (128 * 128 * 128)
+#endif
+
+/* Below this many elements (of the vector for dot and axpy, of the matrix for gemv and ger) a routine stays on one thread */
+#ifndef MATRIXLIB_PARALLEL_VECTOR_THRESHOLD
+#define MATRIXLIB_PARALLEL_VECTOR_THRESHOLD (256 * 1024)
+#endif
+
+namespace MatrixLib {
+namespace Execution {
+    /**
+     * @brief Runs an operation on the calling thread only.
+     */
+    struct SequencedPolicy {};
+
+    /**
+     * @brief Runs an operation on a thread pool: the global pool unless another one is bound with on().
+     */
+    struct ParallelPolicy {
+        ThreadPool* pool = nullptr;
+
+        /**
+         * @return A policy that runs on the given pool instead of the global one.
+         */
+        constexpr ParallelPolicy on(ThreadPool& other) const { return ParallelPolicy{&other}; }
+
+        ThreadPool& resolve() const { return pool ? *pool : ThreadPool::global(); }
+    };
+
+    constexpr SequencedPolicy seq{};
+    constexpr ParallelPolicy par{};
+} /* Execution */
+
+namespace Kernels {
+    /**
+     * Product C = alpha * A * B + beta * C split into tiles of C that run on the pool. Each tile is an
+     * independent blocked GEMM over the full depth k, so tiles never write the same element and need no
+     * synchronisation; every thread packs into its own thread-local buffers. Products below
+     * MATRIXLIB_PARALLEL_GEMM_THRESHOLD, or a single-threaded pool, take the serial path. Edge tiles stay on the
+     * blocked kernel rather than the shape-based choice of gemm, so every element is summed in the same order
+     * whatever the tiling and the result does not depend on the pool size.
+     */
+    template <typename T>
+    void gemm_parallel(ThreadPool& pool, size_t m, size_t n, size_t k, T alpha,
+                       const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                       const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                       T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        using Blk = GemmBlocking<T>;
+        const size_t threads = pool.thread_count();
+
+        if (threads <= 1 || m * n * k < static_cast<size_t>(MATRIXLIB_PARALLEL_GEMM_THRESHOLD)) {
+            gemm<T>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+            return;
+        }
+
+        /* Rows are split at the A panel height; columns only as far as needed for a few tiles per thread */
+        const size_t tileM = Blk::MC;
+        const size_t tilesM = (m + tileM - 1) / tileM;
+        const size_t wantedTiles = 4 * threads;
+        const size_t splitsN = std::max<size_t>(1, (wantedTiles + tilesM - 1) / tilesM);
+        size_t tileN = (n + splitsN - 1) / splitsN;
+        tileN = std::max<size_t>(Blk::NR, (tileN + Blk::NR - 1) / Blk::NR * Blk::NR);
+        const size_t tilesN = (n + tileN - 1) / tileN;
+
+        pool.parallel_for(tilesM * tilesN, [=](size_t tile) {
+            const size_t i0 = (tile / tilesN) * tileM;
+            const size_t j0 = (tile % tilesN) * tileN;
+            const size_t mt = std::min(tileM, m - i0);
+            const size_t nt = std::min(tileN, n - j0);
+
+            /* A vector times a matrix is a gemv however it is tiled, as on the serial path */
+            auto kernel = (m == 1 || n == 1) ? &gemm<T> : &gemm_blocked<T>;
+            kernel(mt, nt, k, alpha, a + i0 * rsa, rsa, csa, b + j0 * csb, rsb, csb,
+                   beta, c + i0 * rsc + j0 * csc, rsc, csc);
+        });
+    }
+
+namespace Detail {
+    /* Length of the pieces [0, n) is cut into: about four per thread, a multiple of grain, never empty */
+    inline size_t chunk_length(size_t n, size_t threads, size_t grain) {
+        const size_t chunk = (n + 4 * threads - 1) / (4 * threads);
+        return std::max(grain, (chunk + grain - 1) / grain * grain);
+    }
+} /* Detail */
+
+    /**
+     * Dot product split into contiguous pieces across the pool. The partial sums are added in piece order, so
+     * the result depends only on the pool size, not on scheduling. In deterministic mode the pieces are the
+     * leaves of the serial kernel and are added up in its pairwise tree, so the result is the serial one.
+     */
+    template <typename T>
+    T dot_parallel(ThreadPool& pool, size_t n, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy) {
+        const size_t threads = pool.thread_count();
+        if (threads <= 1 || n < static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD)) return dot<T>(n, x, incx, y, incy);
+
+        if (std::is_floating_point<T>::value && deterministic_mode()) {
+            constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+            const size_t leaves = (n + B - 1) / B;
+            const size_t chunk = Detail::chunk_length(leaves, threads, 1);
+            std::vector<T> partial(leaves);
+
+            pool.parallel_for((leaves + chunk - 1) / chunk, [&](size_t c) {
+                for (size_t l = c * chunk; l < std::min(leaves, (c + 1) * chunk); ++l) {
+                    const size_t i0 = l * B;
+                    partial[l] = dot<T>(std::min(B, n - i0), x + i0 * incx, incx, y + i0 * incy, incy);
+                }
+            });
+            return Detail::pairwise_sum<T>(0, leaves, [&](size_t l) { return partial[l]; });
+        }
+
+        const size_t chunk = Detail::chunk_length(n, threads, 1024);
+        const size_t chunks = (n + chunk - 1) / chunk;
+        std::vector<T> partial(chunks);
+
+        pool.parallel_for(chunks, [&](size_t c) {
+            const size_t i0 = c * chunk;
+            partial[c] = dot<T>(std::min(chunk, n - i0), x + i0 * incx, incx, y + i0 * incy, incy);
+        });
+
+        T ret(0);
+        for (const T& p : partial) ret += p;
+        return ret;
+    }
+
+    /**
+     * y += alpha * x split into contiguous pieces across the pool.
+     */
+    template <typename T>
+    void axpy_parallel(ThreadPool& pool, size_t n, T alpha, const T* x, ptrdiff_t incx, T* y, ptrdiff_t incy) {
+        const size_t threads = pool.thread_count();
+        if (threads <= 1 || n < static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD)) return axpy<T>(n, alpha, x, incx, y, incy);
+
+        const size_t chunk = Detail::chunk_length(n, threads, 1024);
+        pool.parallel_for((n + chunk - 1) / chunk, [=](size_t c) {
+            const size_t i0 = c * chunk;
+            axpy<T>(std::min(chunk, n - i0), alpha, x + i0 * incx, incx, y + i0 * incy, incy);
+        });
+    }
+
+    /**
+     * y = alpha * A * x + beta * y with the rows of A and y split across the pool. Every piece is an independent
+     * gemv, so the result is the same as on one thread.
+     */
+    template <typename T>
+    void gemv_parallel(ThreadPool& pool, size_t m, size_t n, T alpha, const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                       const T* x, ptrdiff_t incx, T beta, T* y, ptrdiff_t incy) {
+        const size_t threads = pool.thread_count();
+        if (threads <= 1 || m * n < static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD)) {
+            return gemv<T>(m, n, alpha, a, rsa, csa, x, incx, beta, y, incy);
+        }
+
+        const size_t chunk = Detail::chunk_length(m, threads, 16);
+        pool.parallel_for((m + chunk - 1) / chunk, [=](size_t c) {
+            const size_t i0 = c * chunk;
+            gemv<T>(std::min(chunk, m - i0), n, alpha, a + i0 * rsa, rsa, csa, x, incx, beta, y + i0 * incy, incy);
+        });
+    }
+
+    /**
+     * A += alpha * x * y^T with the rows of A split across the pool.
+     */
+    template <typename T>
+    void ger_parallel(ThreadPool& pool, size_t m, size_t n, T alpha, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy,
+                      T* a, ptrdiff_t rsa, ptrdiff_t csa) {
+        const size_t threads = pool.thread_count();
+        if (threads <= 1 || m * n < static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD)) {
+            return ger<T>(m, n, alpha, x, incx, y, incy, a, rsa, csa);
+        }
+
+        const size_t chunk = Detail::chunk_length(m, threads, 16);
+        pool.parallel_for((m + chunk - 1) / chunk, [=](size_t c) {
+            const size_t i0 = c * chunk;
+            ger<T>(std::min(chunk, m - i0), n, alpha, x + i0 * incx, incx, y, incy, a + i0 * rsa, rsa, csa);
+        });
+    }
+} /* Kernels */
+
+    /**
+     * Multiply two matrices (or expressions) on the calling thread. Equivalent to `(lhs * rhs).eval()`.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    auto multiply(Execution::SequencedPolicy, const L& lhs, const R& rhs) {
+        return (lhs * rhs).eval();
+    }
+
+    /**
+     * Multiply two matrices (or expressions) with the output split into tiles across a thread pool.
+     *
+     * @param policy Execution::par, or Execution::par.on(pool) to use a specific pool.
+     * @param lhs The left-hand matrix or expression.
+     * @param rhs The right-hand matrix or expression.
+     * @return The product, as the same matrix type `lhs * rhs` evaluates to.
+     * @throw std::invalid_argument if runtime-sized operands have mismatched inner dimensions.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    auto multiply(Execution::ParallelPolicy policy, const L& lhs, const R& rhs) {
+        using Product = ProductExpr<L, R>;
+        using T = typename Product::Scalar;
+
+        const Product product(lhs, rhs);
+        typename Product::PlainType ret;
+        Detail::OperandTraits<typename Product::PlainType>::resize(ret, product.rows(), product.cols());
+
+        const size_t m = product.rows(), n = product.cols(), k = product.inner();
+        const auto a = Detail::strided_ref(product.lhs());
+        const auto b = Detail::strided_ref(product.rhs());
+        Kernels::gemm_parallel<T>(policy.resolve(), m, n, k, T(1),
+                                  a.data, a.row_stride, a.col_stride,
+                                  b.data, b.row_stride, b.col_stride,
+                                  T(0), Detail::OperandTraits<typename Product::PlainType>::data(ret), n, 1);
+        return ret;
+    }
+
+namespace Detail {
+    /* The pool-backed counterpart of SequencedVectorKernels */
+    struct PooledVectorKernels {
+        ThreadPool* pool;
+
+        template <typename T>
+        T dot(size_t n, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy) const {
+            return Kernels::dot_parallel<T>(*pool, n, x, incx, y, incy);
+        }
+
+        template <typename T>
+        void axpy(size_t n, T alpha, const T* x, ptrdiff_t incx, T* y, ptrdiff_t incy) const {
+            Kernels::axpy_parallel<T>(*pool, n, alpha, x, incx, y, incy);
+        }
+
+        template <typename T>
+        void gemv(size_t m, size_t n, T alpha, const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                  const T* x, ptrdiff_t incx, T beta, T* y, ptrdiff_t incy) const {
+            Kernels::gemv_parallel<T>(*pool, m, n, alpha, a, rsa, csa, x, incx, beta, y, incy);
+        }
+
+        template <typename T>
+        void ger(size_t m, size_t n, T alpha, const T* x, ptrdiff_t incx, const T* y, ptrdiff_t incy,
+                 T* a, ptrdiff_t rsa, ptrdiff_t csa) const {
+            Kernels::ger_parallel<T>(*pool, m, n, alpha, x, incx, y, incy, a, rsa, csa);
+        }
+    };
+
+    inline SequencedVectorKernels vector_kernels(Execution::SequencedPolicy) { return {}; }
+    inline PooledVectorKernels vector_kernels(Execution::ParallelPolicy policy) { return {&policy.resolve()}; }
+
+    template <typename Policy>
+    using vector_kernels_t = decltype(vector_kernels(std::declval<Policy>()));
+
+    /* The pool an execution policy runs on, or null for the calling thread only */
+    inline ThreadPool* policy_pool(Execution::SequencedPolicy) { return nullptr; }
+    inline ThreadPool* policy_pool(Execution::ParallelPolicy policy) { return &policy.resolve(); }
+
+    template <typename Policy>
+    using enable_if_policy = decltype(policy_pool(std::declval<Policy>()));
+} /* Detail */
+
+    /**
+     * @brief Dot product under an execution policy; Execution::par splits long vectors across a thread pool.
+     */
+    template <typename Policy, typename X, typename Y, typename = Detail::vector_kernels_t<Policy>, Detail::enable_if_operands<X, Y> = 0>
+    typename Detail::OperandTraits<X>::Scalar dot(Policy policy, const X& x, const Y& y) {
+        return Detail::dot(Detail::vector_kernels(policy), x, y);
+    }
+
+    /**
+     * @brief y += alpha * x under an execution policy.
+     */
+    template <typename Policy, typename X, typename Y, typename = Detail::vector_kernels_t<Policy>,
+              Detail::enable_if_operands<X, typename std::decay<Y>::type> = 0>
+    void axpy(Policy policy, typename Detail::OperandTraits<X>::Scalar alpha, const X& x, Y&& y) {
+        Detail::axpy(Detail::vector_kernels(policy), alpha, x, y);
+    }
+
+    /**
+     * @brief y = alpha * A * x + beta * y under an execution policy; Execution::par splits the rows of A.
+     */
+    template <typename Policy, typename M, typename X, typename Y, typename = Detail::vector_kernels_t<Policy>,
+              Detail::enable_if_operands<M, X> = 0>
+    void gemv(Policy policy, typename Detail::OperandTraits<M>::Scalar alpha, const M& a, const X& x,
+              typename Detail::OperandTraits<M>::Scalar beta, Y&& y) {
+        Detail::gemv(Detail::vector_kernels(policy), alpha, a, x, beta, y);
+    }
+
+    /**
+     * @brief A += alpha * x * y^T under an execution policy; Execution::par splits the rows of A.
+     */
+    template <typename Policy, typename X, typename Y, typename M, typename = Detail::vector_kernels_t<Policy>,
+              Detail::enable_if_operands<X, Y> = 0>
+    void ger(Policy policy, typename Detail::OperandTraits<typename std::decay<M>::type>::Scalar alpha, const X& x, const Y& y, M&& a) {
+        Detail::ger(Detail::vector_kernels(policy), alpha, x, y, a);
+    }
+} /* MatrixLib */
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,187 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "gemm.h"
+#include "threadPool.h"
+
+namespace MatrixLib {
+namespace Kernels {
+    /*
+     * Reductions over the rows x cols elements a[i * rs + j * cs], addressed like the GEMM kernels.
+     *
+     * A reduction along contiguous memory splits each line into leaves of MATRIXLIB_REDUCTION_BLOCK elements,
+     * reduces every leaf with the SIMD kernels and adds the leaf results up pairwise in a tree that depends only
+     * on the number of leaves, so the rounding error grows with log(n) rather than n. A reduction across
+     * contiguous lines, such as the column sums of a row-major matrix, adds whole rows at a time with Kahan
+     * compensation instead. The pool only decides who computes which leaf or line, so results are bitwise the
+     * same with and without one, whatever its size, for a given instruction set.
+     */
+    enum class Reduction { sum, sum_squares, min, max };
+
+namespace Detail {
+    template <Reduction _Op, typename T>
+    T combine(T a, T b) {
+        if constexpr (_Op == Reduction::min) return b < a ? b : a;
+        else if constexpr (_Op == Reduction::max) return a < b ? b : a;
+        else return a + b;
+    }
+
+    template <Reduction _Op, typename T>
+    T leaf(const T* x, size_t n, ptrdiff_t inc) {
+        if (inc == 1) {
+            if constexpr (_Op == Reduction::sum) return reduce_sum(x, n);
+            else if constexpr (_Op == Reduction::sum_squares) return dot_product(x, x, n);
+            else if constexpr (_Op == Reduction::min) return reduce_min(x, n);
+            else return reduce_max(x, n);
+        }
+
+        T ret = _Op == Reduction::sum_squares ? x[0] * x[0] : x[0];
+        for (size_t i = 1; i < n; ++i) {
+            const T v = x[i * inc];
+            ret = combine<_Op>(ret, _Op == Reduction::sum_squares ? static_cast<T>(v * v) : v);
+        }
+        return ret;
+    }
+
+    /* Pairwise combination of part(first) .. part(last - 1), split at the middle index */
+    template <Reduction _Op, typename T, typename F>
+    T pairwise(size_t first, size_t last, const F& part) {
+        if (last - first == 1) return part(first);
+        const size_t mid = first + (last - first) / 2;
+        return combine<_Op>(pairwise<_Op, T>(first, mid, part), pairwise<_Op, T>(mid, last, part));
+    }
+
+    /* Reduction of one line of n >= 1 elements x[i * inc] */
+    template <Reduction _Op, typename T>
+    T reduce_line(const T* x, size_t n, ptrdiff_t inc) {
+        constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+        if (n <= B) return leaf<_Op>(x, n, inc);
+
+        return pairwise<_Op, T>(0, (n + B - 1) / B, [=](size_t b) {
+            return leaf<_Op>(x + static_cast<ptrdiff_t>(b * B) * inc, std::min(B, n - b * B), inc);
+        });
+    }
+
+    /* Splits count items into chunks of at least grain items, one batch per thread, and runs body(first, last) */
+    template <typename F>
+    void for_chunks(ThreadPool* pool, size_t count, size_t grain, const F& body) {
+        const size_t threads = pool ? pool->thread_count() : 1;
+        if (threads <= 1 || count <= grain) return body(size_t(0), count);
+
+        const size_t chunk = std::max(grain, (count + threads - 1) / threads);
+        pool->parallel_for((count + chunk - 1) / chunk, [&](size_t c) { body(c * chunk, std::min(count, (c + 1) * chunk)); });
+    }
+
+    /*
+     * out[i * inc] = reduction over j of a[i * rs + j * cs] for rows [first, last) of a matrix whose rows are
+     * adjacent (rs == 1): one pass over the columns, updating every row at once.
+     */
+    template <Reduction _Op, typename T>
+    void reduce_across(size_t first, size_t last, size_t cols, const T* a, ptrdiff_t cs, T* out, ptrdiff_t inc) {
+        const size_t m = last - first;
+        static thread_local std::vector<T> buffer;
+        buffer.assign(2 * m, T(0));
+        T* acc = buffer.data();
+        T* comp = acc + m;
+        a += first;
+
+        if constexpr (_Op == Reduction::min || _Op == Reduction::max) {
+            std::copy(a, a + m, acc);
+            for (size_t j = 1; j < cols; ++j) {
+                const T* x = a + static_cast<ptrdiff_t>(j) * cs;
+                MATRIXLIB_IVDEP
+                for (size_t i = 0; i < m; ++i) acc[i] = combine<_Op>(acc[i], x[i]);
+            }
+        } else {
+            for (size_t j = 0; j < cols; ++j) {
+                const T* x = a + static_cast<ptrdiff_t>(j) * cs;
+                if constexpr (std::is_floating_point<T>::value) {
+                    MATRIXLIB_IVDEP
+                    for (size_t i = 0; i < m; ++i) {
+                        const T y = (_Op == Reduction::sum_squares ? x[i] * x[i] : x[i]) - comp[i];
+                        const T t = acc[i] + y;
+                        comp[i] = (t - acc[i]) - y;
+                        acc[i] = t;
+                    }
+                } else {
+                    MATRIXLIB_IVDEP
+                    for (size_t i = 0; i < m; ++i) acc[i] += _Op == Reduction::sum_squares ? x[i] * x[i] : x[i];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < m; ++i) out[(first + i) * inc] = acc[i];
+    }
+} /* Detail */
+
+    /**
+     * out[i * inc] = reduction of row i, over its cols >= 1 elements a[i * rs + j * cs]. Rows are spread over the
+     * pool when one is given. Reduce columns by swapping rows with cols and rs with cs.
+     */
+    template <Reduction _Op, typename T>
+    void reduce_rows(size_t rows, size_t cols, const T* a, ptrdiff_t rs, ptrdiff_t cs, T* out, ptrdiff_t inc, ThreadPool* pool = nullptr) {
+        if (rows == 0) return;
+
+        if (rs == 1 && cs != 1) {
+            /* Slices are whole groups of 64 rows, so each row sees the same vector or scalar code whatever the split */
+            const size_t groups = (rows + 63) / 64;
+            Detail::for_chunks(pool, groups, std::max<size_t>(1, 16 * MATRIXLIB_REDUCTION_BLOCK / (64 * cols)), [&](size_t first, size_t last) {
+                Detail::reduce_across<_Op>(first * 64, std::min(rows, last * 64), cols, a, cs, out, inc);
+            });
+            return;
+        }
+
+        Detail::for_chunks(pool, rows, std::max<size_t>(1, MATRIXLIB_REDUCTION_BLOCK / std::max<size_t>(cols, 1)), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) out[i * inc] = Detail::reduce_line<_Op>(a + static_cast<ptrdiff_t>(i) * rs, cols, cs);
+        });
+    }
+
+    /**
+     * Reduction of all rows * cols >= 1 elements a[i * rs + j * cs]. A contiguous matrix is one line; otherwise
+     * the lines along the smaller stride are reduced and their results combined pairwise.
+     */
+    template <Reduction _Op, typename T>
+    T reduce(size_t rows, size_t cols, const T* a, ptrdiff_t rs, ptrdiff_t cs, ThreadPool* pool = nullptr) {
+        if (std::abs(cs) > std::abs(rs)) {
+            std::swap(rows, cols);
+            std::swap(rs, cs);
+        }
+
+        /* One contiguous line, or any other shape, as lines of equal length and a fixed pairwise tree over them */
+        size_t lines = rows, length = cols;
+        if (cs == 1 && (rows == 1 || rs == static_cast<ptrdiff_t>(cols))) lines = 1, length = rows * cols;
+
+        constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+        const size_t leaves = (length + B - 1) / B;
+        auto part = [&](size_t k) {
+            const size_t line = k / leaves, b = k % leaves;
+            return Detail::leaf<_Op>(a + static_cast<ptrdiff_t>(line) * rs + static_cast<ptrdiff_t>(b * B) * cs, std::min(B, length - b * B), cs);
+        };
+
+        /* Line by line, each line's leaves reduced pairwise first, and then the lines */
+        const size_t total = lines * leaves;
+        if (!pool || pool->thread_count() <= 1 || total <= 1) {
+            return Detail::pairwise<_Op, T>(0, lines, [&](size_t line) {
+                return Detail::pairwise<_Op, T>(line * leaves, (line + 1) * leaves, part);
+            });
+        }
+
+        std::vector<T> partial(total);
+        Detail::for_chunks(pool, total, std::max<size_t>(1, 64 * 1024 / B), [&](size_t first, size_t last) {
+            for (size_t k = first; k < last; ++k) partial[k] = part(k);
+        });
+
+        return Detail::pairwise<_Op, T>(0, lines, [&](size_t line) {
+            return Detail::pairwise<_Op, T>(line * leaves, (line + 1) * leaves, [&](size_t k) { return partial[k]; });
+        });
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* REDUCE_H */
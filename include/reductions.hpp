@@ -0,0 +1,505 @@
+#ifndef REDUCTIONS_H
+#define REDUCTIONS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "utils.h"
+#include "parallel.hpp"
+#include "reduce.h"
+
+/* Lanes a generic reduce() keeps in flight, so that the compiler can turn a simple operation into vector code */
+#ifndef MATRIXLIB_REDUCE_LANES
+#define MATRIXLIB_REDUCE_LANES 32
+#endif
+
+namespace MatrixLib {
+namespace Detail {
+    template <typename E>
+    using enable_if_operand = typename std::enable_if<OperandTraits<E>::is_operand, int>::type;
+
+    /* The type of a mean or a norm: the scalar itself for floating-point matrices, double for integer ones */
+    template <typename T>
+    using real_t = typename std::conditional<std::is_integral<T>::value, double, T>::type;
+
+    /* Below MATRIXLIB_PARALLEL_VECTOR_THRESHOLD elements the pool is not worth waking */
+    template <typename Policy>
+    ThreadPool* reduction_pool(Policy policy, size_t elements) {
+        return elements >= static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD) ? policy_pool(policy) : nullptr;
+    }
+
+    inline void check_not_empty(const char* what, size_t rows, size_t cols) {
+        if (rows == 0 || cols == 0) Utils::throw_invalid_argument_error("Cannot take the %s of an empty %zux%zu matrix", what, rows, cols);
+    }
+
+    inline const char* reduction_name(Kernels::Reduction op) {
+        return op == Kernels::Reduction::min ? "minimum" : "maximum";
+    }
+
+    template <Kernels::Reduction _Op, typename Policy, typename E>
+    typename OperandTraits<E>::Scalar reduce_all(Policy policy, const E& e) {
+        const auto& stored = stored_operand(e);
+        const auto s = strided_ref(stored);
+
+        if (s.rows == 0 || s.cols == 0) {
+            if constexpr (_Op == Kernels::Reduction::min || _Op == Kernels::Reduction::max) check_not_empty(reduction_name(_Op), s.rows, s.cols);
+            return typename OperandTraits<E>::Scalar(0);
+        }
+
+        return Kernels::reduce<_Op>(s.rows, s.cols, s.data, s.row_stride, s.col_stride, reduction_pool(policy, s.rows * s.cols));
+    }
+
+    /* One result per row (_Rowwise) or per column, as a column or a row vector */
+    template <Kernels::Reduction _Op, bool _Rowwise, typename Policy, typename E>
+    auto reduce_lines(Policy policy, const E& e) {
+        using Traits = OperandTraits<E>;
+        using Ret = typename PlainObject<typename Traits::Scalar, _Rowwise ? Traits::row_extent : 1,
+                                         _Rowwise ? 1 : Traits::col_extent, Traits::is_dynamic>::type;
+
+        const auto& stored = stored_operand(e);
+        const auto s = strided_ref(stored);
+        const size_t lines = _Rowwise ? s.rows : s.cols, length = _Rowwise ? s.cols : s.rows;
+
+        Ret ret;
+        OperandTraits<Ret>::resize(ret, _Rowwise ? lines : 1, _Rowwise ? 1 : lines);
+        auto* out = OperandTraits<Ret>::data(ret);
+
+        if (length == 0) {
+            if constexpr (_Op == Kernels::Reduction::min || _Op == Kernels::Reduction::max) check_not_empty(reduction_name(_Op), s.rows, s.cols);
+            std::fill(out, out + lines, typename Traits::Scalar(0));
+            return ret;
+        }
+
+        ThreadPool* pool = reduction_pool(policy, s.rows * s.cols);
+        if constexpr (_Rowwise) {
+            Kernels::reduce_rows<_Op>(s.rows, s.cols, s.data, s.row_stride, s.col_stride, out, 1, pool);
+        } else {
+            Kernels::reduce_rows<_Op>(s.cols, s.rows, s.data, s.col_stride, s.row_stride, out, 1, pool);
+        }
+        return ret;
+    }
+
+    /* The element-wise image f(x) of a vector of sums, in the real type: square roots for norms, quotients for means */
+    template <typename V, typename F>
+    auto transform_lines(const V& v, F f) {
+        using Traits = OperandTraits<V>;
+        using Ret = typename PlainObject<real_t<typename Traits::Scalar>, Traits::row_extent, Traits::col_extent, Traits::is_dynamic>::type;
+
+        Ret ret;
+        OperandTraits<Ret>::resize(ret, Traits::rows(v), Traits::cols(v));
+        const auto* in = strided_ref(v).data;
+        auto* out = OperandTraits<Ret>::data(ret);
+        for (size_t i = 0, n = Traits::rows(v) * Traits::cols(v); i < n; ++i) out[i] = f(static_cast<real_t<typename Traits::Scalar>>(in[i]));
+        return ret;
+    }
+
+    /* Accumulator of integer sums the element type would overflow: 64 bits, or double for sums of squares */
+    template <bool _Squares>
+    using wide_t = typename std::conditional<_Squares, double, std::int64_t>::type;
+
+    /*
+     * Sum, or sum of squares, of every row (_Rowwise) or column of an integer matrix, in wide_t. Every line is
+     * added up in order by one thread, so the pool does not change the result.
+     */
+    template <bool _Squares, bool _Rowwise, typename Policy, typename E>
+    std::vector<wide_t<_Squares>> wide_lines(Policy policy, const E& e) {
+        using Acc = wide_t<_Squares>;
+        const auto& stored = stored_operand(e);
+        const auto s = strided_ref(stored);
+        const size_t lines = _Rowwise ? s.rows : s.cols, length = _Rowwise ? s.cols : s.rows;
+        const ptrdiff_t across = _Rowwise ? s.row_stride : s.col_stride, along = _Rowwise ? s.col_stride : s.row_stride;
+
+        std::vector<Acc> ret(lines, Acc(0));
+        const size_t grain = std::max<size_t>(1, MATRIXLIB_REDUCTION_BLOCK / std::max<size_t>(length, 1));
+        Kernels::Detail::for_chunks(reduction_pool(policy, s.rows * s.cols), lines, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto* x = s.data + static_cast<ptrdiff_t>(i) * across;
+                Acc acc(0);
+                for (size_t j = 0; j < length; ++j) {
+                    const Acc v = static_cast<Acc>(x[static_cast<ptrdiff_t>(j) * along]);
+                    acc += _Squares ? v * v : v;
+                }
+                ret[i] = acc;
+            }
+        });
+        return ret;
+    }
+
+    /* wide_lines over all rows, added up in order */
+    template <bool _Squares, typename Policy, typename E>
+    wide_t<_Squares> wide_total(Policy policy, const E& e) {
+        const auto lines = wide_lines<_Squares, true>(policy, e);
+        return std::accumulate(lines.begin(), lines.end(), wide_t<_Squares>(0));
+    }
+
+    /* f of every wide line sum of an integer matrix, as a column (_Rowwise) or row vector of double */
+    template <bool _Squares, bool _Rowwise, typename Policy, typename E, typename F>
+    auto transform_wide_lines(Policy policy, const E& e, F f) {
+        using Traits = OperandTraits<E>;
+        using Ret = typename PlainObject<double, _Rowwise ? Traits::row_extent : 1, _Rowwise ? 1 : Traits::col_extent, Traits::is_dynamic>::type;
+
+        const auto lines = wide_lines<_Squares, _Rowwise>(policy, e);
+        Ret ret;
+        OperandTraits<Ret>::resize(ret, _Rowwise ? lines.size() : 1, _Rowwise ? 1 : lines.size());
+        double* out = OperandTraits<Ret>::data(ret);
+        for (size_t i = 0; i < lines.size(); ++i) out[i] = f(static_cast<double>(lines[i]));
+        return ret;
+    }
+
+    /* Writes f(x(i, j)...) for every element of equally shaped strided operands into a dense row-major matrix */
+    template <typename U, typename F, typename... T>
+    void map_strided(ThreadPool* pool, U* out, F& f, const StridedRef<T>&... in) {
+        const auto& first = std::get<0>(std::forward_as_tuple(in...));
+        const size_t rows = first.rows, cols = first.cols;
+
+        if (((in.col_stride == 1 && (rows == 1 || in.row_stride == static_cast<ptrdiff_t>(cols))) && ...)) {
+            Kernels::Detail::for_chunks(pool, rows * cols, MATRIXLIB_REDUCTION_BLOCK, [&](size_t begin, size_t end) {
+                MATRIXLIB_IVDEP
+                for (size_t k = begin; k < end; ++k) out[k] = f(in.data[k]...);
+            });
+            return;
+        }
+
+        Kernels::Detail::for_chunks(pool, rows, std::max<size_t>(1, MATRIXLIB_REDUCTION_BLOCK / std::max<size_t>(cols, 1)), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                U* o = out + i * cols;
+                for (size_t j = 0; j < cols; ++j) o[j] = f(in.data[static_cast<ptrdiff_t>(i) * in.row_stride + static_cast<ptrdiff_t>(j) * in.col_stride]...);
+            }
+        });
+    }
+
+    /*
+     * Fold of the n >= 1 elements x[i * inc]. Contiguous runs go through MATRIXLIB_REDUCE_LANES independent
+     * accumulators, seeded with the first elements, so that op is applied lane by lane and can be vectorised.
+     */
+    template <typename A, typename T, typename Op>
+    A fold_run(const T* x, size_t n, ptrdiff_t inc, Op& op) {
+        constexpr size_t K = MATRIXLIB_REDUCE_LANES;
+
+        if (inc != 1 || n < 2 * K) {
+            A acc = static_cast<A>(x[0]);
+            for (size_t i = 1; i < n; ++i) acc = op(acc, static_cast<A>(x[i * inc]));
+            return acc;
+        }
+
+        A lanes[K];
+        for (size_t l = 0; l < K; ++l) lanes[l] = static_cast<A>(x[l]);
+
+        size_t i = K;
+        for (; i + K <= n; i += K) {
+            for (size_t l = 0; l < K; ++l) lanes[l] = op(lanes[l], static_cast<A>(x[i + l]));
+        }
+
+        A acc = lanes[0];
+        for (size_t l = 1; l < K; ++l) acc = op(acc, lanes[l]);
+        for (; i < n; ++i) acc = op(acc, static_cast<A>(x[i]));
+        return acc;
+    }
+} /* Detail */
+
+    /**
+     * @brief Sum of all elements. Floating-point sums are added pairwise from SIMD partial sums, so the error grows
+     * with log(n), and the result is the same on every run, with or without threads, for a given instruction set.
+     * An empty matrix sums to zero.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar sum(Policy policy, const E& m) {
+        return Detail::reduce_all<Kernels::Reduction::sum>(policy, m);
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar sum(const E& m) { return sum(Execution::seq, m); }
+
+    /**
+     * @brief Smallest element. Which element is returned when the matrix contains NaN is unspecified.
+     * @throw std::invalid_argument if the matrix is empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar min(Policy policy, const E& m) {
+        return Detail::reduce_all<Kernels::Reduction::min>(policy, m);
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar min(const E& m) { return min(Execution::seq, m); }
+
+    /**
+     * @brief Largest element. Which element is returned when the matrix contains NaN is unspecified.
+     * @throw std::invalid_argument if the matrix is empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar max(Policy policy, const E& m) {
+        return Detail::reduce_all<Kernels::Reduction::max>(policy, m);
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    typename Detail::OperandTraits<E>::Scalar max(const E& m) { return max(Execution::seq, m); }
+
+    /**
+     * @brief Mean of all elements. Integer matrices are added up in 64 bits and give a double, so the mean is right
+     * even where the sum overflows the element type.
+     * @throw std::invalid_argument if the matrix is empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto mean(Policy policy, const E& m) {
+        using Real = Detail::real_t<typename Detail::OperandTraits<E>::Scalar>;
+        const size_t count = Detail::OperandTraits<E>::rows(m) * Detail::OperandTraits<E>::cols(m);
+        Detail::check_not_empty("mean", Detail::OperandTraits<E>::rows(m), Detail::OperandTraits<E>::cols(m));
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) {
+            return static_cast<Real>(Detail::wide_total<false>(policy, m)) / static_cast<Real>(count);
+        } else {
+            return static_cast<Real>(sum(policy, m)) / static_cast<Real>(count);
+        }
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto mean(const E& m) { return mean(Execution::seq, m); }
+
+    /**
+     * @brief Frobenius norm under an execution policy; the Euclidean norm for vectors. The squares of integer
+     * matrices are added up in double. norm(m) without a policy is declared in matrixVector.hpp.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto norm(Policy policy, const E& m) {
+        using std::sqrt;
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) return sqrt(Detail::wide_total<true>(policy, m));
+        else return sqrt(static_cast<Detail::real_t<typename Detail::OperandTraits<E>::Scalar>>(Detail::reduce_all<Kernels::Reduction::sum_squares>(policy, m)));
+    }
+
+    /**
+     * @brief Sums of every row, as a column vector. Rows are spread across the pool under Execution::par.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto rowwise_sum(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::sum, true>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto rowwise_sum(const E& m) { return rowwise_sum(Execution::seq, m); }
+
+    /**
+     * @brief Smallest element of every row, as a column vector.
+     * @throw std::invalid_argument if the rows are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto rowwise_min(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::min, true>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto rowwise_min(const E& m) { return rowwise_min(Execution::seq, m); }
+
+    /**
+     * @brief Largest element of every row, as a column vector.
+     * @throw std::invalid_argument if the rows are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto rowwise_max(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::max, true>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto rowwise_max(const E& m) { return rowwise_max(Execution::seq, m); }
+
+    /**
+     * @brief Euclidean norm of every row, as a column vector.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto rowwise_norm(Policy policy, const E& m) {
+        using std::sqrt;
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) {
+            return Detail::transform_wide_lines<true, true>(policy, m, [](double x) { return sqrt(x); });
+        } else {
+            return Detail::transform_lines(Detail::reduce_lines<Kernels::Reduction::sum_squares, true>(policy, m), [](auto x) { return sqrt(x); });
+        }
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto rowwise_norm(const E& m) { return rowwise_norm(Execution::seq, m); }
+
+    /**
+     * @brief Mean of every row, as a column vector, in double for integer matrices, which are added up in 64 bits.
+     * @throw std::invalid_argument if the rows are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto rowwise_mean(Policy policy, const E& m) {
+        const size_t cols = Detail::OperandTraits<E>::cols(m);
+        if (Detail::OperandTraits<E>::rows(m) != 0) Detail::check_not_empty("mean", Detail::OperandTraits<E>::rows(m), cols);
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) {
+            return Detail::transform_wide_lines<false, true>(policy, m, [cols](double x) { return x / static_cast<double>(cols); });
+        } else {
+            return Detail::transform_lines(rowwise_sum(policy, m), [cols](auto x) { return x / static_cast<decltype(x)>(cols); });
+        }
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto rowwise_mean(const E& m) { return rowwise_mean(Execution::seq, m); }
+
+    /**
+     * @brief Sums of every column, as a row vector. Columns of a row-major matrix are accumulated a whole row at a
+     * time with Kahan compensation; columns are spread across the pool under Execution::par.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto colwise_sum(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::sum, false>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto colwise_sum(const E& m) { return colwise_sum(Execution::seq, m); }
+
+    /**
+     * @brief Smallest element of every column, as a row vector.
+     * @throw std::invalid_argument if the columns are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto colwise_min(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::min, false>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto colwise_min(const E& m) { return colwise_min(Execution::seq, m); }
+
+    /**
+     * @brief Largest element of every column, as a row vector.
+     * @throw std::invalid_argument if the columns are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto colwise_max(Policy policy, const E& m) { return Detail::reduce_lines<Kernels::Reduction::max, false>(policy, m); }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto colwise_max(const E& m) { return colwise_max(Execution::seq, m); }
+
+    /**
+     * @brief Euclidean norm of every column, as a row vector.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto colwise_norm(Policy policy, const E& m) {
+        using std::sqrt;
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) {
+            return Detail::transform_wide_lines<true, false>(policy, m, [](double x) { return sqrt(x); });
+        } else {
+            return Detail::transform_lines(Detail::reduce_lines<Kernels::Reduction::sum_squares, false>(policy, m), [](auto x) { return sqrt(x); });
+        }
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto colwise_norm(const E& m) { return colwise_norm(Execution::seq, m); }
+
+    /**
+     * @brief Mean of every column, as a row vector, in double for integer matrices, which are added up in 64 bits.
+     * @throw std::invalid_argument if the columns are empty.
+     */
+    template <typename Policy, typename E, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto colwise_mean(Policy policy, const E& m) {
+        const size_t rows = Detail::OperandTraits<E>::rows(m);
+        if (Detail::OperandTraits<E>::cols(m) != 0) Detail::check_not_empty("mean", rows, Detail::OperandTraits<E>::cols(m));
+        if constexpr (std::is_integral<typename Detail::OperandTraits<E>::Scalar>::value) {
+            return Detail::transform_wide_lines<false, false>(policy, m, [rows](double x) { return x / static_cast<double>(rows); });
+        } else {
+            return Detail::transform_lines(colwise_sum(policy, m), [rows](auto x) { return x / static_cast<decltype(x)>(rows); });
+        }
+    }
+
+    template <typename E, Detail::enable_if_operand<E> = 0>
+    auto colwise_mean(const E& m) { return colwise_mean(Execution::seq, m); }
+
+    /**
+     * @brief The matrix of f(x) for every element x, of the type f returns.
+     *
+     * Dense operands are walked as one flat array, so a simple f compiles to a vector loop. Under
+     * Execution::par large matrices are split across the pool, so f must be safe to call concurrently.
+     */
+    template <typename Policy, typename E, typename F, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    auto map(Policy policy, const E& m, F f) {
+        using Traits = Detail::OperandTraits<E>;
+        using U = typename std::decay<std::invoke_result_t<F&, const typename Traits::Scalar&>>::type;
+        using Ret = typename Detail::PlainObject<U, Traits::row_extent, Traits::col_extent, Traits::is_dynamic>::type;
+
+        const auto& stored = Detail::stored_operand(m);
+        const auto s = Detail::strided_ref(stored);
+        Ret ret;
+        Detail::OperandTraits<Ret>::resize(ret, s.rows, s.cols);
+        Detail::map_strided(Detail::reduction_pool(policy, s.rows * s.cols), Detail::OperandTraits<Ret>::data(ret), f, s);
+        return ret;
+    }
+
+    template <typename E, typename F, Detail::enable_if_operand<E> = 0>
+    auto map(const E& m, F f) { return map(Execution::seq, m, std::move(f)); }
+
+    /**
+     * @brief The matrix of f(x, y) for the elements x of a and y of b at the same position.
+     * @throw std::invalid_argument if runtime-sized operands differ in shape.
+     */
+    template <typename Policy, typename A, typename B, typename F, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operands<A, B> = 0>
+    auto zip_map(Policy policy, const A& a, const B& b, F f) {
+        using TA = Detail::OperandTraits<A>;
+        using TB = Detail::OperandTraits<B>;
+        static_assert(Detail::extents_compatible(TA::row_extent, TB::row_extent) && Detail::extents_compatible(TA::col_extent, TB::col_extent),
+                      "zip_map requires operands of the same shape");
+        using U = typename std::decay<std::invoke_result_t<F&, const typename TA::Scalar&, const typename TB::Scalar&>>::type;
+        using Ret = typename Detail::PlainObject<U, Detail::merge_extents(TA::row_extent, TB::row_extent),
+                                                 Detail::merge_extents(TA::col_extent, TB::col_extent), TA::is_dynamic || TB::is_dynamic>::type;
+
+        const auto& sa = Detail::stored_operand(a);
+        const auto& sb = Detail::stored_operand(b);
+        const auto ra = Detail::strided_ref(sa);
+        const auto rb = Detail::strided_ref(sb);
+        if (ra.rows != rb.rows || ra.cols != rb.cols) {
+            Utils::throw_invalid_argument_error("Cannot zip a %zux%zu matrix with a %zux%zu matrix", ra.rows, ra.cols, rb.rows, rb.cols);
+        }
+
+        Ret ret;
+        Detail::OperandTraits<Ret>::resize(ret, ra.rows, ra.cols);
+        Detail::map_strided(Detail::reduction_pool(policy, ra.rows * ra.cols), Detail::OperandTraits<Ret>::data(ret), f, ra, rb);
+        return ret;
+    }
+
+    template <typename A, typename B, typename F, Detail::enable_if_operands<A, B> = 0>
+    auto zip_map(const A& a, const B& b, F f) { return zip_map(Execution::seq, a, b, std::move(f)); }
+
+    /**
+     * @brief Combines init and every element with op, like std::reduce: op(op(init, x0), x1)... in an unspecified
+     * order, so op must be associative and commutative.
+     *
+     * The grouping is fixed by the shape of the matrix alone, so the result does not change between runs or
+     * with the number of threads even for floating-point op. Under Execution::par large matrices are split across
+     * the pool, so op is called concurrently and must be safe to call so, besides associative. Elements are
+     * converted to the type of init.
+     */
+    template <typename Policy, typename E, typename T, typename Op, typename = Detail::enable_if_policy<Policy>, Detail::enable_if_operand<E> = 0>
+    T reduce(Policy policy, const E& m, T init, Op op) {
+        const auto& stored = Detail::stored_operand(m);
+        auto s = Detail::strided_ref(stored);
+        if (s.rows == 0 || s.cols == 0) return init;
+
+        /* Runs of at most one block along the smaller stride, folded in a fixed order */
+        if (std::abs(s.col_stride) > std::abs(s.row_stride)) {
+            std::swap(s.rows, s.cols);
+            std::swap(s.row_stride, s.col_stride);
+        }
+        size_t lines = s.rows, length = s.cols;
+        if (s.col_stride == 1 && (s.rows == 1 || s.row_stride == static_cast<ptrdiff_t>(s.cols))) lines = 1, length = s.rows * s.cols;
+
+        constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+        const size_t runs = (length + B - 1) / B;
+        auto run = [&](size_t k) {
+            const size_t line = k / runs, r = k % runs;
+            return Detail::fold_run<T>(s.data + static_cast<ptrdiff_t>(line) * s.row_stride + static_cast<ptrdiff_t>(r * B) * s.col_stride,
+                                       std::min(B, length - r * B), s.col_stride, op);
+        };
+
+        const size_t total = lines * runs;
+        ThreadPool* pool = Detail::reduction_pool(policy, s.rows * s.cols);
+        if (!pool || pool->thread_count() <= 1) {
+            for (size_t k = 0; k < total; ++k) init = op(init, run(k));
+            return init;
+        }
+
+        std::vector<T> partial(total);
+        Kernels::Detail::for_chunks(pool, total, 1, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) partial[k] = run(k);
+        });
+        for (const T& p : partial) init = op(init, p);
+        return init;
+    }
+
+    template <typename E, typename T, typename Op, Detail::enable_if_operand<E> = 0>
+    T reduce(const E& m, T init, Op op) { return reduce(Execution::seq, m, std::move(init), std::move(op)); }
+} /* MatrixLib */
+
+#endif /* REDUCTIONS_H */
@@ -0,0 +1,269 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "utils.h"
+#include "alignedAllocator.h"
+
+/* Size in bytes of the first block a scratch arena takes from the heap; later blocks at least double */
+#ifndef MATRIXLIB_SCRATCH_BLOCK_SIZE
+#define MATRIXLIB_SCRATCH_BLOCK_SIZE (1 << 20)
+#endif
+
+namespace MatrixLib {
+    /**
+     * @brief Stack-like memory resource that recycles the buffers of short-lived matrix temporaries.
+     *
+     * Allocations are carved from large blocks by bumping a cursor. Freeing the most recent allocation moves
+     * the cursor back, so temporaries created and destroyed in nested scopes reuse the same bytes; memory freed
+     * out of order is reclaimed once everything allocated after it is freed as well. Blocks are kept when they
+     * empty, and an arena that needed several blocks merges them into one as soon as it is idle, so a loop that
+     * allocates the same temporaries on every iteration stops touching the heap after its first iteration.
+     *
+     * Every thread has its own arena, local(), which the library uses for the temporaries of aliased
+     * assignments and nested products of runtime-sized matrices. It is a std::pmr::memory_resource, so it can
+     * also back pmr::DynMatrix or any other pmr container. An arena is not thread-safe; memory must be freed on
+     * the thread that owns the arena.
+     */
+    class ScratchArena : public std::pmr::memory_resource {
+    public:
+        /**
+         * @brief Allocation counters of an arena since it was created or its statistics were last reset.
+         */
+        struct Stats {
+            /* Requests served */
+            size_t allocations = 0;
+            /* Requests served from blocks the arena already held, i.e. heap allocations avoided */
+            size_t allocations_avoided = 0;
+            /* Blocks taken from the heap, including the merged blocks of an idle arena */
+            size_t upstream_allocations = 0;
+            /* Bytes currently handed out, and the most ever handed out at once */
+            size_t bytes_in_use = 0;
+            size_t peak_bytes = 0;
+            /* Bytes held in blocks */
+            size_t capacity = 0;
+        };
+
+        ScratchArena() = default;
+        ScratchArena(const ScratchArena&) = delete;
+        ScratchArena& operator=(const ScratchArena&) = delete;
+
+        ~ScratchArena() override {
+            for (const Block& block : blocks_) free_block(block);
+        }
+
+        /**
+         * @return The calling thread's arena.
+         */
+        static ScratchArena& local() {
+            static thread_local ScratchArena arena;
+            return arena;
+        }
+
+        /**
+         * @return The allocation counters of this arena.
+         */
+        const Stats& stats() const noexcept { return stats_; }
+
+        /**
+         * @brief Zeroes the counters, keeping the current usage and capacity, e.g. after a warm-up iteration.
+         */
+        void reset_stats() noexcept {
+            stats_.allocations = stats_.allocations_avoided = stats_.upstream_allocations = 0;
+            stats_.peak_bytes = stats_.bytes_in_use;
+        }
+
+        /**
+         * @return The number of allocations that have not been freed yet.
+         */
+        size_t live_allocations() const noexcept {
+            return static_cast<size_t>(std::count_if(frames_.begin(), frames_.end(), [](const Frame& f) { return !f.released; }));
+        }
+
+        /**
+         * @brief Returns every block to the heap.
+         * @throw std::runtime_error if allocations from this arena are still alive.
+         */
+        void release() {
+            if (!frames_.empty()) Utils::throw_runtime_error("Cannot release a scratch arena with %zu live allocations", live_allocations());
+
+            for (const Block& block : blocks_) free_block(block);
+            blocks_.clear();
+            block_ = offset_ = 0;
+            stats_.capacity = 0;
+        }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            alignment = std::max(alignment, alignof(std::max_align_t));
+            /* Zero-byte requests still get a distinct address, so that frees can be matched to allocations */
+            bytes = std::max<size_t>(bytes, 1);
+
+            const Frame before{nullptr, block_, offset_, false};
+            bool grew = false;
+
+            for (;;) {
+                if (block_ < blocks_.size()) {
+                    const Block& block = blocks_[block_];
+                    const auto base = reinterpret_cast<std::uintptr_t>(block.data);
+                    const size_t start = static_cast<size_t>(((base + offset_ + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base);
+
+                    if (start + bytes <= block.size) {
+                        Frame frame = before;
+                        frame.pointer = block.data + start;
+                        frames_.push_back(frame);
+                        offset_ = start + bytes;
+
+                        ++stats_.allocations;
+                        if (!grew) ++stats_.allocations_avoided;
+                        stats_.bytes_in_use += bytes;
+                        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_in_use);
+                        return frame.pointer;
+                    }
+
+                    if (block_ + 1 < blocks_.size()) {
+                        ++block_;
+                        offset_ = 0;
+                        continue;
+                    }
+                }
+
+                const size_t previous = blocks_.empty() ? 0 : blocks_.back().size;
+                add_block(std::max({static_cast<size_t>(MATRIXLIB_SCRATCH_BLOCK_SIZE), bytes + alignment, 2 * previous}));
+                block_ = blocks_.size() - 1;
+                offset_ = 0;
+                grew = true;
+            }
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t) override {
+            stats_.bytes_in_use -= std::max<size_t>(bytes, 1);
+
+            for (size_t i = frames_.size(); i-- > 0;) {
+                if (frames_[i].pointer == p && !frames_[i].released) {
+                    frames_[i].released = true;
+                    break;
+                }
+            }
+
+            while (!frames_.empty() && frames_.back().released) {
+                block_ = frames_.back().block;
+                offset_ = frames_.back().offset;
+                frames_.pop_back();
+            }
+
+            if (frames_.empty() && blocks_.size() > 1) merge_blocks();
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct Block {
+            std::byte* data;
+            size_t size;
+        };
+
+        /* An allocation, with the cursor position to return to once it and everything above it are freed */
+        struct Frame {
+            void* pointer;
+            size_t block;
+            size_t offset;
+            bool released;
+        };
+
+        std::vector<Block> blocks_;
+        std::vector<Frame> frames_;
+        size_t block_ = 0;
+        size_t offset_ = 0;
+        Stats stats_;
+
+        void add_block(size_t size) {
+            blocks_.reserve(blocks_.size() + 1);
+            auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t{MATRIXLIB_DEFAULT_ALIGNMENT}));
+            blocks_.push_back({data, size});
+            ++stats_.upstream_allocations;
+            stats_.capacity += size;
+        }
+
+        static void free_block(const Block& block) noexcept {
+            ::operator delete(block.data, std::align_val_t{MATRIXLIB_DEFAULT_ALIGNMENT});
+        }
+
+        /*
+         * One block as large as all of them together, so the next round of the same allocations fits in it. This
+         * runs inside deallocation, which must not throw, so the old blocks stay if the merged one cannot be had.
+         */
+        void merge_blocks() noexcept {
+            const size_t total = stats_.capacity;
+            void* data = ::operator new(total, std::align_val_t{MATRIXLIB_DEFAULT_ALIGNMENT}, std::nothrow);
+            if (!data) return;
+
+            for (const Block& block : blocks_) free_block(block);
+            blocks_.resize(1);
+            blocks_[0] = {static_cast<std::byte*>(data), total};
+            block_ = offset_ = 0;
+            ++stats_.upstream_allocations;
+        }
+    };
+
+    /**
+     * @brief Standard allocator drawing from a ScratchArena: the calling thread's arena unless another is given.
+     *
+     * The arena is captured when the allocator is constructed, so memory always returns to the arena it came
+     * from. Copying a container gives the copy the copying thread's arena, so a matrix may be copied from
+     * anywhere. Moves carry the arena along with the buffer, so a moved buffer still belongs to the thread it
+     * was allocated on and must be freed there, not on the thread it was moved to.
+     */
+    template <typename T>
+    class ScratchAllocator {
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        template <typename U>
+        struct rebind { using other = ScratchAllocator<U>; };
+
+        ScratchAllocator() noexcept : arena_(&ScratchArena::local()) {}
+
+        explicit ScratchAllocator(ScratchArena& arena) noexcept : arena_(&arena) {}
+
+        template <typename U>
+        ScratchAllocator(const ScratchAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+        T* allocate(size_t n) {
+            if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), std::max<size_t>(alignof(T), MATRIXLIB_DEFAULT_ALIGNMENT)));
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            arena_->deallocate(p, n * sizeof(T), std::max<size_t>(alignof(T), MATRIXLIB_DEFAULT_ALIGNMENT));
+        }
+
+        /* A copy allocates from the arena of the thread making it, never from the source's */
+        ScratchAllocator select_on_container_copy_construction() const { return ScratchAllocator(); }
+
+        ScratchArena* arena() const noexcept { return arena_; }
+
+        template <typename U>
+        bool operator==(const ScratchAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+        template <typename U>
+        bool operator!=(const ScratchAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+    private:
+        ScratchArena* arena_;
+    };
+} /* MatrixLib */
+
+#endif /* SCRATCH_ARENA_H */
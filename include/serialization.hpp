@@ -0,0 +1,415 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATRIXLIB_HAS_MMAP 1
+#else
+#define MATRIXLIB_HAS_MMAP 0
+#endif
+
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "matrixView.hpp"
+
+namespace MatrixLib {
+    /**
+     * @brief Element type codes of the binary matrix format.
+     */
+    enum class ScalarType : std::uint8_t {
+        Bool = 1,
+        Int8, UInt8, Int16, UInt16, Int32, UInt32, Int64, UInt64,
+        Float32, Float64,
+        Float16, BFloat16
+    };
+
+namespace Detail {
+    /*
+     * The binary format is a 64-byte header followed by rows * cols elements in row-major order:
+     *
+     *   0  char[4]   magic "MLIB"
+     *   4  uint8     format version
+     *   5  uint8     ScalarType of the elements
+     *   6  uint8     sizeof one element
+     *   7  uint8     byte order of the header fields and the elements: 0 little-endian, 1 big-endian
+     *   8  uint64    rows
+     *   16 uint64    cols
+     *   24 ...       zero padding
+     *
+     * Data is written in the writer's byte order and swapped by readers on the other kind of machine. Placing it
+     * at offset 64 keeps the elements of a memory-mapped file aligned for any vector load.
+     */
+    constexpr char binary_magic[4] = {'M', 'L', 'I', 'B'};
+    constexpr std::uint8_t binary_version = 1;
+    constexpr size_t binary_header_size = 64;
+
+    struct BinaryHeader {
+        ScalarType type;
+        std::uint8_t scalarSize;
+        bool bigEndian;
+        std::uint64_t rows;
+        std::uint64_t cols;
+    };
+
+    inline bool host_is_big_endian() {
+        const std::uint16_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 0;
+    }
+
+    template <typename T>
+    constexpr ScalarType scalar_type() {
+        static_assert(is_matrix_scalar<T>::value, "Only matrix element types can be serialised");
+
+        if constexpr (std::is_same<T, bool>::value) {
+            return ScalarType::Bool;
+        } else if constexpr (std::is_same<T, Half>::value) {
+            return ScalarType::Float16;
+        } else if constexpr (std::is_same<T, BFloat16>::value) {
+            return ScalarType::BFloat16;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 32- and 64-bit floating point elements can be serialised");
+            return sizeof(T) == 4 ? ScalarType::Float32 : ScalarType::Float64;
+        } else {
+            constexpr int bits = static_cast<int>(sizeof(T) * 8);
+            constexpr bool isSigned = std::is_signed<T>::value;
+            static_assert(bits == 8 || bits == 16 || bits == 32 || bits == 64, "Unsupported integer element size");
+
+            if constexpr (bits == 8) return isSigned ? ScalarType::Int8 : ScalarType::UInt8;
+            else if constexpr (bits == 16) return isSigned ? ScalarType::Int16 : ScalarType::UInt16;
+            else if constexpr (bits == 32) return isSigned ? ScalarType::Int32 : ScalarType::UInt32;
+            else return isSigned ? ScalarType::Int64 : ScalarType::UInt64;
+        }
+    }
+
+    inline const char* scalar_type_name(ScalarType type) {
+        switch (type) {
+            case ScalarType::Bool: return "bool";
+            case ScalarType::Int8: return "int8";
+            case ScalarType::UInt8: return "uint8";
+            case ScalarType::Int16: return "int16";
+            case ScalarType::UInt16: return "uint16";
+            case ScalarType::Int32: return "int32";
+            case ScalarType::UInt32: return "uint32";
+            case ScalarType::Int64: return "int64";
+            case ScalarType::UInt64: return "uint64";
+            case ScalarType::Float32: return "float32";
+            case ScalarType::Float64: return "float64";
+            case ScalarType::Float16: return "float16";
+            case ScalarType::BFloat16: return "bfloat16";
+        }
+        return "unknown";
+    }
+
+    /* Reverses the bytes of count elements of the given size in place */
+    inline void swap_bytes(void* data, size_t size, size_t count) {
+        auto* bytes = static_cast<unsigned char*>(data);
+        for (size_t i = 0; i < count; ++i, bytes += size) std::reverse(bytes, bytes + size);
+    }
+
+    inline void encode_header(unsigned char (&out)[binary_header_size], ScalarType type, size_t scalarSize, std::uint64_t rows, std::uint64_t cols) {
+        std::memset(out, 0, sizeof(out));
+        std::memcpy(out, binary_magic, sizeof(binary_magic));
+        out[4] = binary_version;
+        out[5] = static_cast<unsigned char>(type);
+        out[6] = static_cast<unsigned char>(scalarSize);
+        out[7] = host_is_big_endian() ? 1 : 0;
+        std::memcpy(out + 8, &rows, sizeof(rows));
+        std::memcpy(out + 16, &cols, sizeof(cols));
+    }
+
+    /* Parses and validates a header; the dimensions are returned in host byte order */
+    inline BinaryHeader decode_header(const unsigned char* in) {
+        if (std::memcmp(in, binary_magic, sizeof(binary_magic)) != 0) {
+            Utils::throw_runtime_error("Not a binary matrix: bad magic number");
+        }
+        if (in[4] != binary_version) {
+            Utils::throw_runtime_error("Unsupported binary matrix format version %d", static_cast<int>(in[4]));
+        }
+        if (in[7] > 1) {
+            Utils::throw_runtime_error("Corrupt binary matrix header: byte order flag %d", static_cast<int>(in[7]));
+        }
+
+        BinaryHeader header{static_cast<ScalarType>(in[5]), in[6], in[7] == 1, 0, 0};
+        std::memcpy(&header.rows, in + 8, sizeof(header.rows));
+        std::memcpy(&header.cols, in + 16, sizeof(header.cols));
+
+        if (header.bigEndian != host_is_big_endian()) {
+            swap_bytes(&header.rows, sizeof(header.rows), 1);
+            swap_bytes(&header.cols, sizeof(header.cols), 1);
+        }
+
+        return header;
+    }
+
+    /* Checks that the file holds T elements and returns the element count */
+    template <typename T>
+    size_t checked_element_count(const BinaryHeader& header) {
+        if (header.type != scalar_type<T>() || header.scalarSize != sizeof(T)) {
+            Utils::throw_runtime_error("Binary matrix holds %s elements, expected %s",
+                                       scalar_type_name(header.type), scalar_type_name(scalar_type<T>()));
+        }
+
+        const std::uint64_t limit = std::numeric_limits<size_t>::max() / sizeof(T);
+        if (header.rows > limit || (header.rows != 0 && header.cols > limit / header.rows)) {
+            Utils::throw_runtime_error("Binary matrix of %llu x %llu elements is too large",
+                                       static_cast<unsigned long long>(header.rows), static_cast<unsigned long long>(header.cols));
+        }
+
+        return static_cast<size_t>(header.rows * header.cols);
+    }
+} /* Detail */
+
+    /**
+     * @brief Writes a matrix, view or expression in the binary format: a 64-byte header recording the element
+     * type, dimensions and byte order, followed by the elements in row-major order. Expressions and views are
+     * evaluated first.
+     * @throw std::runtime_error if the stream fails.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    void write_binary(std::ostream& os, const M& m) {
+        using T = typename Detail::OperandTraits<M>::Scalar;
+        const auto& plain = Detail::eval_operand(m);
+        const auto ref = Detail::OperandTraits<typename std::decay<decltype(plain)>::type>::ref(plain);
+
+        unsigned char header[Detail::binary_header_size];
+        Detail::encode_header(header, Detail::scalar_type<T>(), sizeof(T), ref.rows, ref.cols);
+        os.write(reinterpret_cast<const char*>(header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(ref.data), static_cast<std::streamsize>(ref.rows * ref.cols * sizeof(T)));
+
+        if (!os) Utils::throw_runtime_error("Failed to write a %zux%zu binary matrix", ref.rows, ref.cols);
+    }
+
+    /**
+     * @brief Reads a matrix written by write_binary(). Elements written on a machine of the other byte order are
+     * swapped while reading.
+     *
+     * @tparam M The Matrix or DynMatrix type to read, e.g. `read_binary<DynMatrix<double>>(is)`.
+     * @throw std::runtime_error if the data is malformed, truncated or holds a different element type.
+     * @throw std::invalid_argument if the stored shape does not fit M.
+     */
+    template <typename M>
+    M read_binary(std::istream& is) {
+        using Traits = Detail::OperandTraits<M>;
+        static_assert(Traits::is_leaf, "Binary matrices are read into a Matrix or a DynMatrix");
+        using T = typename Traits::Scalar;
+
+        /* The file holds packed row-major elements, which other layouts take over by conversion */
+        if constexpr (!Traits::has_linear_access) return M(read_binary<Detail::plain_t<M>>(is));
+
+        unsigned char raw[Detail::binary_header_size];
+        if (!is.read(reinterpret_cast<char*>(raw), sizeof(raw))) {
+            Utils::throw_runtime_error("Unexpected end of binary matrix header");
+        }
+
+        const Detail::BinaryHeader header = Detail::decode_header(raw);
+        const size_t count = Detail::checked_element_count<T>(header);
+
+        M ret;
+        Traits::resize(ret, static_cast<size_t>(header.rows), static_cast<size_t>(header.cols));
+        T* data = Traits::data(ret);
+
+        if (!is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)))) {
+            Utils::throw_runtime_error("Unexpected end of binary matrix data, expected %zu elements", count);
+        }
+        if (header.bigEndian != Detail::host_is_big_endian()) Detail::swap_bytes(data, sizeof(T), count);
+
+        return ret;
+    }
+
+    /**
+     * @brief Writes a matrix, view or expression to a file in the binary format.
+     * @throw std::runtime_error if the file cannot be written.
+     */
+    template <typename M, typename std::enable_if<Detail::OperandTraits<M>::is_operand, int>::type = 0>
+    void save_binary(const std::string& path, const M& m) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) Utils::throw_runtime_error("Cannot open %s for writing", path.c_str());
+        write_binary(file, m);
+    }
+
+    /**
+     * @brief Reads a matrix from a file written by save_binary().
+     * @throw std::runtime_error if the file cannot be read or holds a different element type.
+     * @throw std::invalid_argument if the stored shape does not fit M.
+     */
+    template <typename M>
+    M load_binary(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) Utils::throw_runtime_error("Cannot open %s for reading", path.c_str());
+        return read_binary<M>(file);
+    }
+
+    /**
+     * @brief Read-only, memory-mapped binary matrix file.
+     *
+     * The file is mapped instead of read, so opening it costs no copy and pages are only loaded from disk as they
+     * are touched. view() exposes the elements as a MatrixView, which can be used in any expression:
+     * `DynMatrix<double> y = mapped.view() * x;`. On platforms without mmap the file is read into memory instead.
+     *
+     * @tparam _Scalar The element type stored in the file.
+     */
+    template <typename _Scalar>
+    class MappedMatrix {
+        static_assert(Detail::is_matrix_scalar<_Scalar>::value, "Matrix element type must be numeric");
+
+        const unsigned char* base_ = nullptr;
+        size_t length_ = 0;
+        size_t rows_ = 0;
+        size_t cols_ = 0;
+#if !MATRIXLIB_HAS_MMAP
+        std::vector<unsigned char, AlignedAllocator<unsigned char>> buffer_;
+#endif
+
+        void release() noexcept {
+#if MATRIXLIB_HAS_MMAP
+            if (base_ != nullptr) ::munmap(const_cast<unsigned char*>(base_), length_);
+#else
+            buffer_.clear();
+#endif
+            base_ = nullptr;
+            length_ = rows_ = cols_ = 0;
+        }
+
+        void map(const std::string& path) {
+#if MATRIXLIB_HAS_MMAP
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) Utils::throw_runtime_error("Cannot open %s for reading", path.c_str());
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                Utils::throw_runtime_error("Cannot determine the size of %s", path.c_str());
+            }
+
+            length_ = static_cast<size_t>(st.st_size);
+            void* mapped = length_ > 0 ? ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            ::close(fd);
+
+            if (mapped == MAP_FAILED) {
+                length_ = 0;
+                Utils::throw_runtime_error("Cannot map %s", path.c_str());
+            }
+            base_ = static_cast<const unsigned char*>(mapped);
+#else
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file) Utils::throw_runtime_error("Cannot open %s for reading", path.c_str());
+
+            buffer_.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()))) {
+                Utils::throw_runtime_error("Cannot read %s", path.c_str());
+            }
+            base_ = buffer_.data();
+            length_ = buffer_.size();
+#endif
+        }
+
+    public:
+        using Scalar = _Scalar;
+
+        MappedMatrix() = default;
+
+        /**
+         * @brief Maps a file written by save_binary().
+         * @throw std::runtime_error if the file cannot be mapped, is truncated, holds a different element type or
+         * was written on a machine of the other byte order (it cannot be swapped without copying).
+         */
+        explicit MappedMatrix(const std::string& path) {
+            map(path);
+
+            try {
+                if (length_ < Detail::binary_header_size) Utils::throw_runtime_error("Unexpected end of binary matrix header in %s", path.c_str());
+
+                const Detail::BinaryHeader header = Detail::decode_header(base_);
+                const size_t count = Detail::checked_element_count<_Scalar>(header);
+
+                if (header.bigEndian != Detail::host_is_big_endian()) {
+                    Utils::throw_runtime_error("%s was written with the other byte order; use load_binary() to convert it", path.c_str());
+                }
+                if (length_ - Detail::binary_header_size < count * sizeof(_Scalar)) {
+                    Utils::throw_runtime_error("Unexpected end of binary matrix data in %s, expected %zu elements", path.c_str(), count);
+                }
+
+                rows_ = static_cast<size_t>(header.rows);
+                cols_ = static_cast<size_t>(header.cols);
+            } catch (...) {
+                release();
+                throw;
+            }
+        }
+
+        MappedMatrix(const MappedMatrix&) = delete;
+        MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+        MappedMatrix(MappedMatrix&& other) noexcept { *this = std::move(other); }
+
+        MappedMatrix& operator=(MappedMatrix&& other) noexcept {
+            if (this != &other) {
+                release();
+                base_ = std::exchange(other.base_, nullptr);
+                length_ = std::exchange(other.length_, 0);
+                rows_ = std::exchange(other.rows_, 0);
+                cols_ = std::exchange(other.cols_, 0);
+#if !MATRIXLIB_HAS_MMAP
+                buffer_ = std::move(other.buffer_);
+#endif
+            }
+
+            return *this;
+        }
+
+        ~MappedMatrix() { release(); }
+
+        size_t rows() const noexcept { return rows_; }
+        size_t cols() const noexcept { return cols_; }
+        size_t size() const noexcept { return rows_ * cols_; }
+
+        /**
+         * @return A pointer to the contiguous, row-major elements inside the mapping.
+         */
+        const _Scalar* data() const noexcept {
+            return base_ == nullptr ? nullptr : reinterpret_cast<const _Scalar*>(base_ + Detail::binary_header_size);
+        }
+
+        /**
+         * Access an element. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         */
+        const _Scalar& operator()(size_t indexOuter, size_t indexInner) const {
+            MATRIXLIB_CHECK_INDEX(indexOuter < rows_, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < cols_, "index inner %zu is out of bounds", indexInner);
+
+            return data()[indexOuter * cols_ + indexInner];
+        }
+
+        /**
+         * @return A view of the mapped elements, valid while this object is alive.
+         */
+        MatrixView<const _Scalar> view() const noexcept {
+            return MatrixView<const _Scalar>(data(), rows_, cols_, static_cast<ptrdiff_t>(cols_), 1);
+        }
+
+        /**
+         * @return A DynMatrix holding a copy of the mapped elements.
+         */
+        DynMatrix<_Scalar> to_matrix() const { return DynMatrix<_Scalar>(view()); }
+    };
+} /* MatrixLib */
+
+#endif /* SERIALIZATION_H */
@@ -0,0 +1,1056 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#if !defined(MATRIXLIB_DISABLE_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MATRIXLIB_SIMD_X86 1
+#include <immintrin.h>
+#define MATRIXLIB_TARGET_AVX2 __attribute__((target("avx2")))
+#define MATRIXLIB_TARGET_AVX512 __attribute__((target("avx512f")))
+#elif !defined(MATRIXLIB_DISABLE_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define MATRIXLIB_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Elements summed by one SIMD leaf before leaves are combined pairwise; also the grain of parallel reductions */
+#ifndef MATRIXLIB_REDUCTION_BLOCK
+#define MATRIXLIB_REDUCTION_BLOCK 1024
+#endif
+
+/* Passes a value through an empty asm statement, so the compiler cannot fuse the product it holds into a following add */
+#if defined(MATRIXLIB_SIMD_X86)
+#define MATRIXLIB_UNFUSED(x) __asm__("" : "+v"(x))
+#elif defined(MATRIXLIB_SIMD_NEON)
+#define MATRIXLIB_UNFUSED(x) __asm__("" : "+w"(x))
+#else
+#define MATRIXLIB_UNFUSED(x) ((void)0)
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+    /**
+     * Instruction sets the element-wise kernels can run on. The best one supported by the CPU is picked at
+     * startup; on x86 the wider kernels are compiled with per-function target attributes, so the library
+     * itself does not need to be built with -mavx2 or -mavx512f.
+     */
+    enum class SimdIsa { Scalar, SSE2, AVX2, AVX512, NEON };
+
+    inline const char* simd_isa_name(SimdIsa isa) {
+        switch (isa) {
+            case SimdIsa::SSE2: return "sse2";
+            case SimdIsa::AVX2: return "avx2";
+            case SimdIsa::AVX512: return "avx512";
+            case SimdIsa::NEON: return "neon";
+            default: return "scalar";
+        }
+    }
+
+    /**
+     * @brief Whether the running CPU can execute kernels for the given instruction set.
+     */
+    inline bool simd_isa_supported(SimdIsa isa) {
+        switch (isa) {
+            case SimdIsa::Scalar: return true;
+#if defined(MATRIXLIB_SIMD_X86)
+            case SimdIsa::SSE2: return true;
+            case SimdIsa::AVX2: return __builtin_cpu_supports("avx2");
+            case SimdIsa::AVX512: return __builtin_cpu_supports("avx512f");
+#elif defined(MATRIXLIB_SIMD_NEON)
+            case SimdIsa::NEON: return true;
+#endif
+            default: return false;
+        }
+    }
+
+namespace Detail {
+    inline SimdIsa detect_simd_isa() {
+        for (SimdIsa isa : {SimdIsa::AVX512, SimdIsa::AVX2, SimdIsa::NEON, SimdIsa::SSE2}) {
+            if (simd_isa_supported(isa)) return isa;
+        }
+        return SimdIsa::Scalar;
+    }
+
+    inline std::atomic<SimdIsa>& simd_isa_slot() {
+        static std::atomic<SimdIsa> isa{detect_simd_isa()};
+        return isa;
+    }
+} /* Detail */
+
+    /**
+     * @brief The instruction set currently used by the element-wise kernels.
+     */
+    inline SimdIsa active_simd_isa() {
+        return Detail::simd_isa_slot().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Overrides the instruction set picked at startup, e.g. to compare kernels in tests and benchmarks.
+     * @return False, leaving the selection unchanged, if the CPU does not support the requested instruction set.
+     */
+    inline bool set_simd_isa(SimdIsa isa) {
+        if (!simd_isa_supported(isa)) return false;
+        Detail::simd_isa_slot().store(isa, std::memory_order_relaxed);
+        return true;
+    }
+
+namespace Detail {
+    inline std::atomic<bool>& deterministic_slot() {
+        static std::atomic<bool> on{[] {
+            const char* env = std::getenv("MATRIXLIB_DETERMINISTIC");
+            return env != nullptr && *env != '\0' && std::strcmp(env, "0") != 0;
+        }()};
+        return on;
+    }
+} /* Detail */
+
+    /**
+     * @brief Whether the kernels run in deterministic mode; off unless MATRIXLIB_DETERMINISTIC is set to a value
+     * other than 0 in the environment.
+     *
+     * In deterministic mode sums and dot products use a fixed tree of 16 lanes and 1024-element leaves, and
+     * products are rounded before they are added instead of being fused into FMAs. Results then depend only on
+     * the operands and their shapes: not on the instruction set picked at runtime, the number of threads or
+     * the scheduling. They still run on SIMD registers and threads: dot products, sums and matrix-vector products
+     * lose 5-20% once they stream from memory and up to 3x on short rows in L1; matrix products are unaffected.
+     */
+    inline bool deterministic_mode() {
+        return Detail::deterministic_slot().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Turns deterministic mode on or off for the whole process. Switch it between operations, not while
+     * other threads are running kernels.
+     */
+    inline void set_deterministic_mode(bool on) {
+        Detail::deterministic_slot().store(on, std::memory_order_relaxed);
+    }
+
+namespace Detail {
+    /*
+     * Each Ops struct wraps one register type: load/store, the arithmetic used by the kernels, lane-wise min, max
+     * and absolute value, a horizontal sum, and "not equal" and "not less or equal" masks with and/or/any. The
+     * generic kernels below are stamped out once per target attribute so that the intrinsics inline into them.
+     */
+#if defined(MATRIXLIB_SIMD_X86)
+    struct Sse2F32 {
+        using Reg = __m128; using Mask = __m128;
+        static constexpr size_t width = 4;
+        static Reg load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, Reg v) { _mm_storeu_ps(p, v); }
+        static Reg set1(float s) { return _mm_set1_ps(s); }
+        static Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+        static Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+        static Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+        static Reg min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+        static Reg max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+        static Mask neq(Reg a, Reg b) { return _mm_cmpneq_ps(a, b); }
+        static Mask mask_or(Mask a, Mask b) { return _mm_or_ps(a, b); }
+        static Mask mask_and(Mask a, Mask b) { return _mm_and_ps(a, b); }
+        static Mask nle(Reg a, Reg b) { return _mm_cmpnle_ps(a, b); }
+        static Reg abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static bool any(Mask m) { return _mm_movemask_ps(m) != 0; }
+        static float sum(Reg v) {
+            const Reg h = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_add_ss(h, _mm_shuffle_ps(h, h, 1)));
+        }
+    };
+
+    struct Sse2F64 {
+        using Reg = __m128d; using Mask = __m128d;
+        static constexpr size_t width = 2;
+        static Reg load(const double* p) { return _mm_loadu_pd(p); }
+        static void store(double* p, Reg v) { _mm_storeu_pd(p, v); }
+        static Reg set1(double s) { return _mm_set1_pd(s); }
+        static Reg add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+        static Reg sub(Reg a, Reg b) { return _mm_sub_pd(a, b); }
+        static Reg mul(Reg a, Reg b) { return _mm_mul_pd(a, b); }
+        static Reg min(Reg a, Reg b) { return _mm_min_pd(a, b); }
+        static Reg max(Reg a, Reg b) { return _mm_max_pd(a, b); }
+        static Mask neq(Reg a, Reg b) { return _mm_cmpneq_pd(a, b); }
+        static Mask mask_or(Mask a, Mask b) { return _mm_or_pd(a, b); }
+        static Mask mask_and(Mask a, Mask b) { return _mm_and_pd(a, b); }
+        static Mask nle(Reg a, Reg b) { return _mm_cmpnle_pd(a, b); }
+        static Reg abs(Reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+        static bool any(Mask m) { return _mm_movemask_pd(m) != 0; }
+        static double sum(Reg v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+    };
+
+    struct Avx2F32 {
+        using Reg = __m256; using Mask = __m256;
+        static constexpr size_t width = 8;
+        MATRIXLIB_TARGET_AVX2 static Reg load(const float* p) { return _mm256_loadu_ps(p); }
+        MATRIXLIB_TARGET_AVX2 static void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+        MATRIXLIB_TARGET_AVX2 static Reg set1(float s) { return _mm256_set1_ps(s); }
+        MATRIXLIB_TARGET_AVX2 static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask neq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+        MATRIXLIB_TARGET_AVX2 static Mask mask_or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask mask_and(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask nle(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_NLE_UQ); }
+        MATRIXLIB_TARGET_AVX2 static Reg abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        MATRIXLIB_TARGET_AVX2 static bool any(Mask m) { return _mm256_movemask_ps(m) != 0; }
+        MATRIXLIB_TARGET_AVX2 static float sum(Reg v) { return Sse2F32::sum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1))); }
+    };
+
+    struct Avx2F64 {
+        using Reg = __m256d; using Mask = __m256d;
+        static constexpr size_t width = 4;
+        MATRIXLIB_TARGET_AVX2 static Reg load(const double* p) { return _mm256_loadu_pd(p); }
+        MATRIXLIB_TARGET_AVX2 static void store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+        MATRIXLIB_TARGET_AVX2 static Reg set1(double s) { return _mm256_set1_pd(s); }
+        MATRIXLIB_TARGET_AVX2 static Reg add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Reg max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask neq(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+        MATRIXLIB_TARGET_AVX2 static Mask mask_or(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask mask_and(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+        MATRIXLIB_TARGET_AVX2 static Mask nle(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_NLE_UQ); }
+        MATRIXLIB_TARGET_AVX2 static Reg abs(Reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+        MATRIXLIB_TARGET_AVX2 static bool any(Mask m) { return _mm256_movemask_pd(m) != 0; }
+        MATRIXLIB_TARGET_AVX2 static double sum(Reg v) { return Sse2F64::sum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1))); }
+    };
+
+    /*
+     * One half of a 512-bit register. GCC 12 builds the plain extracts and casts, and min and max, on an undefined
+     * register and warns, hence the all-lanes masked forms here and in the Ops structs.
+     */
+    template <int _Upper>
+    MATRIXLIB_TARGET_AVX512 inline __m256d avx512_half(__m512d v) {
+        return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xFF, v, _Upper);
+    }
+
+    struct Avx512F32 {
+        using Reg = __m512; using Mask = __mmask16;
+        static constexpr size_t width = 16;
+        MATRIXLIB_TARGET_AVX512 static Reg load(const float* p) { return _mm512_loadu_ps(p); }
+        MATRIXLIB_TARGET_AVX512 static void store(float* p, Reg v) { _mm512_storeu_ps(p, v); }
+        MATRIXLIB_TARGET_AVX512 static Reg set1(float s) { return _mm512_set1_ps(s); }
+        MATRIXLIB_TARGET_AVX512 static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg min(Reg a, Reg b) { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg max(Reg a, Reg b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+        MATRIXLIB_TARGET_AVX512 static Mask neq(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ); }
+        MATRIXLIB_TARGET_AVX512 static Mask mask_or(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+        MATRIXLIB_TARGET_AVX512 static Mask mask_and(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+        MATRIXLIB_TARGET_AVX512 static Mask nle(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_NLE_UQ); }
+        MATRIXLIB_TARGET_AVX512 static Reg abs(Reg a) { return _mm512_abs_ps(a); }
+        MATRIXLIB_TARGET_AVX512 static bool any(Mask m) { return m != 0; }
+        MATRIXLIB_TARGET_AVX512 static float sum(Reg v) {
+            const __m512d d = _mm512_castps_pd(v);
+            return Avx2F32::sum(_mm256_add_ps(_mm256_castpd_ps(avx512_half<0>(d)), _mm256_castpd_ps(avx512_half<1>(d))));
+        }
+    };
+
+    struct Avx512F64 {
+        using Reg = __m512d; using Mask = __mmask8;
+        static constexpr size_t width = 8;
+        MATRIXLIB_TARGET_AVX512 static Reg load(const double* p) { return _mm512_loadu_pd(p); }
+        MATRIXLIB_TARGET_AVX512 static void store(double* p, Reg v) { _mm512_storeu_pd(p, v); }
+        MATRIXLIB_TARGET_AVX512 static Reg set1(double s) { return _mm512_set1_pd(s); }
+        MATRIXLIB_TARGET_AVX512 static Reg add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg min(Reg a, Reg b) { return _mm512_mask_min_pd(a, 0xFF, a, b); }
+        MATRIXLIB_TARGET_AVX512 static Reg max(Reg a, Reg b) { return _mm512_mask_max_pd(a, 0xFF, a, b); }
+        MATRIXLIB_TARGET_AVX512 static Mask neq(Reg a, Reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_NEQ_UQ); }
+        MATRIXLIB_TARGET_AVX512 static Mask mask_or(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+        MATRIXLIB_TARGET_AVX512 static Mask mask_and(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+        MATRIXLIB_TARGET_AVX512 static Mask nle(Reg a, Reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_NLE_UQ); }
+        MATRIXLIB_TARGET_AVX512 static Reg abs(Reg a) { return _mm512_abs_pd(a); }
+        MATRIXLIB_TARGET_AVX512 static bool any(Mask m) { return m != 0; }
+        MATRIXLIB_TARGET_AVX512 static double sum(Reg v) {
+            return Avx2F64::sum(_mm256_add_pd(avx512_half<0>(v), avx512_half<1>(v)));
+        }
+    };
+#elif defined(MATRIXLIB_SIMD_NEON)
+    struct NeonF32 {
+        using Reg = float32x4_t; using Mask = uint32x4_t;
+        static constexpr size_t width = 4;
+        static Reg load(const float* p) { return vld1q_f32(p); }
+        static void store(float* p, Reg v) { vst1q_f32(p, v); }
+        static Reg set1(float s) { return vdupq_n_f32(s); }
+        static Reg add(Reg a, Reg b) { return vaddq_f32(a, b); }
+        static Reg sub(Reg a, Reg b) { return vsubq_f32(a, b); }
+        static Reg mul(Reg a, Reg b) { return vmulq_f32(a, b); }
+        static Reg min(Reg a, Reg b) { return vminq_f32(a, b); }
+        static Reg max(Reg a, Reg b) { return vmaxq_f32(a, b); }
+        static Mask neq(Reg a, Reg b) { return vmvnq_u32(vceqq_f32(a, b)); }
+        static Mask mask_or(Mask a, Mask b) { return vorrq_u32(a, b); }
+        static Mask mask_and(Mask a, Mask b) { return vandq_u32(a, b); }
+        static Mask nle(Reg a, Reg b) { return vmvnq_u32(vcleq_f32(a, b)); }
+        static Reg abs(Reg a) { return vabsq_f32(a); }
+        static bool any(Mask m) { return vmaxvq_u32(m) != 0; }
+        static float sum(Reg v) { return vaddvq_f32(v); }
+    };
+
+    struct NeonF64 {
+        using Reg = float64x2_t; using Mask = uint64x2_t;
+        static constexpr size_t width = 2;
+        static Reg load(const double* p) { return vld1q_f64(p); }
+        static void store(double* p, Reg v) { vst1q_f64(p, v); }
+        static Reg set1(double s) { return vdupq_n_f64(s); }
+        static Reg add(Reg a, Reg b) { return vaddq_f64(a, b); }
+        static Reg sub(Reg a, Reg b) { return vsubq_f64(a, b); }
+        static Reg mul(Reg a, Reg b) { return vmulq_f64(a, b); }
+        static Reg min(Reg a, Reg b) { return vminq_f64(a, b); }
+        static Reg max(Reg a, Reg b) { return vmaxq_f64(a, b); }
+        static Mask neq(Reg a, Reg b) { return veorq_u64(vceqq_f64(a, b), vdupq_n_u64(~0ull)); }
+        static Mask mask_or(Mask a, Mask b) { return vorrq_u64(a, b); }
+        static Mask mask_and(Mask a, Mask b) { return vandq_u64(a, b); }
+        static Mask nle(Reg a, Reg b) { return veorq_u64(vcleq_f64(a, b), vdupq_n_u64(~0ull)); }
+        static Reg abs(Reg a) { return vabsq_f64(a); }
+        static bool any(Mask m) { return (vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) != 0; }
+        static double sum(Reg v) { return vaddvq_f64(v); }
+    };
+#endif
+
+    /* Lanes of a deterministic sum, whatever the register width; a multiple of every Ops::width */
+    constexpr size_t deterministic_lanes = 16;
+
+    /* A floating-point product rounded on its own, so the compiler cannot fuse it into the add that uses it */
+    template <typename T>
+    inline T unfused(T p) {
+        if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value) MATRIXLIB_UNFUSED(p);
+        return p;
+    }
+
+    /* The fixed tree over the lanes of a deterministic sum: lane l gets l + 8, then l + 4, l + 2 and l + 1 */
+    template <typename T>
+    inline T fold_lanes(T* lanes) {
+        for (size_t w = deterministic_lanes / 2; w > 0; w /= 2) {
+            for (size_t l = 0; l < w; ++l) lanes[l] += lanes[l + w];
+        }
+        return lanes[0];
+    }
+
+    /* x == y, or |x - y| <= max(absolute, relative * max(|x|, |y|)) with a finite difference */
+    template <typename T>
+    inline bool close_scalar(T x, T y, T relative, T absolute) {
+        if (x == y) return true;
+        const T d = std::abs(x - y);
+        return d - d == T(0) && d <= std::max(absolute, relative * std::max(std::abs(x), std::abs(y)));
+    }
+
+    template <typename T> struct FloatBits;
+    template <> struct FloatBits<float> { using type = uint32_t; static constexpr type exponent = 0x7F800000u; };
+    template <> struct FloatBits<double> { using type = uint64_t; static constexpr type exponent = 0x7FF0000000000000ull; };
+
+    /*
+     * False when x == y or both are finite and at most limit ulps apart, true otherwise. The bit patterns are mapped
+     * onto an unsigned line, negative values below the sign bit and positive ones
+     * above, so that adjacent floats are one apart and -0 meets +0.
+     */
+    template <typename T, typename U>
+    inline bool ulp_miss(T x, T y, U limit) {
+        constexpr U sign = U(1) << (8 * sizeof(U) - 1), exponent = FloatBits<T>::exponent;
+        U bx, by;
+        std::memcpy(&bx, &x, sizeof(U));
+        std::memcpy(&by, &y, sizeof(U));
+        const U mx = bx & ~sign, my = by & ~sign;
+        const U kx = bx & sign ? sign - mx : sign + mx, ky = by & sign ? sign - my : sign + my;
+        const bool finite = mx < exponent && my < exponent;
+        return !(x == y || (finite && (kx > ky ? kx - ky : ky - kx) <= limit));
+    }
+
+    /*
+     * Generic kernel bodies over an Ops struct, unrolled four registers deep to keep enough loads in flight
+     * to approach memory bandwidth. Remainders are finished with scalar code.
+     */
+#define MATRIXLIB_ELEMENTWISE_KERNELS(NAMESPACE, TARGET)                                                         \
+    namespace NAMESPACE {                                                                                      \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void add(T* dst, const T* src, size_t n) {                                                      \
+            constexpr size_t W = Ops::width;                                                                   \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                auto r0 = Ops::add(Ops::load(dst + i), Ops::load(src + i));                                    \
+                auto r1 = Ops::add(Ops::load(dst + i + W), Ops::load(src + i + W));                            \
+                auto r2 = Ops::add(Ops::load(dst + i + 2 * W), Ops::load(src + i + 2 * W));                    \
+                auto r3 = Ops::add(Ops::load(dst + i + 3 * W), Ops::load(src + i + 3 * W));                    \
+                Ops::store(dst + i, r0); Ops::store(dst + i + W, r1);                                          \
+                Ops::store(dst + i + 2 * W, r2); Ops::store(dst + i + 3 * W, r3);                              \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) Ops::store(dst + i, Ops::add(Ops::load(dst + i), Ops::load(src + i)));  \
+            /* Counting the tail keeps GCC from a spurious overflow warning when n is a propagated constant */ \
+            for (size_t r = 0, tail = n - i; r < tail; ++r) dst[i + r] += src[i + r];                          \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void sub(T* dst, const T* src, size_t n) {                                                      \
+            constexpr size_t W = Ops::width;                                                                   \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                auto r0 = Ops::sub(Ops::load(dst + i), Ops::load(src + i));                                    \
+                auto r1 = Ops::sub(Ops::load(dst + i + W), Ops::load(src + i + W));                            \
+                auto r2 = Ops::sub(Ops::load(dst + i + 2 * W), Ops::load(src + i + 2 * W));                    \
+                auto r3 = Ops::sub(Ops::load(dst + i + 3 * W), Ops::load(src + i + 3 * W));                    \
+                Ops::store(dst + i, r0); Ops::store(dst + i + W, r1);                                          \
+                Ops::store(dst + i + 2 * W, r2); Ops::store(dst + i + 3 * W, r3);                              \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) Ops::store(dst + i, Ops::sub(Ops::load(dst + i), Ops::load(src + i)));  \
+            for (; i < n; ++i) dst[i] -= src[i];                                                               \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void scale(T* dst, T s, size_t n) {                                                             \
+            constexpr size_t W = Ops::width;                                                                   \
+            const auto sv = Ops::set1(s);                                                                      \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                Ops::store(dst + i, Ops::mul(Ops::load(dst + i), sv));                                         \
+                Ops::store(dst + i + W, Ops::mul(Ops::load(dst + i + W), sv));                                 \
+                Ops::store(dst + i + 2 * W, Ops::mul(Ops::load(dst + i + 2 * W), sv));                         \
+                Ops::store(dst + i + 3 * W, Ops::mul(Ops::load(dst + i + 3 * W), sv));                         \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) Ops::store(dst + i, Ops::mul(Ops::load(dst + i), sv));                  \
+            for (; i < n; ++i) dst[i] *= s;                                                                    \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET bool equal(const T* a, const T* b, size_t n) {                                                  \
+            constexpr size_t W = Ops::width;                                                                   \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                auto m0 = Ops::mask_or(Ops::neq(Ops::load(a + i), Ops::load(b + i)),                           \
+                                       Ops::neq(Ops::load(a + i + W), Ops::load(b + i + W)));                  \
+                auto m1 = Ops::mask_or(Ops::neq(Ops::load(a + i + 2 * W), Ops::load(b + i + 2 * W)),           \
+                                       Ops::neq(Ops::load(a + i + 3 * W), Ops::load(b + i + 3 * W)));          \
+                if (Ops::any(Ops::mask_or(m0, m1))) return false;                                              \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) {                                                                       \
+                if (Ops::any(Ops::neq(Ops::load(a + i), Ops::load(b + i)))) return false;                      \
+            }                                                                                                  \
+            for (; i < n; ++i) {                                                                               \
+                if (a[i] != b[i]) return false;                                                                \
+            }                                                                                                  \
+            return true;                                                                                       \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void axpy(T* y, T alpha, const T* x, size_t n) {                                                \
+            constexpr size_t W = Ops::width;                                                                   \
+            const auto av = Ops::set1(alpha);                                                                  \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                auto r0 = Ops::add(Ops::load(y + i), Ops::mul(av, Ops::load(x + i)));                          \
+                auto r1 = Ops::add(Ops::load(y + i + W), Ops::mul(av, Ops::load(x + i + W)));                  \
+                auto r2 = Ops::add(Ops::load(y + i + 2 * W), Ops::mul(av, Ops::load(x + i + 2 * W)));          \
+                auto r3 = Ops::add(Ops::load(y + i + 3 * W), Ops::mul(av, Ops::load(x + i + 3 * W)));          \
+                Ops::store(y + i, r0); Ops::store(y + i + W, r1);                                              \
+                Ops::store(y + i + 2 * W, r2); Ops::store(y + i + 3 * W, r3);                                  \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) Ops::store(y + i, Ops::add(Ops::load(y + i), Ops::mul(av, Ops::load(x + i)))); \
+            for (; i < n; ++i) y[i] += alpha * x[i];                                                           \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET T dot(const T* x, const T* y, size_t n) {                                                       \
+            constexpr size_t W = Ops::width;                                                                   \
+            auto s0 = Ops::set1(T(0)), s1 = s0, s2 = s0, s3 = s0;                                              \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                s0 = Ops::add(s0, Ops::mul(Ops::load(x + i), Ops::load(y + i)));                               \
+                s1 = Ops::add(s1, Ops::mul(Ops::load(x + i + W), Ops::load(y + i + W)));                       \
+                s2 = Ops::add(s2, Ops::mul(Ops::load(x + i + 2 * W), Ops::load(y + i + 2 * W)));               \
+                s3 = Ops::add(s3, Ops::mul(Ops::load(x + i + 3 * W), Ops::load(y + i + 3 * W)));               \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) s0 = Ops::add(s0, Ops::mul(Ops::load(x + i), Ops::load(y + i)));        \
+            T ret = Ops::sum(Ops::add(Ops::add(s0, s1), Ops::add(s2, s3)));                                    \
+            for (; i < n; ++i) ret += x[i] * y[i];                                                             \
+            return ret;                                                                                        \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET T sum(const T* x, size_t n) {                                                                   \
+            constexpr size_t W = Ops::width;                                                                   \
+            auto s0 = Ops::set1(T(0)), s1 = s0, s2 = s0, s3 = s0;                                              \
+            size_t i = 0;                                                                                      \
+            for (; i + 4 * W <= n; i += 4 * W) {                                                               \
+                s0 = Ops::add(s0, Ops::load(x + i));                                                           \
+                s1 = Ops::add(s1, Ops::load(x + i + W));                                                       \
+                s2 = Ops::add(s2, Ops::load(x + i + 2 * W));                                                   \
+                s3 = Ops::add(s3, Ops::load(x + i + 3 * W));                                                   \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) s0 = Ops::add(s0, Ops::load(x + i));                                    \
+            T ret = Ops::sum(Ops::add(Ops::add(s0, s1), Ops::add(s2, s3)));                                    \
+            for (; i < n; ++i) ret += x[i];                                                                    \
+            return ret;                                                                                        \
+        }                                                                                                      \
+                                                                                                               \
+        /* Smallest (or, with _Max, largest) of n >= 1 elements */                                             \
+        template <typename Ops, bool _Max, typename T>                                                         \
+        TARGET T extremum(const T* x, size_t n) {                                                              \
+            constexpr size_t W = Ops::width;                                                                   \
+            constexpr auto pick = _Max ? &Ops::max : &Ops::min;                                                \
+            T ret = x[0];                                                                                      \
+            size_t i = 0;                                                                                      \
+            if (n >= 4 * W) {                                                                                  \
+                auto m0 = Ops::load(x), m1 = Ops::load(x + W), m2 = Ops::load(x + 2 * W), m3 = Ops::load(x + 3 * W); \
+                for (i = 4 * W; i + 4 * W <= n; i += 4 * W) {                                                  \
+                    m0 = pick(m0, Ops::load(x + i));                                                           \
+                    m1 = pick(m1, Ops::load(x + i + W));                                                       \
+                    m2 = pick(m2, Ops::load(x + i + 2 * W));                                                   \
+                    m3 = pick(m3, Ops::load(x + i + 3 * W));                                                   \
+                }                                                                                              \
+                T lanes[W];                                                                                    \
+                Ops::store(lanes, pick(pick(m0, m1), pick(m2, m3)));                                           \
+                for (size_t l = 0; l < W; ++l) ret = (_Max ? ret < lanes[l] : lanes[l] < ret) ? lanes[l] : ret; \
+            }                                                                                                  \
+            for (; i < n; ++i) ret = (_Max ? ret < x[i] : x[i] < ret) ? x[i] : ret;                            \
+            return ret;                                                                                        \
+        }                                                                                                      \
+                                                                                                               \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void dot4(const T* a, ptrdiff_t lda, const T* x, size_t n, T* out) {                            \
+            constexpr size_t W = Ops::width;                                                                   \
+            const T* a0 = a; const T* a1 = a + lda; const T* a2 = a + 2 * lda; const T* a3 = a + 3 * lda;      \
+            auto s0 = Ops::set1(T(0)), s1 = s0, s2 = s0, s3 = s0;                                              \
+            size_t i = 0;                                                                                      \
+            for (; i + W <= n; i += W) {                                                                       \
+                const auto xv = Ops::load(x + i);                                                              \
+                s0 = Ops::add(s0, Ops::mul(Ops::load(a0 + i), xv));                                            \
+                s1 = Ops::add(s1, Ops::mul(Ops::load(a1 + i), xv));                                            \
+                s2 = Ops::add(s2, Ops::mul(Ops::load(a2 + i), xv));                                            \
+                s3 = Ops::add(s3, Ops::mul(Ops::load(a3 + i), xv));                                            \
+            }                                                                                                  \
+            T r0 = Ops::sum(s0), r1 = Ops::sum(s1), r2 = Ops::sum(s2), r3 = Ops::sum(s3);                      \
+            for (; i < n; ++i) {                                                                               \
+                r0 += a0[i] * x[i]; r1 += a1[i] * x[i]; r2 += a2[i] * x[i]; r3 += a3[i] * x[i];                \
+            }                                                                                                  \
+            out[0] = r0; out[1] = r1; out[2] = r2; out[3] = r3;                                                \
+        }                                                                                                      \
+                                                                                                               \
+        /*                                                                                                     \
+         * Deterministic sum of x[i] * y[i], or of x[i] alone: element i goes to lane i % 16 whatever the register \
+         * width, products are rounded before they are added, and the lanes are folded by Detail::fold_lanes.  \
+         */                                                                                                    \
+        template <typename Ops, bool _Products, typename T>                                                    \
+        TARGET T fixed_dot(const T* x, const T* y, size_t n) {                                                 \
+            constexpr size_t W = Ops::width, L = Detail::deterministic_lanes, R = L / W;                       \
+            typename Ops::Reg s[R];                                                                            \
+            for (size_t r = 0; r < R; ++r) s[r] = Ops::set1(T(0));                                             \
+            size_t i = 0;                                                                                      \
+            for (; i + L <= n; i += L) {                                                                       \
+                for (size_t r = 0; r < R; ++r) {                                                               \
+                    auto v = Ops::load(x + i + r * W);                                                         \
+                    if constexpr (_Products) {                                                                 \
+                        v = Ops::mul(v, Ops::load(y + i + r * W));                                             \
+                        MATRIXLIB_UNFUSED(v);                                                                  \
+                    }                                                                                          \
+                    s[r] = Ops::add(s[r], v);                                                                  \
+                }                                                                                              \
+            }                                                                                                  \
+            T lanes[L];                                                                                        \
+            for (size_t r = 0; r < R; ++r) Ops::store(lanes + r * W, s[r]);                                    \
+            for (size_t l = 0; i < n; ++i, ++l) {                                                              \
+                if constexpr (_Products) lanes[l] += Detail::unfused(x[i] * y[i]);                             \
+                else lanes[l] += x[i];                                                                         \
+            }                                                                                                  \
+            return Detail::fold_lanes(lanes);                                                                  \
+        }                                                                                                      \
+                                                                                                               \
+        /* fixed_dot of the four rows a + r * lda with x, loading x once; each row is summed exactly as fixed_dot does */ \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void fixed_dot4(const T* a, ptrdiff_t lda, const T* x, size_t n, T* out) {                      \
+            constexpr size_t W = Ops::width, L = Detail::deterministic_lanes, R = L / W;                       \
+            typename Ops::Reg s[4][R];                                                                         \
+            for (size_t q = 0; q < 4; ++q) {                                                                   \
+                for (size_t r = 0; r < R; ++r) s[q][r] = Ops::set1(T(0));                                      \
+            }                                                                                                  \
+            size_t i = 0;                                                                                      \
+            for (; i + L <= n; i += L) {                                                                       \
+                for (size_t r = 0; r < R; ++r) {                                                               \
+                    const auto xv = Ops::load(x + i + r * W);                                                  \
+                    for (size_t q = 0; q < 4; ++q) {                                                           \
+                        auto p = Ops::mul(Ops::load(a + q * lda + i + r * W), xv);                             \
+                        MATRIXLIB_UNFUSED(p);                                                                  \
+                        s[q][r] = Ops::add(s[q][r], p);                                                        \
+                    }                                                                                          \
+                }                                                                                              \
+            }                                                                                                  \
+            for (size_t q = 0; q < 4; ++q) {                                                                   \
+                T lanes[L];                                                                                    \
+                for (size_t r = 0; r < R; ++r) Ops::store(lanes + r * W, s[q][r]);                             \
+                for (size_t j = i, l = 0; j < n; ++j, ++l) lanes[l] += Detail::unfused(a[q * lda + j] * x[j]); \
+                out[q] = Detail::fold_lanes(lanes);                                                            \
+            }                                                                                                  \
+        }                                                                                                      \
+                                                                                                               \
+        /* y += alpha * x with every product rounded before the add, as without FMA */                         \
+        template <typename Ops, typename T>                                                                    \
+        TARGET void axpy_unfused(T* y, T alpha, const T* x, size_t n) {                                        \
+            constexpr size_t W = Ops::width;                                                                   \
+            const auto av = Ops::set1(alpha);                                                                  \
+            size_t i = 0;                                                                                      \
+            for (; i + 2 * W <= n; i += 2 * W) {                                                               \
+                auto p0 = Ops::mul(av, Ops::load(x + i));                                                      \
+                auto p1 = Ops::mul(av, Ops::load(x + i + W));                                                  \
+                MATRIXLIB_UNFUSED(p0);                                                                         \
+                MATRIXLIB_UNFUSED(p1);                                                                         \
+                Ops::store(y + i, Ops::add(Ops::load(y + i), p0));                                             \
+                Ops::store(y + i + W, Ops::add(Ops::load(y + i + W), p1));                                     \
+            }                                                                                                  \
+            for (; i + W <= n; i += W) {                                                                       \
+                auto p = Ops::mul(av, Ops::load(x + i));                                                       \
+                MATRIXLIB_UNFUSED(p);                                                                          \
+                Ops::store(y + i, Ops::add(Ops::load(y + i), p));                                              \
+            }                                                                                                  \
+            for (; i < n; ++i) y[i] += Detail::unfused(alpha * x[i]);                                          \
+        }                                                                                                      \
+                                                                                                               \
+        /* Whether every pair is within Detail::close_scalar's tolerance, a register at a time */              \
+        template <typename Ops, typename T>                                                                    \
+        TARGET bool close(const T* a, const T* b, size_t n, T relative, T absolute) {                          \
+            constexpr size_t W = Ops::width;                                                                   \
+            const auto rv = Ops::set1(relative), av = Ops::set1(absolute), zero = Ops::set1(T(0));             \
+            size_t i = 0;                                                                                      \
+            for (; i + W <= n; i += W) {                                                                       \
+                const auto x = Ops::load(a + i), y = Ops::load(b + i);                                         \
+                const auto d = Ops::abs(Ops::sub(x, y));                                                       \
+                const auto tol = Ops::max(av, Ops::mul(rv, Ops::max(Ops::abs(x), Ops::abs(y))));               \
+                /* d - d is NaN, and so not zero, when the difference overflowed or an operand is NaN */       \
+                const auto bad = Ops::mask_or(Ops::nle(d, tol), Ops::neq(Ops::sub(d, d), zero));               \
+                if (Ops::any(Ops::mask_and(Ops::neq(x, y), bad))) return false;                                \
+            }                                                                                                  \
+            for (; i < n; ++i) {                                                                               \
+                if (!Detail::close_scalar(a[i], b[i], relative, absolute)) return false;                       \
+            }                                                                                                  \
+            return true;                                                                                       \
+        }                                                                                                      \
+                                                                                                               \
+        /* Whether every pair is at most limit ulps apart; a plain loop that the target attribute vectorises */ \
+        template <typename T, typename U>                                                                      \
+        TARGET bool ulp_close(const T* a, const T* b, size_t n, U limit) {                                     \
+            for (size_t i = 0; i < n; i += 64) {                                                               \
+                const size_t end = std::min(n, i + 64);                                                        \
+                bool miss = false;                                                                             \
+                for (size_t j = i; j < end; ++j) miss |= Detail::ulp_miss(a[j], b[j], limit);                  \
+                if (miss) return false;                                                                        \
+            }                                                                                                  \
+            return true;                                                                                       \
+        }                                                                                                      \
+    }
+
+#if defined(MATRIXLIB_SIMD_X86)
+    MATRIXLIB_ELEMENTWISE_KERNELS(Sse2, )
+    MATRIXLIB_ELEMENTWISE_KERNELS(Avx2, MATRIXLIB_TARGET_AVX2)
+    MATRIXLIB_ELEMENTWISE_KERNELS(Avx512, MATRIXLIB_TARGET_AVX512)
+#elif defined(MATRIXLIB_SIMD_NEON)
+    MATRIXLIB_ELEMENTWISE_KERNELS(Neon, )
+#endif
+#undef MATRIXLIB_ELEMENTWISE_KERNELS
+
+    /* Picks the Ops struct for a scalar type and instruction set; Scalar means "no explicit kernel" */
+    template <typename T> struct SimdOps { static constexpr bool available = false; };
+
+#if defined(MATRIXLIB_SIMD_X86)
+    template <> struct SimdOps<float> {
+        using Sse2 = Sse2F32; using Avx2 = Avx2F32; using Avx512 = Avx512F32; using Neon = void;
+        static constexpr bool available = true;
+    };
+    template <> struct SimdOps<double> {
+        using Sse2 = Sse2F64; using Avx2 = Avx2F64; using Avx512 = Avx512F64; using Neon = void;
+        static constexpr bool available = true;
+    };
+#elif defined(MATRIXLIB_SIMD_NEON)
+    template <> struct SimdOps<float> {
+        using Sse2 = void; using Avx2 = void; using Avx512 = void; using Neon = NeonF32;
+        static constexpr bool available = true;
+    };
+    template <> struct SimdOps<double> {
+        using Sse2 = void; using Avx2 = void; using Avx512 = void; using Neon = NeonF64;
+        static constexpr bool available = true;
+    };
+#endif
+} /* Detail */
+
+    /*
+     * Runtime-dispatched element-wise kernels over n contiguous elements. float and double run through the
+     * explicit SIMD kernels above; other scalar types use flat loops, which compilers vectorise on their own
+     * once the row structure is gone. dst may alias src.
+     */
+
+    template <typename T>
+    void add_inplace(T* dst, const T* src, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::add<typename Detail::SimdOps<T>::Avx512>(dst, src, n);
+                case SimdIsa::AVX2: return Detail::Avx2::add<typename Detail::SimdOps<T>::Avx2>(dst, src, n);
+                case SimdIsa::SSE2: return Detail::Sse2::add<typename Detail::SimdOps<T>::Sse2>(dst, src, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::add<typename Detail::SimdOps<T>::Neon>(dst, src, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) dst[i] += src[i];
+    }
+
+    template <typename T>
+    void sub_inplace(T* dst, const T* src, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::sub<typename Detail::SimdOps<T>::Avx512>(dst, src, n);
+                case SimdIsa::AVX2: return Detail::Avx2::sub<typename Detail::SimdOps<T>::Avx2>(dst, src, n);
+                case SimdIsa::SSE2: return Detail::Sse2::sub<typename Detail::SimdOps<T>::Sse2>(dst, src, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::sub<typename Detail::SimdOps<T>::Neon>(dst, src, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) dst[i] -= src[i];
+    }
+
+    template <typename T>
+    void scale_inplace(T* dst, T s, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::scale<typename Detail::SimdOps<T>::Avx512>(dst, s, n);
+                case SimdIsa::AVX2: return Detail::Avx2::scale<typename Detail::SimdOps<T>::Avx2>(dst, s, n);
+                case SimdIsa::SSE2: return Detail::Sse2::scale<typename Detail::SimdOps<T>::Sse2>(dst, s, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::scale<typename Detail::SimdOps<T>::Neon>(dst, s, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) dst[i] *= s;
+    }
+
+    template <typename T>
+    bool equal(const T* a, const T* b, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::equal<typename Detail::SimdOps<T>::Avx512>(a, b, n);
+                case SimdIsa::AVX2: return Detail::Avx2::equal<typename Detail::SimdOps<T>::Avx2>(a, b, n);
+                case SimdIsa::SSE2: return Detail::Sse2::equal<typename Detail::SimdOps<T>::Sse2>(a, b, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::equal<typename Detail::SimdOps<T>::Neon>(a, b, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        if constexpr (std::is_integral<T>::value) {
+            /* Integer equality is bitwise equality, and libc's memcmp is already vectorised and CPU-dispatched */
+            return n == 0 || std::memcmp(a, b, n * sizeof(T)) == 0;
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                if (a[i] != b[i]) return false;
+            }
+            return true;
+        }
+    }
+
+namespace Detail {
+    /* Scalar form of the fixed_dot kernels, with the same 16 lanes and the same tree */
+    template <bool _Products, typename T>
+    T scalar_fixed_dot(const T* x, const T* y, size_t n) {
+        T lanes[deterministic_lanes] = {};
+        for (size_t i = 0; i < n; ++i) {
+            if constexpr (_Products) lanes[i % deterministic_lanes] += unfused(x[i] * y[i]);
+            else lanes[i % deterministic_lanes] += x[i];
+        }
+        return fold_lanes(lanes);
+    }
+
+    template <bool _Products, typename T>
+    T fixed_leaf(const T* x, const T* y, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Avx512::fixed_dot<typename SimdOps<T>::Avx512, _Products>(x, y, n);
+                case SimdIsa::AVX2: return Avx2::fixed_dot<typename SimdOps<T>::Avx2, _Products>(x, y, n);
+                case SimdIsa::SSE2: return Sse2::fixed_dot<typename SimdOps<T>::Sse2, _Products>(x, y, n);
+#else
+                case SimdIsa::NEON: return Neon::fixed_dot<typename SimdOps<T>::Neon, _Products>(x, y, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        return scalar_fixed_dot<_Products>(x, y, n);
+    }
+
+    template <typename T>
+    void fixed_leaf4(const T* a, ptrdiff_t lda, const T* x, size_t n, T* out) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Avx512::fixed_dot4<typename SimdOps<T>::Avx512>(a, lda, x, n, out);
+                case SimdIsa::AVX2: return Avx2::fixed_dot4<typename SimdOps<T>::Avx2>(a, lda, x, n, out);
+                case SimdIsa::SSE2: return Sse2::fixed_dot4<typename SimdOps<T>::Sse2>(a, lda, x, n, out);
+#else
+                case SimdIsa::NEON: return Neon::fixed_dot4<typename SimdOps<T>::Neon>(a, lda, x, n, out);
+#endif
+                default: break;
+            }
+        }
+#endif
+        for (ptrdiff_t r = 0; r < 4; ++r) out[r] = scalar_fixed_dot<true>(a + r * lda, x, n);
+    }
+
+    /* Pairwise sum of part(first) .. part(last - 1), split at the middle index */
+    template <typename T, typename F>
+    T pairwise_sum(size_t first, size_t last, const F& part) {
+        if (last - first == 1) return part(first);
+        const size_t mid = first + (last - first) / 2;
+        return pairwise_sum<T>(first, mid, part) + pairwise_sum<T>(mid, last, part);
+    }
+
+    /*
+     * The deterministic sum of n products x[i] * y[i], or of the x[i] with y == x: fixed_dot leaves of
+     * MATRIXLIB_REDUCTION_BLOCK elements, added up pairwise like Kernels::reduce does.
+     */
+    template <bool _Products, typename T>
+    T deterministic_sum(const T* x, const T* y, size_t n) {
+        constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+        if (n <= B) return fixed_leaf<_Products>(x, y, n);
+        return pairwise_sum<T>(0, (n + B - 1) / B, [=](size_t b) { return fixed_leaf<_Products>(x + b * B, y + b * B, std::min(B, n - b * B)); });
+    }
+
+    /* deterministic_sum<true> of the four rows a + r * lda with x */
+    template <typename T>
+    void deterministic_sum4(const T* a, ptrdiff_t lda, const T* x, size_t n, T* out) {
+        constexpr size_t B = MATRIXLIB_REDUCTION_BLOCK;
+        if (n <= B) return fixed_leaf4(a, lda, x, n, out);
+
+        const size_t leaves = (n + B - 1) / B;
+        static thread_local std::vector<T> partial;
+        partial.resize(4 * leaves);
+        for (size_t b = 0; b < leaves; ++b) fixed_leaf4(a + b * B, lda, x + b * B, std::min(B, n - b * B), &partial[4 * b]);
+        for (size_t r = 0; r < 4; ++r) out[r] = pairwise_sum<T>(0, leaves, [&](size_t b) { return partial[4 * b + r]; });
+    }
+} /* Detail */
+
+    /*
+     * The BLAS-1 building blocks of the matrix-vector kernels, dispatched the same way: y += alpha * x, the dot
+     * product x . y, and four dot products of consecutive rows a + r * lda with one x, which loads x once for
+     * all four rows. x and y must not overlap. In deterministic mode the floating-point ones take the fixed
+     * 16-lane tree and never fuse products; dot_product4 then gives each row exactly the dot_product result.
+     */
+
+    template <typename T>
+    void axpy_inplace(T* y, T alpha, const T* x, size_t n) {
+        const bool deterministic = std::is_floating_point<T>::value && deterministic_mode();
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512:
+                    return deterministic ? Detail::Avx512::axpy_unfused<typename Detail::SimdOps<T>::Avx512>(y, alpha, x, n)
+                                         : Detail::Avx512::axpy<typename Detail::SimdOps<T>::Avx512>(y, alpha, x, n);
+                case SimdIsa::AVX2:
+                    return deterministic ? Detail::Avx2::axpy_unfused<typename Detail::SimdOps<T>::Avx2>(y, alpha, x, n)
+                                         : Detail::Avx2::axpy<typename Detail::SimdOps<T>::Avx2>(y, alpha, x, n);
+                case SimdIsa::SSE2:
+                    return deterministic ? Detail::Sse2::axpy_unfused<typename Detail::SimdOps<T>::Sse2>(y, alpha, x, n)
+                                         : Detail::Sse2::axpy<typename Detail::SimdOps<T>::Sse2>(y, alpha, x, n);
+#else
+                case SimdIsa::NEON:
+                    return deterministic ? Detail::Neon::axpy_unfused<typename Detail::SimdOps<T>::Neon>(y, alpha, x, n)
+                                         : Detail::Neon::axpy<typename Detail::SimdOps<T>::Neon>(y, alpha, x, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        if (deterministic) {
+            for (size_t i = 0; i < n; ++i) y[i] += Detail::unfused(alpha * x[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+        }
+    }
+
+    template <typename T>
+    T dot_product(const T* x, const T* y, size_t n) {
+        if constexpr (std::is_floating_point<T>::value) {
+            if (deterministic_mode()) return Detail::deterministic_sum<true>(x, y, n);
+        }
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::dot<typename Detail::SimdOps<T>::Avx512>(x, y, n);
+                case SimdIsa::AVX2: return Detail::Avx2::dot<typename Detail::SimdOps<T>::Avx2>(x, y, n);
+                case SimdIsa::SSE2: return Detail::Sse2::dot<typename Detail::SimdOps<T>::Sse2>(x, y, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::dot<typename Detail::SimdOps<T>::Neon>(x, y, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        T ret(0);
+        for (size_t i = 0; i < n; ++i) ret += x[i] * y[i];
+        return ret;
+    }
+
+    template <typename T>
+    void dot_product4(const T* a, ptrdiff_t lda, const T* x, size_t n, T* out) {
+        if constexpr (std::is_floating_point<T>::value) {
+            if (deterministic_mode()) return Detail::deterministic_sum4(a, lda, x, n, out);
+        }
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::dot4<typename Detail::SimdOps<T>::Avx512>(a, lda, x, n, out);
+                case SimdIsa::AVX2: return Detail::Avx2::dot4<typename Detail::SimdOps<T>::Avx2>(a, lda, x, n, out);
+                case SimdIsa::SSE2: return Detail::Sse2::dot4<typename Detail::SimdOps<T>::Sse2>(a, lda, x, n, out);
+#else
+                case SimdIsa::NEON: return Detail::Neon::dot4<typename Detail::SimdOps<T>::Neon>(a, lda, x, n, out);
+#endif
+                default: break;
+            }
+        }
+#endif
+        T r0(0), r1(0), r2(0), r3(0);
+        for (size_t i = 0; i < n; ++i) {
+            r0 += a[i] * x[i];
+            r1 += a[lda + i] * x[i];
+            r2 += a[2 * lda + i] * x[i];
+            r3 += a[3 * lda + i] * x[i];
+        }
+        out[0] = r0; out[1] = r1; out[2] = r2; out[3] = r3;
+    }
+
+    /*
+     * Horizontal reductions of n contiguous elements, dispatched the same way: the sum, and the smallest and
+     * largest element of n >= 1 elements. Which element wins among NaNs and equal values is unspecified. In
+     * deterministic mode floating-point sums take the fixed 16-lane tree.
+     */
+
+    template <typename T>
+    T reduce_sum(const T* x, size_t n) {
+        if constexpr (std::is_floating_point<T>::value) {
+            if (deterministic_mode()) return Detail::deterministic_sum<false>(x, x, n);
+        }
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::sum<typename Detail::SimdOps<T>::Avx512>(x, n);
+                case SimdIsa::AVX2: return Detail::Avx2::sum<typename Detail::SimdOps<T>::Avx2>(x, n);
+                case SimdIsa::SSE2: return Detail::Sse2::sum<typename Detail::SimdOps<T>::Sse2>(x, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::sum<typename Detail::SimdOps<T>::Neon>(x, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        T ret(0);
+        for (size_t i = 0; i < n; ++i) ret += x[i];
+        return ret;
+    }
+
+    template <bool _Max, typename T>
+    T reduce_extremum(const T* x, size_t n) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::extremum<typename Detail::SimdOps<T>::Avx512, _Max>(x, n);
+                case SimdIsa::AVX2: return Detail::Avx2::extremum<typename Detail::SimdOps<T>::Avx2, _Max>(x, n);
+                case SimdIsa::SSE2: return Detail::Sse2::extremum<typename Detail::SimdOps<T>::Sse2, _Max>(x, n);
+#else
+                case SimdIsa::NEON: return Detail::Neon::extremum<typename Detail::SimdOps<T>::Neon, _Max>(x, n);
+#endif
+                default: break;
+            }
+        }
+#endif
+        T ret = x[0];
+        for (size_t i = 1; i < n; ++i) ret = (_Max ? ret < x[i] : x[i] < ret) ? x[i] : ret;
+        return ret;
+    }
+
+    template <typename T>
+    T reduce_min(const T* x, size_t n) { return reduce_extremum<false>(x, n); }
+
+    template <typename T>
+    T reduce_max(const T* x, size_t n) { return reduce_extremum<true>(x, n); }
+
+    /*
+     * Whether every pair a[i], b[i] of n elements is equal, or differs by at most
+     * max(absolute, relative * max(|a[i]|, |b[i]|)). Infinities only match themselves and NaN matches nothing.
+     */
+    template <typename T>
+    bool approx_equal(const T* a, const T* b, size_t n, T relative, T absolute) {
+#if defined(MATRIXLIB_SIMD_X86) || defined(MATRIXLIB_SIMD_NEON)
+        if constexpr (Detail::SimdOps<T>::available) {
+            switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+                case SimdIsa::AVX512: return Detail::Avx512::close<typename Detail::SimdOps<T>::Avx512>(a, b, n, relative, absolute);
+                case SimdIsa::AVX2: return Detail::Avx2::close<typename Detail::SimdOps<T>::Avx2>(a, b, n, relative, absolute);
+                case SimdIsa::SSE2: return Detail::Sse2::close<typename Detail::SimdOps<T>::Sse2>(a, b, n, relative, absolute);
+#else
+                case SimdIsa::NEON: return Detail::Neon::close<typename Detail::SimdOps<T>::Neon>(a, b, n, relative, absolute);
+#endif
+                default: break;
+            }
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) {
+            if (!Detail::close_scalar(a[i], b[i], relative, absolute)) return false;
+        }
+        return true;
+    }
+
+    /*
+     * Whether every pair a[i], b[i] of n float or double elements is equal, or both finite and at most max_ulps
+     * representable values apart, counting -0 and +0 as one value. NaN matches nothing.
+     */
+    template <typename T>
+    bool ulp_equal(const T* a, const T* b, size_t n, uint64_t max_ulps) {
+        using U = typename Detail::FloatBits<T>::type;
+        const U limit = static_cast<U>(std::min<uint64_t>(max_ulps, static_cast<U>(~U(0))));
+        switch (active_simd_isa()) {
+#if defined(MATRIXLIB_SIMD_X86)
+            case SimdIsa::AVX512: return Detail::Avx512::ulp_close(a, b, n, limit);
+            case SimdIsa::AVX2: return Detail::Avx2::ulp_close(a, b, n, limit);
+            case SimdIsa::SSE2: return Detail::Sse2::ulp_close(a, b, n, limit);
+#elif defined(MATRIXLIB_SIMD_NEON)
+            case SimdIsa::NEON: return Detail::Neon::ulp_close(a, b, n, limit);
+#endif
+            default: break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (Detail::ulp_miss(a[i], b[i], limit)) return false;
+        }
+        return true;
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* SIMD_H */
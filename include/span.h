@@ -0,0 +1,110 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "utils.h"
+
+namespace MatrixLib {
+    /**
+     * @brief Non-owning view of size elements spaced stride elements apart, such as a row (stride 1) or a
+     * column (stride = column count) of a row-major matrix.
+     *
+     * Writes through a StridedSpan<T> go straight to the viewed storage. A span is invalidated by anything
+     * that reallocates the matrix it views.
+     *
+     * @tparam T The element type, const-qualified for read-only views.
+     */
+    template <typename T>
+    class StridedSpan {
+        T* data_;
+        size_t size_;
+        ptrdiff_t stride_;
+
+    public:
+        /**
+         * @brief Random-access iterator over the view. It tracks an index rather than a pointer, so end() of a
+         * column view never points past the matrix storage.
+         */
+        class iterator {
+            T* base_;
+            ptrdiff_t index_;
+            ptrdiff_t stride_;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::remove_cv<T>::type;
+            using difference_type = ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            constexpr iterator() noexcept : base_(nullptr), index_(0), stride_(1) {}
+            constexpr iterator(T* base, ptrdiff_t index, ptrdiff_t stride) noexcept : base_(base), index_(index), stride_(stride) {}
+
+            constexpr reference operator*() const noexcept { return base_[index_ * stride_]; }
+            constexpr pointer operator->() const noexcept { return base_ + index_ * stride_; }
+            constexpr reference operator[](difference_type n) const noexcept { return base_[(index_ + n) * stride_]; }
+
+            constexpr iterator& operator++() noexcept { ++index_; return *this; }
+            constexpr iterator operator++(int) noexcept { iterator old = *this; ++index_; return old; }
+            constexpr iterator& operator--() noexcept { --index_; return *this; }
+            constexpr iterator operator--(int) noexcept { iterator old = *this; --index_; return old; }
+            constexpr iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+            constexpr iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+
+            friend constexpr iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+            friend constexpr iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+            friend constexpr iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+            friend constexpr difference_type operator-(const iterator& a, const iterator& b) noexcept { return a.index_ - b.index_; }
+
+            friend constexpr bool operator==(const iterator& a, const iterator& b) noexcept { return a.index_ == b.index_; }
+            friend constexpr bool operator!=(const iterator& a, const iterator& b) noexcept { return a.index_ != b.index_; }
+            friend constexpr bool operator<(const iterator& a, const iterator& b) noexcept { return a.index_ < b.index_; }
+            friend constexpr bool operator>(const iterator& a, const iterator& b) noexcept { return a.index_ > b.index_; }
+            friend constexpr bool operator<=(const iterator& a, const iterator& b) noexcept { return a.index_ <= b.index_; }
+            friend constexpr bool operator>=(const iterator& a, const iterator& b) noexcept { return a.index_ >= b.index_; }
+        };
+
+        constexpr StridedSpan(T* data, size_t size, ptrdiff_t stride = 1) noexcept : data_(data), size_(size), stride_(stride) {}
+
+        /**
+         * @brief A mutable span converts to a read-only one.
+         */
+        template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+        constexpr StridedSpan(const StridedSpan<U>& other) noexcept : data_(other.data()), size_(other.size()), stride_(other.stride()) {}
+
+        /**
+         * @return The number of elements in the view.
+         */
+        constexpr size_t size() const noexcept { return size_; }
+
+        /**
+         * @return The distance in elements between consecutive elements of the view.
+         */
+        constexpr ptrdiff_t stride() const noexcept { return stride_; }
+
+        /**
+         * @return A pointer to the first element of the view.
+         */
+        constexpr T* data() const noexcept { return data_; }
+
+        /**
+         * Access an element of the view. Bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param index The position of the element in the view.
+         * @return A reference to the element.
+         */
+        constexpr T& operator[](size_t index) const {
+            MATRIXLIB_CHECK_INDEX(index < size_, "Index %zu is out of bounds", index);
+
+            return data_[static_cast<ptrdiff_t>(index) * stride_];
+        }
+
+        constexpr iterator begin() const noexcept { return iterator(data_, 0, stride_); }
+        constexpr iterator end() const noexcept { return iterator(data_, static_cast<ptrdiff_t>(size_), stride_); }
+    };
+} /* MatrixLib */
+
+#endif /* SPAN_H */
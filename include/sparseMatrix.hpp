@@ -0,0 +1,779 @@
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "dynMatrix.hpp"
+#include "parallel.hpp"
+
+/* Below this many multiply-adds (nonzeros * dense columns) a sparse product is not worth splitting across threads */
+#ifndef MATRIXLIB_PARALLEL_SPARSE_THRESHOLD
+#define MATRIXLIB_PARALLEL_SPARSE_THRESHOLD (1 << 16)
+#endif
+
+namespace MatrixLib {
+    /**
+     * @brief Compressed layout of a SparseMatrix: CSR keeps the nonzeros of each row together, CSC those of each
+     * column.
+     */
+    enum class SparseFormat { CSR, CSC };
+
+    /**
+     * @brief A (row, column, value) entry used to build a SparseMatrix.
+     */
+    template <typename _Scalar>
+    struct Triplet {
+        size_t row;
+        size_t col;
+        _Scalar value;
+    };
+
+namespace Kernels {
+    /*
+     * Sparse kernels take a compressed operand as its outer pointers, inner indices and values, and dense
+     * operands row-major with a row stride. Each one writes a disjoint range of output rows or columns, which is
+     * how the parallel products split the work.
+     */
+
+    /**
+     * C(r0:r1, :) = A(r0:r1, :) * B for a CSR A and a dense B with n columns. Each output row accumulates
+     * contiguous rows of B; a single column (SpMV) is a gather-dot along the row instead.
+     */
+    template <typename T, typename I>
+    void csr_times_dense(size_t r0, size_t r1, const I* outer, const I* inner, const T* values,
+                         size_t n, const T* b, ptrdiff_t ldb, T* c, ptrdiff_t ldc) {
+        if (n == 1) {
+            for (size_t i = r0; i < r1; ++i) {
+                T sum(0);
+                for (size_t k = outer[i]; k < outer[i + 1]; ++k) sum += values[k] * b[inner[k] * ldb];
+                c[i * ldc] = sum;
+            }
+            return;
+        }
+
+        for (size_t i = r0; i < r1; ++i) {
+            T* cRow = c + i * ldc;
+            std::fill(cRow, cRow + n, T(0));
+
+            for (size_t k = outer[i]; k < outer[i + 1]; ++k) {
+                const T v = values[k];
+                const T* bRow = b + inner[k] * ldb;
+                for (size_t j = 0; j < n; ++j) cRow[j] += v * bRow[j];
+            }
+        }
+    }
+
+    /**
+     * C(:, j0:j1) = A * B(:, j0:j1) for a CSC A with cols columns. Every nonzero scatters a slice of a row of B
+     * into a row of C, which must be zeroed beforehand.
+     */
+    template <typename T, typename I>
+    void csc_times_dense(size_t cols, const I* outer, const I* inner, const T* values,
+                         size_t j0, size_t j1, const T* b, ptrdiff_t ldb, T* c, ptrdiff_t ldc) {
+        for (size_t p = 0; p < cols; ++p) {
+            const T* bRow = b + p * ldb;
+
+            for (size_t k = outer[p]; k < outer[p + 1]; ++k) {
+                const T v = values[k];
+                T* cRow = c + inner[k] * ldc;
+                for (size_t j = j0; j < j1; ++j) cRow[j] += v * bRow[j];
+            }
+        }
+    }
+
+    /**
+     * C(i0:i1, :) = B(i0:i1, :) * A for a dense B and a CSR A with k rows. Nonzero entries of B scale rows of A
+     * into the output row, which must be zeroed beforehand.
+     */
+    template <typename T, typename I>
+    void dense_times_csr(size_t i0, size_t i1, size_t k, const T* b, ptrdiff_t ldb,
+                         const I* outer, const I* inner, const T* values, T* c, ptrdiff_t ldc) {
+        for (size_t i = i0; i < i1; ++i) {
+            const T* bRow = b + i * ldb;
+            T* cRow = c + i * ldc;
+
+            for (size_t p = 0; p < k; ++p) {
+                const T bip = bRow[p];
+                if (bip == T(0)) continue;
+                for (size_t q = outer[p]; q < outer[p + 1]; ++q) cRow[inner[q]] += bip * values[q];
+            }
+        }
+    }
+
+    /**
+     * C(i0:i1, :) = B(i0:i1, :) * A for a dense B and a CSC A with n columns, as a gather-dot per output element.
+     */
+    template <typename T, typename I>
+    void dense_times_csc(size_t i0, size_t i1, size_t n, const T* b, ptrdiff_t ldb,
+                         const I* outer, const I* inner, const T* values, T* c, ptrdiff_t ldc) {
+        for (size_t i = i0; i < i1; ++i) {
+            const T* bRow = b + i * ldb;
+            T* cRow = c + i * ldc;
+
+            for (size_t j = 0; j < n; ++j) {
+                T sum(0);
+                for (size_t q = outer[j]; q < outer[j + 1]; ++q) sum += bRow[inner[q]] * values[q];
+                cRow[j] = sum;
+            }
+        }
+    }
+
+    /**
+     * C = A * B for CSR operands (Gustavson's algorithm): each row of C accumulates scaled rows of B into a dense
+     * accumulator of n entries, and its nonzero columns are collected and sorted. A CSC product is the same
+     * computation on the transposes, C^T = B^T A^T.
+     */
+    template <typename T, typename I>
+    void csr_times_csr(size_t m, size_t n, const I* ao, const I* ai, const T* av, const I* bo, const I* bi, const T* bv,
+                       std::vector<I>& co, std::vector<I>& ci, std::vector<T>& cv) {
+        std::vector<T> acc(n);
+        std::vector<size_t> marker(n, static_cast<size_t>(-1));
+        std::vector<I> cols;
+
+        co.assign(m + 1, I(0));
+        ci.clear();
+        cv.clear();
+
+        for (size_t i = 0; i < m; ++i) {
+            cols.clear();
+
+            for (size_t k = ao[i]; k < ao[i + 1]; ++k) {
+                const size_t p = ai[k];
+                const T v = av[k];
+
+                for (size_t q = bo[p]; q < bo[p + 1]; ++q) {
+                    const I j = bi[q];
+                    if (marker[j] != i) {
+                        marker[j] = i;
+                        acc[j] = T(0);
+                        cols.push_back(j);
+                    }
+                    acc[j] += v * bv[q];
+                }
+            }
+
+            std::sort(cols.begin(), cols.end());
+            for (I j : cols) {
+                ci.push_back(j);
+                cv.push_back(acc[j]);
+            }
+
+            if (ci.size() > std::numeric_limits<I>::max()) {
+                Utils::throw_invalid_argument_error("Sparse product has more nonzeros than its storage index type can address");
+            }
+            co[i + 1] = static_cast<I>(ci.size());
+        }
+    }
+} /* Kernels */
+
+    template <typename _Scalar, SparseFormat _Format = SparseFormat::CSR, typename _StorageIndex = std::uint32_t>
+    class SparseMatrix;
+
+namespace Detail {
+    /*
+     * Re-buckets a compressed matrix by its inner index, i.e. converts CSR to CSC or back. Walking the source in
+     * outer order leaves the destination's inner indices sorted, which is also how unsorted input gets sorted.
+     */
+    template <typename T, typename I>
+    void transpose_compressed(size_t outerSize, size_t innerSize, const I* outer, const I* inner, const T* values,
+                              std::vector<I>& dstOuter, std::vector<I>& dstInner, std::vector<T>& dstValues) {
+        const size_t nnz = outer[outerSize];
+        dstOuter.assign(innerSize + 1, I(0));
+        dstInner.resize(nnz);
+        dstValues.resize(nnz);
+
+        for (size_t k = 0; k < nnz; ++k) ++dstOuter[inner[k] + 1];
+        for (size_t i = 0; i < innerSize; ++i) dstOuter[i + 1] += dstOuter[i];
+
+        std::vector<I> next(dstOuter.begin(), dstOuter.end() - 1);
+        for (size_t o = 0; o < outerSize; ++o) {
+            for (size_t k = outer[o]; k < outer[o + 1]; ++k) {
+                const I pos = next[inner[k]]++;
+                dstInner[pos] = static_cast<I>(o);
+                dstValues[pos] = values[k];
+            }
+        }
+    }
+
+    /* Enables the mixed sparse/dense operators for any dense matrix or expression D */
+    template <typename D>
+    using enable_if_dense_operand = typename std::enable_if<OperandTraits<D>::is_operand, int>::type;
+
+    /* Flat view of a dense operand: packed row-major leaves are referenced in place, anything else is evaluated once */
+    template <typename D, bool = OperandTraits<D>::is_leaf && OperandTraits<D>::has_linear_access>
+    struct DenseOperand {
+        DenseRef<typename OperandTraits<D>::Scalar> ref;
+
+        explicit DenseOperand(const D& d) : ref(OperandTraits<D>::ref(d)) {}
+    };
+
+    template <typename D>
+    struct DenseOperand<D, false> {
+        plain_t<D> storage;
+        DenseRef<typename OperandTraits<D>::Scalar> ref;
+
+        explicit DenseOperand(const D& d) : storage(d), ref(OperandTraits<plain_t<D>>::ref(storage)) {}
+    };
+} /* Detail */
+
+    /**
+     * @brief A matrix that stores only its nonzero entries, in compressed sparse row (CSR) or column (CSC) form.
+     *
+     * The nonzeros of every row (CSR) or column (CSC) are stored contiguously and sorted by their column (row)
+     * index, and each row's (column's) range is given by an array of outer pointers. Memory and the work of every
+     * product grow with the number of nonzeros instead of rows * cols. The structure is fixed once built; the
+     * values of stored entries can be changed through values().
+     *
+     * @tparam _Scalar The scalar type of the matrix elements. Must be a numeric type.
+     * @tparam _Format SparseFormat::CSR or SparseFormat::CSC.
+     * @tparam _StorageIndex Unsigned integer type of the stored indices. The 32-bit default halves the index
+     * traffic of the bandwidth-bound products compared to size_t.
+     */
+    template <typename _Scalar, SparseFormat _Format, typename _StorageIndex>
+    class SparseMatrix {
+        static_assert(std::is_arithmetic<_Scalar>::value, "Matrix element type must be numeric");
+        static_assert(std::is_integral<_StorageIndex>::value && std::is_unsigned<_StorageIndex>::value,
+                      "Sparse storage index must be an unsigned integer type");
+
+        template <typename, SparseFormat, typename>
+        friend class SparseMatrix;
+
+        size_t rows_;
+        size_t cols_;
+        std::vector<_StorageIndex> outer_;
+        std::vector<_StorageIndex> inner_;
+        std::vector<_Scalar> values_;
+
+        static constexpr bool is_row_major = _Format == SparseFormat::CSR;
+
+        static size_t outer_of(size_t row, size_t col) { return is_row_major ? row : col; }
+        static size_t inner_of(size_t row, size_t col) { return is_row_major ? col : row; }
+
+        static void check_index_range(size_t rows, size_t cols, size_t nonzeros) {
+            const size_t limit = std::numeric_limits<_StorageIndex>::max();
+            if (rows > limit || cols > limit || nonzeros > limit) {
+                Utils::throw_invalid_argument_error("A %zux%zu sparse matrix with %zu nonzeros does not fit its storage index type",
+                                                    rows, cols, nonzeros);
+            }
+        }
+
+        /* Merges adjacent entries with equal inner indices within each (sorted) outer segment */
+        void sum_duplicates() {
+            size_t write = 0, start = 0;
+
+            for (size_t o = 0; o + 1 < outer_.size(); ++o) {
+                const size_t end = outer_[o + 1];
+                const size_t segment = write;
+
+                for (size_t k = start; k < end; ++k) {
+                    if (write > segment && inner_[write - 1] == inner_[k]) {
+                        values_[write - 1] += values_[k];
+                    } else {
+                        inner_[write] = inner_[k];
+                        values_[write] = values_[k];
+                        ++write;
+                    }
+                }
+
+                start = end;
+                outer_[o + 1] = static_cast<_StorageIndex>(write);
+            }
+
+            inner_.resize(write);
+            values_.resize(write);
+        }
+
+    public:
+        using Scalar = _Scalar;
+        using StorageIndex = _StorageIndex;
+        static constexpr SparseFormat format = _Format;
+
+        /**
+         * @brief Default constructor, an empty 0x0 matrix.
+         */
+        SparseMatrix() : rows_(0), cols_(0), outer_(1, 0) {}
+
+        /**
+         * @brief Constructs a rows x cols matrix without nonzeros.
+         * @throw std::invalid_argument if a dimension does not fit _StorageIndex.
+         */
+        SparseMatrix(size_t rows, size_t cols) : rows_(rows), cols_(cols) {
+            check_index_range(rows, cols, 0);
+            outer_.assign(outer_of(rows, cols) + 1, 0);
+        }
+
+        /**
+         * @brief Builds the matrix from (row, column, value) entries given in any order. Entries at the same
+         * position are summed. Runs in O(rows + cols + entries) by bucketing the entries twice.
+         * @throw std::out_of_range if an entry lies outside the matrix.
+         * @throw std::invalid_argument if the matrix does not fit _StorageIndex.
+         */
+        SparseMatrix(size_t rows, size_t cols, const std::vector<Triplet<_Scalar>>& triplets) : rows_(rows), cols_(cols) {
+            check_index_range(rows, cols, triplets.size());
+
+            /* Bucket by inner index into the transposed format, then transpose back: that pass sorts each segment */
+            const size_t outerSize = outer_of(rows, cols), innerSize = inner_of(rows, cols);
+            std::vector<_StorageIndex> byInner(innerSize + 1, 0), outerIndex(triplets.size());
+            std::vector<_Scalar> values(triplets.size());
+
+            for (const auto& t : triplets) {
+                if (t.row >= rows || t.col >= cols) {
+                    Utils::throw_out_of_range_error("Entry (%zu, %zu) lies outside a %zux%zu matrix", t.row, t.col, rows, cols);
+                }
+                ++byInner[inner_of(t.row, t.col) + 1];
+            }
+            for (size_t i = 0; i < innerSize; ++i) byInner[i + 1] += byInner[i];
+
+            std::vector<_StorageIndex> next(byInner.begin(), byInner.end() - 1);
+            for (const auto& t : triplets) {
+                const _StorageIndex pos = next[inner_of(t.row, t.col)]++;
+                outerIndex[pos] = static_cast<_StorageIndex>(outer_of(t.row, t.col));
+                values[pos] = t.value;
+            }
+
+            Detail::transpose_compressed(innerSize, outerSize, byInner.data(), outerIndex.data(), values.data(),
+                                         outer_, inner_, values_);
+            sum_duplicates();
+        }
+
+        /**
+         * @brief Adopts existing compressed arrays, e.g. a CSR matrix produced by other code, without copying them.
+         * @param outer outer_size() + 1 nondecreasing offsets into inner and values, starting at zero.
+         * @param inner The column (CSR) or row (CSC) index of every nonzero, ascending within each segment.
+         * @param values The value of every nonzero.
+         * @throw std::invalid_argument if the array sizes are inconsistent.
+         */
+        SparseMatrix(size_t rows, size_t cols, std::vector<_StorageIndex> outer, std::vector<_StorageIndex> inner, std::vector<_Scalar> values)
+            : rows_(rows), cols_(cols), outer_(std::move(outer)), inner_(std::move(inner)), values_(std::move(values)) {
+            check_index_range(rows, cols, values_.size());
+
+            if (outer_.size() != outer_of(rows, cols) + 1 || outer_.front() != 0 || outer_.back() != inner_.size()
+                || inner_.size() != values_.size()) {
+                Utils::throw_invalid_argument_error("Inconsistent compressed arrays for a %zux%zu sparse matrix", rows, cols);
+            }
+        }
+
+        /**
+         * @brief Converts a dense matrix or expression, keeping its nonzero entries.
+         */
+        template <typename D, Detail::enable_if_dense_operand<D> = 0>
+        explicit SparseMatrix(const D& dense) {
+            const Detail::DenseOperand<D> operand(dense);
+            const auto& ref = operand.ref;
+            rows_ = ref.rows;
+            cols_ = ref.cols;
+
+            outer_.assign(outer_of(rows_, cols_) + 1, 0);
+            for (size_t i = 0; i < rows_; ++i) {
+                for (size_t j = 0; j < cols_; ++j) {
+                    if (ref.data[i * cols_ + j] != 0) ++outer_[outer_of(i, j) + 1];
+                }
+            }
+            for (size_t o = 0; o + 1 < outer_.size(); ++o) outer_[o + 1] += outer_[o];
+            check_index_range(rows_, cols_, outer_.back());
+
+            /* A row-major walk visits every outer segment in ascending inner order, for either format */
+            inner_.resize(outer_.back());
+            values_.resize(outer_.back());
+            std::vector<_StorageIndex> next(outer_.begin(), outer_.end() - 1);
+            for (size_t i = 0; i < rows_; ++i) {
+                for (size_t j = 0; j < cols_; ++j) {
+                    const auto value = ref.data[i * cols_ + j];
+                    if (value == 0) continue;
+
+                    const _StorageIndex pos = next[outer_of(i, j)]++;
+                    inner_[pos] = static_cast<_StorageIndex>(inner_of(i, j));
+                    values_[pos] = static_cast<_Scalar>(value);
+                }
+            }
+        }
+
+        /**
+         * @brief Converts between CSR and CSC in O(rows + cols + nonzeros).
+         */
+        template <SparseFormat _OtherFormat, typename = typename std::enable_if<_OtherFormat != _Format>::type>
+        explicit SparseMatrix(const SparseMatrix<_Scalar, _OtherFormat, _StorageIndex>& other) : rows_(other.rows_), cols_(other.cols_) {
+            Detail::transpose_compressed(other.outer_size(), other.inner_size(), other.outer_.data(), other.inner_.data(),
+                                         other.values_.data(), outer_, inner_, values_);
+        }
+
+        /**
+         * @return The number of rows in the matrix.
+         */
+        size_t rows() const noexcept { return rows_; }
+
+        /**
+         * @return The number of columns in the matrix.
+         */
+        size_t cols() const noexcept { return cols_; }
+
+        /**
+         * @return The number of stored entries.
+         */
+        size_t nonzeros() const noexcept { return values_.size(); }
+
+        /**
+         * @return The number of rows (CSR) or columns (CSC), i.e. of compressed segments.
+         */
+        size_t outer_size() const noexcept { return outer_.size() - 1; }
+
+        /**
+         * @return The number of columns (CSR) or rows (CSC).
+         */
+        size_t inner_size() const noexcept { return is_row_major ? cols_ : rows_; }
+
+        /**
+         * @return The outer_size() + 1 offsets delimiting each row's (column's) entries.
+         */
+        const _StorageIndex* outer_index() const noexcept { return outer_.data(); }
+
+        /**
+         * @return The column (CSR) or row (CSC) index of every stored entry.
+         */
+        const _StorageIndex* inner_index() const noexcept { return inner_.data(); }
+
+        /**
+         * @return The values of the stored entries, in storage order.
+         */
+        _Scalar* values() noexcept { return values_.data(); }
+        const _Scalar* values() const noexcept { return values_.data(); }
+
+        /**
+         * Read an element by binary search within its row (CSR) or column (CSC). Bounds-checked unless
+         * MATRIXLIB_UNCHECKED_ACCESS is defined.
+         *
+         * @param indexOuter The row index of the element.
+         * @param indexInner The column index of the element.
+         * @return The element, zero if it is not stored.
+         */
+        _Scalar operator()(size_t indexOuter, size_t indexInner) const {
+            MATRIXLIB_CHECK_INDEX(indexOuter < rows_, "Index outer %zu is out of bounds", indexOuter);
+            MATRIXLIB_CHECK_INDEX(indexInner < cols_, "index inner %zu is out of bounds", indexInner);
+
+            const size_t o = outer_of(indexOuter, indexInner);
+            const auto first = inner_.begin() + outer_[o], last = inner_.begin() + outer_[o + 1];
+            const auto it = std::lower_bound(first, last, static_cast<_StorageIndex>(inner_of(indexOuter, indexInner)));
+
+            return (it != last && *it == inner_of(indexOuter, indexInner)) ? values_[it - inner_.begin()] : _Scalar(0);
+        }
+
+        /**
+         * @return The matrix with its zeros filled in.
+         */
+        DynMatrix<_Scalar> to_dense() const {
+            DynMatrix<_Scalar> ret(rows_, cols_);
+            add_to(ret.data(), cols_, _Scalar(1));
+            return ret;
+        }
+
+        /**
+         * @brief Adds scale * this to the row-major rows() x cols() dense matrix at dst with row stride ldd.
+         */
+        void add_to(_Scalar* dst, ptrdiff_t ldd, _Scalar scale) const {
+            for (size_t o = 0; o < outer_size(); ++o) {
+                for (size_t k = outer_[o]; k < outer_[o + 1]; ++k) {
+                    const size_t i = is_row_major ? o : inner_[k];
+                    const size_t j = is_row_major ? inner_[k] : o;
+                    dst[i * ldd + j] += scale * values_[k];
+                }
+            }
+        }
+
+        /**
+         * Multiply every stored entry by a scalar value.
+         *
+         * @param val The scalar value to multiply by.
+         * @return A reference to this matrix after the multiplication.
+         */
+        template <typename _NumericScalar>
+        SparseMatrix& operator*=(const _NumericScalar& val) {
+            static_assert(std::is_arithmetic<_NumericScalar>::value, "Can only do scalar multiplication with a numeric type!");
+
+            for (auto& x : values_) x *= val;
+            return *this;
+        }
+
+        /**
+         * @brief Structural equality: same shape, same stored positions and same values.
+         */
+        bool operator==(const SparseMatrix& other) const {
+            return rows_ == other.rows_ && cols_ == other.cols_ && outer_ == other.outer_ && inner_ == other.inner_
+                   && values_ == other.values_;
+        }
+
+        bool operator!=(const SparseMatrix& other) const { return !(*this == other); }
+    };
+
+namespace Detail {
+    inline void check_product_shape(size_t lhsRows, size_t lhsCols, size_t rhsRows, size_t rhsCols) {
+        if (lhsCols != rhsRows) {
+            Utils::throw_invalid_argument_error("Matrix multiplication requires matching inner dimensions, got %zux%zu and %zux%zu",
+                                                lhsRows, lhsCols, rhsRows, rhsCols);
+        }
+    }
+
+    /* Splits [0, count) into chunks of roughly equal work and runs them on the pool, or runs it all inline */
+    template <typename F>
+    void run_chunks(ThreadPool* pool, size_t count, size_t work, F&& body) {
+        if (!pool || pool->thread_count() <= 1 || count < 2 || work < static_cast<size_t>(MATRIXLIB_PARALLEL_SPARSE_THRESHOLD)) {
+            body(0, count);
+            return;
+        }
+
+        const size_t chunks = std::min(count, 4 * pool->thread_count());
+        pool->parallel_for(chunks, [&](size_t t) { body(count * t / chunks, count * (t + 1) / chunks); });
+    }
+
+    template <typename T, SparseFormat F, typename I>
+    DynMatrix<T> sparse_times_dense(ThreadPool* pool, const SparseMatrix<T, F, I>& a, const DenseRef<T>& b) {
+        check_product_shape(a.rows(), a.cols(), b.rows, b.cols);
+
+        const size_t n = b.cols;
+        DynMatrix<T> c(a.rows(), n);
+        const I* outer = a.outer_index();
+
+        if constexpr (F == SparseFormat::CSR) {
+            /* Rows are split so that every chunk holds about the same number of nonzeros */
+            const size_t rows = a.rows(), nnz = a.nonzeros();
+            run_chunks(pool, rows, nnz * n, [&](size_t r0, size_t r1) {
+                if (r0 > 0 && nnz > 0) r0 = std::lower_bound(outer, outer + rows, static_cast<I>(nnz * r0 / rows)) - outer;
+                if (r1 < rows && nnz > 0) r1 = std::lower_bound(outer, outer + rows, static_cast<I>(nnz * r1 / rows)) - outer;
+                Kernels::csr_times_dense<T, I>(r0, r1, outer, a.inner_index(), a.values(), n, b.data, n, c.data(), n);
+            });
+        } else {
+            /* Columns scatter into shared rows of C, so only the columns of B can be split */
+            run_chunks(pool, n, a.nonzeros() * n, [&](size_t j0, size_t j1) {
+                Kernels::csc_times_dense<T, I>(a.cols(), outer, a.inner_index(), a.values(), j0, j1, b.data, n, c.data(), n);
+            });
+        }
+
+        return c;
+    }
+
+    template <typename T, SparseFormat F, typename I>
+    DynMatrix<T> dense_times_sparse(ThreadPool* pool, const DenseRef<T>& b, const SparseMatrix<T, F, I>& a) {
+        check_product_shape(b.rows, b.cols, a.rows(), a.cols());
+
+        DynMatrix<T> c(b.rows, a.cols());
+        run_chunks(pool, b.rows, a.nonzeros() * b.rows, [&](size_t i0, size_t i1) {
+            if constexpr (F == SparseFormat::CSR) {
+                Kernels::dense_times_csr<T, I>(i0, i1, a.rows(), b.data, b.cols, a.outer_index(), a.inner_index(), a.values(),
+                                               c.data(), a.cols());
+            } else {
+                Kernels::dense_times_csc<T, I>(i0, i1, a.cols(), b.data, b.cols, a.outer_index(), a.inner_index(), a.values(),
+                                               c.data(), a.cols());
+            }
+        });
+
+        return c;
+    }
+
+    /* sparseScale * sparse + denseScale * dense, evaluated into a new dense matrix */
+    template <typename T, SparseFormat F, typename I, typename D>
+    DynMatrix<T> sparse_dense_sum(const SparseMatrix<T, F, I>& sparse, const D& dense, T sparseScale, T denseScale) {
+        static_assert(std::is_same<typename OperandTraits<D>::Scalar, T>::value, "Sparse and dense operands must have the same scalar type");
+
+        const DenseOperand<D> operand(dense);
+        if (operand.ref.rows != sparse.rows() || operand.ref.cols != sparse.cols()) {
+            Utils::throw_invalid_argument_error("Matrix addition requires equal shapes, got %zux%zu and %zux%zu",
+                                                sparse.rows(), sparse.cols(), operand.ref.rows, operand.ref.cols);
+        }
+
+        DynMatrix<T> ret(sparse.rows(), sparse.cols());
+        std::copy(operand.ref.data, operand.ref.data + ret.size(), ret.data());
+        if (denseScale != T(1)) ret *= denseScale;
+        sparse.add_to(ret.data(), sparse.cols(), sparseScale);
+        return ret;
+    }
+
+    /* lhs + scale * rhs, merging the sorted segments of both operands */
+    template <typename T, SparseFormat F, typename I>
+    SparseMatrix<T, F, I> sparse_sum(const SparseMatrix<T, F, I>& lhs, const SparseMatrix<T, F, I>& rhs, T scale) {
+        if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols()) {
+            Utils::throw_invalid_argument_error("Matrix addition requires equal shapes, got %zux%zu and %zux%zu",
+                                                lhs.rows(), lhs.cols(), rhs.rows(), rhs.cols());
+        }
+
+        const I *lo = lhs.outer_index(), *li = lhs.inner_index(), *ro = rhs.outer_index(), *ri = rhs.inner_index();
+        const T *lv = lhs.values(), *rv = rhs.values();
+
+        std::vector<I> outer(lhs.outer_size() + 1, I(0)), inner;
+        std::vector<T> values;
+        inner.reserve(std::max(lhs.nonzeros(), rhs.nonzeros()));
+        values.reserve(inner.capacity());
+
+        for (size_t o = 0; o < lhs.outer_size(); ++o) {
+            size_t a = lo[o], b = ro[o];
+            while (a < lo[o + 1] || b < ro[o + 1]) {
+                if (b == ro[o + 1] || (a < lo[o + 1] && li[a] < ri[b])) {
+                    inner.push_back(li[a]);
+                    values.push_back(lv[a++]);
+                } else if (a == lo[o + 1] || ri[b] < li[a]) {
+                    inner.push_back(ri[b]);
+                    values.push_back(scale * rv[b++]);
+                } else {
+                    inner.push_back(li[a]);
+                    values.push_back(lv[a++] + scale * rv[b++]);
+                }
+            }
+            outer[o + 1] = static_cast<I>(inner.size());
+        }
+
+        return SparseMatrix<T, F, I>(lhs.rows(), lhs.cols(), std::move(outer), std::move(inner), std::move(values));
+    }
+} /* Detail */
+
+    /**
+     * Multiply a sparse matrix by a dense matrix or expression on the calling thread.
+     *
+     * @return The dense product.
+     * @throw std::invalid_argument if the inner dimensions do not match.
+     */
+    template <typename T, SparseFormat F, typename I, typename D, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> multiply(Execution::SequencedPolicy, const SparseMatrix<T, F, I>& lhs, const D& rhs) {
+        const Detail::DenseOperand<D> operand(rhs);
+        return Detail::sparse_times_dense<T, F, I>(nullptr, lhs, operand.ref);
+    }
+
+    /**
+     * Multiply a sparse matrix by a dense matrix or expression on a thread pool. CSR operands are split into
+     * row ranges holding equal numbers of nonzeros; CSC operands into column ranges of the dense operand.
+     *
+     * @return The dense product.
+     * @throw std::invalid_argument if the inner dimensions do not match.
+     */
+    template <typename T, SparseFormat F, typename I, typename D, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> multiply(Execution::ParallelPolicy policy, const SparseMatrix<T, F, I>& lhs, const D& rhs) {
+        const Detail::DenseOperand<D> operand(rhs);
+        return Detail::sparse_times_dense<T, F, I>(&policy.resolve(), lhs, operand.ref);
+    }
+
+    /**
+     * Multiply a dense matrix or expression by a sparse matrix on the calling thread.
+     */
+    template <typename D, typename T, SparseFormat F, typename I, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> multiply(Execution::SequencedPolicy, const D& lhs, const SparseMatrix<T, F, I>& rhs) {
+        const Detail::DenseOperand<D> operand(lhs);
+        return Detail::dense_times_sparse<T, F, I>(nullptr, operand.ref, rhs);
+    }
+
+    /**
+     * Multiply a dense matrix or expression by a sparse matrix, with the rows of the result split across a thread pool.
+     */
+    template <typename D, typename T, SparseFormat F, typename I, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> multiply(Execution::ParallelPolicy policy, const D& lhs, const SparseMatrix<T, F, I>& rhs) {
+        const Detail::DenseOperand<D> operand(lhs);
+        return Detail::dense_times_sparse<T, F, I>(&policy.resolve(), operand.ref, rhs);
+    }
+
+    /**
+     * @brief Sparse times dense on the calling thread. Equivalent to multiply(Execution::seq, lhs, rhs).
+     */
+    template <typename T, SparseFormat F, typename I, typename D, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator*(const SparseMatrix<T, F, I>& lhs, const D& rhs) {
+        return multiply(Execution::seq, lhs, rhs);
+    }
+
+    /**
+     * @brief Dense times sparse on the calling thread. Equivalent to multiply(Execution::seq, lhs, rhs).
+     */
+    template <typename D, typename T, SparseFormat F, typename I, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator*(const D& lhs, const SparseMatrix<T, F, I>& rhs) {
+        return multiply(Execution::seq, lhs, rhs);
+    }
+
+    /**
+     * @brief Sparse product of two sparse matrices of the same format.
+     * @throw std::invalid_argument if the inner dimensions do not match.
+     */
+    template <typename T, SparseFormat F, typename I>
+    SparseMatrix<T, F, I> operator*(const SparseMatrix<T, F, I>& lhs, const SparseMatrix<T, F, I>& rhs) {
+        Detail::check_product_shape(lhs.rows(), lhs.cols(), rhs.rows(), rhs.cols());
+
+        /* A CSC product is computed as the CSR product of the transposes, C^T = B^T A^T */
+        const SparseMatrix<T, F, I>& first = (F == SparseFormat::CSR) ? lhs : rhs;
+        const SparseMatrix<T, F, I>& second = (F == SparseFormat::CSR) ? rhs : lhs;
+
+        std::vector<I> outer, inner;
+        std::vector<T> values;
+        Kernels::csr_times_csr<T, I>(first.outer_size(), second.inner_size(),
+                                     first.outer_index(), first.inner_index(), first.values(),
+                                     second.outer_index(), second.inner_index(), second.values(), outer, inner, values);
+
+        return SparseMatrix<T, F, I>(lhs.rows(), rhs.cols(), std::move(outer), std::move(inner), std::move(values));
+    }
+
+    /**
+     * @brief Element-wise sum of two sparse matrices of the same format, as a sparse matrix.
+     * @throw std::invalid_argument if the shapes differ.
+     */
+    template <typename T, SparseFormat F, typename I>
+    SparseMatrix<T, F, I> operator+(const SparseMatrix<T, F, I>& lhs, const SparseMatrix<T, F, I>& rhs) {
+        return Detail::sparse_sum(lhs, rhs, T(1));
+    }
+
+    /**
+     * @brief Element-wise difference of two sparse matrices of the same format, as a sparse matrix.
+     * @throw std::invalid_argument if the shapes differ.
+     */
+    template <typename T, SparseFormat F, typename I>
+    SparseMatrix<T, F, I> operator-(const SparseMatrix<T, F, I>& lhs, const SparseMatrix<T, F, I>& rhs) {
+        return Detail::sparse_sum(lhs, rhs, T(-1));
+    }
+
+    /**
+     * @brief Sum of a sparse and a dense matrix or expression, as a dense matrix.
+     * @throw std::invalid_argument if the shapes differ.
+     */
+    template <typename T, SparseFormat F, typename I, typename D, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator+(const SparseMatrix<T, F, I>& lhs, const D& rhs) {
+        return Detail::sparse_dense_sum(lhs, rhs, T(1), T(1));
+    }
+
+    template <typename D, typename T, SparseFormat F, typename I, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator+(const D& lhs, const SparseMatrix<T, F, I>& rhs) {
+        return Detail::sparse_dense_sum(rhs, lhs, T(1), T(1));
+    }
+
+    /**
+     * @brief Difference of a sparse and a dense matrix or expression, as a dense matrix.
+     * @throw std::invalid_argument if the shapes differ.
+     */
+    template <typename T, SparseFormat F, typename I, typename D, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator-(const SparseMatrix<T, F, I>& lhs, const D& rhs) {
+        return Detail::sparse_dense_sum(lhs, rhs, T(1), T(-1));
+    }
+
+    template <typename D, typename T, SparseFormat F, typename I, Detail::enable_if_dense_operand<D> = 0>
+    DynMatrix<T> operator-(const D& lhs, const SparseMatrix<T, F, I>& rhs) {
+        return Detail::sparse_dense_sum(rhs, lhs, T(-1), T(1));
+    }
+
+    /**
+     * @brief Product of a sparse matrix and a scalar.
+     */
+    template <typename T, SparseFormat F, typename I, typename S, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type>
+    SparseMatrix<T, F, I> operator*(SparseMatrix<T, F, I> lhs, const S& scalar) {
+        return lhs *= scalar;
+    }
+
+    template <typename S, typename T, SparseFormat F, typename I, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type>
+    SparseMatrix<T, F, I> operator*(const S& scalar, SparseMatrix<T, F, I> rhs) {
+        return rhs *= scalar;
+    }
+
+    template <typename _Scalar, SparseFormat _Format, typename _StorageIndex>
+    std::string to_string(const SparseMatrix<_Scalar, _Format, _StorageIndex>& toPrint) {
+        return to_string(toPrint.to_dense());
+    }
+
+    template <typename _Scalar, SparseFormat _Format, typename _StorageIndex>
+    std::ostream& operator<<(std::ostream& os, const SparseMatrix<_Scalar, _Format, _StorageIndex>& toPrint) {
+        return os << toPrint.to_dense();
+    }
+} /* MatrixLib */
+
+#endif /* SPARSEMATRIX_H */
@@ -0,0 +1,1003 @@
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "decomposition.hpp"
+#include "parallel.hpp"
+#include "transpose.h"
+
+/* Columns of the rotation targets that are updated together; a slice of two rows of doubles fits in L1 */
+#ifndef MATRIXLIB_ROTATION_BLOCK
+#define MATRIXLIB_ROTATION_BLOCK 512
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+namespace Detail {
+    /*
+     * Workspace of one call, from the calling thread's ScratchArena. A thread waiting on the pool runs other
+     * tasks, possibly another solve, so workspaces must not be shared between calls on the same thread.
+     */
+    template <typename T>
+    using SpectralWork = std::vector<T, ScratchAllocator<T>>;
+
+    /* GEMM on the pool when there is one */
+    template <typename T>
+    void gemm_on(ThreadPool* pool, size_t m, size_t n, size_t k, T alpha, const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                 const T* b, ptrdiff_t rsb, ptrdiff_t csb, T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+        if (pool) {
+            gemm_parallel<T>(*pool, m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+        } else {
+            gemm<T>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+        }
+    }
+
+    /* (x, y) = (c x - s y, s x + c y) over n contiguous elements */
+    template <typename T>
+    void rotate(size_t n, T* x, T* y, T c, T s) {
+        MATRIXLIB_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            const T xi = x[i], yi = y[i];
+            x[i] = c * xi - s * yi;
+            y[i] = s * xi + c * yi;
+        }
+    }
+
+    /*
+     * Applies the rotations of one implicit QL sweep to rows first .. first + count of z, rotation i mixing rows
+     * first + i and first + i + 1, last rotation first. Columns are taken in slices so that the rows stay in
+     * cache for the whole sweep, and the slices are independent, so they are split across the pool.
+     */
+    template <typename T>
+    void apply_rotations(ThreadPool* pool, size_t first, size_t count, const T* c, const T* s, T* z, ptrdiff_t ldz, size_t cols) {
+        const size_t block = MATRIXLIB_ROTATION_BLOCK;
+        const size_t slices = (cols + block - 1) / block;
+
+        auto slice = [=](size_t b) {
+            const size_t j0 = b * block, nj = std::min(block, cols - j0);
+            for (size_t i = count; i-- > 0;) {
+                rotate(nj, z + (first + i) * ldz + j0, z + (first + i + 1) * ldz + j0, c[i], s[i]);
+            }
+        };
+
+        if (pool && slices > 1 && count * cols >= static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD) / 8) {
+            pool->parallel_for(slices, slice);
+        } else {
+            for (size_t b = 0; b < slices; ++b) slice(b);
+        }
+    }
+
+    /* y = A x for a symmetric n x n A of which only the upper triangle is read, in one pass over its rows */
+    template <typename T>
+    void symv_upper(size_t n, const T* a, ptrdiff_t lda, const T* x, T* y) {
+        std::fill_n(y, n, T(0));
+        for (size_t i = 0; i < n; ++i) {
+            const T* row = a + i * lda + i;
+            y[i] += dot_product(row, x + i, n - i);
+            if (i + 1 < n) axpy_inplace(y + i + 1, x[i], row + 1, n - i - 1);
+        }
+    }
+
+    /*
+     * Householder vector of x (length n): afterwards x = (1, v(1 .. n)), so that (I - tau v v^T) x_before =
+     * beta e_1. Returns beta; tau is zero when x is already a multiple of e_1.
+     */
+    template <typename T>
+    T householder(size_t n, T* x, T& tau) {
+        const T alpha = x[0];
+
+        T maxAbs = std::abs(alpha);
+        for (size_t i = 1; i < n; ++i) maxAbs = std::max(maxAbs, std::abs(x[i]));
+
+        T tail = 0;
+        if (maxAbs > T(0)) {
+            for (size_t i = 1; i < n; ++i) {
+                const T v = x[i] / maxAbs;
+                tail += v * v;
+            }
+        }
+
+        x[0] = T(1);
+        if (tail == T(0)) {
+            tau = T(0);
+            return alpha;
+        }
+
+        const T scaledAlpha = alpha / maxAbs;
+        const T norm = maxAbs * std::sqrt(scaledAlpha * scaledAlpha + tail);
+        const T beta = alpha >= T(0) ? -norm : norm;
+        tau = (beta - alpha) / beta;
+        scale_inplace(x + 1, T(1) / (alpha - beta), n - 1);
+        return beta;
+    }
+} /* Detail */
+
+    /**
+     * Reduces the symmetric row-major n x n matrix a to tridiagonal form T = Q^T A Q, reading and overwriting
+     * the upper triangle only. The diagonal of T goes to d and its off-diagonal to e (e[n - 1] is zero).
+     * Reflector j is H_j = I - tau[j] v v^T with v(0 .. j) zero, and v(j + 1 .. n) stored in row j from column
+     * j + 1, the leading one included; Q = H_0 H_1 ... H_{n-2}.
+     *
+     * Reflectors are formed MATRIXLIB_FACTOR_BLOCK at a time as in LAPACK's sytrd: within a panel the trailing
+     * matrix is only updated on the fly where it is read, and once per panel by a rank-2k update made of GEMMs.
+     * The other half of the work, one symmetric matrix-vector product per reflector, streams the trailing
+     * matrix through the SIMD dot and axpy kernels.
+     */
+    template <typename T>
+    void sytrd(size_t n, T* a, ptrdiff_t lda, T* d, T* e, T* tau, ThreadPool* pool = nullptr) {
+        if (n == 0) return;
+
+        const size_t nbMax = MATRIXLIB_FACTOR_BLOCK;
+        Detail::SpectralWork<T> panels, vec;
+
+        for (size_t j0 = 0; j0 + 1 < n; j0 += nbMax) {
+            const size_t jb = std::min(nbMax, n - 1 - j0);
+            const size_t rows = n - j0;
+
+            /* V and W hold the panel's reflectors and their update vectors, row r - j0 for matrix row r */
+            panels.assign(2 * rows * jb, T(0));
+            vec.resize(2 * jb + n);
+            T* v = panels.data();
+            T* w = v + rows * jb;
+            T* t = vec.data();
+            T* y = t + 2 * jb;
+
+            for (size_t p = 0; p < jb; ++p) {
+                const size_t j = j0 + p;
+                T* row = a + j * lda;
+                const size_t len = n - j - 1;
+
+                /* Row j of A - V W^T - W V^T over the panel's earlier reflectors */
+                if (p > 0) {
+                    gemv<T>(n - j, p, T(-1), w + (j - j0) * jb, jb, 1, v + (j - j0) * jb, 1, T(1), row + j, 1);
+                    gemv<T>(n - j, p, T(-1), v + (j - j0) * jb, jb, 1, w + (j - j0) * jb, 1, T(1), row + j, 1);
+                }
+
+                d[j] = row[j];
+                e[j] = Detail::householder(len, row + j + 1, tau[j]);
+
+                T* vj = v + (j + 1 - j0) * jb + p;
+                for (size_t r = 0; r < len; ++r) vj[r * jb] = row[j + 1 + r];
+                if (tau[j] == T(0)) continue;
+
+                /* w = tau (A - V W^T - W V^T) v, then w -= (tau / 2)(w . v) v */
+                const T* x = row + j + 1;
+                Detail::symv_upper(len, a + (j + 1) * lda + j + 1, lda, x, y);
+                if (p > 0) {
+                    const T* vTrail = v + (j + 1 - j0) * jb;
+                    const T* wTrail = w + (j + 1 - j0) * jb;
+                    gemv<T>(p, len, T(1), wTrail, 1, jb, x, 1, T(0), t, 1);
+                    gemv<T>(p, len, T(1), vTrail, 1, jb, x, 1, T(0), t + jb, 1);
+                    gemv<T>(len, p, T(-1), vTrail, jb, 1, t, 1, T(1), y, 1);
+                    gemv<T>(len, p, T(-1), wTrail, jb, 1, t + jb, 1, T(1), y, 1);
+                }
+
+                scale_inplace(y, tau[j], len);
+                axpy_inplace(y, -tau[j] / T(2) * dot_product(y, x, len), x, len);
+
+                T* wj = w + (j + 1 - j0) * jb + p;
+                for (size_t r = 0; r < len; ++r) wj[r * jb] = y[r];
+            }
+
+            /* Trailing update A22 -= V W^T + W V^T, a block row of the upper triangle at a time */
+            const size_t k1 = j0 + jb;
+            for (size_t r0 = k1; r0 < n; r0 += nbMax) {
+                const size_t rb = std::min(nbMax, n - r0);
+                const T* vr = v + (r0 - j0) * jb;
+                const T* wr = w + (r0 - j0) * jb;
+                T* c = a + r0 * lda + r0;
+                Detail::gemm_on<T>(pool, rb, n - r0, jb, T(-1), vr, jb, 1, wr, 1, jb, T(1), c, lda, 1);
+                Detail::gemm_on<T>(pool, rb, n - r0, jb, T(-1), wr, jb, 1, vr, 1, jb, T(1), c, lda, 1);
+            }
+        }
+
+        d[n - 1] = a[(n - 1) * lda + n - 1];
+        e[n - 1] = T(0);
+    }
+
+    /**
+     * Multiplies the row-major n x ncols matrix z in place by the Q of sytrd. Reflectors are applied
+     * MATRIXLIB_FACTOR_BLOCK at a time in the compact WY form I - V T V^T, so the work is three GEMMs per block.
+     */
+    template <typename T>
+    void ormtr(size_t n, const T* a, ptrdiff_t lda, const T* tau, size_t ncols, T* z, ptrdiff_t ldz, ThreadPool* pool = nullptr) {
+        if (n < 2) return;
+
+        const size_t nbMax = MATRIXLIB_FACTOR_BLOCK;
+        const size_t count = n - 1;
+        Detail::SpectralWork<T> work;
+
+        for (size_t end = count; end > 0;) {
+            const size_t j0 = end > nbMax ? end - nbMax : 0;
+            const size_t b = end - j0;
+            const size_t len = n - j0 - 1;
+            end = j0;
+
+            work.assign(b * len + b * b + b * ncols, T(0));
+            T* vt = work.data();
+            T* t = vt + b * len;
+            T* w = t + b * b;
+
+            /* Row q of V^T is reflector j0 + q over rows j0 + 1 .. n */
+            for (size_t q = 0; q < b; ++q) {
+                const T* src = a + (j0 + q) * lda + j0 + q + 1;
+                std::copy(src, src + (len - q), vt + q * len + q);
+            }
+
+            /* T upper triangular with T(0:i, i) = -tau_i T(0:i, 0:i) V(:, 0:i)^T v_i */
+            for (size_t i = 0; i < b; ++i) {
+                const T ti = tau[j0 + i];
+                t[i * b + i] = ti;
+                for (size_t k = 0; k < i; ++k) t[k * b + i] = -ti * dot_product(vt + k * len + i, vt + i * len + i, len - i);
+                for (size_t k = 0; k < i; ++k) {
+                    T s(0);
+                    for (size_t l = k; l < i; ++l) s += t[k * b + l] * t[l * b + i];
+                    t[k * b + i] = s;
+                }
+            }
+
+            /* Z -= V (T (V^T Z)) over rows j0 + 1 .. n of Z */
+            T* zs = z + (j0 + 1) * ldz;
+            Detail::gemm_on<T>(pool, b, ncols, len, T(1), vt, len, 1, zs, ldz, 1, T(0), w, ncols, 1);
+            for (size_t i = 0; i < b; ++i) {
+                T* wi = w + i * ncols;
+                scale_inplace(wi, t[i * b + i], ncols);
+                for (size_t k = i + 1; k < b; ++k) axpy_inplace(wi, t[i * b + k], w + k * ncols, ncols);
+            }
+            Detail::gemm_on<T>(pool, len, ncols, b, T(-1), vt, 1, len, w, ncols, 1, T(1), zs, ldz, 1);
+        }
+    }
+
+    /**
+     * Eigenvalues of the symmetric tridiagonal matrix with diagonal d and off-diagonal e (e[n - 1] unused) by
+     * implicit QL iteration with Wilkinson shifts. d receives the eigenvalues in ascending order and e is
+     * destroyed. If zt is not null, its rows 0 .. n (each of length ncols) are rotated along, so that when they
+     * start as the rows of Q^T they end as the eigenvectors, row i belonging to d[i].
+     *
+     * @return False if an eigenvalue did not converge within 30 iterations.
+     */
+    template <typename T>
+    bool tridiagonal_ql(size_t n, T* d, T* e, T* zt, ptrdiff_t ldz, size_t ncols, ThreadPool* pool = nullptr) {
+        if (n == 0) return true;
+
+        const T eps = std::numeric_limits<T>::epsilon();
+        Detail::SpectralWork<T> rotations(2 * n);
+        T* cs = rotations.data();
+        T* sn = cs + n;
+
+        bool converged = true;
+        e[n - 1] = T(0);
+        T f(0), tst1(0);
+
+        for (size_t l = 0; l < n; ++l) {
+            tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+            size_t m = l;
+            while (m + 1 < n && !(std::abs(e[m]) <= eps * tst1)) ++m;
+
+            if (m > l) {
+                for (int iter = 0; !(std::abs(e[l]) <= eps * tst1); ++iter) {
+                    if (iter == 30) {
+                        converged = false;
+                        break;
+                    }
+
+                    /* Wilkinson shift from the leading 2 x 2 block */
+                    T g = d[l];
+                    T p = (d[l + 1] - g) / (T(2) * e[l]);
+                    T r = std::hypot(p, T(1));
+                    if (p < T(0)) r = -r;
+                    d[l] = e[l] / (p + r);
+                    d[l + 1] = e[l] * (p + r);
+                    const T dl1 = d[l + 1];
+                    T h = g - d[l];
+                    for (size_t i = l + 2; i < n; ++i) d[i] -= h;
+                    f += h;
+
+                    /* Chase the bulge from m back up to l */
+                    p = d[m];
+                    T c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                    const T el1 = e[l + 1];
+                    for (size_t i = m; i-- > l;) {
+                        c3 = c2;
+                        c2 = c;
+                        s2 = s;
+                        g = c * e[i];
+                        h = c * p;
+                        r = std::hypot(p, e[i]);
+                        e[i + 1] = s * r;
+                        s = e[i] / r;
+                        c = p / r;
+                        p = c * d[i] - s * g;
+                        d[i + 1] = h + s * (c * g + s * d[i]);
+
+                        /* Rows i and i + 1 become (c z_i - s z_i+1, s z_i + c z_i+1) */
+                        cs[i - l] = c;
+                        sn[i - l] = s;
+                    }
+
+                    p = -s * s2 * c3 * el1 * e[l] / dl1;
+                    e[l] = s * p;
+                    d[l] = c * p;
+
+                    if (zt) Detail::apply_rotations(pool, l, m - l, cs, sn, zt, ldz, ncols);
+                }
+            }
+
+            d[l] += f;
+            e[l] = T(0);
+        }
+
+        /* Selection sort, so that every eigenvector row moves at most once */
+        for (size_t i = 0; i + 1 < n; ++i) {
+            const size_t k = static_cast<size_t>(std::min_element(d + i, d + n) - d);
+            if (k == i) continue;
+            std::swap(d[i], d[k]);
+            if (zt) std::swap_ranges(zt + i * ldz, zt + i * ldz + ncols, zt + k * ldz);
+        }
+
+        return converged;
+    }
+
+    /**
+     * One-sided Jacobi SVD of the n x m matrix whose rows g (row stride ldg) are the columns of the matrix to
+     * decompose. Pairs of rows are rotated until they are orthogonal to `tolerance` relative to their norms;
+     * the rotations are accumulated into the rows of vt (n x n, may be null), which should start as the
+     * identity. The rows then hold sigma_i u_i and vt holds v_i^T.
+     *
+     * Pairs are visited in round-robin order: each round is n / 2 disjoint pairs, which run across the pool
+     * when there is one. The order does not depend on the pool, so neither do the results.
+     *
+     * @return The number of sweeps taken, or 0 if the rows were not orthogonal after max_sweeps.
+     */
+    template <typename T>
+    size_t jacobi_svd(size_t n, size_t m, T* g, ptrdiff_t ldg, T* vt, ptrdiff_t ldv, T tolerance, size_t maxSweeps,
+                      ThreadPool* pool = nullptr) {
+        if (n < 2) return 1;
+
+        /* Round-robin over an even number of players; player n, if any, sits the round out */
+        const size_t players = n + (n & 1);
+        std::vector<size_t> order(players);
+        std::iota(order.begin(), order.end(), size_t(0));
+
+        auto rotate_pair = [=](size_t i, size_t j) {
+            T* gi = g + i * ldg;
+            T* gj = g + j * ldg;
+            const T alpha = dot_product(gi, gi, m);
+            const T beta = dot_product(gj, gj, m);
+            const T gamma = dot_product(gi, gj, m);
+            if (!(std::abs(gamma) > tolerance * std::sqrt(alpha) * std::sqrt(beta))) return false;
+
+            const T zeta = (beta - alpha) / (T(2) * gamma);
+            const T t = std::copysign(T(1), zeta) / (std::abs(zeta) + std::sqrt(T(1) + zeta * zeta));
+            const T c = T(1) / std::sqrt(T(1) + t * t);
+            const T s = c * t;
+            Detail::rotate(m, gi, gj, c, s);
+            if (vt) Detail::rotate(n, vt + i * ldv, vt + j * ldv, c, s);
+            return true;
+        };
+
+        const bool parallel = pool && pool->thread_count() > 1 && n * m >= static_cast<size_t>(MATRIXLIB_PARALLEL_VECTOR_THRESHOLD) / 4;
+
+        for (size_t sweep = 1; sweep <= maxSweeps; ++sweep) {
+            std::atomic<size_t> rotations{0};
+
+            for (size_t round = 0; round + 1 < players; ++round) {
+                auto pair = [&](size_t q) {
+                    const size_t i = std::min(order[q], order[players - 1 - q]);
+                    const size_t j = std::max(order[q], order[players - 1 - q]);
+                    if (j < n && rotate_pair(i, j)) rotations.fetch_add(1, std::memory_order_relaxed);
+                };
+
+                if (parallel) {
+                    pool->parallel_for(players / 2, pair);
+                } else {
+                    for (size_t q = 0; q < players / 2; ++q) pair(q);
+                }
+
+                std::rotate(order.begin() + 1, order.end() - 1, order.end());
+            }
+
+            if (rotations.load(std::memory_order_relaxed) == 0) return sweep;
+        }
+
+        return 0;
+    }
+} /* Kernels */
+
+namespace Detail {
+    /* Deterministic start vector with no special structure, entries in [-1, 1) */
+    template <typename T>
+    void start_vector(T* x, size_t n, uint64_t seed) {
+        uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+        for (size_t i = 0; i < n; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            x[i] = static_cast<T>(static_cast<double>(state >> 11) * 0x1.0p-52 - 1.0);
+        }
+    }
+} /* Detail */
+
+    /**
+     * @brief Eigenvalues and eigenvectors of a symmetric Matrix or DynMatrix, A = V diag(lambda) V^T.
+     *
+     * A is reduced to tridiagonal form by blocked Householder reflections, whose trailing updates are GEMMs. The
+     * tridiagonal matrix is diagonalised by implicit QL iteration, whose rotations are applied to the
+     * eigenvectors a cache-sized slice of columns at a time; the reflectors are then applied in blocks through
+     * GEMM. With Execution::par the GEMMs and the rotations are split across the thread pool. Only the upper
+     * triangle of A is read.
+     *
+     * @tparam _MatrixType The matrix type being decomposed, e.g. Matrix<double, 3, 3> or DynMatrix<float>.
+     */
+    template <typename _MatrixType>
+    class SymmetricEigen {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static_assert(Detail::extents_compatible(Traits::row_extent, Traits::col_extent), "SymmetricEigen requires a square matrix");
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+        /**
+         * @brief Type of the vector of eigenvalues.
+         */
+        using VectorType = Detail::plain_matrix_t<Scalar, Detail::merge_extents(Traits::row_extent, Traits::col_extent), 1, Traits::is_dynamic>;
+
+    private:
+        VectorType values_;
+        _MatrixType vectors_;
+        size_t n_ = 0;
+        bool hasVectors_ = false;
+        bool converged_ = true;
+
+    public:
+        SymmetricEigen() = default;
+
+        /**
+         * @brief Decomposes a; eigenvectors are skipped when computeVectors is false.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        explicit SymmetricEigen(const _MatrixType& a, bool computeVectors = true) { compute(Execution::seq, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a under an execution policy.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        SymmetricEigen(Policy policy, const _MatrixType& a, bool computeVectors = true) { compute(policy, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a, reusing the storage of the previous decomposition.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        SymmetricEigen& compute(const _MatrixType& a, bool computeVectors = true) { return compute(Execution::seq, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a under an execution policy, reusing the storage of the previous decomposition.
+         * @throw std::invalid_argument if a runtime-sized a is not square.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        SymmetricEigen& compute(Policy policy, const _MatrixType& a, bool computeVectors = true) {
+            n_ = Traits::rows(a);
+            if (Traits::cols(a) != n_) {
+                Utils::throw_invalid_argument_error("SymmetricEigen requires a square matrix, got %zux%zu", n_, Traits::cols(a));
+            }
+
+            ThreadPool* pool = Detail::policy_pool(policy);
+            Detail::OperandTraits<VectorType>::resize(values_, n_, 1);
+            Scalar* d = Detail::OperandTraits<VectorType>::data(values_);
+
+            /* The reduced matrix and its reflectors, then e, tau and the eigenvectors as rows */
+            Kernels::Detail::SpectralWork<Scalar> work(2 * n_ * n_ + 2 * n_);
+            Scalar* reduced = work.data();
+            Scalar* e = reduced + n_ * n_;
+            Scalar* tau = e + n_;
+            Scalar* zt = tau + n_;
+            std::copy(Traits::ref(a).data, Traits::ref(a).data + n_ * n_, reduced);
+
+            Kernels::sytrd<Scalar>(n_, reduced, n_, d, e, tau, pool);
+
+            hasVectors_ = computeVectors;
+            if (!computeVectors) {
+                converged_ = Kernels::tridiagonal_ql<Scalar>(n_, d, e, nullptr, 0, 0);
+                return *this;
+            }
+
+            std::fill(zt, zt + n_ * n_, Scalar(0));
+            for (size_t i = 0; i < n_; ++i) zt[i * n_ + i] = Scalar(1);
+            converged_ = Kernels::tridiagonal_ql<Scalar>(n_, d, e, zt, n_, n_, pool);
+
+            Traits::resize(vectors_, n_, n_);
+            Scalar* v = Traits::data(vectors_);
+            Kernels::transpose<Scalar>(n_, n_, zt, n_, 1, v, n_);
+            Kernels::ormtr<Scalar>(n_, reduced, n_, tau, n_, v, n_, pool);
+            return *this;
+        }
+
+        /**
+         * @return The dimension of the decomposed matrix.
+         */
+        size_t rows() const noexcept { return n_; }
+
+        /**
+         * @return False if the QL iteration gave up on an eigenvalue, which only happens for matrices with
+         * non-finite entries.
+         */
+        bool converged() const noexcept { return converged_; }
+
+        /**
+         * @return The eigenvalues in ascending order.
+         */
+        const VectorType& eigenvalues() const noexcept { return values_; }
+
+        /**
+         * @return The orthonormal eigenvectors as columns, column i belonging to eigenvalue i.
+         * @throw std::runtime_error if the eigenvectors were not computed.
+         */
+        const _MatrixType& eigenvectors() const {
+            if (!hasVectors_) Utils::throw_runtime_error("Eigenvectors were not computed");
+            return vectors_;
+        }
+    };
+
+    /**
+     * @brief Thin singular value decomposition A = U diag(sigma) V^T of any Matrix or DynMatrix, by one-sided
+     * Jacobi rotations.
+     *
+     * With k = min(m, n), U is m x k and V is n x k, both with orthonormal columns. A tall A is first reduced to
+     * its square R factor by Householder QR, and a wide A is decomposed through its transpose, so the
+     * rotations always work on k x k data. Jacobi SVD computes small singular values to high relative accuracy.
+     * With Execution::par each round of disjoint rotations is split across the thread pool, with results
+     * identical to the sequential ones.
+     *
+     * @tparam _MatrixType The matrix type being decomposed.
+     */
+    template <typename _MatrixType>
+    class SVD {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static constexpr size_t diag_extent = (Traits::row_extent == Dynamic || Traits::col_extent == Dynamic)
+                                                  ? Dynamic : std::min(Traits::row_extent, Traits::col_extent);
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+        /**
+         * @brief Types of the singular values and of the factors U and V.
+         */
+        using VectorType = Detail::plain_matrix_t<Scalar, diag_extent, 1, Traits::is_dynamic>;
+        using UType = Detail::plain_matrix_t<Scalar, Traits::row_extent, diag_extent, Traits::is_dynamic>;
+        using VType = Detail::plain_matrix_t<Scalar, Traits::col_extent, diag_extent, Traits::is_dynamic>;
+
+    private:
+        VectorType values_;
+        UType u_;
+        VType v_;
+        size_t m_ = 0;
+        size_t n_ = 0;
+        size_t sweeps_ = 0;
+        bool hasVectors_ = false;
+
+    public:
+        SVD() = default;
+
+        /**
+         * @brief Decomposes a; U and V are skipped when computeVectors is false.
+         */
+        explicit SVD(const _MatrixType& a, bool computeVectors = true) { compute(Execution::seq, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a under an execution policy.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        SVD(Policy policy, const _MatrixType& a, bool computeVectors = true) { compute(policy, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a, reusing the storage of the previous decomposition.
+         */
+        SVD& compute(const _MatrixType& a, bool computeVectors = true) { return compute(Execution::seq, a, computeVectors); }
+
+        /**
+         * @brief Decomposes a under an execution policy, reusing the storage of the previous decomposition.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        SVD& compute(Policy policy, const _MatrixType& a, bool computeVectors = true) {
+            ThreadPool* pool = Detail::policy_pool(policy);
+            m_ = Traits::rows(a);
+            n_ = Traits::cols(a);
+            hasVectors_ = computeVectors;
+
+            /* B is A or A^T, whichever has at least as many rows as columns: rows x k */
+            const bool wide = m_ < n_;
+            const size_t rows = std::max(m_, n_), k = std::min(m_, n_);
+            const Scalar* src = Traits::ref(a).data;
+
+            Kernels::Detail::SpectralWork<Scalar> work(rows * k + 2 * k * k + 2 * k);
+            Scalar* b = work.data();
+            Scalar* g = b + rows * k;
+            Scalar* vt = g + k * k;
+            Scalar* tau = vt + k * k;
+            Scalar* scratch = tau + k;
+
+            if (wide) {
+                Kernels::transpose<Scalar>(m_, n_, src, n_, 1, b, k);
+            } else {
+                std::copy(src, src + m_ * n_, b);
+            }
+
+            /* The rows of g are the columns of the square matrix being rotated, R or B itself */
+            const bool reduce = rows > k;
+            if (reduce) {
+                Kernels::qr_factor<Scalar>(rows, k, b, k, tau, scratch);
+                std::fill(g, g + k * k, Scalar(0));
+                for (size_t i = 0; i < k; ++i) {
+                    for (size_t j = i; j < k; ++j) g[j * k + i] = b[i * k + j];
+                }
+            } else {
+                Kernels::transpose<Scalar>(k, k, b, k, 1, g, k);
+            }
+
+            if (computeVectors) {
+                std::fill(vt, vt + k * k, Scalar(0));
+                for (size_t i = 0; i < k; ++i) vt[i * k + i] = Scalar(1);
+            }
+
+            const Scalar tolerance = std::numeric_limits<Scalar>::epsilon() * static_cast<Scalar>(std::max<size_t>(k, 4));
+            sweeps_ = Kernels::jacobi_svd<Scalar>(k, k, g, k, computeVectors ? vt : nullptr, k, tolerance, 60, pool);
+
+            /* sigma_i = |g_i|, in descending order */
+            Detail::OperandTraits<VectorType>::resize(values_, k, 1);
+            Scalar* sigma = Detail::OperandTraits<VectorType>::data(values_);
+            std::vector<size_t> order(k);
+            for (size_t i = 0; i < k; ++i) sigma[i] = std::sqrt(Kernels::dot_product(g + i * k, g + i * k, k));
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::stable_sort(order.begin(), order.end(), [sigma](size_t x, size_t y) { return sigma[x] > sigma[y]; });
+
+            std::vector<Scalar> sorted(k);
+            for (size_t i = 0; i < k; ++i) sorted[i] = sigma[order[i]];
+            std::copy(sorted.begin(), sorted.end(), sigma);
+            if (!computeVectors) return *this;
+
+            /* Left vectors of the square problem as the columns of a rows x k matrix, right vectors as k x k */
+            std::vector<Scalar> left(rows * k, Scalar(0)), right(k * k);
+            for (size_t c = 0; c < k; ++c) {
+                const Scalar* gi = g + order[c] * k;
+                const Scalar inv = sigma[c] > Scalar(0) ? Scalar(1) / sigma[c] : Scalar(0);
+                for (size_t r = 0; r < k; ++r) left[r * k + c] = gi[r] * inv;
+                for (size_t r = 0; r < k; ++r) right[r * k + c] = vt[order[c] * k + r];
+            }
+            complete_basis(left.data(), k, k, sigma);
+
+            if (reduce) Kernels::qr_apply<Scalar>(false, rows, k, b, k, tau, k, left.data(), k, scratch);
+
+            assign_factor(u_, v_, wide, left, right, rows, k);
+            return *this;
+        }
+
+        /**
+         * @return The number of rows of the decomposed matrix.
+         */
+        size_t rows() const noexcept { return m_; }
+
+        /**
+         * @return The number of columns of the decomposed matrix.
+         */
+        size_t cols() const noexcept { return n_; }
+
+        /**
+         * @return False if the Jacobi rotations had not converged after 60 sweeps.
+         */
+        bool converged() const noexcept { return sweeps_ != 0; }
+
+        /**
+         * @return The sweeps over all column pairs the rotations took.
+         */
+        size_t sweeps() const noexcept { return sweeps_; }
+
+        /**
+         * @return The min(m, n) singular values in descending order.
+         */
+        const VectorType& singular_values() const noexcept { return values_; }
+
+        /**
+         * @return The number of singular values above tolerance, by default max(m, n) eps sigma_max.
+         */
+        size_t rank(Scalar tolerance = Scalar(-1)) const {
+            const size_t k = std::min(m_, n_);
+            if (k == 0) return 0;
+
+            const Scalar* sigma = Detail::OperandTraits<VectorType>::ref(values_).data;
+            if (tolerance < Scalar(0)) tolerance = static_cast<Scalar>(std::max(m_, n_)) * std::numeric_limits<Scalar>::epsilon() * sigma[0];
+            return static_cast<size_t>(std::count_if(sigma, sigma + k, [tolerance](Scalar s) { return s > tolerance; }));
+        }
+
+        /**
+         * @return U, m x min(m, n) with orthonormal columns.
+         * @throw std::runtime_error if the singular vectors were not computed.
+         */
+        const UType& matrixU() const {
+            check_vectors();
+            return u_;
+        }
+
+        /**
+         * @return V, n x min(m, n) with orthonormal columns.
+         * @throw std::runtime_error if the singular vectors were not computed.
+         */
+        const VType& matrixV() const {
+            check_vectors();
+            return v_;
+        }
+
+    private:
+        void check_vectors() const {
+            if (!hasVectors_) Utils::throw_runtime_error("Singular vectors were not computed");
+        }
+
+        /* Replaces the columns of zero singular values by unit vectors orthogonalised against the others */
+        static void complete_basis(Scalar* q, size_t rows, size_t k, const Scalar* sigma) {
+            std::vector<Scalar> x(rows);
+            size_t candidate = 0;
+
+            for (size_t c = 0; c < k; ++c) {
+                if (sigma[c] > Scalar(0)) continue;
+
+                for (; candidate < rows; ++candidate) {
+                    std::fill(x.begin(), x.end(), Scalar(0));
+                    x[candidate] = Scalar(1);
+
+                    for (int pass = 0; pass < 2; ++pass) {
+                        for (size_t o = 0; o < k; ++o) {
+                            if (o == c || (sigma[o] == Scalar(0) && o > c)) continue;
+                            Scalar s(0);
+                            for (size_t r = 0; r < rows; ++r) s += q[r * k + o] * x[r];
+                            for (size_t r = 0; r < rows; ++r) x[r] -= s * q[r * k + o];
+                        }
+                    }
+
+                    const Scalar norm = std::sqrt(Kernels::dot_product(x.data(), x.data(), rows));
+                    if (norm > Scalar(0.5)) {
+                        for (size_t r = 0; r < rows; ++r) q[r * k + c] = x[r] / norm;
+                        ++candidate;
+                        break;
+                    }
+                }
+            }
+        }
+
+        /* U and V from the factors of B, swapped when B is A^T */
+        static void assign_factor(UType& u, VType& v, bool wide, const std::vector<Scalar>& left,
+                                  const std::vector<Scalar>& right, size_t rows, size_t k) {
+            using UT = Detail::OperandTraits<UType>;
+            using VT = Detail::OperandTraits<VType>;
+
+            if (wide) {
+                UT::resize(u, k, k);
+                VT::resize(v, rows, k);
+                std::copy(right.begin(), right.end(), UT::data(u));
+                std::copy(left.begin(), left.end(), VT::data(v));
+            } else {
+                UT::resize(u, rows, k);
+                VT::resize(v, k, k);
+                std::copy(left.begin(), left.end(), UT::data(u));
+                std::copy(right.begin(), right.end(), VT::data(v));
+            }
+        }
+    };
+
+    /**
+     * @brief The k algebraically largest eigenvalues of a symmetric Matrix or DynMatrix, and their eigenvectors,
+     * by Lanczos iteration with full reorthogonalisation.
+     *
+     * Only products of A with a vector are needed, and the Krylov basis grows only until the k Ritz pairs have
+     * residuals below tolerance |lambda|, so for k much smaller than n this costs a small multiple of k
+     * matrix-vector products instead of a full decomposition. For a covariance matrix the largest eigenvalues
+     * are the leading principal components. With Execution::par the matrix-vector products and the
+     * reorthogonalisation are split across the thread pool.
+     *
+     * @tparam _MatrixType The matrix type being decomposed.
+     */
+    template <typename _MatrixType>
+    class LanczosEigen {
+        using Traits = Detail::FactorTraits<_MatrixType>;
+        static_assert(Detail::extents_compatible(Traits::row_extent, Traits::col_extent), "LanczosEigen requires a square matrix");
+
+    public:
+        using Scalar = typename Traits::Scalar;
+
+        /**
+         * @brief Types of the eigenvalues and of the n x k eigenvector matrix.
+         */
+        using VectorType = DynMatrix<Scalar, Dynamic, 1>;
+        using MatrixType = DynMatrix<Scalar>;
+
+    private:
+        VectorType values_;
+        MatrixType vectors_;
+        size_t n_ = 0;
+        size_t steps_ = 0;
+        bool converged_ = false;
+
+    public:
+        LanczosEigen() = default;
+
+        /**
+         * @brief Computes the k largest eigenpairs of a.
+         * @param tolerance Bound on the residual |A x - lambda x| relative to |lambda|; the default is sqrt(eps).
+         * @throw std::invalid_argument if a is not square or k exceeds its dimension.
+         */
+        LanczosEigen(const _MatrixType& a, size_t k, Scalar tolerance = Scalar(-1)) { compute(Execution::seq, a, k, tolerance); }
+
+        /**
+         * @brief Computes the k largest eigenpairs of a under an execution policy.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        LanczosEigen(Policy policy, const _MatrixType& a, size_t k, Scalar tolerance = Scalar(-1)) { compute(policy, a, k, tolerance); }
+
+        /**
+         * @brief Computes the k largest eigenpairs of a, reusing the storage of the previous computation.
+         */
+        LanczosEigen& compute(const _MatrixType& a, size_t k, Scalar tolerance = Scalar(-1)) { return compute(Execution::seq, a, k, tolerance); }
+
+        /**
+         * @brief Computes the k largest eigenpairs of a under an execution policy.
+         * @throw std::invalid_argument if a is not square or k exceeds its dimension.
+         */
+        template <typename Policy, typename = Detail::enable_if_policy<Policy>>
+        LanczosEigen& compute(Policy policy, const _MatrixType& a, size_t k, Scalar tolerance = Scalar(-1)) {
+            n_ = Traits::rows(a);
+            if (Traits::cols(a) != n_) {
+                Utils::throw_invalid_argument_error("LanczosEigen requires a square matrix, got %zux%zu", n_, Traits::cols(a));
+            }
+            if (k > n_) Utils::throw_invalid_argument_error("Cannot compute %zu eigenpairs of a %zux%zu matrix", k, n_, n_);
+            if (tolerance < Scalar(0)) tolerance = std::sqrt(std::numeric_limits<Scalar>::epsilon());
+
+            steps_ = 0;
+            converged_ = k == 0;
+            if (k == 0) {
+                values_.resize(0, 1);
+                vectors_.resize(n_, 0);
+                return *this;
+            }
+
+            const auto kernels = Detail::vector_kernels(policy);
+            const Scalar* am = Traits::ref(a).data;
+
+            /* The Lanczos vectors are the rows of q; alpha and beta form the tridiagonal T */
+            std::vector<Scalar> q, alpha, beta, d, e, zt, h(n_);
+            std::vector<Scalar> w(n_);
+            q.reserve(std::min(n_, 2 * k + 20) * n_);
+
+            const size_t checkEvery = std::max<size_t>(5, k / 2);
+            size_t restarts = 0;
+            Scalar normT(0);
+
+            q.resize(n_);
+            Detail::start_vector(q.data(), n_, 0);
+            normalise(q.data());
+
+            for (;;) {
+                const size_t j = steps_++;
+                const Scalar* qj = q.data() + j * n_;
+
+                /* w = A q_j - beta_j-1 q_j-1 - alpha_j q_j, then twice w -= Q (Q^T w) */
+                kernels.gemv(n_, n_, Scalar(1), am, static_cast<ptrdiff_t>(n_), 1, qj, 1, Scalar(0), w.data(), 1);
+                alpha.push_back(kernels.dot(n_, qj, 1, w.data(), 1));
+                for (int pass = 0; pass < 2; ++pass) {
+                    kernels.gemv(j + 1, n_, Scalar(1), q.data(), static_cast<ptrdiff_t>(n_), 1, w.data(), 1, Scalar(0), h.data(), 1);
+                    kernels.gemv(n_, j + 1, Scalar(-1), q.data(), 1, static_cast<ptrdiff_t>(n_), h.data(), 1, Scalar(1), w.data(), 1);
+                }
+
+                const Scalar b = std::sqrt(kernels.dot(n_, w.data(), 1, w.data(), 1));
+                beta.push_back(b);
+                const size_t m = j + 1;
+                const bool exhausted = m == n_;
+                normT = std::max(normT, std::abs(alpha[j]) + b + (j > 0 ? beta[j - 1] : Scalar(0)));
+
+                /*
+                 * An invariant subspace: continue from a fresh vector orthogonal to the basis, with beta = 0. A NaN
+                 * beta is not one, so that it reaches T and the QL iteration reports it.
+                 */
+                const bool invariant = b <= std::numeric_limits<Scalar>::epsilon() * normT;
+
+                if (exhausted || (!invariant && m >= k && (m - k) % checkEvery == 0)) {
+                    d.assign(alpha.begin(), alpha.end());
+                    e.assign(beta.begin(), beta.end());
+                    zt.assign(m * m, Scalar(0));
+                    for (size_t i = 0; i < m; ++i) zt[i * m + i] = Scalar(1);
+                    if (!Kernels::tridiagonal_ql<Scalar>(m, d.data(), e.data(), zt.data(), m, m)) {
+                        /* T has non-finite entries, so no more steps can help; keep what there is, unconverged */
+                        converged_ = false;
+                        finish(q.data(), d.data(), zt.data(), m, k, policy);
+                        break;
+                    }
+
+                    /* The residual of Ritz pair i is |beta_j| times the last entry of its eigenvector of T */
+                    converged_ = exhausted;
+                    if (m >= k && !exhausted) {
+                        converged_ = true;
+                        for (size_t i = m - k; i < m && converged_; ++i) {
+                            const Scalar residual = std::abs(b * zt[i * m + m - 1]);
+                            converged_ = residual <= tolerance * std::max(std::abs(d[i]), std::numeric_limits<Scalar>::min());
+                        }
+                    }
+
+                    if (converged_) {
+                        finish(q.data(), d.data(), zt.data(), m, k, policy);
+                        break;
+                    }
+                }
+
+                q.resize((m + 1) * n_);
+                Scalar* next = q.data() + m * n_;
+                if (invariant) {
+                    beta.back() = Scalar(0);
+                    Detail::start_vector(next, n_, ++restarts);
+                    for (int pass = 0; pass < 2; ++pass) {
+                        kernels.gemv(m, n_, Scalar(1), q.data(), static_cast<ptrdiff_t>(n_), 1, next, 1, Scalar(0), h.data(), 1);
+                        kernels.gemv(n_, m, Scalar(-1), q.data(), 1, static_cast<ptrdiff_t>(n_), h.data(), 1, Scalar(1), next, 1);
+                    }
+                    normalise(next);
+                } else {
+                    for (size_t i = 0; i < n_; ++i) next[i] = w[i] / b;
+                }
+            }
+
+            return *this;
+        }
+
+        /**
+         * @return The dimension of the decomposed matrix.
+         */
+        size_t rows() const noexcept { return n_; }
+
+        /**
+         * @return The size of the Krylov basis that was built, i.e. the number of products with A.
+         */
+        size_t iterations() const noexcept { return steps_; }
+
+        /**
+         * @return False if the QL iteration on the tridiagonal matrix gave up, which only happens for matrices
+         * with non-finite entries.
+         */
+        bool converged() const noexcept { return converged_; }
+
+        /**
+         * @return The k largest eigenvalues in descending order.
+         */
+        const VectorType& eigenvalues() const noexcept { return values_; }
+
+        /**
+         * @return The n x k matrix of orthonormal eigenvectors, column i belonging to eigenvalue i.
+         */
+        const MatrixType& eigenvectors() const noexcept { return vectors_; }
+
+    private:
+        void normalise(Scalar* x) const {
+            Kernels::scale_inplace(x, Scalar(1) / std::sqrt(Kernels::dot_product(x, x, n_)), n_);
+        }
+
+        /* Ritz values and vectors of the top k eigenpairs of T, largest first */
+        template <typename Policy>
+        void finish(const Scalar* q, const Scalar* d, const Scalar* zt, size_t m, size_t k, Policy policy) {
+            values_.resize(k, 1);
+            vectors_.resize(n_, k);
+
+            /* S holds the eigenvectors of T as columns, largest first; then X = Q^T S */
+            std::vector<Scalar> s(m * k);
+            for (size_t c = 0; c < k; ++c) {
+                const size_t i = m - 1 - c;
+                values_(c, 0) = d[i];
+                for (size_t r = 0; r < m; ++r) s[r * k + c] = zt[i * m + r];
+            }
+
+            Kernels::Detail::gemm_on<Scalar>(Detail::policy_pool(policy), n_, k, m, Scalar(1), q, 1, static_cast<ptrdiff_t>(n_),
+                                             s.data(), static_cast<ptrdiff_t>(k), 1, Scalar(0), vectors_.data(), static_cast<ptrdiff_t>(k), 1);
+        }
+    };
+} /* MatrixLib */
+
+#endif /* SPECTRAL_H */
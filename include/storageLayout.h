@@ -0,0 +1,80 @@
+#ifndef STORAGE_LAYOUT_H
+#define STORAGE_LAYOUT_H
+
+#include <cstddef>
+#include <algorithm>
+
+namespace MatrixLib {
+    /**
+     * @brief Order in which a Matrix lays out its elements: row by row, or column by column.
+     */
+    enum class StorageOrder {
+        RowMajor,
+        ColMajor
+    };
+
+    /**
+     * @brief Storage policy of a fixed-size Matrix, passed as its fourth template argument.
+     *
+     * The default is the packed row-major layout every other part of the library assumes. An alignment places
+     * the whole matrix (and, in arrays of matrices, each element of the array) on that boundary, which keeps
+     * matrices owned by different threads on separate cache lines. Padding rounds the leading dimension up to a
+     * multiple of the alignment, so that every row (or column) starts on the boundary and vector loads never
+     * straddle a cache line. Padding elements are zero-initialised and never read: element-wise updates may run
+     * over them to keep whole lines in one vector loop, but comparisons, printing and products skip them.
+     *
+     * @tparam _Order Row-major or column-major element order.
+     * @tparam _Alignment Alignment in bytes of the storage (and of padded lines), or 0 for the element alignment.
+     * @tparam _Padded Whether the leading dimension is padded to a multiple of _Alignment.
+     */
+    template <StorageOrder _Order = StorageOrder::RowMajor, size_t _Alignment = 0, bool _Padded = false>
+    struct StorageLayout {
+        static_assert((_Alignment & (_Alignment - 1)) == 0, "Alignment must be zero or a power of two");
+        static_assert(!_Padded || _Alignment > 0, "Padding needs an alignment to pad to");
+
+        static constexpr StorageOrder order = _Order;
+        static constexpr size_t alignment = _Alignment;
+        static constexpr bool padded = _Padded;
+
+        /* Where element (i, j) of an R x C matrix of T lives under this layout */
+        template <typename T, size_t R, size_t C>
+        struct Shape {
+            static constexpr bool row_major = _Order == StorageOrder::RowMajor;
+            static constexpr size_t outer = row_major ? R : C;
+            static constexpr size_t inner = row_major ? C : R;
+            static constexpr size_t line_multiple = _Padded && _Alignment > sizeof(T) ? _Alignment / sizeof(T) : 1;
+            static constexpr size_t leading_dimension = (inner + line_multiple - 1) / line_multiple * line_multiple;
+            static constexpr size_t storage_size = outer * leading_dimension;
+            static constexpr ptrdiff_t row_stride = row_major ? static_cast<ptrdiff_t>(leading_dimension) : 1;
+            static constexpr ptrdiff_t col_stride = row_major ? 1 : static_cast<ptrdiff_t>(leading_dimension);
+            static constexpr size_t storage_alignment = std::max(_Alignment, alignof(T));
+
+            /* Packed row-major storage, which the flat kernels and the rest of the library can use directly */
+            static constexpr bool is_dense_row_major = row_major && leading_dimension == C;
+        };
+    };
+
+    /**
+     * @brief Packed row-major storage, the default layout of Matrix.
+     */
+    using RowMajorLayout = StorageLayout<>;
+
+    /**
+     * @brief Packed column-major storage.
+     */
+    using ColMajorLayout = StorageLayout<StorageOrder::ColMajor>;
+
+    /**
+     * @brief Row-major storage aligned to _Alignment bytes, without padding.
+     */
+    template <size_t _Alignment = 64>
+    using AlignedLayout = StorageLayout<StorageOrder::RowMajor, _Alignment>;
+
+    /**
+     * @brief Storage aligned to _Alignment bytes whose rows (or columns) are padded to start on that boundary.
+     */
+    template <size_t _Alignment = 64, StorageOrder _Order = StorageOrder::RowMajor>
+    using PaddedLayout = StorageLayout<_Order, _Alignment, true>;
+} /* MatrixLib */
+
+#endif /* STORAGE_LAYOUT_H */
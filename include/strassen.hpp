@@ -0,0 +1,326 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "alignedAllocator.h"
+
+/* Smallest dimension the recursion stops at and hands to the blocked kernel; tuned with matrixLibGemmBench */
+#ifndef MATRIXLIB_STRASSEN_LEAF
+#define MATRIXLIB_STRASSEN_LEAF 512
+#endif
+
+namespace MatrixLib {
+namespace Detail {
+    /* Recursion depth of a Strassen product and the operand extents padded to a multiple of 2^depth */
+    struct StrassenPlan {
+        size_t depth;
+        size_t m, n, k;
+    };
+
+    inline StrassenPlan strassen_plan(size_t m, size_t n, size_t k, size_t leaf) {
+        size_t depth = 0;
+        for (size_t smallest = std::min({m, n, k}); smallest > leaf; smallest = (smallest + 1) / 2) ++depth;
+
+        const size_t step = size_t(1) << depth;
+        auto pad = [step](size_t extent) { return (extent + step - 1) / step * step; };
+        return {depth, pad(m), pad(n), pad(k)};
+    }
+
+    /* Scratch elements the recursion needs below the top level: the two temporaries of every level */
+    inline size_t strassen_temporaries(const StrassenPlan& plan) {
+        size_t ret = 0;
+        for (size_t level = 0, m = plan.m, n = plan.n, k = plan.k; level < plan.depth; ++level, m /= 2, n /= 2, k /= 2) {
+            ret += (m / 2) * std::max(k / 2, n / 2) + (k / 2) * (n / 2);
+        }
+        return ret;
+    }
+} /* Detail */
+
+    /**
+     * @brief Preallocated scratch memory for Strassen-Winograd products.
+     *
+     * Holds the padded copies of the operands and the two temporaries of every recursion level in one buffer,
+     * so a product allocates nothing once the workspace is large enough. The buffer only grows; reuse one
+     * workspace across products of the same size to keep the allocator out of the loop. A workspace is not
+     * thread-safe: give each thread its own.
+     *
+     * @tparam T The scalar type of the products.
+     */
+    template <typename T>
+    class StrassenWorkspace {
+    public:
+        /**
+         * @param leafSize Products whose smallest dimension is at most this size go to the blocked kernel.
+         * @throw std::invalid_argument if leafSize is zero.
+         */
+        explicit StrassenWorkspace(size_t leafSize = MATRIXLIB_STRASSEN_LEAF) : leaf_(leafSize) {
+            if (leafSize == 0) Utils::throw_invalid_argument_error("Strassen leaf size must be positive");
+        }
+
+        /**
+         * @return The dimension at which the recursion stops.
+         */
+        size_t leaf_size() const { return leaf_; }
+
+        /**
+         * @return The number of elements the workspace currently holds.
+         */
+        size_t capacity() const { return buffer_.size(); }
+
+        /**
+         * Number of elements an m x k by k x n product needs, counting padded copies of both operands and of
+         * the result even when the product turns out not to need them.
+         */
+        size_t required(size_t m, size_t n, size_t k) const {
+            const Detail::StrassenPlan plan = Detail::strassen_plan(m, n, k, leaf_);
+            if (plan.depth == 0) return 0;
+            return plan.m * plan.k + plan.k * plan.n + plan.m * plan.n + Detail::strassen_temporaries(plan);
+        }
+
+        /**
+         * Grow the workspace so that an m x k by k x n product runs without allocating.
+         */
+        void reserve(size_t m, size_t n, size_t k) {
+            const size_t size = required(m, n, k);
+            if (size > buffer_.size()) buffer_.resize(size);
+        }
+
+        /**
+         * @return The start of the scratch buffer.
+         */
+        T* data() { return buffer_.data(); }
+
+    private:
+        size_t leaf_;
+        std::vector<T, AlignedAllocator<T>> buffer_;
+    };
+
+namespace Kernels {
+namespace Detail {
+    /* dst = x + y over a rows x cols block; dst may be x or y */
+    template <typename T>
+    void block_add(size_t rows, size_t cols, const T* x, size_t ldx, const T* y, size_t ldy, T* dst, size_t ldd) {
+        for (size_t i = 0; i < rows; ++i) {
+            const T* xi = x + i * ldx;
+            const T* yi = y + i * ldy;
+            T* di = dst + i * ldd;
+            MATRIXLIB_IVDEP
+            for (size_t j = 0; j < cols; ++j) di[j] = xi[j] + yi[j];
+        }
+    }
+
+    /* dst = x - y over a rows x cols block; dst may be x or y */
+    template <typename T>
+    void block_sub(size_t rows, size_t cols, const T* x, size_t ldx, const T* y, size_t ldy, T* dst, size_t ldd) {
+        for (size_t i = 0; i < rows; ++i) {
+            const T* xi = x + i * ldx;
+            const T* yi = y + i * ldy;
+            T* di = dst + i * ldd;
+            MATRIXLIB_IVDEP
+            for (size_t j = 0; j < cols; ++j) di[j] = xi[j] - yi[j];
+        }
+    }
+
+    template <typename T>
+    void block_add_inplace(size_t rows, size_t cols, T* dst, size_t ldd, const T* src, size_t lds) {
+        for (size_t i = 0; i < rows; ++i) add_inplace(dst + i * ldd, src + i * lds, cols);
+    }
+
+    template <typename T>
+    void block_sub_inplace(size_t rows, size_t cols, T* dst, size_t ldd, const T* src, size_t lds) {
+        for (size_t i = 0; i < rows; ++i) sub_inplace(dst + i * ldd, src + i * lds, cols);
+    }
+
+    /*
+     * C = A * B for row-major blocks whose extents are divisible by 2^depth, with Winograd's variant of
+     * Strassen's algorithm: seven half-size products and fifteen block additions per level. The schedule is
+     * the one of Boyer, Dumas, Pernet and Zhou (2009), which needs only two temporaries per level, X for the
+     * sums of A blocks (then P1) and Y for the sums of B blocks, and uses the quadrants of C for the rest.
+     */
+    template <typename T>
+    void strassen_recursive(size_t m, size_t n, size_t k, size_t depth,
+                            const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, T* work) {
+        if (depth == 0) {
+            gemm<T>(m, n, k, T(1), a, static_cast<ptrdiff_t>(lda), 1, b, static_cast<ptrdiff_t>(ldb), 1,
+                    T(0), c, static_cast<ptrdiff_t>(ldc), 1);
+            return;
+        }
+
+        const size_t mh = m / 2, nh = n / 2, kh = k / 2;
+        const T *a11 = a, *a12 = a + kh, *a21 = a + mh * lda, *a22 = a21 + kh;
+        const T *b11 = b, *b12 = b + nh, *b21 = b + kh * ldb, *b22 = b21 + nh;
+        T *c11 = c, *c12 = c + nh, *c21 = c + mh * ldc, *c22 = c21 + nh;
+
+        const size_t ldx = std::max(kh, nh), ldy = nh;
+        T* x = work;
+        T* y = x + mh * ldx;
+        T* next = y + kh * nh;
+
+        auto product = [&](const T* l, size_t ldl, const T* r, size_t ldr, T* dst, size_t ldd) {
+            strassen_recursive<T>(mh, nh, kh, depth - 1, l, ldl, r, ldr, dst, ldd, next);
+        };
+
+        block_sub(mh, kh, a11, lda, a21, lda, x, ldx);     /* S3 = A11 - A21 */
+        block_sub(kh, nh, b22, ldb, b12, ldb, y, ldy);     /* T3 = B22 - B12 */
+        product(x, ldx, y, ldy, c21, ldc);                 /* P7 = S3 * T3 */
+        block_add(mh, kh, a21, lda, a22, lda, x, ldx);     /* S1 = A21 + A22 */
+        block_sub(kh, nh, b12, ldb, b11, ldb, y, ldy);     /* T1 = B12 - B11 */
+        product(x, ldx, y, ldy, c22, ldc);                 /* P5 = S1 * T1 */
+        block_sub(mh, kh, x, ldx, a11, lda, x, ldx);       /* S2 = S1 - A11 */
+        block_sub(kh, nh, b22, ldb, y, ldy, y, ldy);       /* T2 = B22 - T1 */
+        product(x, ldx, y, ldy, c12, ldc);                 /* P6 = S2 * T2 */
+        block_sub(mh, kh, a12, lda, x, ldx, x, ldx);       /* S4 = A12 - S2 */
+        product(x, ldx, b22, ldb, c11, ldc);               /* P3 = S4 * B22 */
+        product(a11, lda, b11, ldb, x, ldx);               /* P1 = A11 * B11 */
+        block_add_inplace(mh, nh, c12, ldc, x, ldx);       /* U2 = P1 + P6 */
+        block_add_inplace(mh, nh, c21, ldc, c12, ldc);     /* U3 = U2 + P7 */
+        block_add_inplace(mh, nh, c12, ldc, c22, ldc);     /* U4 = U2 + P5 */
+        block_add_inplace(mh, nh, c22, ldc, c21, ldc);     /* C22 = U7 = U3 + P5 */
+        block_add_inplace(mh, nh, c12, ldc, c11, ldc);     /* C12 = U5 = U4 + P3 */
+        block_sub(kh, nh, y, ldy, b21, ldb, y, ldy);       /* T4 = T2 - B21 */
+        product(a22, lda, y, ldy, c11, ldc);               /* P4 = A22 * T4 */
+        block_sub_inplace(mh, nh, c21, ldc, c11, ldc);     /* C21 = U6 = U3 - P4 */
+        product(a12, lda, b21, ldb, c11, ldc);             /* P2 = A12 * B21 */
+        block_add_inplace(mh, nh, c11, ldc, x, ldx);       /* C11 = U1 = P1 + P2 */
+    }
+
+    /* Copy a rows x cols strided block into a zero-padded row-major buffer of prows x pcols */
+    template <typename T>
+    void pack_padded(size_t rows, size_t cols, const T* src, ptrdiff_t rs, ptrdiff_t cs, size_t prows, size_t pcols, T* dst) {
+        for (size_t i = 0; i < rows; ++i) {
+            T* di = dst + i * pcols;
+            for (size_t j = 0; j < cols; ++j) di[j] = src[i * rs + j * cs];
+            std::fill(di + cols, di + pcols, T(0));
+        }
+        std::fill(dst + rows * pcols, dst + prows * pcols, T(0));
+    }
+
+    /* Operands the recursion can read in place: unpadded, unit column stride and non-overlapping rows */
+    inline bool strassen_in_place(bool padded, ptrdiff_t rs, ptrdiff_t cs, size_t cols) {
+        return !padded && cs == 1 && rs >= static_cast<ptrdiff_t>(cols);
+    }
+} /* Detail */
+
+    /**
+     * General matrix product C = alpha * A * B + beta * C with Strassen-Winograd recursion down to the leaf size
+     * of the workspace, after which the blocked kernel takes over. Extents are padded with zeros to a multiple
+     * of 2^depth, where depth is the number of halvings that bring the smallest extent down to the leaf size.
+     * Operands that are already row-major and need no padding are read in place, and C is written in place
+     * when alpha is one and beta is zero; everything else goes through the workspace. C must not overlap A or B.
+     */
+    template <typename T>
+    void gemm_strassen(size_t m, size_t n, size_t k, T alpha,
+                       const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+                       const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+                       T beta, T* c, ptrdiff_t rsc, ptrdiff_t csc, StrassenWorkspace<T>& workspace) {
+        const MatrixLib::Detail::StrassenPlan plan = MatrixLib::Detail::strassen_plan(m, n, k, workspace.leaf_size());
+        if (plan.depth == 0) {
+            gemm<T>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+            return;
+        }
+
+        workspace.reserve(m, n, k);
+        T* free = workspace.data();
+
+        const bool padded = plan.m != m || plan.n != n || plan.k != k;
+        const bool directA = Detail::strassen_in_place(padded, rsa, csa, k);
+        const bool directB = Detail::strassen_in_place(padded, rsb, csb, n);
+        const bool directC = Detail::strassen_in_place(padded, rsc, csc, n) && alpha == T(1) && beta == T(0);
+
+        const T* pa = a;
+        size_t lda = static_cast<size_t>(rsa);
+        if (!directA) {
+            Detail::pack_padded(m, k, a, rsa, csa, plan.m, plan.k, free);
+            pa = free;
+            lda = plan.k;
+            free += plan.m * plan.k;
+        }
+
+        const T* pb = b;
+        size_t ldb = static_cast<size_t>(rsb);
+        if (!directB) {
+            Detail::pack_padded(k, n, b, rsb, csb, plan.k, plan.n, free);
+            pb = free;
+            ldb = plan.n;
+            free += plan.k * plan.n;
+        }
+
+        if (directC) {
+            Detail::strassen_recursive<T>(plan.m, plan.n, plan.k, plan.depth, pa, lda, pb, ldb, c, static_cast<size_t>(rsc), free);
+            return;
+        }
+
+        T* pc = free;
+        free += plan.m * plan.n;
+        Detail::strassen_recursive<T>(plan.m, plan.n, plan.k, plan.depth, pa, lda, pb, ldb, pc, plan.n, free);
+
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                T& cij = c[i * rsc + j * csc];
+                cij = (beta == T(0)) ? alpha * pc[i * plan.n + j] : alpha * pc[i * plan.n + j] + beta * cij;
+            }
+        }
+    }
+} /* Kernels */
+
+namespace Detail {
+    template <typename T>
+    StrassenWorkspace<T>& thread_strassen_workspace() {
+        static thread_local StrassenWorkspace<T> workspace;
+        return workspace;
+    }
+} /* Detail */
+
+    /**
+     * Multiply two matrices (or expressions) with Strassen-Winograd recursion, for very large products where
+     * the O(n^2.81) operation count beats the blocked kernel. Each level of recursion halves every extent and
+     * replaces eight half-size products with seven, at the cost of fifteen block additions; the recursion stops
+     * once the smallest extent reaches the workspace's leaf size (MATRIXLIB_STRASSEN_LEAF by default).
+     *
+     * The result is not bitwise equal to operator*. Strassen's method only satisfies a normwise error bound,
+     * |C - C'| <= c(n) u |A| |B| in the max norm with c(n) about (n0^2 + 6 n0)(n / n0)^log2(18) for a leaf of n0
+     * (Higham, Accuracy and Stability of Numerical Algorithms, 23.2), whereas the blocked kernel bounds every
+     * element by n u (|A| |B|)_ij. Each recursion level loosens the bound about ninefold, roughly three bits, on
+     * evenly scaled operands; elements much smaller than the largest entries of A and B lose far more. Integer
+     * products are exact.
+     *
+     * @param lhs The left-hand matrix or expression.
+     * @param rhs The right-hand matrix or expression.
+     * @param workspace Scratch memory reused across calls; defaults to a per-thread workspace.
+     * @return The product, as the same matrix type `lhs * rhs` evaluates to.
+     * @throw std::invalid_argument if runtime-sized operands have mismatched inner dimensions.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    auto multiply_strassen(const L& lhs, const R& rhs, StrassenWorkspace<typename ProductExpr<L, R>::Scalar>& workspace) {
+        using Product = ProductExpr<L, R>;
+        using T = typename Product::Scalar;
+
+        const Product product(lhs, rhs);
+        typename Product::PlainType ret;
+        Detail::OperandTraits<typename Product::PlainType>::resize(ret, product.rows(), product.cols());
+
+        const size_t m = product.rows(), n = product.cols(), k = product.inner();
+        const auto a = Detail::strided_ref(product.lhs());
+        const auto b = Detail::strided_ref(product.rhs());
+        Kernels::gemm_strassen<T>(m, n, k, T(1),
+                                  a.data, a.row_stride, a.col_stride,
+                                  b.data, b.row_stride, b.col_stride,
+                                  T(0), Detail::OperandTraits<typename Product::PlainType>::data(ret), n, 1, workspace);
+        return ret;
+    }
+
+    /**
+     * @brief Strassen-Winograd product using this thread's workspace with the default leaf size.
+     */
+    template <typename L, typename R, Detail::enable_if_operands<L, R> = 0>
+    auto multiply_strassen(const L& lhs, const R& rhs) {
+        return multiply_strassen(lhs, rhs, Detail::thread_strassen_workspace<typename ProductExpr<L, R>::Scalar>());
+    }
+} /* MatrixLib */
+
+#endif /* STRASSEN_H */
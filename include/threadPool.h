@@ -0,0 +1,246 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MatrixLib {
+    /**
+     * @brief A fixed set of worker threads that run tasks from per-thread, work-stealing queues.
+     *
+     * Threads are started once, when the pool is constructed, and parked on a condition variable while idle, so
+     * handing work to the pool never spawns threads. Every worker pushes and pops its own tasks LIFO at the back
+     * of its queue and steals FIFO from the front of the others'. Threads outside the pool submit through a
+     * shared queue. A thread waiting on a parallel_for runs pending tasks in the meantime, so nested parallel
+     * loops cannot deadlock the pool.
+     */
+    class ThreadPool {
+        using Task = std::function<void()>;
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        /* queues_[i] belongs to worker i; the last queue takes submissions from threads outside the pool */
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> workers_;
+        std::mutex sleepMutex_;
+        std::condition_variable wake_;
+        std::atomic<size_t> pending_{0};
+        bool stop_ = false;
+
+        struct WorkerIdentity {
+            const ThreadPool* pool = nullptr;
+            size_t index = 0;
+        };
+
+        static WorkerIdentity& current_worker() {
+            static thread_local WorkerIdentity identity;
+            return identity;
+        }
+
+        size_t own_queue() const {
+            const WorkerIdentity& id = current_worker();
+            return id.pool == this ? id.index : workers_.size();
+        }
+
+        void push(size_t queue, Task task) {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                ++pending_;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+                queues_[queue]->tasks.push_back(std::move(task));
+            }
+
+            wake_.notify_one();
+        }
+
+        bool pop(size_t queue, bool back, Task& task) {
+            Queue& q = *queues_[queue];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty()) return false;
+
+            if (back) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            } else {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+
+            --pending_;
+            return true;
+        }
+
+        /* Own queue first (most recently pushed, still warm in cache), then steal the oldest task elsewhere */
+        bool try_run_one(size_t self) {
+            if (pending_.load(std::memory_order_relaxed) == 0) return false;
+
+            Task task;
+            bool found = pop(self, true, task);
+            for (size_t i = 1; !found && i < queues_.size(); ++i) {
+                found = pop((self + i) % queues_.size(), false, task);
+            }
+
+            if (!found) return false;
+            task();
+            return true;
+        }
+
+        void worker_loop(size_t index) {
+            current_worker() = {this, index};
+
+            for (;;) {
+                if (try_run_one(index)) continue;
+
+                std::unique_lock<std::mutex> lock(sleepMutex_);
+                wake_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+                if (stop_ && pending_.load() == 0) return;
+            }
+        }
+
+    public:
+        /**
+         * @brief Number of threads used when none is given: MATRIXLIB_NUM_THREADS if set, otherwise the
+         * hardware concurrency.
+         */
+        static size_t default_thread_count() {
+            if (const char* env = std::getenv("MATRIXLIB_NUM_THREADS")) {
+                const long n = std::strtol(env, nullptr, 10);
+                if (n > 0) return static_cast<size_t>(n);
+            }
+
+            const unsigned hw = std::thread::hardware_concurrency();
+            return hw ? hw : 1;
+        }
+
+        /**
+         * @brief Starts the pool.
+         * @param threads Total number of threads that work on a parallel loop, counting the thread that waits on
+         * it. threads - 1 workers are started; a pool of one thread runs everything on the caller.
+         */
+        explicit ThreadPool(size_t threads = default_thread_count()) {
+            const size_t workers = threads > 1 ? threads - 1 : 0;
+
+            for (size_t i = 0; i <= workers; ++i) queues_.push_back(std::make_unique<Queue>());
+
+            workers_.reserve(workers);
+            for (size_t i = 0; i < workers; ++i) workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Runs every task that is still queued, then joins the workers.
+         */
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                stop_ = true;
+            }
+
+            wake_.notify_all();
+            for (auto& worker : workers_) worker.join();
+        }
+
+        /**
+         * @return The number of threads that work on a parallel loop, including the waiting thread.
+         */
+        size_t thread_count() const noexcept { return workers_.size() + 1; }
+
+        /**
+         * @return Whether the calling thread is one of this pool's workers.
+         */
+        bool is_worker() const noexcept { return current_worker().pool == this; }
+
+        /**
+         * @brief Runs one queued task on the calling thread, for threads that would otherwise block on work the
+         * pool has yet to do.
+         * @return false if no task was pending.
+         */
+        bool run_pending_task() { return try_run_one(own_queue()); }
+
+        /**
+         * @brief Queues a task without waiting for it. Exceptions thrown by the task terminate the program.
+         */
+        template <typename F>
+        void submit(F&& task) {
+            if (workers_.empty()) {
+                task();
+                return;
+            }
+
+            push(own_queue(), Task(std::forward<F>(task)));
+        }
+
+        /**
+         * @brief Runs body(i) for every i in [0, count) across the pool and returns once all calls finished.
+         *
+         * The calling thread takes part in the loop and, while waiting for the rest, runs any other queued task.
+         * If calls throw, the first exception is rethrown here after the loop has completed.
+         */
+        template <typename F>
+        void parallel_for(size_t count, F&& body) {
+            if (count == 0) return;
+
+            if (workers_.empty() || count == 1) {
+                for (size_t i = 0; i < count; ++i) body(i);
+                return;
+            }
+
+            struct State {
+                std::atomic<size_t> remaining;
+                std::mutex errorMutex;
+                std::exception_ptr error;
+            } state;
+            state.remaining.store(count);
+
+            auto run = [&state, &body](size_t i) {
+                try {
+                    body(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state.errorMutex);
+                    if (!state.error) state.error = std::current_exception();
+                }
+
+                /* Last touch of state: the waiting thread may return as soon as this reaches zero */
+                state.remaining.fetch_sub(1, std::memory_order_acq_rel);
+            };
+
+            const size_t self = own_queue();
+            for (size_t i = count - 1; i > 0; --i) push(self, [run, i] { run(i); });
+            run(0);
+
+            while (state.remaining.load(std::memory_order_acquire) != 0) {
+                if (!try_run_one(self)) std::this_thread::yield();
+            }
+
+            if (state.error) std::rethrow_exception(state.error);
+        }
+
+        /**
+         * @brief The process-wide pool used by the parallel execution policy, sized by default_thread_count() and
+         * started on first use.
+         */
+        static ThreadPool& global() {
+            static ThreadPool pool;
+            return pool;
+        }
+    };
+} /* MatrixLib */
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,80 @@
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+/* Edge of the tiles the transpose kernels work on; two tiles of doubles at the default fit comfortably in L1 */
+#ifndef MATRIXLIB_TRANSPOSE_BLOCK
+#define MATRIXLIB_TRANSPOSE_BLOCK 32
+#endif
+
+namespace MatrixLib {
+namespace Kernels {
+    /**
+     * Out-of-place transpose dst = src^T of a rows x cols operand addressed with strides (rss, css) into a
+     * row-major destination with leading dimension ldd. The operand is halved along its longer side until a
+     * piece fits in a MATRIXLIB_TRANSPOSE_BLOCK tile, so both the reads and the scattered writes stay in
+     * cache whatever the cache sizes are. dst must not overlap src.
+     */
+    template <typename T>
+    void transpose(size_t rows, size_t cols, const T* src, ptrdiff_t rss, ptrdiff_t css, T* dst, ptrdiff_t ldd) {
+        constexpr size_t block = MATRIXLIB_TRANSPOSE_BLOCK;
+
+        if (rows <= block && cols <= block) {
+            for (size_t i = 0; i < rows; ++i) {
+                for (size_t j = 0; j < cols; ++j) dst[j * ldd + i] = src[i * rss + j * css];
+            }
+        } else if (rows >= cols) {
+            const size_t half = rows / 2;
+            transpose(half, cols, src, rss, css, dst, ldd);
+            transpose(rows - half, cols, src + half * rss, rss, css, dst + half, ldd);
+        } else {
+            const size_t half = cols / 2;
+            transpose(rows, half, src, rss, css, dst, ldd);
+            transpose(rows, cols - half, src + half * css, rss, css, dst + half * ldd, ldd);
+        }
+    }
+
+    /**
+     * Copies a rows x cols operand addressed with strides (rss, css) into a row-major destination with leading
+     * dimension ldd: row by row when the operand's rows are contiguous, through transpose() otherwise.
+     */
+    template <typename T>
+    void copy_strided(size_t rows, size_t cols, const T* src, ptrdiff_t rss, ptrdiff_t css, T* dst, ptrdiff_t ldd) {
+        if (css == 1 || cols <= 1) {
+            for (size_t i = 0; i < rows; ++i) std::copy_n(src + i * rss, cols, dst + i * ldd);
+        } else {
+            transpose(cols, rows, src, css, rss, dst, ldd);
+        }
+    }
+
+    /**
+     * In-place transpose of an n x n row-major matrix with leading dimension lda. Diagonal tiles are transposed
+     * on their own and every tile above the diagonal is swapped with its mirror, so each element moves once.
+     */
+    template <typename T>
+    void transpose_inplace(size_t n, T* a, ptrdiff_t lda) {
+        constexpr size_t block = MATRIXLIB_TRANSPOSE_BLOCK;
+
+        for (size_t ib = 0; ib < n; ib += block) {
+            const size_t ie = std::min(n, ib + block);
+
+            for (size_t i = ib; i < ie; ++i) {
+                for (size_t j = i + 1; j < ie; ++j) std::swap(a[i * lda + j], a[j * lda + i]);
+            }
+
+            for (size_t jb = ie; jb < n; jb += block) {
+                const size_t je = std::min(n, jb + block);
+
+                for (size_t i = ib; i < ie; ++i) {
+                    for (size_t j = jb; j < je; ++j) std::swap(a[i * lda + j], a[j * lda + i]);
+                }
+            }
+        }
+    }
+} /* Kernels */
+} /* MatrixLib */
+
+#endif /* TRANSPOSE_H */
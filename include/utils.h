@@ -2,10 +2,33 @@
 #define UTILS_H
 
 #include <string>
+#include <cassert>
 #include <cstdarg>
 #include <stdexcept>
 
+/*
+ * Element accessors check their indices and throw std::out_of_range by default. Defining
+ * MATRIXLIB_UNCHECKED_ACCESS turns the checks into asserts, so release builds (NDEBUG) pay nothing.
+ */
+#ifdef MATRIXLIB_UNCHECKED_ACCESS
+#define MATRIXLIB_CHECK_INDEX(cond, ...) do { assert(cond); (void)sizeof(cond); } while (0)
+#else
+#define MATRIXLIB_CHECK_INDEX(cond, ...) do { if (!(cond)) ::Utils::throw_out_of_range_error(__VA_ARGS__); } while (0)
+#endif
+
 namespace Utils {
+    /**
+     * C++17 stand-in for std::is_constant_evaluated(). Compilers without the builtin report true so that
+     * callers always take their constexpr-safe path.
+     */
+    constexpr bool is_constant_evaluated() noexcept {
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+        return __builtin_is_constant_evaluated();
+#else
+        return true;
+#endif
+    }
+
     template<typename... Args>
     std::string format_str(const std::string& format, Args&&... args) {
         size_t size = std::snprintf(nullptr, 0, format.c_str(), std::forward<Args>(args)...);
@@ -1,6 +1,33 @@
 #include <cassert>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include "matrixLib.hpp"
+#include "dynMatrix.hpp"
+#include "parallel.hpp"
+#include "batch.hpp"
+#include "decomposition.hpp"
+#include "sparseMatrix.hpp"
+#include "serialization.hpp"
+#include "mixedPrecision.hpp"
+#include "matrixVector.hpp"
+#include "strassen.hpp"
+#include "instrumentation.h"
+#include "spectral.hpp"
+#include "async.hpp"
+#include "reductions.hpp"
+#include "outOfCore.hpp"
 
 using namespace MatrixLib;
 
@@ -144,6 +171,1912 @@ void test_arithmetic_operations() {
     assert(mat8_expected == mat8_actual);
 }
 
+void test_blocked_multiplication() {
+    // Compile-time products still go through the naive loop
+    constexpr Matrix<int, 2, 3> a = {{1, 2, 3}, {4, 5, 6}};
+    constexpr Matrix<int, 3, 2> b = {{7, 8}, {9, 10}, {11, 12}};
+    constexpr Matrix<int, 2, 2> ab = a * b;
+    static_assert(ab(0, 0) == 58 && ab(0, 1) == 64 && ab(1, 0) == 139 && ab(1, 1) == 154);
+
+    // Small fixed shapes whose column count is not a multiple of the vector width
+    Matrix<double, 5, 7> c;
+    Matrix<double, 7, 11> d;
+    for (size_t i = 0; i < 5; ++i) for (size_t j = 0; j < 7; ++j) c(i, j) = (double)(i + 2 * j) * 0.5;
+    for (size_t i = 0; i < 7; ++i) for (size_t j = 0; j < 11; ++j) d(i, j) = (double)(3 * i) - (double)j;
+    Matrix<double, 5, 11> cd = c * d;
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 11; ++j) {
+            double expected = 0;
+            for (size_t k = 0; k < 7; ++k) expected += c(i, k) * d(k, j);
+            assert(cd(i, j) == expected);
+        }
+    }
+
+    // Odd shapes above the blocking threshold exercise the packed kernel and its edge tiles
+    constexpr size_t M = 67, N = 131, P = 45;
+    auto lhs = std::make_unique<Matrix<long long, M, N>>();
+    auto rhs = std::make_unique<Matrix<long long, N, P>>();
+    for (size_t i = 0; i < M; ++i) for (size_t j = 0; j < N; ++j) (*lhs)(i, j) = (long long)((i * 7 + j * 3) % 11) - 5;
+    for (size_t i = 0; i < N; ++i) for (size_t j = 0; j < P; ++j) (*rhs)(i, j) = (long long)((i * 5 + j) % 13) - 6;
+
+    auto actual = std::make_unique<Matrix<long long, M, P>>(*lhs * *rhs);
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < P; ++j) {
+            long long expected = 0;
+            for (size_t k = 0; k < N; ++k) expected += (*lhs)(i, k) * (*rhs)(k, j);
+            assert((*actual)(i, j) == expected);
+        }
+    }
+
+    // Strided operands: multiply A^T * B through the kernel interface directly
+    std::vector<double> at(N * M), bt(N * P), ct(M * P, 1.0);
+    for (size_t i = 0; i < N * M; ++i) at[i] = (double)(i % 17) * 0.25;
+    for (size_t i = 0; i < N * P; ++i) bt[i] = (double)(i % 19) * 0.5;
+    Kernels::gemm_blocked<double>(M, P, N, 2.0, at.data(), 1, M, bt.data(), P, 1, 1.0, ct.data(), P, 1);
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < P; ++j) {
+            double expected = 1.0;
+            for (size_t k = 0; k < N; ++k) expected += 2.0 * at[k * M + i] * bt[k * P + j];
+            assert(std::abs(ct[i * P + j] - expected) <= 1e-9 * std::abs(expected));
+        }
+    }
+}
+
+template <typename T>
+void check_elementwise_kernels(size_t n) {
+    std::vector<T> a(n), b(n), expected(n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = (T)((double)(i % 29) * 0.75 - 3.0);
+        b[i] = (T)((double)(i % 13) * 1.25 + 0.5);
+    }
+
+    expected = a;
+    for (size_t i = 0; i < n; ++i) expected[i] += b[i];
+    std::vector<T> actual = a;
+    Kernels::add_inplace(actual.data(), b.data(), n);
+    assert(actual == expected);
+
+    for (size_t i = 0; i < n; ++i) expected[i] -= b[i];
+    Kernels::sub_inplace(actual.data(), b.data(), n);
+    assert(actual == expected);
+
+    for (size_t i = 0; i < n; ++i) expected[i] *= (T)1.5;
+    Kernels::scale_inplace(actual.data(), (T)1.5, n);
+    assert(actual == expected);
+
+    assert(Kernels::equal(actual.data(), expected.data(), n));
+    for (size_t i = 0; i < n; i += 7) {
+        actual[i] += (T)1;
+        assert(!Kernels::equal(actual.data(), expected.data(), n));
+        actual[i] = expected[i];
+    }
+}
+
+void test_simd_kernels() {
+    const Kernels::SimdIsa original = Kernels::active_simd_isa();
+
+    for (auto isa : {Kernels::SimdIsa::Scalar, Kernels::SimdIsa::SSE2, Kernels::SimdIsa::AVX2,
+                     Kernels::SimdIsa::AVX512, Kernels::SimdIsa::NEON}) {
+        if (!Kernels::set_simd_isa(isa)) continue;
+
+        for (size_t n : {1, 3, 16, 67, 256}) {
+            check_elementwise_kernels<float>(n);
+            check_elementwise_kernels<double>(n);
+            check_elementwise_kernels<int>(n);
+        }
+
+        // Element-wise operators keep IEEE comparison semantics
+        Matrix<double, 3, 7> x;
+        Matrix<double, 3, 7> y;
+        x(2, 6) = 0.0;
+        y(2, 6) = -0.0;
+        assert(x == y);
+        y(1, 3) = std::nan("");
+        x(1, 3) = std::nan("");
+        assert(x != y);
+    }
+
+    Kernels::set_simd_isa(original);
+
+    // Scalar multiplication keeps the promotion semantics of `x *= val`
+    Matrix<int, 2, 2> m{{1, 2}, {3, 4}};
+    m *= 2.5;
+    assert(m == (Matrix<int, 2, 2>{{2, 5}, {7, 10}}));
+
+    Matrix<float, 3, 5> f;
+    for (size_t i = 0; i < 3; ++i) for (size_t j = 0; j < 5; ++j) f(i, j) = (float)(i * 5 + j);
+    Matrix<float, 3, 5> g = f + f;
+    g -= f;
+    assert(g == f);
+    g *= 2;
+    assert(g == f + f);
+}
+
+void test_dyn_matrix() {
+    // Construction and shape checks
+    DynMatrix<int> a{{1, 2, 3}, {4, 5, 6}};
+    assert(a.rows() == 2 && a.cols() == 3 && a.size() == 6);
+    assert(a(1, 2) == 6 && a[0][1] == 2);
+    assert(reinterpret_cast<uintptr_t>(a.data()) % MATRIXLIB_DEFAULT_ALIGNMENT == 0);
+
+    DynMatrix<double> zeros(3, 4);
+    assert(zeros.rows() == 3 && zeros.cols() == 4 && zeros(2, 3) == 0.0);
+
+    bool threw = false;
+    try { DynMatrix<int, 3, Dynamic> wrong(2, 5); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { DynMatrix<int> ragged{{1, 2}, {3}}; } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)a(2, 0); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    // Moves hand over the buffer
+    const int* buffer = a.data();
+    DynMatrix<int> moved(std::move(a));
+    assert(moved.data() == buffer && a.size() == 0);
+    DynMatrix<int, 2, Dynamic> narrowed(std::move(moved));
+    assert(narrowed.data() == buffer && narrowed.cols() == 3);
+
+    // Arithmetic matches the fixed-size Matrix
+    Matrix<int, 2, 3> fa = {{1, 2, 3}, {4, 5, 6}};
+    Matrix<int, 3, 2> fb = {{7, 8}, {9, 10}, {11, 12}};
+    DynMatrix<int> da(fa), db(fb);
+
+    assert(da == fa && fa == da && da != db);
+    assert((da + da) == (fa + fa));
+    assert((da - fa) == (Matrix<int, 2, 3>{}));
+    DynMatrix<int> product = da * db;
+    assert(product == fa * fb);
+    assert(((fa * db).eval().to_matrix<2, 2>() == fa * fb));
+
+    DynMatrix<int, 2, 2> mixed = fa * db;
+    assert(mixed == (Matrix<int, 2, 2>{{58, 64}, {139, 154}}));
+    Matrix<int, 2, 2> back = static_cast<Matrix<int, 2, 2>>(product);
+    assert(back == mixed);
+
+    da *= 2;
+    da -= fa;
+    assert(da == fa);
+
+    threw = false;
+    try { (void)(da + db); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)(da * da); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // Printing is shared with Matrix
+    assert(to_string(da) == to_string(fa));
+    std::stringstream ss;
+    ss << db;
+    assert(ss.str() == to_string(fb));
+
+    // Large runtime shapes go through the blocked kernel
+    const size_t n = 150;
+    DynMatrix<double> x(n, n), y(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            x(i, j) = (double)((i + j) % 7);
+            y(i, j) = (double)((i * j) % 5);
+        }
+    }
+    DynMatrix<double> xy = x * y;
+    for (size_t i = 0; i < n; i += 37) {
+        for (size_t j = 0; j < n; j += 23) {
+            double expected = 0;
+            for (size_t k = 0; k < n; ++k) expected += x(i, k) * y(k, j);
+            assert(xy(i, j) == expected);
+        }
+    }
+}
+
+void test_expression_templates() {
+    Matrix<int, 2, 3> a = {{1, 2, 3}, {4, 5, 6}};
+    Matrix<int, 2, 3> b = {{6, 5, 4}, {3, 2, 1}};
+    Matrix<int, 2, 3> c = {{1, 1, 1}, {2, 2, 2}};
+    Matrix<int, 2, 3> d = {{0, 1, 0}, {1, 0, 1}};
+
+    // Chained element-wise operations are lazy and evaluated in one pass
+    auto sum = a + b - c + d;
+    static_assert(!std::is_same<decltype(sum), Matrix<int, 2, 3>>::value);
+    static_assert(std::is_same<decltype(sum.eval()), Matrix<int, 2, 3>>::value);
+    assert(sum(0, 1) == 7 && sum(1, 2) == 6);
+    Matrix<int, 2, 3> fused = sum;
+    assert(fused == (Matrix<int, 2, 3>{{6, 7, 6}, {6, 5, 6}}));
+    assert(fused == sum && sum == fused);
+
+    // Scalar scaling, including a scalar that promotes the element type
+    Matrix<int, 2, 3> scaled = 2 * a + b * 3 - c;
+    assert(scaled == (Matrix<int, 2, 3>{{19, 18, 17}, {15, 14, 13}}));
+    Matrix<int, 2, 3> promoted = a * 2.5;
+    assert(promoted == (Matrix<int, 2, 3>{{2, 5, 7}, {10, 12, 15}}));
+
+    // Products are accumulated into the destination
+    Matrix<int, 3, 2> e = {{7, 8}, {9, 10}, {11, 12}};
+    Matrix<int, 2, 2> f = {{1, 2}, {3, 4}};
+    Matrix<int, 2, 2> ae = a * e;
+    assert((Matrix<int, 2, 2>(a * e + f)) == (Matrix<int, 2, 2>{{59, 66}, {142, 158}}));
+    assert((Matrix<int, 2, 2>(f - a * e)) == (Matrix<int, 2, 2>{{-57, -62}, {-136, -150}}));
+    assert((Matrix<int, 2, 2>(2 * (a * e) - f * 2)) == (Matrix<int, 2, 2>{{114, 124}, {272, 300}}));
+    assert(((a + b) * e) == ((a * e) + (b * e)));
+    Matrix<int, 2, 2> acc = f;
+    acc += a * e;
+    acc -= f;
+    assert(acc == ae);
+
+    // Products that read the destination go through a temporary
+    Matrix<int, 2, 2> g = f;
+    g = g * f;
+    assert(g == (Matrix<int, 2, 2>{{7, 10}, {15, 22}}));
+    g = f * g + g;
+    assert(g == (Matrix<int, 2, 2>{{44, 64}, {96, 140}}));
+    g += g * f;
+    assert(g == (Matrix<int, 2, 2>{{280, 408}, {612, 892}}));
+    a = a + a - b;
+    assert(a == (Matrix<int, 2, 3>{{-4, -1, 2}, {5, 8, 11}}));
+
+    // Everything still works at compile time
+    constexpr Matrix<int, 2, 2> x = {{1, 2}, {3, 4}};
+    constexpr Matrix<int, 2, 2> y = x * x + x * 2 - x;
+    static_assert(y(0, 0) == 8 && y(0, 1) == 12 && y(1, 0) == 18 && y(1, 1) == 26);
+    static_assert((x + x)(1, 1) == 8);
+
+    // Expressions over DynMatrix evaluate to DynMatrix and resize the destination
+    DynMatrix<double> p{{1, 2, 3}, {4, 5, 6}};
+    DynMatrix<double> q{{1, 0}, {0, 1}, {1, 1}};
+    static_assert(std::is_same<decltype((p * q).eval()), DynMatrix<double>>::value);
+    Matrix<double, 2, 2> h = {{1, 2}, {3, 4}};
+    DynMatrix<double> r;
+    r = p * q * 0.5 + h;
+    assert(r.rows() == 2 && r.cols() == 2);
+    assert(r == (DynMatrix<double>{{3, 4.5}, {8, 9.5}}));
+    p = p * q;
+    assert(p == (Matrix<double, 2, 2>{{4, 5}, {10, 11}}));
+    std::stringstream ss;
+    ss << p + p;
+    assert(ss.str() == to_string(p * 2.0));
+
+    // Large runtime shapes: the fused GEMM + accumulate matches separate steps
+    const size_t n = 96;
+    DynMatrix<double> s(n, n), t(n, n), u(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            s(i, j) = (double)((i + 2 * j) % 7);
+            t(i, j) = (double)((i * j) % 5);
+            u(i, j) = (double)(i % 3) - (double)(j % 4);
+        }
+    }
+    DynMatrix<double> st = s * t;
+    DynMatrix<double> expected = st;
+    expected -= u;
+    expected -= u;
+    assert((DynMatrix<double>(s * t - 2.0 * u)) == expected);
+}
+
+
+void test_parallel_multiply() {
+    ThreadPool pool(4);
+    assert(pool.thread_count() == 4);
+
+    // Large products are split into tiles and match the serial result exactly
+    const size_t m = 300, k = 170, n = 260;
+    DynMatrix<double> a(m, k), b(k, n);
+    for (size_t i = 0; i < m; ++i) for (size_t j = 0; j < k; ++j) a(i, j) = (double)((i * 3 + j) % 11) - 5;
+    for (size_t i = 0; i < k; ++i) for (size_t j = 0; j < n; ++j) b(i, j) = (double)((i + j * 7) % 13) * 0.5;
+
+    DynMatrix<double> serial = multiply(Execution::seq, a, b);
+    DynMatrix<double> parallel = multiply(Execution::par.on(pool), a, b);
+    assert(parallel == serial);
+    assert(multiply(Execution::par.on(pool), a + a, b) == serial * 2.0);
+
+    // Small fixed-size products fall back to the serial path
+    Matrix<int, 2, 3> fa = {{1, 2, 3}, {4, 5, 6}};
+    Matrix<int, 3, 2> fb = {{7, 8}, {9, 10}, {11, 12}};
+    Matrix<int, 2, 2> fab = multiply(Execution::par.on(pool), fa, fb);
+    assert(fab == (Matrix<int, 2, 2>{{58, 64}, {139, 154}}));
+
+    // Nested loops help instead of blocking, so they cannot deadlock the pool
+    std::atomic<size_t> visits{0};
+    pool.parallel_for(8, [&](size_t) {
+        pool.parallel_for(8, [&](size_t) { ++visits; });
+    });
+    assert(visits == 64);
+
+    // The first exception of a loop reaches the caller once the loop is done
+    bool threw = false;
+    try {
+        pool.parallel_for(16, [](size_t i) { if (i == 5) throw std::runtime_error("tile failed"); });
+    } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    // A single-threaded pool runs everything on the caller
+    ThreadPool single(1);
+    assert(single.thread_count() == 1);
+    assert(multiply(Execution::par.on(single), a, b) == serial);
+}
+
+template <typename T, size_t D>
+void check_batched_products(size_t count) {
+    std::vector<Matrix<T, D, D>> a(count), b(count), expected(count), actual(count);
+    for (size_t l = 0; l < count; ++l) {
+        for (size_t i = 0; i < D; ++i) {
+            for (size_t j = 0; j < D; ++j) {
+                a[l](i, j) = static_cast<T>((l + i * 3 + j) % 7) - 3;
+                b[l](i, j) = static_cast<T>((l * 5 + i + 2 * j) % 5);
+            }
+        }
+        expected[l] = a[l] * b[l];
+    }
+
+    // Structure-of-arrays batches vectorise across instances
+    MatrixBatch<T, D, D> sa(a.data(), count), sb(b.data(), count), sc;
+    Batch::multiply(sa, sb, sc);
+    assert(sc.size() == count);
+    for (size_t l = 0; l < count; ++l) assert(sc.get(l) == expected[l]);
+
+    // Contiguous arrays of matrices
+    Batch::multiply(a.data(), b.data(), actual.data(), count);
+    assert(actual == expected);
+
+    // One transform applied to every instance, in both forms
+    Batch::multiply(a[0], sb, sc);
+    Batch::multiply(a[0], b.data(), actual.data(), count);
+    for (size_t l = 0; l < count; ++l) {
+        assert(actual[l] == a[0] * b[l]);
+        assert(sc.get(l) == actual[l]);
+    }
+
+    // Element-wise operations
+    sa += sb;
+    sa *= T(2);
+    sa -= sb;
+    Batch::add(a.data(), b.data(), actual.data(), count);
+    Batch::scale(actual.data(), T(2), count);
+    Batch::subtract(actual.data(), b.data(), actual.data(), count);
+    for (size_t l = 0; l < count; ++l) {
+        assert(actual[l] == (Matrix<T, D, D>(a[l] * T(2) + b[l])));
+        assert(sa.get(l) == actual[l]);
+    }
+}
+
+void test_batched_products() {
+    check_batched_products<float, 3>(1003);
+    check_batched_products<float, 4>(37);
+    check_batched_products<double, 4>(260);
+    check_batched_products<int, 3>(5);
+
+    // Batched matrix-vector transforms through N = 1
+    Matrix<float, 3, 3> rotate = {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}};
+    MatrixBatch<float, 3, 1> points(20), rotated;
+    for (size_t l = 0; l < points.size(); ++l) points(l, 0, 0) = (float)l;
+    Batch::multiply(rotate, points, rotated);
+    assert(rotated(7, 0, 0) == 0.0f && rotated(7, 1, 0) == 7.0f);
+
+    bool threw = false;
+    try { (void)points(20, 0, 0); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    MatrixBatch<float, 3, 1> fewer(3);
+    try { points += fewer; } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+}
+
+void test_raw_access() {
+    Matrix<int, 3, 4> m;
+    static_assert(Matrix<int, 3, 4>::rows() == 3 && Matrix<int, 3, 4>::cols() == 4 && Matrix<int, 3, 4>::size() == 12);
+
+    // Contiguous row-major storage
+    int next = 0;
+    for (int& x : m) x = next++;
+    assert(m.data() == &m(0, 0) && m.data()[5] == m(1, 1));
+    assert(std::accumulate(m.begin(), m.end(), 0) == 66);
+
+    // Row and column views write through to the matrix
+    auto row = m.row(1);
+    assert(row.size() == 4 && row[2] == 6);
+    auto col = m.col(2);
+    assert(col.size() == 3 && col.stride() == 4 && col[2] == 10);
+    for (int& x : col) x = -x;
+    assert(m(0, 2) == -2 && m(2, 2) == -10);
+    std::reverse(col.begin(), col.end());
+    assert(m(0, 2) == -10 && m(2, 2) == -2);
+    assert(col.end() - col.begin() == 3);
+
+    const Matrix<int, 3, 4>& cm = m;
+    StridedSpan<const int> ccol = cm.col(0);
+    StridedSpan<const int> crow = row;
+    assert(ccol[1] == 4 && crow[3] == 7);
+
+    // The same views over DynMatrix
+    DynMatrix<double> d(2, 3, 1.0);
+    d.col(1)[1] = 5.0;
+    assert(d(1, 1) == 5.0 && std::accumulate(d.begin(), d.end(), 0.0) == 10.0);
+    assert(d.row(1).data() == d.data() + 3);
+
+    // Accessors stay bounds-checked unless MATRIXLIB_UNCHECKED_ACCESS is defined
+    bool threw = false;
+    try { (void)m.col(4); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)row[4]; } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+}
+
+template <typename M>
+double max_abs(const M& m) {
+    double ret = 0;
+    for (auto x : m) ret = std::max(ret, (double)std::abs(x));
+    return ret;
+}
+
+void test_decompositions() {
+    // Unrolled small-size routines work at compile time
+    constexpr Matrix<int, 3, 3> ci = {{2, 0, 1}, {1, 3, 2}, {1, 1, 2}};
+    static_assert(determinant(ci) == 6);
+    constexpr Matrix<double, 2, 2> c2 = {{4, 2}, {2, 2}};
+    static_assert(inverse(c2)(0, 0) == 0.5 && inverse(c2)(1, 1) == 1.0 && inverse(c2)(1, 0) == -0.5);
+    static_assert(solve(c2, Matrix<double, 2, 1>{{2}, {0}})(1, 0) == -1.0);
+
+    // Small sizes agree with the LU path
+    Matrix<double, 4, 4> f = {{4, -2, 1, 3}, {3, 6, -4, 2}, {2, 1, 8, -5}, {1, 2, 3, 9}};
+    Matrix<double, 4, 4> id = Detail::make_identity<Matrix<double, 4, 4>>(4);
+    LU<Matrix<double, 4, 4>> flu(f);
+    assert(std::abs(determinant(f) - flu.determinant()) <= 1e-9 * std::abs(determinant(f)));
+    assert(max_abs(Matrix<double, 4, 4>(inverse(f) - flu.inverse())) < 1e-12);
+    assert(max_abs(Matrix<double, 4, 4>(f * inverse(f) - id)) < 1e-12);
+    Matrix<double, 3, 3> f3 = {{2, -1, 0}, {-1, 2, -1}, {0, -1, 2}};
+    assert(std::abs(determinant(f3) - 4.0) < 1e-12);
+    assert(max_abs(Matrix<double, 3, 3>(f3 * inverse(f3) - Detail::make_identity<Matrix<double, 3, 3>>(3))) < 1e-12);
+
+    // Blocked LU across several panels; the factorisation is reused for every right-hand side
+    const size_t n = 150;
+    DynMatrix<double> a(n, n), b(n, 3);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) a(i, j) = (double)((i * 7 + j * 13) % 17) - 8 + (i == j ? 4.0 : 0.0);
+        for (size_t j = 0; j < 3; ++j) b(i, j) = (double)((i + j * 5) % 9) - 4;
+    }
+
+    LU<DynMatrix<double>> lu(a);
+    assert(lu.is_invertible());
+    DynMatrix<double> x = lu.solve(b);
+    assert(max_abs(DynMatrix<double>(a * x - b)) < 1e-9 * max_abs(b) * n);
+    assert(max_abs(DynMatrix<double>(a * lu.inverse() - Detail::make_identity<DynMatrix<double>>(n))) < 1e-9);
+    assert(solve(a, b) == x);
+    assert(lu.solve(b * 2.0) == x * 2.0);
+
+    DynMatrix<double> pa = a;
+    for (size_t i = 0; i < n; ++i) {
+        if (lu.pivot(i) != i) std::swap_ranges(pa.row(i).begin(), pa.row(i).end(), pa.row(lu.pivot(i)).begin());
+    }
+    DynMatrix<double> l(n, n), u(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (j < i) l(i, j) = lu.matrixLU()(i, j);
+            else u(i, j) = lu.matrixLU()(i, j);
+        }
+        l(i, i) = 1;
+    }
+    assert(max_abs(DynMatrix<double>(l * u - pa)) < 1e-9 * max_abs(a));
+
+    // Singular matrices are reported rather than solved
+    Matrix<double, 3, 3> singular = {{1, 2, 3}, {2, 4, 6}, {1, 0, 1}};
+    LU<Matrix<double, 3, 3>> slu(singular);
+    assert(!slu.is_invertible() && slu.determinant() == 0.0);
+    bool threw = false;
+    try { (void)slu.solve(Matrix<double, 3, 1>()); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)lu.solve(DynMatrix<double>(n + 1, 1)); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { LU<DynMatrix<double>> rect(DynMatrix<double>(3, 4)); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // Cholesky of S = A A^T + n I, with the trailing update split across panels
+    DynMatrix<double> s(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < n; ++k) s(i, j) += a(i, k) * a(j, k);
+        }
+        s(i, i) += (double)n;
+    }
+
+    Cholesky<DynMatrix<double>> chol(s);
+    assert(chol.is_positive_definite());
+    DynMatrix<double> lower = chol.matrixL();
+    assert(lower(0, 1) == 0.0);
+    DynMatrix<double> llt(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < n; ++k) llt(i, j) += lower(i, k) * lower(j, k);
+        }
+    }
+    assert(max_abs(DynMatrix<double>(llt - s)) < 1e-9 * max_abs(s));
+    DynMatrix<double> y = chol.solve(b);
+    assert(max_abs(DynMatrix<double>(s * y - b)) < 1e-9 * max_abs(b));
+
+    Cholesky<Matrix<double, 3, 3>> fchol(f3);
+    assert(std::abs(fchol.determinant() - 4.0) < 1e-12);
+    Cholesky<Matrix<double, 2, 2>> indefinite(Matrix<double, 2, 2>{{1, 2}, {2, 1}});
+    assert(!indefinite.is_positive_definite());
+    threw = false;
+    try { (void)indefinite.solve(Matrix<double, 2, 1>()); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    // Least-squares fit of y = 2x + 1 through an overdetermined system
+    Matrix<double, 5, 2> design;
+    Matrix<double, 5, 1> observed;
+    for (size_t i = 0; i < 5; ++i) {
+        design(i, 0) = (double)i;
+        design(i, 1) = 1;
+        observed(i, 0) = 2.0 * (double)i + 1;
+    }
+    QR<Matrix<double, 5, 2>> fit(design);
+    Matrix<double, 2, 1> coeffs = fit.solve(observed);
+    assert(std::abs(coeffs(0, 0) - 2) < 1e-12 && std::abs(coeffs(1, 0) - 1) < 1e-12);
+
+    // Q has orthonormal columns and Q R reproduces A
+    DynMatrix<double> tall(90, 70);
+    for (size_t i = 0; i < 90; ++i) for (size_t j = 0; j < 70; ++j) tall(i, j) = (double)((i * 5 + j * 11) % 23) - 11 + (i == j ? 3.0 : 0.0);
+    QR<DynMatrix<double>> qr(tall);
+    assert(qr.is_full_rank());
+    DynMatrix<double> q = qr.matrixQ(), r = qr.matrixR();
+    assert(q.rows() == 90 && q.cols() == 70 && r.rows() == 70 && r(1, 0) == 0.0);
+    assert(max_abs(DynMatrix<double>(q * r - tall)) < 1e-9 * max_abs(tall));
+    DynMatrix<double> qtq(70, 70);
+    for (size_t i = 0; i < 70; ++i) for (size_t j = 0; j < 70; ++j) for (size_t k = 0; k < 90; ++k) qtq(i, j) += q(k, i) * q(k, j);
+    assert(max_abs(DynMatrix<double>(qtq - Detail::make_identity<DynMatrix<double>>(70))) < 1e-12);
+
+    QR<Matrix<double, 3, 3>> rankDeficient(singular);
+    assert(!rankDeficient.is_full_rank());
+}
+
+template <SparseFormat F>
+void check_sparse_format() {
+    using Sparse = SparseMatrix<double, F>;
+
+    // A banded 200x150 matrix with some entries given twice
+    const size_t m = 200, n = 150;
+    std::vector<Triplet<double>> triplets;
+    DynMatrix<double> dense(m, n);
+    for (size_t i = m; i-- > 0;) {
+        for (size_t j = (i >= 2 ? i - 2 : 0); j < std::min(n, i + 3); ++j) {
+            const double v = (double)((i * 3 + j) % 7) - 3;
+            triplets.push_back({i, j, v});
+            dense(i, j) += v;
+            if ((i + j) % 5 == 0) {
+                triplets.push_back({i, j, 1.0});
+                dense(i, j) += 1.0;
+            }
+        }
+    }
+
+    Sparse a(m, n, triplets);
+    assert(a.rows() == m && a.cols() == n && a.to_dense() == dense);
+    assert(a(3, 1) == dense(3, 1) && a(0, 100) == 0.0);
+    assert(Sparse(dense) == Sparse(Sparse(dense).to_dense()));
+
+    // Products with dense operands, single columns and expressions match the dense results
+    DynMatrix<double> b(n, 7), x(n, 1), c(9, m);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < 7; ++j) b(i, j) = (double)((i + j * 11) % 13) * 0.5;
+        x(i, 0) = (double)(i % 4) - 1.5;
+    }
+    for (size_t i = 0; i < 9; ++i) for (size_t j = 0; j < m; ++j) c(i, j) = (double)((i * 17 + j) % 5) - 2;
+
+    assert(a * b == dense * b);
+    assert(a * x == dense * x);
+    assert(a * (b + b) == dense * (b * 2.0));
+    assert(c * a == c * dense);
+
+    ThreadPool pool(3);
+    DynMatrix<double> big(n, 300);
+    for (size_t i = 0; i < n; ++i) for (size_t j = 0; j < 300; ++j) big(i, j) = (double)((i * 7 + j) % 9);
+    assert(multiply(Execution::par.on(pool), a, big) == multiply(Execution::seq, a, big));
+    DynMatrix<double> wide(300, m);
+    for (size_t i = 0; i < 300; ++i) for (size_t j = 0; j < m; ++j) wide(i, j) = (double)((i + j * 3) % 11);
+    assert(multiply(Execution::par.on(pool), wide, a) == wide * dense);
+
+    // Sums with dense and sparse operands
+    assert(a + dense == dense * 2.0);
+    assert(dense - a == DynMatrix<double>(m, n));
+    assert(a - dense * 3.0 == dense * -2.0);
+    assert((a + a).to_dense() == dense * 2.0 && (a - a).to_dense() == DynMatrix<double>(m, n));
+    assert((2.0 * a).to_dense() == dense * 2.0);
+
+    // Sparse products stay sparse
+    std::vector<Triplet<double>> transposed;
+    for (const auto& t : triplets) transposed.push_back({t.col, t.row, t.value});
+    Sparse at(n, m, transposed);
+    Sparse ata = at * a;
+    assert(ata.to_dense() == at.to_dense() * dense);
+    assert(ata.nonzeros() < n * n / 10);
+}
+
+void test_sparse_matrix() {
+    check_sparse_format<SparseFormat::CSR>();
+    check_sparse_format<SparseFormat::CSC>();
+
+    // Conversions between the formats and from fixed-size matrices
+    Matrix<float, 3, 4> f = {{0, 2, 0, 0}, {1, 0, 0, 3}, {0, 0, 0, 4}};
+    SparseMatrix<float> csr(f);
+    SparseMatrix<float, SparseFormat::CSC> csc(csr);
+    assert(csr.nonzeros() == 4 && csc.nonzeros() == 4);
+    assert(csc.outer_size() == 4 && csc.outer_index()[4] == 4 && csc.inner_index()[2] == 1);
+    assert(SparseMatrix<float>(csc) == csr);
+    assert(csr.to_dense() == f && csc.to_dense() == f);
+    Matrix<float, 4, 1> v = {{1}, {1}, {1}, {1}};
+    assert(csr * v == f * v);
+    assert(to_string(csr) == to_string(f));
+
+    // Adopting compressed arrays built elsewhere
+    SparseMatrix<float> adopted(3, 4, {0, 1, 3, 4}, {1, 0, 3, 3}, {2, 1, 3, 4});
+    assert(adopted == csr);
+
+    bool threw = false;
+    try { SparseMatrix<float> bad(3, 4, {{3, 0, 1.0f}}); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)(csr * Matrix<float, 3, 1>()); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { SparseMatrix<double, SparseFormat::CSR, std::uint8_t> tooBig(300, 2); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+}
+
+void test_transpose_and_views() {
+    // Copying and in-place transposes, also at compile time
+    constexpr Matrix<int, 2, 3> ct = {{1, 2, 3}, {4, 5, 6}};
+    static_assert(ct.transpose()(2, 1) == 6 && ct.transpose()(0, 1) == 4);
+    static_assert(Matrix<int, 2, 2>{{1, 2}, {3, 4}}.transpose_inplace()(0, 1) == 3);
+
+    // Integer-valued doubles keep every sum below exact
+    auto fill = [](auto& m) {
+        for (size_t i = 0; i < m.rows(); ++i) {
+            for (size_t j = 0; j < m.cols(); ++j) m(i, j) = static_cast<double>((i * 7 + j * 3) % 11) - 5.0;
+        }
+    };
+
+    DynMatrix<double> a(70, 45);
+    fill(a);
+    DynMatrix<double> at = a.transpose();
+    assert(at.rows() == 45 && at.cols() == 70 && at(44, 69) == a(69, 44) && at(3, 17) == a(17, 3));
+    assert(DynMatrix<double>(a).transpose_inplace() == at);
+    assert(DynMatrix<double>(at).transpose_inplace().transpose_inplace() == at);
+
+    DynMatrix<double> sq(67, 67);
+    fill(sq);
+    DynMatrix<double> sqt = sq;
+    sqt.transpose_inplace();
+    assert(sqt == sq.transpose() && sqt(5, 60) == sq(60, 5));
+
+    Matrix<int, 3, 3> f = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    Matrix<int, 3, 3> fi = f;
+    assert(fi.transpose_inplace() == f.transpose());
+
+    // Views look at the elements in place and write through
+    Matrix<int, 3, 4> m = {{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}};
+    auto v = view(m);
+    static_assert(std::is_same<decltype(v), MatrixView<int, 3, 4>>::value);
+    assert(v.is_contiguous() && v(2, 3) == 11 && !v.transpose().is_contiguous());
+    assert(v.transpose()(3, 1) == 7 && v.block(1, 1, 2, 2)(1, 0) == 9);
+    assert(v.row(2)(0, 1) == 9 && v.col(3)(1, 0) == 7);
+    assert(v.strided(2, 3).rows() == 2 && v.strided(2, 3).cols() == 2 && v.strided(2, 3)(1, 1) == 11);
+    v.block(0, 2, 2, 2)(1, 1) = 70;
+    assert(m(1, 3) == 70);
+    m(1, 3) = 7;
+
+    const Matrix<int, 3, 4>& cm = m;
+    MatrixView<const int> cv = transpose_view(cm);
+    assert(cv.rows() == 4 && cv(2, 1) == 6);
+    Matrix<int, 2, 4> lower = {{4, 5, 6, 7}, {8, 9, 10, 11}};
+    assert(transpose_view(m) == m.transpose() && v.block(1, 0, 2, 4) == lower);
+    assert(to_string(v.col(0)) == "| 0 |\n| 4 |\n| 8 |\n");
+
+    // Element-wise expressions accept views, including ones that alias the destination
+    Matrix<int, 4, 3> sum = transpose_view(m) + m.transpose();
+    assert(sum == m.transpose() * 2);
+    f = f + transpose_view(f);
+    assert(f == f.transpose() && f(0, 2) == 10);
+
+    // Products read views through their strides; the results match products of copies
+    DynMatrix<double> b(60, 45);
+    fill(b);
+    DynMatrix<double> bt = b.transpose();
+    DynMatrix<double> abt = a * transpose_view(b);
+    assert(abt.rows() == 70 && abt.cols() == 60 && abt == a * bt);
+    assert(DynMatrix<double>(transpose_view(a) * a) == at * a);
+    assert(DynMatrix<double>(transpose_view(at) * transpose_view(b)) == abt);
+    assert(DynMatrix<double>(view(a).block(10, 5, 20, 30) * view(b).block(0, 0, 30, 15))
+           == DynMatrix<double>(view(a).block(10, 5, 20, 30)) * DynMatrix<double>(view(b).block(0, 0, 30, 15)));
+
+    DynMatrix<double> acc(70, 60, 1.0);
+    acc += a * transpose_view(b);
+    assert(acc == abt + DynMatrix<double>(70, 60, 1.0));
+
+    // Views of fixed-size matrices keep static extents
+    Matrix<double, 3, 4> p = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    auto ppt = (p * transpose_view(p)).eval();
+    static_assert(std::is_same<decltype(ppt), Matrix<double, 3, 3>>::value);
+    assert(ppt == p * p.transpose() && ppt(1, 2) == 278);
+
+    ThreadPool pool(2);
+    assert(multiply(Execution::par.on(pool), transpose_view(a), a) == at * a);
+
+    bool threw = false;
+    try { (void)v.block(2, 0, 2, 1); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { (void)v.strided(0, 1); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+}
+
+void test_binary_serialization() {
+    // Stream round trips keep element type, shape and values exactly
+    Matrix<int, 2, 3> mi = {{1, -2, 3}, {-4, 5, 2147483647}};
+    std::stringstream ss;
+    write_binary(ss, mi);
+    assert(ss.str().size() == 64 + 6 * sizeof(int));
+    assert((read_binary<Matrix<int, 2, 3>>(ss) == mi));
+
+    DynMatrix<double> d(37, 53);
+    for (size_t k = 0; k < d.size(); ++k) d.data()[k] = std::sin(static_cast<double>(k)) * 1e10;
+    std::stringstream ds;
+    write_binary(ds, d);
+    write_binary(ds, transpose_view(d));
+    assert(read_binary<DynMatrix<double>>(ds) == d);
+    assert(read_binary<DynMatrix<double>>(ds) == d.transpose());
+
+    // Files from a machine of the other byte order are swapped while reading
+    std::string bytes;
+    {
+        std::stringstream os;
+        write_binary(os, mi);
+        bytes = os.str();
+    }
+    bytes[7] = static_cast<char>(bytes[7] ^ 1);
+    std::reverse(bytes.begin() + 8, bytes.begin() + 16);
+    std::reverse(bytes.begin() + 16, bytes.begin() + 24);
+    for (size_t k = 64; k < bytes.size(); k += sizeof(int)) std::reverse(bytes.begin() + k, bytes.begin() + k + sizeof(int));
+    std::stringstream swapped(bytes);
+    assert((read_binary<Matrix<int, 2, 3>>(swapped) == mi));
+
+    // Memory-mapped files are viewed in place
+    const char* path = "matrixLibTest_mapped.mlib";
+    save_binary(path, d);
+    {
+        MappedMatrix<double> mapped(path);
+        assert(mapped.rows() == 37 && mapped.cols() == 53 && mapped(36, 52) == d(36, 52));
+        assert(reinterpret_cast<std::uintptr_t>(mapped.data()) % 64 == 0);
+        assert(mapped.view() == d && mapped.to_matrix() == d);
+        assert(DynMatrix<double>(mapped.view() * transpose_view(d)) == d * d.transpose());
+
+        MappedMatrix<double> moved = std::move(mapped);
+        assert(moved.rows() == 37 && mapped.data() == nullptr);
+    }
+    assert(load_binary<DynMatrix<double>>(path) == d);
+
+    bool threw = false;
+    try { MappedMatrix<float> wrongType(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    std::remove(path);
+
+    threw = false;
+    try { ds.clear(); ds.seekg(0); (void)read_binary<Matrix<double, 3, 3>>(ds); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { std::stringstream truncated(ss.str().substr(0, 70)); (void)read_binary<Matrix<int, 2, 3>>(truncated); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { std::stringstream text("| 1, 2 |\n"); (void)read_binary<DynMatrix<int>>(text); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    // Text output goes through std::to_chars unless the stream has non-default formatting
+    Matrix<double, 1, 3> t = {{0.1, 1e-7, 123456789.0}};
+    assert(to_string(t) == "| 0.1, 1e-07, 1.23457e+08 |\n");
+    std::ostringstream precise;
+    precise.precision(10);
+    precise << t;
+    assert(precise.str() == "| 0.1, 1e-07, 123456789 |\n");
+}
+
+void test_mixed_precision() {
+    // Every half survives a round trip through float, and float -> half rounds to nearest even
+    for (std::uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+        const Half h = Half::from_bits(static_cast<std::uint16_t>(bits));
+        const float f = h;
+        if (f != f) continue;
+        assert(Half(f).bits() == bits);
+    }
+    assert(Half(1.0f + 1.0f / 2048).bits() == Half(1.0f).bits());
+    assert(float(Half(65520.0f)) == INFINITY && float(Half(1e-8f)) == 0.0f);
+    assert(float(BFloat16(1.0f + 1.0f / 256)) == 1.0f && float(BFloat16(3.0f)) == 3.0f);
+
+    // Half storage multiplies in float: small integers are exact, so it matches the float product
+    DynMatrix<Half> h(30, 40);
+    DynMatrix<float> f(30, 40);
+    for (size_t k = 0; k < h.size(); ++k) {
+        h.data()[k] = Half(static_cast<float>(static_cast<int>(k * 7 % 15) - 7));
+        f.data()[k] = h.data()[k];
+    }
+    const DynMatrix<float> hf = multiply<float>(h, transpose_view(h));
+    assert(hf == f * transpose_view(f));
+    Matrix<Half, 2, 3> hs = {{Half(1.0f), Half(2.0f), Half(3.0f)}, {Half(-1.0f), Half(0.5f), Half(0.0f)}};
+    Matrix<std::int8_t, 3, 2> is = {{1, 2}, {3, 4}, {5, -6}};
+    const Matrix<float, 2, 2> mixed = multiply<float>(hs, is);
+    assert(mixed(0, 0) == 22.0f && mixed(0, 1) == -8.0f && mixed(1, 0) == 0.5f && mixed(1, 1) == 0.0f);
+
+    // int8 x int8 -> int32 is exact on the VNNI kernel and on the widening fallback, at ragged sizes
+    const Kernels::SimdIsa original = Kernels::active_simd_isa();
+    for (auto isa : {Kernels::SimdIsa::AVX512, Kernels::SimdIsa::AVX2, Kernels::SimdIsa::Scalar}) {
+        if (!Kernels::set_simd_isa(isa)) continue;
+
+        for (size_t m : {1, 5, 67}) {
+            for (size_t k : {1, 3, 300}) {
+                for (size_t n : {1, 17, 45}) {
+                    DynMatrix<std::int8_t> a(m, k), b(k, n);
+                    for (size_t x = 0; x < a.size(); ++x) a.data()[x] = static_cast<std::int8_t>(x * 37 % 256);
+                    for (size_t x = 0; x < b.size(); ++x) b.data()[x] = static_cast<std::int8_t>(x * 101 % 256);
+
+                    const DynMatrix<std::int32_t> c = multiply<std::int32_t>(a, b);
+                    const DynMatrix<std::int32_t> ct = multiply<std::int32_t>(a, transpose_view(b).transpose());
+                    for (size_t i = 0; i < m; ++i) {
+                        for (size_t j = 0; j < n; ++j) {
+                            std::int32_t sum = 0;
+                            for (size_t p = 0; p < k; ++p) sum += a(i, p) * b(p, j);
+                            assert(c(i, j) == sum && ct(i, j) == sum);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    Kernels::set_simd_isa(original);
+
+    // Quantisation is within half a step, and the quantised product matches the product of the dequantised values
+    DynMatrix<float> x(50, 60), y(60, 20);
+    for (size_t k = 0; k < x.size(); ++k) x.data()[k] = 2.5f * std::sin(static_cast<float>(k)) + 0.5f;
+    for (size_t k = 0; k < y.size(); ++k) y.data()[k] = std::cos(static_cast<float>(k));
+    const QuantizedMatrix qx = QuantizedMatrix::quantize(x);
+    const QuantizedMatrix qy = QuantizedMatrix::quantize(y);
+    const DynMatrix<float> dx = qx.dequantize();
+    for (size_t k = 0; k < x.size(); ++k) assert(std::abs(dx.data()[k] - x.data()[k]) <= 0.5f * qx.scale() * 1.001f);
+    assert(QuantizedMatrix::quantize(DynMatrix<float>(2, 2)).dequantize() == DynMatrix<float>(2, 2));
+
+    const DynMatrix<float> qp = qx * qy;
+    const DynMatrix<float> dp = dx * qy.dequantize();
+    for (size_t k = 0; k < qp.size(); ++k) assert(std::abs(qp.data()[k] - dp.data()[k]) <= 1e-3f);
+
+    bool threw = false;
+    try { QuantizedMatrix bad(DynMatrix<std::int8_t>(2, 2), 0.0f, 0); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { (void)(qx * qx); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // Half and bfloat16 matrices keep their element type through binary files
+    std::stringstream ss;
+    write_binary(ss, h);
+    assert(ss.str().size() == 64 + h.size() * 2);
+    const DynMatrix<Half> back = read_binary<DynMatrix<Half>>(ss);
+    assert(back.rows() == 30 && back.cols() == 40 && std::memcmp(back.data(), h.data(), h.size() * 2) == 0);
+}
+
+void test_storage_layouts() {
+    Matrix<float, 3, 5> a = {{1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}, {11, 12, 13, 14, 15}};
+    Matrix<float, 3, 5, ColMajorLayout> c(a);
+    Matrix<float, 3, 5, PaddedLayout<64>> p(a);
+    Matrix<float, 3, 5, PaddedLayout<32, StorageOrder::ColMajor>> pc(a);
+
+    // Padded rows start on the alignment boundary, and arrays of matrices keep every element aligned
+    static_assert(alignof(Matrix<float, 3, 5, PaddedLayout<64>>) == 64 && Matrix<float, 3, 5, PaddedLayout<64>>::leading_dimension() == 16);
+    static_assert(Matrix<float, 3, 5, PaddedLayout<32, StorageOrder::ColMajor>>::leading_dimension() == 8);
+    static_assert(sizeof(Matrix<double, 3, 3, AlignedLayout<64>>[4]) == 4 * 128);
+    assert(reinterpret_cast<std::uintptr_t>(p.data()) % 64 == 0 && p.row_stride() == 16 && c.col_stride() == 3);
+
+    // Element access, comparison and printing see the same matrix whatever the layout
+    assert(c == a && p == a && pc == a && a == pc && p == c);
+    assert(c(2, 1) == 12 && c[2][1] == 12 && p[1][4] == 10 && pc.col(3)[2] == 14);
+    assert(to_string(c) == to_string(a) && to_string(pc) == to_string(a));
+    std::ostringstream os;
+    os << p;
+    assert(os.str() == to_string(a));
+
+    // Arithmetic mixes layouts and never touches the padding
+    Matrix<float, 3, 5, PaddedLayout<64>> s = p + c;
+    s += c;
+    s -= a;
+    s *= 2.0f;
+    const Matrix<float, 3, 5> doubled = (a + a) * 2.0f;
+    assert(s == doubled);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 5; j < 16; ++j) assert(s.data()[i * 16 + j] == 0.0f);
+    }
+
+    // Products read and write any layout through its strides
+    const Matrix<float, 3, 3> gram = a * a.transpose();
+    const Matrix<float, 3, 3, PaddedLayout<64>> pg = p * c.transpose();
+    Matrix<float, 3, 3, ColMajorLayout> cg = a * transpose_view(pc);
+    assert(pg == gram && cg == gram);
+    cg.transpose_inplace();
+    assert(cg == gram.transpose());
+    const Matrix<float, 5, 3, ColMajorLayout> ct = c.transpose();
+    assert(ct == a.transpose());
+
+    Matrix<double, 70, 70, PaddedLayout<64>> big;
+    Matrix<double, 70, 70> dense;
+    for (size_t i = 0; i < 70; ++i) {
+        for (size_t j = 0; j < 70; ++j) big(i, j) = dense(i, j) = static_cast<double>(i * j % 7);
+    }
+    Matrix<double, 70, 70, PaddedLayout<64>> bigProduct = big * big;
+    bigProduct = bigProduct * big;
+    assert(bigProduct == dense * dense * dense);
+
+    // Conversions to and from DynMatrix, views and binary files
+    DynMatrix<float> d = pc;
+    assert(d == a && pc == d);
+    d += pc;
+    assert(d == a + a);
+    assert(transpose_view(pc) == a.transpose() && view(p).block(1, 1, 2, 2) == view(a).block(1, 1, 2, 2));
+    std::stringstream ss;
+    write_binary(ss, p);
+    assert((read_binary<Matrix<float, 3, 5, ColMajorLayout>>(ss) == a));
+
+    // Column-major matrices stay usable in constant expressions
+    constexpr Matrix<int, 2, 2, ColMajorLayout> k = {{1, 2}, {3, 4}};
+    constexpr Matrix<int, 2, 2, ColMajorLayout> k2 = k + k;
+    static_assert(k(0, 1) == 2 && k.transpose()(0, 1) == 3 && k2(1, 0) == 6);
+}
+
+void test_compile_time_matrices() {
+    // Factories
+    constexpr auto i3 = Matrix<int, 3, 3>::identity();
+    static_assert(i3(0, 0) == 1 && i3(1, 1) == 1 && i3(2, 2) == 1 && i3(0, 1) == 0 && i3(2, 0) == 0);
+    static_assert(Matrix<int, 2, 3>::identity()(1, 1) == 1 && Matrix<int, 2, 3>::identity()(1, 2) == 0);
+    static_assert(Matrix<int, 2, 2>::zero() == Matrix<int, 2, 2>{{0, 0}, {0, 0}});
+    constexpr auto d = Matrix<int, 3, 3>::diagonal({2, 3, 4});
+    static_assert(d(0, 0) == 2 && d(2, 2) == 4 && d(1, 0) == 0 && trace(d) == 9 && determinant(d) == 24);
+    static_assert(Matrix<int, 2, 2, ColMajorLayout>::identity()(1, 1) == 1);
+
+    // Powers by repeated squaring, with compile-time and runtime exponents
+    constexpr Matrix<long, 2, 2> fib = {{1, 1}, {1, 0}};
+    static_assert(pow<0>(fib) == Matrix<long, 2, 2>::identity() && pow<1>(fib) == fib);
+    static_assert(pow<10>(fib)(0, 1) == 55 && pow<11>(fib)(0, 1) == 89);
+    static_assert(pow(fib, 40)(0, 1) == 102334155 && pow(fib, 0) == Matrix<long, 2, 2>::identity());
+
+    // A rotation chain baked into the binary: four quarter turns are the identity
+    constexpr Matrix<int, 2, 2> quarter = {{0, -1}, {1, 0}};
+    static_assert(pow<4>(quarter) == Matrix<int, 2, 2>::identity() && pow<2>(quarter) == -1 * Matrix<int, 2, 2>::identity());
+    static_assert(trace(quarter.transpose() * quarter) == 2);
+
+    // 1x1 and other layouts go through the unrolled determinant and inverse
+    static_assert(determinant(Matrix<int, 1, 1>{{7}}) == 7 && inverse(Matrix<double, 1, 1>{{4}})(0, 0) == 0.25);
+    constexpr Matrix<double, 2, 2, ColMajorLayout> c = {{4, 2}, {2, 2}};
+    static_assert(determinant(c) == 4 && inverse(c)(1, 0) == -0.5);
+
+    // The same functions at runtime, on a padded layout and on runtime-sized operands
+    Matrix<double, 3, 3, PaddedLayout<32>> r = {{0.5, 0.1, 0}, {0, 0.5, 0.2}, {0.3, 0, 0.5}};
+    Matrix<double, 3, 3, PaddedLayout<32>> r5 = r * r * r * r * r;
+    assert(max_abs(Matrix<double, 3, 3>(pow<5>(r) - r5)) < 1e-15 && max_abs(Matrix<double, 3, 3>(pow(r, 5) - r5)) < 1e-15);
+    assert(trace(r) == 1.5);
+    DynMatrix<double> dr = r;
+    assert(trace(dr) == 1.5 && trace(dr + dr) == 3.0);
+    bool threw = false;
+    try {
+        trace(DynMatrix<double>(2, 3));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+template <typename T>
+void check_vector_kernels(size_t m, size_t n) {
+    // Small integers keep every sum exact, so the kernels can be compared with == against plain loops
+    DynMatrix<T> a(m, n);
+    Vector<T> x(n), y(m), y0(m);
+    for (size_t i = 0; i < m; ++i) for (size_t j = 0; j < n; ++j) a(i, j) = T((i * 7 + j * 3) % 11) - T(5);
+    for (size_t j = 0; j < n; ++j) x(j, 0) = T(j % 5) - T(2);
+    for (size_t i = 0; i < m; ++i) y0(i, 0) = T(i % 3);
+
+    T expectedDot(0);
+    for (size_t j = 0; j < n; ++j) expectedDot += x(j, 0) * x(j, 0);
+    assert(dot(x, x) == expectedDot && dot(x.transpose(), x) == expectedDot);
+
+    DynMatrix<T> expected(m, 1);
+    for (size_t i = 0; i < m; ++i) {
+        T acc(0);
+        for (size_t j = 0; j < n; ++j) acc += a(i, j) * x(j, 0);
+        expected(i, 0) = T(2) * acc + T(3) * y0(i, 0);
+    }
+
+    // Row-major, column-major (a transposed view) and strided matrices, and the product operator
+    DynMatrix<T> at = a.transpose();
+    y = y0;
+    gemv(T(2), a, x, T(3), y);
+    assert(y == expected);
+    y = y0;
+    gemv(T(2), transpose_view(at), x, T(3), y);
+    assert(y == expected);
+    y = a * x;
+    assert(DynMatrix<T>(T(2) * y) == DynMatrix<T>(expected - T(3) * y0));
+    assert(DynMatrix<T>(x.transpose() * at) == y.transpose());
+
+    // axpy and ger against the same plain loops
+    Vector<T> z = y0;
+    axpy(T(2), expected, z);
+    for (size_t i = 0; i < m; ++i) assert(z(i, 0) == y0(i, 0) + T(2) * expected(i, 0));
+    DynMatrix<T> r = a;
+    ger(T(2), y0, x, r);
+    DynMatrix<T> rt = at;
+    ger(T(2), y0, x, transpose_view(rt));
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) assert(r(i, j) == a(i, j) + T(2) * y0(i, 0) * x(j, 0) && rt(j, i) == r(i, j));
+    }
+}
+
+void test_vectors() {
+    const Kernels::SimdIsa original = Kernels::active_simd_isa();
+
+    for (auto isa : {Kernels::SimdIsa::Scalar, Kernels::SimdIsa::SSE2, Kernels::SimdIsa::AVX2,
+                     Kernels::SimdIsa::AVX512, Kernels::SimdIsa::NEON}) {
+        if (!Kernels::set_simd_isa(isa)) continue;
+
+        for (auto shape : {std::make_pair(1, 1), std::make_pair(3, 5), std::make_pair(17, 67), std::make_pair(70, 3), std::make_pair(9, 300)}) {
+            check_vector_kernels<float>(shape.first, shape.second);
+            check_vector_kernels<double>(shape.first, shape.second);
+            check_vector_kernels<int>(shape.first, shape.second);
+        }
+    }
+
+    Kernels::set_simd_isa(original);
+
+    // Fixed-size vectors are matrices of one column and mix with everything else
+    Vector<double, 3> u = {{1}, {2}, {2}};
+    RowVector<double, 3> v = u.transpose();
+    Matrix<double, 3, 3> m = {{1, 0, 0}, {0, 2, 0}, {0, 0, 3}};
+    assert(norm(u) == 3.0 && dot(u, v) == 9.0);
+    assert((m * u == Vector<double, 3>{{1}, {4}, {6}}) && (v * m == RowVector<double, 3>{{1, 4, 6}}));
+    assert(dot(view(m).col(2), u) == 6.0 && dot(view(m).row(1), u + u) == 8.0);
+    Matrix<double, 3, 3> outer;
+    ger(1.0, u, v, outer);
+    assert(outer == u * v);
+    assert(Vector<float>(4).rows() == 4 && RowVector<float>(4).cols() == 4);
+    assert(Vector<double>(5, 2.0) == DynMatrix<double>(5, 1, 2.0) && RowVector<float>(3, 1.5f) == DynMatrix<float>(1, 3, 1.5f));
+    assert(Vector<double>(5, 1).rows() == 5 && Vector<double>(5, 1)(4, 0) == 0.0 && Vector<int>(3, 7)(2, 0) == 7);
+
+    // Rows and columns of a matrix can be updated through views
+    Matrix<double, 3, 3> w = m;
+    axpy(2.0, u, view(w).col(0));
+    gemv(1.0, m, u, 0.0, view(w).col(1));
+    assert(w(0, 0) == 3.0 && w(2, 0) == 4.0 && w(1, 1) == 4.0 && w(2, 1) == 6.0);
+
+    // Operands that overlap the destination are read before it is written
+    Vector<double, 3> s = u;
+    axpy(1.0, s, s);
+    assert(s == 2.0 * u);
+    gemv(1.0, m, s, 1.0, s);
+    assert((s == Vector<double, 3>{{4}, {12}, {16}}));
+    Matrix<double, 2, 2> g = {{1, 2}, {3, 4}};
+    ger(1.0, view(g).col(0), view(g).row(0), g);
+    assert((g == Matrix<double, 2, 2>{{2, 4}, {6, 10}}));
+
+    bool threw = false;
+    try {
+        dot(u, Vector<double, 2>());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        dot(m, m);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // The parallel routines match the serial ones; the long dot product is split, added in order and exact here
+    ThreadPool pool(3);
+    const size_t n = 1 << 19;
+    Vector<double> big(n), acc(n);
+    for (size_t i = 0; i < n; ++i) big(i, 0) = double(i % 9) - 4.0;
+    assert(dot(Execution::par.on(pool), big, big) == dot(big, big));
+    axpy(Execution::par.on(pool), 2.0, big, acc);
+    assert(acc == 2.0 * big);
+    DynMatrix<float> tall(4096, 128);
+    for (size_t i = 0; i < tall.rows(); ++i) for (size_t j = 0; j < tall.cols(); ++j) tall(i, j) = float((i + j) % 7);
+    Vector<float> x(128), yPar(4096);
+    for (size_t j = 0; j < x.rows(); ++j) x(j, 0) = float(j % 3);
+    gemv(Execution::par.on(pool), 1.0f, tall, x, 0.0f, yPar);
+    assert(yPar == tall * x && multiply(Execution::par.on(pool), tall, x) == yPar);
+    DynMatrix<float> updated = tall;
+    ger(Execution::par.on(pool), 1.0f, yPar, x, updated);
+    ger(1.0f, yPar, x, tall);
+    assert(updated == tall);
+}
+
+/* Strassen against the blocked kernel on an m x k by k x n product, with a leaf small enough to recurse */
+template <typename T>
+void check_strassen(size_t m, size_t n, size_t k, size_t leaf) {
+    DynMatrix<T> a(m, k), b(k, n);
+    for (size_t i = 0; i < m; ++i) for (size_t j = 0; j < k; ++j) a(i, j) = T(int((i * 7 + j * 3) % 11) - 5);
+    for (size_t i = 0; i < k; ++i) for (size_t j = 0; j < n; ++j) b(i, j) = T(int((i * 5 + j * 2) % 13) - 6);
+
+    StrassenWorkspace<T> workspace(leaf);
+    const DynMatrix<T> expected = a * b;
+    const DynMatrix<T> product = multiply_strassen(a, b, workspace);
+    assert(product.rows() == m && product.cols() == n);
+
+    const double scale = max_abs(a) * max_abs(b) * double(k);
+    const double tolerance = std::is_integral<T>::value ? 0.0 : 1e-4 * scale;
+    assert(max_abs(DynMatrix<T>(product - expected)) <= tolerance);
+
+    /* Operands read through their strides, and C = alpha * A * B + beta * C into a view */
+    const DynMatrix<T> at = a.transpose();
+    DynMatrix<T> c(n, m, T(1));
+    Kernels::gemm_strassen<T>(m, n, k, T(2), at.data(), 1, m, b.data(), n, 1, T(3), c.data(), 1, m, workspace);
+    assert(max_abs(DynMatrix<T>(c.transpose() - (T(2) * expected + DynMatrix<T>(m, n, T(3))))) <= 2 * tolerance);
+
+    /* A sized workspace does not grow again */
+    const size_t capacity = workspace.capacity();
+    assert(capacity == workspace.required(m, n, k));
+    multiply_strassen(a, b, workspace);
+    assert(workspace.capacity() == capacity);
+}
+
+void test_strassen() {
+    /* Powers of two, odd sizes that need padding at several levels, and rectangular shapes */
+    check_strassen<double>(64, 64, 64, 8);
+    check_strassen<double>(37, 37, 37, 4);
+    check_strassen<float>(45, 29, 61, 7);
+    check_strassen<int>(100, 90, 80, 16);
+    check_strassen<int>(33, 2, 33, 1);
+
+    /* Below the leaf size it is exactly the blocked kernel */
+    DynMatrix<float> a(40, 30, 0.5f), b(30, 20, 0.25f);
+    StrassenWorkspace<float> large(64);
+    assert(multiply_strassen(a, b, large) == a * b && large.capacity() == 0);
+
+    /* Fixed-size operands and expressions keep their product type; the default workspace is per thread */
+    Matrix<double, 48, 48> f;
+    for (size_t i = 0; i < 48; ++i) for (size_t j = 0; j < 48; ++j) f(i, j) = double((i + 2 * j) % 9);
+    StrassenWorkspace<double> small(12);
+    Matrix<double, 48, 48> ff = multiply_strassen(f, transpose_view(f), small);
+    assert(max_abs(Matrix<double, 48, 48>(ff - f * transpose_view(f))) < 1e-9);
+    assert(multiply_strassen(f + f, f) == (f + f) * f);
+
+    bool threw = false;
+    try {
+        multiply_strassen(DynMatrix<double>(4, 5), DynMatrix<double>(4, 5));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        StrassenWorkspace<double> none(0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_scratch_arena() {
+    /* Frees in stack order rewind the arena; a later allocation reuses the same bytes */
+    ScratchArena arena;
+    void* a = arena.allocate(1000, 64);
+    void* b = arena.allocate(24);
+    assert(reinterpret_cast<std::uintptr_t>(a) % 64 == 0 && arena.live_allocations() == 2);
+    arena.deallocate(a, 1000, 64);
+    assert(arena.live_allocations() == 1 && arena.stats().bytes_in_use == 24);
+    arena.deallocate(b, 24);
+    assert(arena.allocate(1000, 64) == a && arena.stats().upstream_allocations == 1);
+
+    bool threw = false;
+    try {
+        arena.release();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    arena.deallocate(a, 1000, 64);
+
+    /* Outgrowing the first block adds another; once idle the two merge, so the next round fits in one */
+    void* big = arena.allocate(MATRIXLIB_SCRATCH_BLOCK_SIZE / 2);
+    void* bigger = arena.allocate(MATRIXLIB_SCRATCH_BLOCK_SIZE);
+    arena.deallocate(big, MATRIXLIB_SCRATCH_BLOCK_SIZE / 2);
+    arena.deallocate(bigger, MATRIXLIB_SCRATCH_BLOCK_SIZE);
+    const size_t capacity = arena.stats().capacity;
+    arena.reset_stats();
+    big = arena.allocate(MATRIXLIB_SCRATCH_BLOCK_SIZE / 2);
+    bigger = arena.allocate(MATRIXLIB_SCRATCH_BLOCK_SIZE);
+    assert(arena.stats().upstream_allocations == 0 && arena.stats().allocations_avoided == 2 && arena.stats().capacity == capacity);
+    arena.deallocate(bigger, MATRIXLIB_SCRATCH_BLOCK_SIZE);
+    arena.deallocate(big, MATRIXLIB_SCRATCH_BLOCK_SIZE / 2);
+    arena.release();
+    assert(arena.stats().capacity == 0);
+
+    /* Matrices on an explicit arena or any pmr resource interoperate with the default DynMatrix */
+    ScratchMatrix<double> s(3, 4, 1.5, ScratchAllocator<double>(arena));
+    assert(s.get_allocator().arena() == &arena && arena.live_allocations() == 1);
+    DynMatrix<double> d = s;
+    ScratchMatrix<double> back = d * 2.0;
+    assert(d == s && back == DynMatrix<double>(3, 4, 3.0) && to_string(back) == to_string(DynMatrix<double>(back)));
+    assert(s.transpose().get_allocator() == s.get_allocator());
+
+    /* Vectors take an allocator too */
+    ScratchMatrix<double, Dynamic, 1> sv(4, ScratchAllocator<double>(arena)), filled(4, 0.5, ScratchAllocator<double>(arena));
+    assert(sv.get_allocator().arena() == &arena && filled.get_allocator().arena() == &arena);
+    assert(sv.rows() == 4 && filled == DynMatrix<double>(4, 1, 0.5));
+
+    /* A copy made on another thread draws from that thread's arena and leaves the source's alone */
+    const size_t sourceLive = arena.live_allocations();
+    std::thread copier([&] {
+        ScratchMatrix<double> copy = s;
+        assert(copy.get_allocator().arena() == &ScratchArena::local() && copy == s);
+        assert(ScratchArena::local().live_allocations() == 1);
+    });
+    copier.join();
+    assert(arena.live_allocations() == sourceLive);
+
+    std::pmr::monotonic_buffer_resource pool;
+    pmr::DynMatrix<double> p(4, 3, std::pmr::polymorphic_allocator<double>(&pool));
+    p = transpose_view(s) * 2.0;
+    assert(p.get_allocator().resource() == &pool && p == transpose_view(back));
+    p = p * DynMatrix<double>(3, 3, 1.0);
+    assert(p(0, 0) == 9.0);
+
+    /* Temporaries of aliased products and nested expressions come from the thread's arena and are recycled */
+    ScratchArena& local = ScratchArena::local();
+    DynMatrix<float> x(64, 64, 0.5f), y(64, 64, 0.25f), z(64, 64);
+    auto iteration = [&] {
+        z = (x + y) * y;
+        x = x * y;
+        x *= 1.0f / float(x(0, 0) * 2);
+    };
+    iteration();
+    const size_t live = local.live_allocations();
+    local.reset_stats();
+    for (int i = 0; i < 10; ++i) iteration();
+    assert(local.stats().allocations >= 20 && local.stats().allocations_avoided == local.stats().allocations);
+    assert(local.stats().upstream_allocations == 0 && local.live_allocations() == live);
+
+    /* User temporaries in a solver-style loop reuse the same buffers */
+    DynMatrix<double> m(32, 32, 0.01), rhs(32, 1, 1.0), sol(32, 1);
+    local.reset_stats();
+    for (int i = 0; i < 5; ++i) {
+        ScratchMatrix<double> residual = rhs - m * sol;
+        sol += 0.5 * residual;
+    }
+    assert(local.stats().allocations >= 5 && local.stats().upstream_allocations == 0);
+}
+
+namespace {
+    std::atomic<size_t> callbackEvents{0};
+    std::atomic<uint64_t> callbackFlops{0};
+
+    void count_event(const Instrumentation::Event& e) {
+        ++callbackEvents;
+        callbackFlops += e.flops;
+    }
+
+    const Instrumentation::Record* find_record(const Instrumentation::Snapshot& s, Instrumentation::Operation op,
+                                               size_t rows, size_t cols, size_t inner = 0) {
+        for (const auto& r : s.records) {
+            if (r.operation == op && !r.other_shapes && r.rows == rows && r.cols == cols && r.inner == inner) return &r;
+        }
+        return nullptr;
+    }
+}
+
+void test_instrumentation() {
+    using Instrumentation::Operation;
+
+    if constexpr (!Instrumentation::enabled) {
+        /* Switched off, the API still compiles, including user probes, and reports nothing */
+        Instrumentation::Probe probe(Operation::add, 1, 1, 0, 1, 0);
+        const Matrix<double, 4, 5> c = Matrix<double, 4, 3>::identity() * Matrix<double, 3, 5>::identity();
+        assert(c(0, 0) == 1.0);
+        assert(Instrumentation::set_callback(count_event) == nullptr && !Instrumentation::active());
+        assert(Instrumentation::snapshot().records.empty() && callbackEvents == 0);
+        assert(Instrumentation::to_json(Instrumentation::snapshot()).find("\"enabled\": false") != std::string::npos);
+        return;
+    }
+
+    Instrumentation::reset();
+    assert(Instrumentation::snapshot().records.empty());
+
+    /* Every instrumented operator is counted once per call, under its own shape */
+    const auto a = Matrix<double, 4, 3>::identity();
+    const auto b = Matrix<double, 3, 5>::identity();
+    Matrix<double, 4, 5> c = a * b;
+    c = a * b;
+    c += c;
+    c -= Matrix<double, 4, 5>::identity();
+    c *= 0.5;
+    assert(!(c == Matrix<double, 4, 5>()));
+    DynMatrix<float> d(6, 7, 1.0f);
+    d += d;
+    d -= d * 0.5f;
+    d *= 2.0f;
+    assert(d == DynMatrix<float>(6, 7, 2.0f));
+    assert(!to_string(d).empty());
+
+    auto s = Instrumentation::snapshot();
+    const auto* mul = find_record(s, Operation::multiply, 4, 5, 3);
+    assert(mul && mul->calls == 2 && mul->flops == 2 * 2 * 4 * 5 * 3 && mul->bytes == 2 * (12 + 15 + 20) * sizeof(double));
+    assert(find_record(s, Operation::add, 4, 5)->calls == 1 && find_record(s, Operation::subtract, 4, 5)->calls == 1);
+    assert(find_record(s, Operation::scale, 4, 5)->flops == 20 && find_record(s, Operation::compare, 4, 5)->calls == 1);
+    assert(find_record(s, Operation::add, 6, 7)->calls == 1 && find_record(s, Operation::subtract, 6, 7)->calls == 1);
+    assert(find_record(s, Operation::scale, 6, 7)->calls == 1 && find_record(s, Operation::compare, 6, 7)->calls == 1);
+    assert(find_record(s, Operation::to_string, 6, 7)->bytes == 42 * sizeof(float));
+    for (size_t i = 1; i < s.records.size(); ++i) assert(s.records[i - 1].nanoseconds >= s.records[i].nanoseconds);
+
+    /* Compile-time evaluation is not recorded */
+    constexpr Matrix<int, 2, 2> x = {{1, 2}, {3, 4}};
+    constexpr Matrix<int, 2, 2> square = x * x;
+    static_assert(square(1, 0) == 15, "constexpr products still work with instrumentation");
+    assert(find_record(Instrumentation::snapshot(), Operation::multiply, 2, 2, 2) == nullptr);
+
+    /* Threads aggregate separately; a finished thread's totals are kept */
+    std::thread worker([] {
+        DynMatrix<double> x(8, 8, 1.0), y(8, 8);
+        for (int i = 0; i < 3; ++i) y = x * x;
+    });
+    worker.join();
+    c = a * b;
+    s = Instrumentation::snapshot();
+    assert(find_record(s, Operation::multiply, 8, 8, 8)->calls == 3 && find_record(s, Operation::multiply, 4, 5, 3)->calls == 3);
+
+    const std::string json = Instrumentation::to_json(s);
+    assert(json.find("\"operation\": \"multiply\", \"shape\": [8, 8, 8], \"calls\": 3, \"flops\": 3072") != std::string::npos);
+    std::stringstream dumped;
+    Instrumentation::dump_json(dumped);
+    assert(dumped.str().find("\"enabled\": true") != std::string::npos);
+
+    /* Callbacks see every event; a paused layer records nothing */
+    assert(Instrumentation::set_callback(count_event) == nullptr);
+    c = a * b;
+    c *= 2.0;
+    assert(callbackEvents == 2 && callbackFlops == 2 * 4 * 5 * 3 + 20);
+    assert(Instrumentation::set_callback(nullptr) == count_event);
+
+    Instrumentation::reset();
+    Instrumentation::set_active(false);
+    c = a * b;
+    assert(Instrumentation::snapshot().records.empty() && callbackEvents == 2);
+    Instrumentation::set_active(true);
+
+    /* Without timing the counts are kept and the time stays zero */
+    Instrumentation::set_timing(false);
+    c = a * b;
+    mul = find_record(s = Instrumentation::snapshot(), Operation::multiply, 4, 5, 3);
+    assert(mul->calls == 1 && mul->nanoseconds == 0);
+    Instrumentation::set_timing(true);
+    Instrumentation::reset();
+
+    /* Shapes beyond the table's capacity are still counted, together */
+    for (size_t i = 0; i < MATRIXLIB_INSTRUMENTATION_SLOTS + 10; ++i) {
+        Instrumentation::Probe probe(Operation::add, i + 1, 1, 0, i + 1, 0);
+    }
+    s = Instrumentation::snapshot();
+    uint64_t adds = 0, addFlops = 0;
+    bool overflowed = false;
+    for (const auto& r : s.records) {
+        if (r.operation != Operation::add) continue;
+        adds += r.calls;
+        addFlops += r.flops;
+        overflowed |= r.other_shapes;
+    }
+    assert(overflowed && adds == MATRIXLIB_INSTRUMENTATION_SLOTS + 10);
+    assert(addFlops == (MATRIXLIB_INSTRUMENTATION_SLOTS + 10) * (MATRIXLIB_INSTRUMENTATION_SLOTS + 11) / 2);
+    assert(Instrumentation::to_json(s).find("\"shape\": null") != std::string::npos);
+    Instrumentation::reset();
+}
+
+void test_spectral() {
+    // Fixed-size symmetric matrix: A V = V diag(lambda), V orthogonal, eigenvalues ascending
+    const Matrix<double, 3, 3> s3 = {{4, 1, -2}, {1, 2, 0}, {-2, 0, 3}};
+    SymmetricEigen<Matrix<double, 3, 3>> e3(s3);
+    const auto& v3 = e3.eigenvectors();
+    auto l3 = e3.eigenvalues();
+    assert(e3.converged() && l3(0, 0) <= l3(1, 0) && l3(1, 0) <= l3(2, 0));
+    assert(std::abs(l3(0, 0) + l3(1, 0) + l3(2, 0) - trace(s3)) < 1e-12);
+    Matrix<double, 3, 3> d3 = Matrix<double, 3, 3>::zero();
+    for (size_t i = 0; i < 3; ++i) d3(i, i) = l3(i, 0);
+    assert(max_abs(Matrix<double, 3, 3>(s3 * v3 - v3 * d3)) < 1e-12);
+    assert(max_abs(Matrix<double, 3, 3>(transpose_view(v3) * v3 - Matrix<double, 3, 3>::identity())) < 1e-14);
+
+    // Runtime-sized, across several reduction panels, sequential and on a pool
+    const size_t n = 150;
+    DynMatrix<double> a(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j <= i; ++j) a(i, j) = a(j, i) = std::sin(double(i * 31 + j * 17 + 1));
+    }
+    SymmetricEigen<DynMatrix<double>> es(a);
+    const DynMatrix<double>& v = es.eigenvectors();
+    DynMatrix<double> av = a * v;
+    double residual = 0;
+    for (size_t j = 0; j < n; ++j) {
+        if (j > 0) assert(es.eigenvalues()(j - 1, 0) <= es.eigenvalues()(j, 0));
+        for (size_t i = 0; i < n; ++i) residual = std::max(residual, std::abs(av(i, j) - es.eigenvalues()(j, 0) * v(i, j)));
+    }
+    assert(residual < 1e-10);
+    assert(max_abs(DynMatrix<double>(transpose_view(v) * v - Detail::make_identity<DynMatrix<double>>(n))) < 1e-12);
+
+    ThreadPool pool(3);
+    SymmetricEigen<DynMatrix<double>> ep(Execution::par.on(pool), a);
+    SymmetricEigen<DynMatrix<double>> values(a, false);
+    assert(max_abs(DynMatrix<double>(ep.eigenvalues() - es.eigenvalues())) < 1e-12);
+    assert(max_abs(DynMatrix<double>(values.eigenvalues() - es.eigenvalues())) < 1e-12);
+
+    bool threw = false;
+    try { (void)values.eigenvectors(); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { SymmetricEigen<DynMatrix<double>> bad(DynMatrix<double>(3, 4)); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // SVD of tall and wide matrices: A = U diag(sigma) V^T with orthonormal columns, sigma descending
+    auto check_svd = [](const DynMatrix<double>& m, const SVD<DynMatrix<double>>& svd) {
+        const size_t k = std::min(m.rows(), m.cols());
+        const DynMatrix<double>& u = svd.matrixU();
+        DynMatrix<double> us = u;
+        for (size_t j = 0; j < k; ++j) {
+            if (j > 0) assert(svd.singular_values()(j - 1, 0) >= svd.singular_values()(j, 0));
+            for (size_t i = 0; i < m.rows(); ++i) us(i, j) *= svd.singular_values()(j, 0);
+        }
+        assert(max_abs(DynMatrix<double>(us * transpose_view(svd.matrixV()) - m)) < 1e-12 * max_abs(m) * double(k));
+        assert(max_abs(DynMatrix<double>(transpose_view(u) * u - Detail::make_identity<DynMatrix<double>>(k))) < 1e-12);
+        assert(max_abs(DynMatrix<double>(transpose_view(svd.matrixV()) * svd.matrixV() - Detail::make_identity<DynMatrix<double>>(k))) < 1e-12);
+    };
+    DynMatrix<double> tall(90, 40);
+    for (size_t i = 0; i < tall.rows(); ++i) {
+        for (size_t j = 0; j < tall.cols(); ++j) tall(i, j) = std::cos(double((i + 1) * (j + 3)) * 0.7);
+    }
+    SVD<DynMatrix<double>> st(tall);
+    assert(st.converged() && st.rank() == 40);
+    check_svd(tall, st);
+    DynMatrix<double> wide = tall.transpose();
+    SVD<DynMatrix<double>> sw(Execution::par.on(pool), wide);
+    check_svd(wide, sw);
+    assert(max_abs(DynMatrix<double>(sw.singular_values() - st.singular_values())) < 1e-12);
+
+    // Rank deficiency: columns 3.. repeat columns 0..2, the basis is still completed to orthonormal U and V
+    DynMatrix<double> low(12, 6);
+    for (size_t i = 0; i < 12; ++i) {
+        for (size_t j = 0; j < 6; ++j) low(i, j) = std::sin(double((i + 2) * (j % 3 + 1)) * 0.9);
+    }
+    SVD<DynMatrix<double>> sl(low);
+    assert(sl.rank() == 3 && sl.singular_values()(3, 0) < 1e-12);
+    check_svd(low, sl);
+
+    // Fixed sizes pick up fixed factor types
+    const Matrix<double, 4, 2> f42 = {{1, 2}, {3, 4}, {5, 6}, {7, 9}};
+    SVD<Matrix<double, 4, 2>> s42(f42);
+    static_assert(std::is_same_v<SVD<Matrix<double, 4, 2>>::UType, Matrix<double, 4, 2>>);
+    Matrix<double, 4, 2> us42 = s42.matrixU();
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 2; ++j) us42(i, j) *= s42.singular_values()(j, 0);
+    }
+    assert(max_abs(Matrix<double, 4, 2>(us42 * transpose_view(s42.matrixV()) - f42)) < 1e-12);
+
+    // Single precision
+    DynMatrix<float> af(40, 40);
+    for (size_t i = 0; i < 40; ++i) {
+        for (size_t j = 0; j <= i; ++j) af(i, j) = af(j, i) = float(a(i, j));
+    }
+    SymmetricEigen<DynMatrix<float>> ef(af);
+    DynMatrix<float> afv = af * ef.eigenvectors();
+    for (size_t j = 0; j < 40; ++j) {
+        for (size_t i = 0; i < 40; ++i) assert(std::abs(afv(i, j) - ef.eigenvalues()(j, 0) * ef.eigenvectors()(i, j)) < 1e-4f);
+    }
+
+    // Lanczos finds the top of the spectrum in far fewer than n steps
+    LanczosEigen<DynMatrix<double>> lz(a, 4);
+    assert(lz.eigenvalues().rows() == 4 && lz.eigenvectors().cols() == 4 && lz.iterations() < n);
+    for (size_t j = 0; j < 4; ++j) {
+        assert(std::abs(lz.eigenvalues()(j, 0) - es.eigenvalues()(n - 1 - j, 0)) < 1e-8 * std::abs(es.eigenvalues()(n - 1, 0)));
+    }
+    DynMatrix<double> ax = a * lz.eigenvectors();
+    for (size_t j = 0; j < 4; ++j) {
+        for (size_t i = 0; i < n; ++i) assert(std::abs(ax(i, j) - lz.eigenvalues()(j, 0) * lz.eigenvectors()(i, j)) < 1e-6);
+    }
+    assert(lz.converged());
+    threw = false;
+    try { LanczosEigen<DynMatrix<double>> bad(a, n + 1); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // No eigenpairs asked for leaves nothing of the previous computation; a NaN is reported, not returned as a result
+    lz.compute(a, 0);
+    assert(lz.eigenvalues().rows() == 0 && lz.eigenvectors().cols() == 0 && lz.converged());
+    DynMatrix<double> poisoned(6, 6, 1.0);
+    poisoned(2, 3) = poisoned(3, 2) = std::numeric_limits<double>::quiet_NaN();
+    lz.compute(poisoned, 2);
+    assert(!lz.converged() && lz.eigenvalues().rows() == 2);
+}
+
+void test_async() {
+    ThreadPool pool(3);
+    DynMatrix<double> a(70, 70);
+    for (size_t i = 0; i < 70; ++i) {
+        for (size_t j = 0; j < 70; ++j) a(i, j) = std::sin(double(i * 3 + j * 7 + 1)) + (i == j ? 20.0 : 0.0);
+    }
+    const DynMatrix<double> a2 = a * a;
+    const DynMatrix<double> a3 = a2 * a;
+
+    // A chain of dependent products, a solve fed by a future, and a generic job joining two branches
+    Future<DynMatrix<double>> square = async_multiply(pool, a, a);
+    Future<DynMatrix<double>> cube = async_multiply(pool, square, a);
+    Future<DynMatrix<double>> x = async_solve(pool, a, square);
+    Future<double> diff = async_invoke(pool, [](const DynMatrix<double>& c, const DynMatrix<double>& s) {
+        return max_abs(DynMatrix<double>(c - s));
+    }, cube, square);
+    assert(max_abs(DynMatrix<double>(cube.get() - a3)) < 1e-9 * max_abs(a3));
+    assert(max_abs(DynMatrix<double>(x.get() - a)) < 1e-9 * max_abs(a));
+    assert(std::abs(diff.get() - max_abs(DynMatrix<double>(a3 - a2))) < 1e-9 * max_abs(a3));
+    assert(square.ready() && cube.ready() && diff.ready());
+
+    // Expressions are evaluated when queued, so their operands may go away before the job runs
+    Future<DynMatrix<double>> shifted;
+    {
+        DynMatrix<double> temporary = a;
+        shifted = async_multiply(pool, temporary + temporary, std::cref(a2));
+    }
+    assert(max_abs(DynMatrix<double>(shifted.get() - 2.0 * a3)) < 1e-9 * max_abs(a3));
+
+    // Independent fixed-size products on the library's executor, joined with when_all
+    std::vector<Future<Matrix<double, 4, 4>>> batch;
+    Matrix<double, 4, 4> m = Matrix<double, 4, 4>::identity() * 2.0;
+    for (int i = 0; i < 50; ++i) batch.push_back(async_multiply(m, m));
+    Future<void> all = when_all(batch);
+    all.get();
+    for (const auto& f : batch) assert(f.ready() && f.get()(3, 3) == 4.0);
+    assert(async_executor().thread_count() >= 2);
+
+    // then() continues on the same pool; void jobs order work without a result
+    std::atomic<int> order{0};
+    Future<void> first = async_invoke(pool, [&order] { order = 1; });
+    Future<int> second = first.then([&order] { return order.load() + 1; });
+    assert(second.get() == 2);
+    assert(cube.then([](const DynMatrix<double>& c) { return c.rows(); }).get() == 70);
+
+    // Errors reach every dependent job, which then never runs
+    std::atomic<bool> ran{false};
+    Future<DynMatrix<double>> bad = async_multiply(pool, DynMatrix<double>(3, 4), DynMatrix<double>(3, 4));
+    Future<size_t> dependent = bad.then([&ran](const DynMatrix<double>& p) { ran = true; return p.rows(); });
+    bool threw = false;
+    try { (void)dependent.get(); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw && !ran);
+    threw = false;
+    try { when_all(std::vector<Future<DynMatrix<double>>>{cube, bad}).get(); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // A job that waits on another job runs queued work meanwhile, even on a pool with a single worker
+    ThreadPool single(2);
+    Future<double> inner;
+    Future<double> outer = async_invoke(single, [&] {
+        inner = async_invoke(single, [] { return 3.0; });
+        return inner.get() * 2;
+    });
+    assert(outer.get() == 6.0);
+
+    // A pool without workers runs each job inline on the submitting thread
+    ThreadPool inline_pool(1);
+    Future<DynMatrix<double>> now = async_multiply(inline_pool, a, a);
+    assert(now.ready() && max_abs(DynMatrix<double>(now.get() - a2)) < 1e-9 * max_abs(a2));
+    assert(!Future<int>().valid() && now.valid());
+
+    // An empty or moved-from future has no job to ask about
+    Future<DynMatrix<double>> taken = std::move(now);
+    assert(taken.valid() && !now.valid());
+    for (int call = 0; call < 4; ++call) {
+        threw = false;
+        try {
+            if (call == 0) (void)now.ready();
+            else if (call == 1) now.wait();
+            else if (call == 2) (void)now.get();
+            else (void)Future<int>().then([](int x) { return x; });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+void test_reductions() {
+    // Whole-matrix and per-line reductions agree across layouts, views and expressions
+    const Matrix<float, 3, 5> a = {{1, -2, 3, 4, 5}, {6, 7, -8, 9, 10}, {11, 12, 13, 14, -15}};
+    const Matrix<float, 3, 5, ColMajorLayout> c(a);
+    const Matrix<float, 3, 5, PaddedLayout<64>> p(a);
+    assert(sum(a) == 70 && sum(c) == 70 && sum(p) == 70 && sum(a + c) == 140 && sum(transpose_view(a)) == 70);
+    assert(min(a) == -15 && max(c) == 14 && min(p) == -15 && max(a * 2.0f) == 28 && mean(a) == 70.0f / 15);
+    assert(std::abs(norm(a) - std::sqrt(1240.0f)) < 1e-4f && norm(c) == norm(a) && norm(Execution::par, p) == norm(a));
+
+    const Matrix<float, 3, 1> rs = rowwise_sum(a);
+    const Matrix<float, 1, 5> cs = colwise_sum(c);
+    assert(rs == (Matrix<float, 3, 1>{{11}, {24}, {35}}) && rowwise_sum(c) == rs && rowwise_sum(p) == rs);
+    assert(cs == (Matrix<float, 1, 5>{{18, 17, 8, 27, 0}}) && colwise_sum(a) == cs && colwise_sum(transpose_view(a)) == rs.transpose());
+    assert(rowwise_min(a) == (Matrix<float, 3, 1>{{-2}, {-8}, {-15}}) && rowwise_max(c) == (Matrix<float, 3, 1>{{5}, {10}, {14}}));
+    assert(colwise_min(c) == (Matrix<float, 1, 5>{{1, -2, -8, 4, -15}}) && colwise_max(a) == (Matrix<float, 1, 5>{{11, 12, 13, 14, 10}}));
+    assert(colwise_mean(a)(0, 0) == 6.0f && rowwise_mean(c)(1, 0) == 4.8f && std::abs(rowwise_norm(a)(0, 0) - std::sqrt(55.0f)) < 1e-5f);
+    assert(std::abs(colwise_norm(c)(0, 4) - std::sqrt(350.0f)) < 1e-4f);
+
+    // Integers are exact; their means and norms come out in double
+    const Matrix<int, 2, 3> ints = {{1, 2, 3}, {4, 5, 7}};
+    assert(sum(ints) == 22 && min(ints) == 1 && max(ints) == 7 && rowwise_sum(ints) == (Matrix<int, 2, 1>{{6}, {16}}));
+    static_assert(std::is_same<decltype(mean(ints)), double>::value && std::is_same<decltype(rowwise_mean(ints)), Matrix<double, 2, 1>>::value);
+    assert(mean(ints) == 22.0 / 6 && colwise_mean(ints)(0, 2) == 5.0 && norm(ints) == std::sqrt(104.0));
+
+    // Narrow integers, such as int8 quantised values, reduce in their own type along and across memory
+    DynMatrix<std::int8_t> bytes(3, 4);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes.data()[i] = static_cast<std::int8_t>(int(i) - 5);
+    assert(sum(bytes) == 6 && sum(transpose_view(bytes)) == 6 && min(transpose_view(bytes)) == -5 && max(bytes) == 6);
+    assert(rowwise_sum(bytes)(2, 0) == 18 && colwise_sum(bytes)(0, 3) == 6);
+    assert(norm(bytes) == std::sqrt(146.0) && norm(Execution::par, transpose_view(bytes)) == norm(bytes));
+
+    // Means and norms of integers do not overflow with the element type
+    const Matrix<int, 2, 2> large = {{INT_MAX, INT_MAX}, {INT_MAX - 1, 1}};
+    assert(mean(large) == (3.0 * INT_MAX) / 4 && mean(Execution::par, transpose_view(large)) == mean(large));
+    assert(rowwise_mean(large)(0, 0) == double(INT_MAX) && colwise_mean(large)(0, 0) == INT_MAX - 0.5);
+    assert(std::abs(norm(large) - std::sqrt(3.0) * INT_MAX) < 1.0 && norm(Execution::seq, large) == norm(large));
+    assert(rowwise_norm(large)(0, 0) == std::sqrt(2.0) * INT_MAX && colwise_norm(large)(0, 1) == std::sqrt(double(INT_MAX) * INT_MAX + 1));
+    assert(colwise_max(transpose_view(bytes)) == (Matrix<std::int8_t, 1, 3>{{-2, 2, 6}}) && mean(bytes) == 0.5);
+    const QuantizedMatrix quantized = QuantizedMatrix::quantize(DynMatrix<float>(1, 3, 0.25f));
+    assert(sum(quantized.values()) == static_cast<std::int8_t>(3 * quantized.values()(0, 0)));
+
+    // Pairwise summation keeps the error of a long float sum near one rounding, where a running sum drifts by percents
+    DynMatrix<float> tenths(1000, 1000);
+    for (size_t i = 0; i < tenths.size(); ++i) tenths.data()[i] = 0.1f;
+    float running = 0;
+    for (size_t i = 0; i < tenths.size(); ++i) running += tenths.data()[i];
+    assert(std::abs(sum(tenths) - 1e5f) < 1.0f && std::abs(running - 1e5f) > 100.0f);
+    assert(std::abs(colwise_sum(tenths)(0, 999) - 100.0f) < 1e-4f && std::abs(rowwise_sum(transpose_view(tenths))(7, 0) - 100.0f) < 1e-4f);
+
+    // Threads only change who computes which part: results are bitwise equal to the sequential ones
+    ThreadPool pool(3);
+    DynMatrix<double> big(700, 900);
+    for (size_t i = 0; i < 700; ++i) {
+        for (size_t j = 0; j < 900; ++j) big(i, j) = std::sin(double(i * 13 + j * 7 + 1)) * (1.0 + double(j % 11));
+    }
+    const auto big_t = transpose_view(big);
+    assert(sum(Execution::par.on(pool), big) == sum(big) && sum(Execution::par.on(pool), big_t) == sum(big_t));
+    assert(min(Execution::par.on(pool), big) == min(big) && max(Execution::par.on(pool), big_t) == max(big));
+    assert(norm(Execution::par.on(pool), big) == norm(big) && mean(Execution::par.on(pool), big) == mean(big));
+    assert(rowwise_sum(Execution::par.on(pool), big) == rowwise_sum(big) && colwise_sum(Execution::par.on(pool), big) == colwise_sum(big));
+    assert(rowwise_max(Execution::par.on(pool), big_t) == rowwise_max(big_t) && colwise_norm(Execution::par.on(pool), big) == colwise_norm(big));
+    assert(std::abs(sum(big) - std::accumulate(big.data(), big.data() + big.size(), 0.0)) < 1e-9 * norm(big));
+    assert(max(big) == *std::max_element(big.data(), big.data() + big.size()));
+    DynMatrix<double> rows = rowwise_sum(big), cols = colwise_sum(big_t);
+    assert(rows.rows() == 700 && rows.cols() == 1 && cols.rows() == 1 && cols.cols() == 700);
+    for (size_t i = 0; i < 700; ++i) assert(std::abs(rows(i, 0) - cols(0, i)) < 1e-10);
+
+    // map and zip_map build a matrix of whatever the function returns, in the operand's shape
+    const Matrix<int, 3, 5> rounded = map(a, [](float x) { return int(x) * 2; });
+    assert(rounded(2, 4) == -30 && rounded == map(c, [](float x) { return int(x) * 2; }));
+    const Matrix<float, 5, 3> squares = map(transpose_view(a), [](float x) { return x * x; });
+    assert(squares(4, 2) == 225 && sum(squares) == 1240);
+    assert(zip_map(a, c, [](float x, float y) { return x - y; }) == (Matrix<float, 3, 5>::zero()));
+    const DynMatrix<double> scaled = map(Execution::par.on(pool), big, [](double x) { return 3 * x; });
+    assert(scaled == map(big, [](double x) { return 3 * x; }) && scaled(699, 899) == 3 * big(699, 899));
+    const DynMatrix<double> diff = zip_map(Execution::par.on(pool), big, big_t.transpose(), [](double x, double y) { return x - y; });
+    assert(diff.rows() == 700 && max(diff) == 0 && min(diff) == 0);
+
+    // reduce folds with any associative operation, with the same grouping under every policy
+    assert(reduce(ints, 1, [](int x, int y) { return x * y; }) == 840 && reduce(a, 0.0, [](double x, double y) { return x + y; }) == 70.0);
+    auto absmax = [](double x, double y) { return std::max(std::abs(x), std::abs(y)); };
+    assert(reduce(big, 0.0, absmax) == max(map(big, [](double x) { return std::abs(x); })));
+    auto plus = [](double x, double y) { return x + y; };
+    assert(reduce(Execution::par.on(pool), big, 0.0, plus) == reduce(big, 0.0, plus) && std::abs(reduce(big, 0.0, plus) - sum(big)) < 1e-9 * norm(big));
+    assert(reduce(Execution::par.on(pool), big_t, 0.0, plus) == reduce(big_t, 0.0, plus));
+
+    // Empty matrices sum to zero; extrema and means of nothing are errors, as are shape mismatches
+    DynMatrix<double> empty(0, 4);
+    assert(sum(empty) == 0 && norm(empty) == 0 && reduce(empty, 5.0, plus) == 5.0 && colwise_sum(empty) == DynMatrix<double>(1, 4));
+    assert(rowwise_min(empty).rows() == 0 && map(empty, [](double x) { return x; }).cols() == 4);
+    bool threw = false;
+    try { (void)min(empty); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { (void)mean(empty); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { (void)colwise_max(empty); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { (void)zip_map(big, tenths, [](double x, float y) { return x + y; }); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+}
+
+void test_deterministic() {
+    const Kernels::SimdIsa original = Kernels::active_simd_isa();
+    const bool wasDeterministic = Kernels::deterministic_mode();
+
+    DynMatrix<double> a(300, 1100), b(1100, 37), x(300000, 1), y(300000, 1);
+    for (size_t i = 0; i < a.size(); ++i) a.data()[i] = std::sin(double(i) * 0.37) * double(1 + i % 7);
+    for (size_t i = 0; i < b.size(); ++i) b.data()[i] = std::cos(double(i) * 0.11);
+    for (size_t i = 0; i < x.size(); ++i) x.data()[i] = std::sin(double(i) * 0.013), y.data()[i] = 1.0 / double(1 + i % 97);
+    const DynMatrix<double> v = view(b).col(3), row = transpose_view(a).col(5).transpose();
+    DynMatrix<double> wide(1100, 2000);
+    for (size_t i = 0; i < wide.size(); ++i) wide.data()[i] = std::sin(double(i) * 0.7);
+    ThreadPool two(2), three(3), five(5);
+
+    // Sums, dot products and matrix-vector products are bitwise the same on every instruction set and any pool
+    Kernels::set_deterministic_mode(true);
+    bool first = true;
+    double s0 = 0, d0 = 0, n0 = 0;
+    DynMatrix<double> av0, atv0, rs0, cs0, ab0, rb0;
+    for (auto isa : {Kernels::SimdIsa::Scalar, Kernels::SimdIsa::SSE2, Kernels::SimdIsa::AVX2,
+                     Kernels::SimdIsa::AVX512, Kernels::SimdIsa::NEON}) {
+        if (!Kernels::set_simd_isa(isa)) continue;
+
+        const double s = sum(a), d = dot(x, y), n = norm(a);
+        const DynMatrix<double> av = a * v, atv = transpose_view(b) * transpose_view(a).col(7), rs = rowwise_sum(a), cs = colwise_sum(a);
+        const DynMatrix<double> ab = a * b, rb = row * wide;
+        assert(dot(Execution::par.on(three), x, y) == d && dot(Execution::par.on(five), transpose_view(x).row(0), y) == d);
+        assert(sum(Execution::par.on(three), a) == s && norm(Execution::par.on(five), a) == n && rowwise_sum(Execution::par.on(two), a) == rs);
+        assert(multiply(Execution::par.on(two), a, b) == ab && multiply(Execution::par.on(five), a, b) == ab);
+        assert(multiply(Execution::par.on(three), row, wide) == rb);
+        DynMatrix<double> pv(300, 1);
+        gemv(Execution::par.on(three), 1.0, a, v, 0.0, pv);
+        assert(pv == av && av(5, 0) == dot(view(a).row(5), v));
+
+        if (first) {
+            s0 = s, d0 = d, n0 = n, av0 = av, atv0 = atv, rs0 = rs, cs0 = cs, ab0 = ab, rb0 = rb;
+            first = false;
+        }
+        assert(s == s0 && d == d0 && n == n0 && av == av0 && atv == atv0 && rs == rs0 && cs == cs0 && ab == ab0 && rb == rb0);
+    }
+    Kernels::set_simd_isa(original);
+    Kernels::set_deterministic_mode(false);
+
+    // Outside deterministic mode results move by a few roundings at most, and products still ignore the tiling
+    assert(std::abs(sum(a) - s0) < 1e-12 * norm(a) * 1100 && std::abs(dot(x, y) - d0) < 1e-12 * std::abs(d0) + 1e-9);
+    assert(approx_equal(a * v, av0, 1e-12, 1e-9) && multiply(Execution::par.on(two), a, b) == multiply(Execution::par.on(five), a, b));
+
+    // approx_equal: relative and absolute tolerances, infinities only match themselves, NaN matches nothing
+    const Matrix<double, 2, 3> p = {{1, -0.0, 1e300}, {INFINITY, -INFINITY, 1e-300}};
+    Matrix<double, 2, 3> q = p;
+    q(0, 1) = 0.0;
+    assert(approx_equal(p, q, 0.0) && ulp_equal(p, q, 0));
+    q(0, 0) = std::nextafter(1.0, 2.0);
+    assert(approx_equal(p, q, 1e-15) && !approx_equal(p, q, 1e-17) && ulp_equal(p, q, 1) && !ulp_equal(p, q, 0));
+    q(1, 0) = std::numeric_limits<double>::max();
+    assert(!approx_equal(p, q, 1.0) && !ulp_equal(p, q, 1000));
+    const Matrix<double, 1, 2> tiny = {{1e-20, -std::numeric_limits<double>::denorm_min()}}, zeros = {{0.0, std::numeric_limits<double>::denorm_min()}};
+    assert(!approx_equal(tiny, zeros, 1e-9) && approx_equal(tiny, zeros, 1e-9, 1e-12));
+    assert(ulp_equal(view(tiny).col(1), view(zeros).col(1), 2) && !ulp_equal(view(tiny).col(1), view(zeros).col(1), 1));
+    const Matrix<double, 1, 2> nan = {{1, std::nan("")}};
+    assert(!approx_equal(nan, nan, 1.0, 1.0) && !ulp_equal(nan, nan, 1000) && approx_equal(view(nan).col(0), view(nan).col(0), 0.0));
+
+    // Any operands of one scalar type: layouts, views and expressions; shapes must match
+    const Matrix<double, 2, 3, ColMajorLayout> pc(p);
+    assert(approx_equal(pc, p, 0.0) && ulp_equal(transpose_view(p), pc.transpose(), 0));
+    assert(approx_equal(a * 2.0, a + a, 0.0) && approx_equal(transpose_view(a), a.transpose(), 0.0) && !approx_equal(a, a.transpose(), 1.0));
+    assert(!ulp_equal(DynMatrix<double>(2, 3), DynMatrix<double>(3, 2), 10) && approx_equal(DynMatrix<float>(0, 3), DynMatrix<float>(0, 3), 0.0f));
+
+    // Long operands go through the SIMD kernels, with differences in vector bodies and in scalar tails
+    DynMatrix<float> f(1, 1003);
+    for (size_t i = 0; i < f.size(); ++i) f.data()[i] = std::sin(float(i)) * 100.0f;
+    for (auto isa : {Kernels::SimdIsa::Scalar, Kernels::SimdIsa::SSE2, Kernels::SimdIsa::AVX2,
+                     Kernels::SimdIsa::AVX512, Kernels::SimdIsa::NEON}) {
+        if (!Kernels::set_simd_isa(isa)) continue;
+
+        for (size_t at : {size_t(5), size_t(1001)}) {
+            DynMatrix<float> g = f;
+            g(0, at) = std::nextafter(g(0, at), INFINITY);
+            assert(!(g == f) && ulp_equal(g, f, 1) && !ulp_equal(g, f, 0) && approx_equal(g, f, 1e-6f) && !approx_equal(g, f, 1e-9f));
+            g(0, at) = f(0, at) * 1.001f;
+            assert(approx_equal(f, g, 1e-2f) && !approx_equal(f, g, 1e-4f) && !ulp_equal(f, g, 100));
+            g(0, at) = std::nanf("");
+            assert(!approx_equal(f, g, 1.0f) && !ulp_equal(f, g, ~uint64_t(0)));
+        }
+    }
+
+    Kernels::set_simd_isa(original);
+    Kernels::set_deterministic_mode(wasDeterministic);
+}
+
+void test_out_of_core() {
+    DynMatrix<double> a(150, 97), b(97, 131);
+    for (size_t k = 0; k < a.size(); ++k) a.data()[k] = std::sin(static_cast<double>(k));
+    for (size_t k = 0; k < b.size(); ++k) b.data()[k] = std::cos(static_cast<double>(k) * 0.5);
+
+    // Tiles round trip, with edge tiles cut to the matrix
+    const char* pathA = "matrixLibTest_a.mltl";
+    const char* pathB = "matrixLibTest_b.mltl";
+    const char* pathC = "matrixLibTest_c.mltl";
+    {
+        TiledMatrix<double> ta = save_tiled(pathA, a, 64, 40);
+        assert(ta.rows() == 150 && ta.cols() == 97 && ta.tile_row_count() == 3 && ta.tile_col_count() == 3);
+        assert(ta.tile_height(2) == 22 && ta.tile_width(2) == 17);
+        bool outside = false;
+        try { (void)ta.tile_height(3); } catch (const std::out_of_range&) { outside = true; }
+        assert(outside);
+        outside = false;
+        try { (void)ta.tile_width(3); } catch (const std::out_of_range&) { outside = true; }
+        assert(outside);
+        assert(ta.tile(2, 2) == DynMatrix<double>(view(a).block(128, 80, 22, 17)));
+        assert(ta.to_matrix() == a);
+
+        TiledMatrix<double> moved = std::move(ta);
+        assert(moved.tile(0, 1) == DynMatrix<double>(view(a).block(0, 40, 64, 40)));
+    }
+    TiledMatrix<double> ta(pathA);
+    assert(ta.tile_rows() == 64 && ta.tile_cols() == 40 && ta.to_matrix() == a);
+    TiledMatrix<double> tb = save_tiled(pathB, transpose_view(DynMatrix<double>(b.transpose())), 40, 48);
+    assert(tb.to_matrix() == b);
+
+    // The product streams through budgets from a single tile up to the whole problem, serially and in parallel
+    const DynMatrix<double> expected = a * b;
+    const size_t oneTile = (64 * 48 + 2 * (64 * 40 + 40 * 48)) * sizeof(double);
+    for (size_t budget : {oneTile, 3 * oneTile, size_t(MATRIXLIB_OUT_OF_CORE_BUDGET)}) {
+        TiledMatrix<double> tc(pathC, 150, 131, 64, 48);
+        multiply(ta, tb, tc, budget);
+        assert(approx_equal(tc.to_matrix(), expected, 1e-12, 1e-12));
+
+        ThreadPool pool(3);
+        TiledMatrix<double> pc(pathC, 150, 131, 64, 48);
+        multiply(Execution::par.on(pool), ta, tb, pc, budget);
+        assert(approx_equal(TiledMatrix<double>(pathC).to_matrix(), expected, 1e-12, 1e-12));
+    }
+
+    TiledMatrix<double> tc(pathC, 150, 131, 64, 48);
+    tc.set_tile(1, 2, DynMatrix<double>(64, 35, 1.0));
+    assert(tc.tile(1, 2) == DynMatrix<double>(64, 35, 1.0) && tc.tile(1, 1) == DynMatrix<double>(64, 48));
+
+    bool threw = false;
+    try { tc.set_tile(2, 2, DynMatrix<double>(64, 35)); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { multiply(ta, tb, tc, oneTile - 1); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<double> other(pathC, 150, 131, 32, 48); multiply(ta, tb, other); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<double> square = save_tiled(pathB, DynMatrix<double>(8, 8, 1.0), 4, 4); multiply(square, square, square); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<double> square = save_tiled(pathB, DynMatrix<double>(8, 8, 1.0), 4, 4); TiledMatrix<double> same("./matrixLibTest_b.mltl"); multiply(square, square, same); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<double> closed; multiply(ta, tb, closed); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<float> wrongType(pathA); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    threw = false;
+    try { TiledMatrix<double> notTiled(pathA, 4, 4, 0, 4); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    std::remove(pathA);
+    std::remove(pathB);
+    std::remove(pathC);
+}
 
 int main(int argc, char *argv[]) {
     (void)argc;
@@ -157,6 +2090,29 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_mutators());
     DO_TEST(test_equality());
     DO_TEST(test_arithmetic_operations());
+    DO_TEST(test_blocked_multiplication());
+    DO_TEST(test_simd_kernels());
+    DO_TEST(test_dyn_matrix());
+    DO_TEST(test_expression_templates());
+    DO_TEST(test_parallel_multiply());
+    DO_TEST(test_batched_products());
+    DO_TEST(test_raw_access());
+    DO_TEST(test_decompositions());
+    DO_TEST(test_sparse_matrix());
+    DO_TEST(test_transpose_and_views());
+    DO_TEST(test_binary_serialization());
+    DO_TEST(test_mixed_precision());
+    DO_TEST(test_storage_layouts());
+    DO_TEST(test_compile_time_matrices());
+    DO_TEST(test_vectors());
+    DO_TEST(test_strassen());
+    DO_TEST(test_scratch_arena());
+    DO_TEST(test_instrumentation());
+    DO_TEST(test_spectral());
+    DO_TEST(test_async());
+    DO_TEST(test_reductions());
+    DO_TEST(test_deterministic());
+    DO_TEST(test_out_of_core());
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file